@@ -18,17 +18,45 @@ SOURCES += \
     mainwindow.cpp \
     voicetextedit.cpp \
     voicerecognitionmanager.cpp \
+    enginepipeline.cpp \
+    dictationpipeline.cpp \
+    handsfreepipeline.cpp \
+    recognitionprotocol.cpp \
+    capturestore.cpp \
+    latencyhistogram.cpp \
+    pipelinetrace.cpp \
+    sessionrecorder.cpp \
+    voicelogging.cpp \
+    audiosource.cpp \
+    capturehealth.cpp \
+    tentativetextregion.cpp \
     simplevoicetextedit.cpp
 
 HEADERS += \
     mainwindow.h \
     voicetextedit.h \
     voicerecognitionmanager.h \
+    enginepipeline.h \
+    dictationpipeline.h \
+    handsfreepipeline.h \
+    recognitionprotocol.h \
+    capturestore.h \
+    audiosource.h \
+    capturehealth.h \
+    requestmetrics.h \
+    latencyhistogram.h \
+    pipelinetrace.h \
+    sessionrecorder.h \
+    voicelogging.h \
+    tentativetextregion.h \
     simplevoicetextedit.h
 
 FORMS += \
     mainwindow.ui
 
+# 内置推理引擎
+include(engine/engine.pri)
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,498 @@
+#include "audiosource.h"
+#include "requestmetrics.h"
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const int TICK_MS = 10;             // 回放时钟的间隔，与声卡的典型周期相当
+const int FAST_CHUNK_MS = 1000;     // 不等待时每次送出的音频时长
+const int HEALTH_INTERVAL_MS = 50;  // 管理器未要求notify时，麦克风健康采样的间隔
+
+/**
+ * 函数名称：`StreamDevice`
+ * 功能描述：GeneratedAudioSource读取模式返回的设备：送出的数据排队，readAll取走
+ */
+class StreamDevice : public QIODevice
+{
+public:
+    explicit StreamDevice(QObject *parent = nullptr)
+        : QIODevice(parent)
+    {
+        QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_pending.size() + QIODevice::bytesAvailable(); }
+
+    void append(const QByteArray &data)
+    {
+        m_pending.append(data);
+        emit readyRead();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const int size = static_cast<int>(qMin<qint64>(maxSize, m_pending.size()));
+        memcpy(data, m_pending.constData(), static_cast<size_t>(size));
+        m_pending.remove(0, size);
+        return size;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    QByteArray m_pending;
+};
+
+bool isNativeFormat(const QAudioFormat &format)
+{
+    return format.sampleRate() == SAMPLE_RATE && format.channelCount() == 1 && format.sampleSize() == 16
+           && format.sampleType() == QAudioFormat::SignedInt && format.byteOrder() == QAudioFormat::LittleEndian;
+}
+
+} // namespace
+
+AudioSource::AudioSource(const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , m_format(format)
+{
+}
+
+AudioSource *AudioSource::create(const QString &spec, const QAudioFormat &format, QObject *parent, QString *error)
+{
+    // "<类型>[:<参数>][?k=v&k=v]"，文件路径中可含冒号，只按第一个冒号和最后一个问号拆分
+    QString body = spec.trimmed();
+    QString query;
+    const int question = body.lastIndexOf('?');
+    if (question >= 0) {
+        query = body.mid(question + 1);
+        body.truncate(question);
+    }
+    const QString kind = body.section(':', 0, 0).toLower();
+    const QString argument = body.contains(':') ? body.mid(body.indexOf(':') + 1) : QString();
+    QHash<QString, QString> options;
+    for (const QString &pair : query.split('&', QString::SkipEmptyParts)) {
+        options.insert(pair.section('=', 0, 0).toLower(), pair.section('=', 1));
+    }
+    const double speed = options.value("speed", "1").toDouble();
+
+    QString message;
+    if (kind.isEmpty() || kind == "device") {
+        return new DeviceAudioSource(format, parent);
+    } else if (kind == "file") {
+        QByteArray pcm;
+        if (QFileInfo(argument).suffix().compare("wav", Qt::CaseInsensitive) == 0) {
+            if (readWavFile(argument, &pcm, &message)) {
+                return new FileAudioSource(format, pcm, argument, speed, options.value("loop") == "1", parent);
+            }
+        } else {
+            QFile file(argument);
+            if (file.open(QIODevice::ReadOnly)) {
+                pcm = file.readAll();
+                pcm.truncate(pcm.size() & ~1);
+                return new FileAudioSource(format, pcm, argument, speed, options.value("loop") == "1", parent);
+            }
+            message = "无法打开: " + argument;
+        }
+    } else if (kind == "synthetic") {
+        static const QStringList signalNames = {"speech", "tone", "noise", "silence"};
+        const int signal = signalNames.indexOf(argument.isEmpty() ? QString("speech") : argument.toLower());
+        if (signal >= 0) {
+            return new SyntheticAudioSource(format, static_cast<SyntheticAudioSource::Signal>(signal),
+                                            options.value("seed", "1").toUInt(), speed, parent);
+        }
+        message = "未知的合成信号: " + argument;
+    } else {
+        message = "未知的录音来源: " + spec;
+    }
+    if (error) {
+        *error = message;
+    }
+    return nullptr;
+}
+
+bool AudioSource::readWavFile(const QString &path, QByteArray *pcm, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = "无法打开: " + path;
+        return false;
+    }
+    QByteArray data = file.readAll();
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE") {
+        *errorMessage = "不是WAV文件: " + path;
+        return false;
+    }
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.skipRawData(12);
+    quint16 format = 0, channels = 0, bits = 0;
+    quint32 rate = 0;
+    while (!stream.atEnd()) {
+        char id[4];
+        quint32 size = 0;
+        stream.readRawData(id, 4);
+        stream >> size;
+        if (qstrncmp(id, "fmt ", 4) == 0) {
+            quint32 byteRate;
+            quint16 blockAlign;
+            stream >> format >> channels >> rate >> byteRate >> blockAlign >> bits;
+            stream.skipRawData(static_cast<int>(size) - 16);
+        } else if (qstrncmp(id, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16 || rate != 16000) {
+                *errorMessage = "仅支持16kHz单声道16位PCM: " + path;
+                return false;
+            }
+            const int offset = static_cast<int>(stream.device()->pos());
+            *pcm = data.mid(offset, qMin<int>(static_cast<int>(size), data.size() - offset) & ~1);
+            return true;
+        } else {
+            stream.skipRawData(static_cast<int>(size + (size & 1)));
+        }
+    }
+    *errorMessage = "缺少data块: " + path;
+    return false;
+}
+
+DeviceAudioSource::DeviceAudioSource(const QAudioFormat &format, QObject *parent)
+    : AudioSource(format, parent)
+    , m_device(QAudioDeviceInfo::defaultInputDevice())
+    , m_notifyInterval(0)
+    , m_bufferSize(0)
+{
+}
+
+DeviceAudioSource::~DeviceAudioSource()
+{
+    stop();
+}
+
+bool DeviceAudioSource::prepare(bool allowNearest, QString *error)
+{
+    if (m_device.isNull()) {
+        *error = "未找到音频输入设备";
+        return false;
+    }
+    if (!m_device.isFormatSupported(m_format)) {
+        if (!allowNearest) {
+            *error = "音频输入设备不支持16kHz单声道录音";
+            return false;
+        }
+        m_format = m_device.nearestFormat(m_format);
+    }
+    return true;
+}
+
+bool DeviceAudioSource::start(QIODevice *sink)
+{
+    createInput();
+    m_input->start(sink);
+    beginHealth();
+    return m_input->state() == QAudio::ActiveState;
+}
+
+QIODevice *DeviceAudioSource::start()
+{
+    createInput();
+    QIODevice *device = m_input->start();
+    if (!device || m_input->state() == QAudio::StoppedState) {
+        m_input.reset();
+        return nullptr;
+    }
+    beginHealth();
+    return device;
+}
+
+void DeviceAudioSource::createInput()
+{
+    m_input.reset(new QAudioInput(m_device, m_format));
+    if (m_bufferSize > 0) {
+        m_input->setBufferSize(m_bufferSize);
+    }
+    // 健康采样借用notify：读取模式和未要求notify时也按固定间隔回调，只在要求时转发
+    m_input->setNotifyInterval(m_notifyInterval > 0 ? m_notifyInterval : HEALTH_INTERVAL_MS);
+    connect(m_input.data(), &QAudioInput::notify, this, &DeviceAudioSource::onInputNotify);
+    connect(m_input.data(), &QAudioInput::stateChanged, this, &DeviceAudioSource::onInputStateChanged);
+}
+
+void DeviceAudioSource::beginHealth()
+{
+    m_probe.start(RequestMetrics::now(), m_input->notifyInterval() * 1000LL, m_input->bufferSize());
+}
+
+void DeviceAudioSource::onInputNotify()
+{
+    const qint64 lostUs = m_probe.sample(RequestMetrics::now(), m_input->processedUSecs(), m_input->bytesReady());
+    if (lostUs > 0) {
+        emit captureGap(lostUs);
+    }
+    if (m_notifyInterval > 0) {
+        emit notify();
+    }
+}
+
+void DeviceAudioSource::onInputStateChanged(QAudio::State state)
+{
+    Q_UNUSED(state);
+    if (m_input && m_input->error() != QAudio::NoError) {
+        m_probe.recordError();
+    }
+}
+
+void DeviceAudioSource::stop()
+{
+    if (m_input) {
+        m_input->stop();
+        m_input.reset();
+    }
+}
+
+void DeviceAudioSource::setNotifyInterval(int ms)
+{
+    m_notifyInterval = ms;
+}
+
+QString DeviceAudioSource::description() const
+{
+    return "device:" + m_device.deviceName();
+}
+
+GeneratedAudioSource::GeneratedAudioSource(const QAudioFormat &format, double speed, QObject *parent)
+    : AudioSource(format, parent)
+    , m_speed(qMax(speed, 0.0))
+    , m_notifyInterval(1000)
+    , m_producedSamples(0)
+    , m_notifiedSamples(0)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &GeneratedAudioSource::onTick);
+}
+
+GeneratedAudioSource::~GeneratedAudioSource()
+{
+    stop();
+}
+
+bool GeneratedAudioSource::prepare(bool allowNearest, QString *error)
+{
+    if (!isNativeFormat(m_format)) {
+        if (!allowNearest) {
+            *error = "文件和合成信号只支持16kHz单声道16位";
+            return false;
+        }
+        m_format.setSampleRate(SAMPLE_RATE);
+        m_format.setChannelCount(1);
+        m_format.setSampleSize(16);
+        m_format.setSampleType(QAudioFormat::SignedInt);
+        m_format.setByteOrder(QAudioFormat::LittleEndian);
+    }
+    return true;
+}
+
+bool GeneratedAudioSource::start(QIODevice *sink)
+{
+    stop();
+    m_sink = sink;
+    begin();
+    return true;
+}
+
+QIODevice *GeneratedAudioSource::start()
+{
+    stop();
+    m_stream.reset(new StreamDevice());
+    begin();
+    return m_stream.data();
+}
+
+void GeneratedAudioSource::begin()
+{
+    rewind();
+    m_producedSamples = 0;
+    m_notifiedSamples = 0;
+    m_clock.start();
+    m_timer.start(m_speed > 0.0 ? TICK_MS : 0);
+    m_probe.start(RequestMetrics::now(), m_speed > 0.0 ? TICK_MS * 1000 : 0, 0);
+}
+
+void GeneratedAudioSource::stop()
+{
+    m_timer.stop();
+    m_sink = nullptr;
+}
+
+void GeneratedAudioSource::onTick()
+{
+    // 按时钟计算应送出的总量，定时器的抖动不会累积成回放速度的偏差
+    const qint64 target = m_speed > 0.0
+                              ? static_cast<qint64>(m_clock.nsecsElapsed() / 1e9 * m_speed * SAMPLE_RATE)
+                              : m_producedSamples + FAST_CHUNK_MS * SAMPLE_RATE / 1000;
+    const int count = static_cast<int>(target - m_producedSamples);
+    if (count <= 0) {
+        return;
+    }
+    m_chunk.resize(count * 2);
+    generate(reinterpret_cast<qint16 *>(m_chunk.data()), count);
+    m_producedSamples = target;
+    if (m_speed > 0.0) {
+        // 送出量按时钟补齐，不会丢数据；周期和抖动反映采集线程事件循环的延迟
+        const qint64 producedUs = static_cast<qint64>(m_producedSamples * 1e6 / SAMPLE_RATE / m_speed);
+        m_probe.sample(RequestMetrics::now(), producedUs, -1);
+    }
+
+    if (m_sink) {
+        m_sink->write(m_chunk);
+        if (m_producedSamples - m_notifiedSamples >= static_cast<qint64>(m_notifyInterval) * SAMPLE_RATE / 1000) {
+            m_notifiedSamples = m_producedSamples;
+            emit notify();
+        }
+    } else if (m_stream) {
+        static_cast<StreamDevice *>(m_stream.data())->append(m_chunk);
+    }
+}
+
+FileAudioSource::FileAudioSource(const QAudioFormat &format, const QByteArray &pcm, const QString &path,
+                                 double speed, bool loop, QObject *parent)
+    : GeneratedAudioSource(format, speed, parent)
+    , m_pcm(pcm)
+    , m_path(path)
+    , m_loop(loop && !pcm.isEmpty())
+    , m_position(0)
+    , m_finished(false)
+{
+}
+
+QString FileAudioSource::description() const
+{
+    return QString("file:%1 (%2s, speed=%3%4)").arg(m_path).arg(m_pcm.size() / 32000.0, 0, 'f', 1)
+        .arg(speed()).arg(m_loop ? ", loop" : "");
+}
+
+void FileAudioSource::rewind()
+{
+    m_position = 0;
+    m_finished = false;
+}
+
+void FileAudioSource::generate(qint16 *samples, int count)
+{
+    const qint16 *pcm = reinterpret_cast<const qint16 *>(m_pcm.constData());
+    const int total = m_pcm.size() / 2;
+    while (count > 0) {
+        if (m_position >= total) {
+            if (m_loop) {
+                m_position = 0;
+                continue;
+            }
+            // 放完后送静音，与麦克风一样让端点检测自然结束
+            std::fill(samples, samples + count, qint16(0));
+            if (!m_finished) {
+                m_finished = true;
+                QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+            }
+            return;
+        }
+        const int n = qMin(count, total - m_position);
+        std::copy(pcm + m_position, pcm + m_position + n, samples);
+        m_position += n;
+        samples += n;
+        count -= n;
+    }
+}
+
+SyntheticAudioSource::SyntheticAudioSource(const QAudioFormat &format, Signal signal, quint32 seed, double speed,
+                                           QObject *parent)
+    : GeneratedAudioSource(format, speed, parent)
+    , m_signal(signal)
+    , m_seed(seed)
+{
+    rewind();
+}
+
+QString SyntheticAudioSource::description() const
+{
+    static const char *names[] = {"speech", "tone", "noise", "silence"};
+    return QString("synthetic:%1 (seed=%2, speed=%3)").arg(names[m_signal]).arg(m_seed).arg(speed());
+}
+
+void SyntheticAudioSource::rewind()
+{
+    m_state = m_seed;
+    m_sample = 0;
+    m_voiced = true;                    // 第一段为停顿，端点检测先估计噪声底
+    m_partLength = 0;
+    m_partRemaining = 0;
+    m_pitch = 0.0;
+    m_formant = 0.0;
+    m_phase = 0.0;
+}
+
+double SyntheticAudioSource::random()
+{
+    m_state = m_state * 1664525u + 1013904223u;
+    return (m_state >> 8) / 16777216.0;
+}
+
+void SyntheticAudioSource::nextSpeechPart()
+{
+    m_voiced = !m_voiced;
+    const double seconds = m_voiced ? 1.0 + 2.0 * random() : 0.3 + 0.7 * random();
+    m_partLength = static_cast<int>(seconds * SAMPLE_RATE);
+    m_partRemaining = m_partLength;
+    m_pitch = 100.0 + 120.0 * random();
+    m_formant = 400.0 + 500.0 * random();
+}
+
+void SyntheticAudioSource::generate(qint16 *samples, int count)
+{
+    const double twoPi = 2.0 * M_PI;
+    for (int i = 0; i < count; ++i, ++m_sample) {
+        double value = 0.0;
+        switch (m_signal) {
+        case Speech: {
+            if (m_partRemaining == 0) {
+                nextSpeechPart();
+            }
+            --m_partRemaining;
+            if (!m_voiced) {
+                value = 30.0 * (random() - 0.5);
+                break;
+            }
+            // 谐波按共振峰加权，4Hz的包络模拟音节
+            const double t = static_cast<double>(m_partLength - m_partRemaining) / SAMPLE_RATE;
+            const double envelope = 0.5 * (1.0 - qCos(twoPi * 4.0 * t));
+            for (int k = 1; k * m_pitch < 4000.0; ++k) {
+                const double offset = (k * m_pitch - m_formant) / 300.0;
+                value += qSin(k * m_phase) / (1.0 + offset * offset);
+            }
+            value = 2500.0 * envelope * value + 30.0 * (random() - 0.5);
+            m_phase = std::fmod(m_phase + twoPi * m_pitch / SAMPLE_RATE, twoPi);
+            break;
+        }
+        case Tone:
+            value = 10000.0 * qSin(twoPi * 440.0 * m_sample / SAMPLE_RATE);
+            break;
+        case Noise:
+            value = 6000.0 * (random() - 0.5);
+            break;
+        case Silence:
+            value = 30.0 * (random() - 0.5);
+            break;
+        }
+        samples[i] = static_cast<qint16>(qBound(-32768.0, value, 32767.0));
+    }
+}
@@ -0,0 +1,313 @@
+#ifndef AUDIOSOURCE_H
+#define AUDIOSOURCE_H
+
+#include "capturehealth.h"
+#include <QObject>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QAudioDeviceInfo>
+#include <QAudioInput>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QTimer>
+
+/**
+ * 函数名称：`AudioSource`
+ * 功能描述：录音来源：麦克风、按实时或加速回放的WAV/PCM文件、合成信号。
+ *           接口与QAudioInput一致（写入指定设备并定时notify，或返回可读设备并发readyRead），
+ *           管理器不区分来源，没有麦克风的构建机上也能按确定的输入跑完整条识别链路
+ * 设计特点：
+ *   - 用create按描述串创建："device"（默认输入设备）、"file:<路径>"、"synthetic[:speech|tone|noise|silence]"，
+ *     后两者可附加参数，如"file:/data/a.wav?speed=4&loop=1"、"synthetic:speech?speed=0&seed=7"
+ *   - speed为回放倍速，1为实时，0为不等待、尽快送出
+ *   - 文件放完后持续送出静音（与麦克风一致，端点检测能正常结束），并发出finished
+ *   - 每次回调对照墙钟采样采集健康状况（health），发现空洞时发出captureGap
+ * 线程安全：在创建线程中使用，数据在创建线程的事件循环中送出
+ */
+class AudioSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioSource(const QAudioFormat &format, QObject *parent = nullptr);
+
+    /**
+     * 函数名称：`create`
+     * 功能描述：按描述串创建录音来源
+     * 参数说明：
+     *     - spec：QString，来源描述，空串等同"device"
+     *     - format：QAudioFormat，期望的采集格式
+     *     - parent：QObject*，父对象
+     *     - error：QString*，失败时写入错误信息，可为nullptr
+     * 返回值：AudioSource*，描述串无效或文件无法读取时返回nullptr
+     */
+    static AudioSource *create(const QString &spec, const QAudioFormat &format, QObject *parent = nullptr,
+                               QString *error = nullptr);
+
+    /**
+     * 函数名称：`readWavFile`
+     * 功能描述：读取16kHz单声道16位PCM的WAV文件
+     * 参数说明：
+     *     - path：QString，文件路径
+     *     - pcm：QByteArray*，输出PCM数据
+     *     - errorMessage：QString*，失败时写入错误信息
+     * 返回值：bool，是否成功
+     */
+    static bool readWavFile(const QString &path, QByteArray *pcm, QString *errorMessage);
+
+    QAudioFormat format() const { return m_format; }
+
+    /**
+     * 函数名称：`prepare`
+     * 功能描述：检查能否按format()采集
+     * 参数说明：
+     *     - allowNearest：bool，麦克风不支持时是否改用最接近的格式（format()随之改变）
+     *     - error：QString*，失败时写入错误信息
+     * 返回值：bool，是否可以开始
+     */
+    virtual bool prepare(bool allowNearest, QString *error) = 0;
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始采集，音频写入sink，每notifyInterval发一次notify
+     * 返回值：bool，是否已开始
+     */
+    virtual bool start(QIODevice *sink) = 0;
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始采集，返回可读设备，新数据到达时发readyRead
+     * 返回值：QIODevice*，由来源持有，失败时返回nullptr
+     */
+    virtual QIODevice *start() = 0;
+
+    virtual void stop() = 0;
+    virtual void setNotifyInterval(int ms) = 0;
+
+    /**
+     * 函数名称：`setBufferSize`
+     * 功能描述：设置设备缓冲区大小，下次start生效；文件和合成信号没有设备缓冲区，忽略
+     * 参数说明：
+     *     - bytes：int，字节数，0表示设备默认
+     * 返回值：void
+     */
+    virtual void setBufferSize(int bytes) { Q_UNUSED(bytes); }
+
+    /**
+     * 函数名称：`health`
+     * 功能描述：本次（或最近一次）start以来的采集健康状况
+     */
+    const CaptureHealth &health() const { return m_probe.health(); }
+
+    /**
+     * 函数名称：`description`
+     * 功能描述：来源的单行描述，用于日志
+     */
+    virtual QString description() const = 0;
+
+signals:
+    /**
+     * 信号名称：`notify`
+     * 功能描述：写入模式下每notifyInterval毫秒（音频时长）发出
+     */
+    void notify();
+
+    /**
+     * 信号名称：`finished`
+     * 功能描述：文件已全部送出（之后送出静音）；循环回放和其他来源不发出
+     */
+    void finished();
+
+    /**
+     * 信号名称：`captureGap`
+     * 功能描述：采集出现空洞：已处理的音频时长落后墙钟，设备缓冲区溢出丢了音频
+     * 参数说明：
+     *     - lostUs：qint64，丢失的音频时长（微秒）
+     */
+    void captureGap(qint64 lostUs);
+
+protected:
+    QAudioFormat m_format;
+    CaptureHealthProbe m_probe;
+};
+
+/**
+ * 函数名称：`DeviceAudioSource`
+ * 功能描述：默认音频输入设备，即原来直接使用的QAudioInput
+ */
+class DeviceAudioSource : public AudioSource
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceAudioSource(const QAudioFormat &format, QObject *parent = nullptr);
+    ~DeviceAudioSource();
+
+    bool prepare(bool allowNearest, QString *error) override;
+    bool start(QIODevice *sink) override;
+    QIODevice *start() override;
+    void stop() override;
+    void setNotifyInterval(int ms) override;
+    void setBufferSize(int bytes) override { m_bufferSize = bytes; }
+    QString description() const override;
+
+private slots:
+    void onInputNotify();
+    void onInputStateChanged(QAudio::State state);
+
+private:
+    /**
+     * 函数名称：`createInput`
+     * 功能描述：创建QAudioInput：设置缓冲区大小和notify间隔（未要求notify时按健康采样的间隔）
+     */
+    void createInput();
+
+    /**
+     * 函数名称：`beginHealth`
+     * 功能描述：设备启动后开始健康采样，此时缓冲区大小已确定
+     */
+    void beginHealth();
+
+private:
+    QAudioDeviceInfo m_device;
+    QScopedPointer<QAudioInput> m_input;
+    int m_notifyInterval;               // 管理器要求的notify间隔，0表示不转发notify
+    int m_bufferSize;                   // 0表示设备默认
+};
+
+/**
+ * 函数名称：`GeneratedAudioSource`
+ * 功能描述：按时钟送出自身产生的音频（文件回放和合成信号的公共部分），只支持16kHz单声道16位
+ */
+class GeneratedAudioSource : public AudioSource
+{
+    Q_OBJECT
+
+public:
+    GeneratedAudioSource(const QAudioFormat &format, double speed, QObject *parent = nullptr);
+    ~GeneratedAudioSource();
+
+    bool prepare(bool allowNearest, QString *error) override;
+    bool start(QIODevice *sink) override;
+    QIODevice *start() override;
+    void stop() override;
+    void setNotifyInterval(int ms) override { m_notifyInterval = qMax(ms, 1); }
+
+    double speed() const { return m_speed; }
+
+protected:
+    /**
+     * 函数名称：`generate`
+     * 功能描述：产生接下来的count个采样
+     * 参数说明：
+     *     - samples：qint16*，输出
+     *     - count：int，采样数
+     * 返回值：void
+     */
+    virtual void generate(qint16 *samples, int count) = 0;
+
+    /**
+     * 函数名称：`rewind`
+     * 功能描述：每次start时回到开头
+     */
+    virtual void rewind() = 0;
+
+private slots:
+    void onTick();
+
+private:
+    void begin();
+
+private:
+    double m_speed;
+    int m_notifyInterval;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_producedSamples;           // 本次start以来送出的采样数
+    qint64 m_notifiedSamples;           // 上次notify时的采样数
+    QPointer<QIODevice> m_sink;         // 写入模式的目标
+    QScopedPointer<QIODevice> m_stream; // 读取模式返回的设备
+    QByteArray m_chunk;                 // 每次送出的数据，容量复用
+};
+
+/**
+ * 函数名称：`FileAudioSource`
+ * 功能描述：回放WAV（16kHz单声道16位）或裸PCM文件
+ */
+class FileAudioSource : public GeneratedAudioSource
+{
+    Q_OBJECT
+
+public:
+    FileAudioSource(const QAudioFormat &format, const QByteArray &pcm, const QString &path, double speed,
+                    bool loop, QObject *parent = nullptr);
+
+    QString description() const override;
+
+protected:
+    void generate(qint16 *samples, int count) override;
+    void rewind() override;
+
+private:
+    QByteArray m_pcm;
+    QString m_path;
+    bool m_loop;
+    int m_position;                     // 下一个送出的采样
+    bool m_finished;
+};
+
+/**
+ * 函数名称：`SyntheticAudioSource`
+ * 功能描述：合成信号：speech为1~3秒的浊音段（基频和共振峰随机变化）与0.3~1秒的停顿交替，
+ *           可驱动端点检测、分段和唤醒门控；tone为440Hz正弦，noise为白噪声，silence为底噪。同一seed结果相同
+ */
+class SyntheticAudioSource : public GeneratedAudioSource
+{
+    Q_OBJECT
+
+public:
+    enum Signal {
+        Speech,
+        Tone,
+        Noise,
+        Silence
+    };
+
+    SyntheticAudioSource(const QAudioFormat &format, Signal signal, quint32 seed, double speed,
+                         QObject *parent = nullptr);
+
+    QString description() const override;
+
+protected:
+    void generate(qint16 *samples, int count) override;
+    void rewind() override;
+
+private:
+    /**
+     * 函数名称：`random`
+     * 功能描述：[0, 1)均匀分布，线性同余，跨平台结果一致
+     */
+    double random();
+
+    /**
+     * 函数名称：`nextSpeechPart`
+     * 功能描述：speech信号切换到下一段（浊音或停顿），随机选取时长和音色
+     */
+    void nextSpeechPart();
+
+private:
+    Signal m_signal;
+    quint32 m_seed;
+    quint32 m_state;
+    qint64 m_sample;                    // 已产生的采样数
+    bool m_voiced;                      // 当前是否浊音段
+    int m_partLength;                   // 当前段的采样数
+    int m_partRemaining;                // 当前段剩余采样数
+    double m_pitch;                     // 基频(Hz)
+    double m_formant;                   // 第一共振峰(Hz)
+    double m_phase;
+};
+
+#endif // AUDIOSOURCE_H
@@ -0,0 +1,93 @@
+#include "capturehealth.h"
+#include <limits>
+
+namespace {
+
+const qint64 MIN_GAP_US = 50000;        // 空洞门限的下限
+
+} // namespace
+
+void CaptureHealth::merge(const CaptureHealth &other)
+{
+    period.merge(other.period);
+    jitter.merge(other.jitter);
+    captures += other.captures;
+    callbacks += other.callbacks;
+    capturedUs += other.capturedUs;
+    wallUs += other.wallUs;
+    maxDriftUs = qMax(maxDriftUs, other.maxDriftUs);
+    gaps += other.gaps;
+    lostUs += other.lostUs;
+    fillSamples += other.fillSamples;
+    fillPercentSum += other.fillPercentSum;
+    maxFillPercent = qMax(maxFillPercent, other.maxFillPercent);
+    highFillCallbacks += other.highFillCallbacks;
+    errors += other.errors;
+    if (other.bufferBytes > 0) {
+        bufferBytes = other.bufferBytes;
+    }
+}
+
+CaptureHealthProbe::CaptureHealthProbe()
+    : m_startNs(0)
+    , m_lastNs(0)
+    , m_expectedUs(0)
+    , m_baselineUs(std::numeric_limits<qint64>::max())
+    , m_accountedUs(std::numeric_limits<qint64>::max())
+{
+}
+
+void CaptureHealthProbe::start(qint64 nowNs, qint64 expectedPeriodUs, int bufferBytes)
+{
+    m_health = CaptureHealth();
+    m_health.captures = 1;
+    m_health.bufferBytes = bufferBytes;
+    m_startNs = nowNs;
+    m_lastNs = 0;
+    m_expectedUs = expectedPeriodUs;
+    m_baselineUs = std::numeric_limits<qint64>::max();
+    m_accountedUs = std::numeric_limits<qint64>::max();
+}
+
+qint64 CaptureHealthProbe::sample(qint64 nowNs, qint64 processedUs, qint64 bytesReady)
+{
+    ++m_health.callbacks;
+    if (m_lastNs) {
+        const qint64 periodNs = nowNs - m_lastNs;
+        m_health.period.record(periodNs);
+        if (m_expectedUs > 0) {
+            m_health.jitter.record(qAbs(periodNs - m_expectedUs * 1000));
+        }
+    }
+    m_lastNs = nowNs;
+
+    const qint64 wallUs = (nowNs - m_startNs) / 1000;
+    m_health.capturedUs = processedUs;
+    m_health.wallUs = wallUs;
+
+    // 回调在数据取走之后发生，正常时已处理时长跟上墙钟；偏差持续增长说明中间有音频没被取走、已被设备丢弃
+    const qint64 driftUs = wallUs - processedUs;
+    m_baselineUs = qMin(m_baselineUs, driftUs);
+    m_accountedUs = qMin(m_accountedUs, driftUs);
+    m_health.maxDriftUs = qMax(m_health.maxDriftUs, driftUs - m_baselineUs);
+
+    qint64 lostUs = 0;
+    const qint64 thresholdUs = qMax(2 * m_expectedUs, MIN_GAP_US);
+    if (driftUs - m_accountedUs > thresholdUs) {
+        lostUs = driftUs - m_accountedUs;
+        m_accountedUs = driftUs;
+        ++m_health.gaps;
+        m_health.lostUs += lostUs;
+    }
+
+    if (bytesReady >= 0 && m_health.bufferBytes > 0) {
+        const int percent = static_cast<int>(qMin<qint64>(100, bytesReady * 100 / m_health.bufferBytes));
+        ++m_health.fillSamples;
+        m_health.fillPercentSum += percent;
+        m_health.maxFillPercent = qMax(m_health.maxFillPercent, percent);
+        if (percent >= CaptureHealth::HIGH_FILL_PERCENT) {
+            ++m_health.highFillCallbacks;
+        }
+    }
+    return lostUs;
+}
@@ -0,0 +1,98 @@
+#ifndef CAPTUREHEALTH_H
+#define CAPTUREHEALTH_H
+
+#include "latencyhistogram.h"
+
+/**
+ * 函数名称：`CaptureHealth`
+ * 功能描述：录音采集的健康状况：设备已处理的音频时长与墙钟的偏差、缓冲区水位、回调周期与抖动、空洞（丢失的音频），
+ *           由AudioSource在每次回调时采样，VoiceRecognitionManager在每路采集结束时累计，captureHealth()取快照
+ * 设计特点：
+ *   - 偏差 = 墙钟经过时间 - 已处理的音频时长，以本次采集中最小的偏差为基线（去掉设备启动的延迟）；
+ *     偏差比已计入的部分再增长超过门限（两个回调周期，至少50ms）记为一次空洞：采集线程没跟上，设备缓冲区溢出丢了音频
+ *   - 回调周期与抖动（周期与期望间隔之差的绝对值）记入直方图
+ *   - 水位 = 设备缓冲区中待取的字节 / 缓冲区大小，不低于75%计为高水位：再慢一点就会溢出
+ * 线程安全：值类型，不加锁
+ */
+struct CaptureHealth
+{
+    LatencyHistogram period;            // 相邻两次回调的间隔
+    LatencyHistogram jitter;            // |间隔 - 期望间隔|
+    qint64 captures = 0;                // 累计的采集次数
+    qint64 callbacks = 0;
+    qint64 capturedUs = 0;              // 设备已处理的音频时长
+    qint64 wallUs = 0;                  // 同期的墙钟时长
+    qint64 maxDriftUs = 0;              // 偏差相对基线的最大值
+    qint64 gaps = 0;
+    qint64 lostUs = 0;                  // 空洞合计丢失的音频时长
+    qint64 fillSamples = 0;             // 取得水位的回调数
+    qint64 fillPercentSum = 0;
+    int maxFillPercent = 0;
+    qint64 highFillCallbacks = 0;       // 水位不低于75%的回调数
+    qint64 errors = 0;                  // 设备报告的错误
+    int bufferBytes = 0;                // 最近一次采集的设备缓冲区大小，0为未知
+
+    enum {
+        HIGH_FILL_PERCENT = 75
+    };
+
+    double meanFillPercent() const { return fillSamples ? static_cast<double>(fillPercentSum) / fillSamples : 0.0; }
+
+    /**
+     * 函数名称：`fallingBehind`
+     * 功能描述：采集线程是否没跟上：出现空洞、设备错误或高水位
+     */
+    bool fallingBehind() const { return gaps > 0 || errors > 0 || highFillCallbacks > 0; }
+
+    /**
+     * 函数名称：`merge`
+     * 功能描述：并入另一路采集的统计；bufferBytes取对方的（较新）
+     */
+    void merge(const CaptureHealth &other);
+};
+
+/**
+ * 函数名称：`CaptureHealthProbe`
+ * 功能描述：一路采集中逐回调计算CaptureHealth，由AudioSource持有
+ * 线程安全：在采集线程中使用
+ */
+class CaptureHealthProbe
+{
+public:
+    CaptureHealthProbe();
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始一路采集，清空此前的统计
+     * 参数说明：
+     *     - nowNs：qint64，开始时间（RequestMetrics::now()）
+     *     - expectedPeriodUs：qint64，期望的回调间隔（微秒），0表示不统计抖动
+     *     - bufferBytes：int，设备缓冲区大小，0表示未知（不统计水位）
+     * 返回值：void
+     */
+    void start(qint64 nowNs, qint64 expectedPeriodUs, int bufferBytes);
+
+    /**
+     * 函数名称：`sample`
+     * 功能描述：一次回调时采样
+     * 参数说明：
+     *     - nowNs：qint64，回调时间
+     *     - processedUs：qint64，开始以来设备已处理的音频时长（微秒）
+     *     - bytesReady：qint64，设备缓冲区中待取的字节，负值表示未知
+     * 返回值：qint64，本次发现空洞时为丢失的音频时长（微秒），否则为0
+     */
+    qint64 sample(qint64 nowNs, qint64 processedUs, qint64 bytesReady);
+
+    void recordError() { ++m_health.errors; }
+    const CaptureHealth &health() const { return m_health; }
+
+private:
+    CaptureHealth m_health;
+    qint64 m_startNs;
+    qint64 m_lastNs;                    // 上次回调，0表示还没有
+    qint64 m_expectedUs;
+    qint64 m_baselineUs;                // 最小偏差
+    qint64 m_accountedUs;               // 已计入空洞的偏差
+};
+
+#endif // CAPTUREHEALTH_H
@@ -0,0 +1,280 @@
+#include "capturestore.h"
+#include "voicelogging.h"
+#include "requestmetrics.h"
+#include "sessionrecorder.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+
+namespace {
+
+const qint64 SPILL_BLOCK = 64 * 1024;           // 落盘粒度
+const qint64 MIN_MEMORY_LIMIT = 4 * SPILL_BLOCK;
+const qint64 MAP_WINDOW = 4 * 1024 * 1024;      // 上传时每次映射的临时文件长度，读完即解除映射
+
+/**
+ * 函数名称：`CaptureReader`
+ * 功能描述：CaptureStore::createReader返回的只读设备：WAV头 + 临时文件 + 内存窗口的快照
+ */
+class CaptureReader : public QIODevice
+{
+public:
+    CaptureReader(const QByteArray &header, const QSharedPointer<QTemporaryFile> &spillFile,
+                  qint64 spilled, const QByteArray &window, QObject *parent)
+        : QIODevice(parent)
+        , m_header(header)
+        , m_spillFile(spillFile)
+        , m_spilled(spilled)
+        , m_window(window)
+        , m_map(nullptr)
+        , m_mapStart(0)
+        , m_mapSize(0)
+    {
+        if (m_spilled > 0) {
+            m_file.setFileName(m_spillFile->fileName());
+            m_file.open(QIODevice::ReadOnly);
+        }
+        QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    ~CaptureReader()
+    {
+        unmap();
+    }
+
+    qint64 size() const override
+    {
+        return m_header.size() + m_spilled + m_window.size();
+    }
+
+    void close() override
+    {
+        unmap();
+        m_file.close();
+        QIODevice::close();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        qint64 position = pos();
+        qint64 done = 0;
+        while (done < maxSize && position < size()) {
+            qint64 count = 0;
+            if (position < m_header.size()) {
+                count = qMin(maxSize - done, m_header.size() - position);
+                memcpy(data + done, m_header.constData() + position, static_cast<size_t>(count));
+            } else if (position < m_header.size() + m_spilled) {
+                count = readSpilled(position - m_header.size(), data + done, maxSize - done);
+                if (count <= 0) {
+                    return done > 0 ? done : -1;
+                }
+            } else {
+                const qint64 offset = position - m_header.size() - m_spilled;
+                count = qMin(maxSize - done, m_window.size() - offset);
+                memcpy(data + done, m_window.constData() + offset, static_cast<size_t>(count));
+            }
+            done += count;
+            position += count;
+        }
+        return done;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    /**
+     * 按MAP_WINDOW分段映射临时文件，换段时解除上一段，常驻内存不超过一段；映射失败时直接读文件
+     */
+    qint64 readSpilled(qint64 offset, char *data, qint64 maxSize)
+    {
+        const qint64 count = qMin(maxSize, m_spilled - offset);
+        if (!m_map || offset < m_mapStart || offset >= m_mapStart + m_mapSize) {
+            unmap();
+            m_mapStart = offset - offset % MAP_WINDOW;
+            m_mapSize = qMin(MAP_WINDOW, m_spilled - m_mapStart);
+            m_map = m_file.map(m_mapStart, m_mapSize);
+        }
+        if (m_map) {
+            const qint64 mapped = qMin(count, m_mapStart + m_mapSize - offset);
+            memcpy(data, m_map + (offset - m_mapStart), static_cast<size_t>(mapped));
+            return mapped;
+        }
+        if (!m_file.seek(offset)) {
+            return -1;
+        }
+        return m_file.read(data, count);
+    }
+
+    void unmap()
+    {
+        if (m_map) {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+        }
+    }
+
+    QByteArray m_header;
+    QSharedPointer<QTemporaryFile> m_spillFile;     // 保持临时文件存在
+    QFile m_file;                                   // 独立的读取句柄，不影响录音写入的位置
+    qint64 m_spilled;
+    QByteArray m_window;                            // 隐式共享，录音已结束时不复制
+    uchar *m_map;
+    qint64 m_mapStart;
+    qint64 m_mapSize;
+};
+
+} // namespace
+
+CaptureStore::CaptureStore(QObject *parent)
+    : QIODevice(parent)
+    , m_spilled(0)
+    , m_memoryLimit(0)
+    , m_activeLimit(0)
+    , m_spillFailed(false)
+    , m_firstWriteNs(0)
+{
+}
+
+CaptureStore::~CaptureStore()
+{
+}
+
+void CaptureStore::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = bytes > 0 ? qMax(bytes, MIN_MEMORY_LIMIT) : 0;
+}
+
+bool CaptureStore::open(OpenMode mode)
+{
+    if ((mode & ReadOnly) || !(mode & WriteOnly)) {
+        return false;
+    }
+    if (isOpen()) {
+        QIODevice::close();
+    }
+    clear();
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void CaptureStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_window = QByteArray();
+    m_spilled = 0;
+    m_spillFile.reset();
+    m_activeLimit = m_memoryLimit;
+    m_spillFailed = false;
+    m_firstWriteNs = 0;
+    if (m_activeLimit > 0) {
+        m_window.reserve(static_cast<int>(m_activeLimit + SPILL_BLOCK));
+    }
+}
+
+qint64 CaptureStore::bytesCaptured() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spilled + m_window.size();
+}
+
+qint64 CaptureStore::spilledBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spilled;
+}
+
+qint64 CaptureStore::firstWriteTime() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_firstWriteNs;
+}
+
+bool CaptureStore::readAt(qint64 offset, char *data, qint64 length) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (offset < 0 || length < 0 || offset + length > m_spilled + m_window.size()) {
+        return false;
+    }
+    if (offset < m_spilled) {
+        const qint64 count = qMin(length, m_spilled - offset);
+        if (!m_spillFile->seek(offset) || m_spillFile->read(data, count) != count
+                || !m_spillFile->seek(m_spilled)) {
+            return false;
+        }
+        data += count;
+        offset += count;
+        length -= count;
+    }
+    memcpy(data, m_window.constData() + (offset - m_spilled), static_cast<size_t>(length));
+    return true;
+}
+
+QByteArray CaptureStore::toByteArray() const
+{
+    const qint64 total = bytesCaptured();
+    QByteArray data(static_cast<int>(total), Qt::Uninitialized);
+    if (!readAt(0, data.data(), total)) {
+        qCWarning(lcCapture) << "🎤 读取录音临时文件失败";
+        return QByteArray();
+    }
+    return data;
+}
+
+QIODevice *CaptureStore::createReader(const QByteArray &header, QObject *parent) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_spillFile) {
+        m_spillFile->flush();
+    }
+    return new CaptureReader(header, m_spillFile, m_spilled, m_window, parent);
+}
+
+qint64 CaptureStore::readData(char *, qint64)
+{
+    return -1;
+}
+
+qint64 CaptureStore::writeData(const char *data, qint64 maxSize)
+{
+    SessionRecorder::audio(data, maxSize);
+    QMutexLocker locker(&m_mutex);
+    if (!m_firstWriteNs && maxSize > 0) {
+        m_firstWriteNs = RequestMetrics::now();
+    }
+    m_window.append(data, static_cast<int>(maxSize));
+    if (m_activeLimit > 0 && m_window.size() > m_activeLimit && !m_spillFailed) {
+        spill();
+    }
+    return maxSize;
+}
+
+void CaptureStore::spill()
+{
+    if (!m_spillFile) {
+        m_spillFile.reset(new QTemporaryFile(QDir::tempPath() + "/voiceinput-capture-XXXXXX.pcm"));
+        if (!m_spillFile->open()) {
+            qCWarning(lcCapture) << "🎤 无法创建录音临时文件，本段录音保留在内存中:" << m_spillFile->errorString();
+            m_spillFile.reset();
+            m_spillFailed = true;
+            return;
+        }
+    }
+
+    // 保留最近一半，之前的整块落盘；remove不释放容量，之后的追加不再分配
+    const qint64 bytes = (m_window.size() - m_activeLimit / 2) / SPILL_BLOCK * SPILL_BLOCK;
+    if (bytes <= 0) {
+        return;
+    }
+    if (m_spillFile->write(m_window.constData(), bytes) != bytes) {
+        qCWarning(lcCapture) << "🎤 写入录音临时文件失败，之后的录音保留在内存中:" << m_spillFile->errorString();
+        m_spillFile->seek(m_spilled);
+        m_spillFailed = true;
+        return;
+    }
+    m_window.remove(0, static_cast<int>(bytes));
+    m_spilled += bytes;
+}
@@ -0,0 +1,115 @@
+#ifndef CAPTURESTORE_H
+#define CAPTURESTORE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTemporaryFile>
+
+/**
+ * 函数名称：`CaptureStore`
+ * 功能描述：录音数据的存储，作为QAudioInput的写入设备：最近的音频留在内存窗口，
+ *           窗口超过上限时把最早的块写入临时文件，长时间录音的内存占用与录音时长无关
+ * 设计特点：
+ *   - 内存窗口超过memoryLimit时，按64KB块把较早的一半写入临时文件，窗口容量复用，稳态下不分配内存
+ *   - 分块识别读取的是最近的音频，始终在内存窗口中，不触及磁盘
+ *   - createReader返回只读设备，按WAV头、临时文件（分段映射）、内存窗口的顺序提供数据，
+ *     直接作为上传的请求体，不再拼出完整的WAV和表单
+ *   - memoryLimit为0时不落盘，与原来整段放在内存中相同
+ * 线程安全：写入（录音线程）与readAt/createReader（管理器线程）可并发
+ */
+class CaptureStore : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureStore(QObject *parent = nullptr);
+    ~CaptureStore();
+
+    /**
+     * 函数名称：`setMemoryLimit`
+     * 功能描述：设置内存窗口上限，下次open时生效
+     * 参数说明：
+     *     - bytes：qint64，字节数，0表示不落盘
+     * 返回值：void
+     */
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const { return m_memoryLimit; }
+
+    /**
+     * 函数名称：`open`
+     * 功能描述：清空上一段录音，开始写入；只支持WriteOnly
+     */
+    bool open(OpenMode mode) override;
+    bool isSequential() const override { return true; }
+
+    /**
+     * 函数名称：`clear`
+     * 功能描述：丢弃已录音频；临时文件在最后一个读取设备释放后删除
+     */
+    void clear();
+
+    /**
+     * 函数名称：`bytesCaptured`/`spilledBytes`
+     * 功能描述：已录音频的总字节数；其中已写入临时文件的字节数
+     */
+    qint64 bytesCaptured() const;
+    qint64 spilledBytes() const;
+
+    /**
+     * 函数名称：`firstWriteTime`
+     * 功能描述：本段录音第一次写入数据的时间（RequestMetrics::now()，steady_clock纳秒），尚未写入时为0
+     */
+    qint64 firstWriteTime() const;
+
+    /**
+     * 函数名称：`readAt`
+     * 功能描述：读取[offset, offset + length)的音频
+     * 参数说明：
+     *     - offset：qint64，起始字节
+     *     - data：char*，输出缓冲区
+     *     - length：qint64，字节数，不得超过bytesCaptured() - offset
+     * 返回值：bool，读取临时文件失败时返回false
+     */
+    bool readAt(qint64 offset, char *data, qint64 length) const;
+
+    /**
+     * 函数名称：`toByteArray`
+     * 功能描述：把全部音频读入内存（内置引擎整句识别需要完整的PCM）
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * 函数名称：`createReader`
+     * 功能描述：创建读取当前全部音频的只读设备，先输出header；之后的写入不影响已创建的设备
+     * 参数说明：
+     *     - header：QByteArray，输出在音频之前的数据（WAV头）
+     *     - parent：QObject*，父对象
+     * 返回值：QIODevice*，已打开、可随机访问，size()为header与音频的总长度
+     */
+    QIODevice *createReader(const QByteArray &header, QObject *parent = nullptr) const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    /**
+     * 函数名称：`spill`
+     * 功能描述：窗口超过上限时把较早的整块写入临时文件（调用方持有锁）
+     */
+    void spill();
+
+private:
+    mutable QMutex m_mutex;
+    QByteArray m_window;                // 尚未落盘的最近音频
+    qint64 m_spilled;                   // 已写入临时文件的字节数，即m_window首字节的位置
+    QSharedPointer<QTemporaryFile> m_spillFile;     // 读取设备共享，全部释放后删除
+    qint64 m_memoryLimit;
+    qint64 m_activeLimit;               // 本段录音生效的上限
+    bool m_spillFailed;                 // 临时文件不可用，本段录音留在内存中
+    qint64 m_firstWriteNs;
+};
+
+#endif // CAPTURESTORE_H
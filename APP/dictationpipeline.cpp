@@ -0,0 +1,309 @@
+#include "dictationpipeline.h"
+#include "enginepipeline.h"
+#include "audiosource.h"
+#include "sessionrecorder.h"
+#include "voicelogging.h"
+#include <QIODevice>
+
+namespace {
+
+// 听写分段的请求ID为"<控件ID>#dictation-<序号>"
+const QString DICTATION_SEGMENT_TAG = QStringLiteral("#dictation-");
+
+} // namespace
+
+DictationPipeline::DictationPipeline(EnginePipeline *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_source(nullptr)
+    , m_device(nullptr)
+    , m_nextSegment(0)
+    , m_nextResult(0)
+    , m_stopping(false)
+    , m_partialMode(PartialStable)
+    , m_partials(false)
+    , m_partialRequestedSample(0)
+    , m_partialInFlight(false)
+    , m_partialSegment(-1)
+{
+}
+
+DictationPipeline::~DictationPipeline()
+{
+    delete m_source;
+}
+
+bool DictationPipeline::isSegmentId(const QString &requestId)
+{
+    return requestId.contains(DICTATION_SEGMENT_TAG);
+}
+
+void DictationPipeline::start(const QString &requestId, AudioSource *source)
+{
+    if (source) {
+        m_device = source->start();
+        if (!m_device) {
+            delete source;
+            emit statusChanged("无法启动音频录制");
+            emit finished(requestId);
+            return;
+        }
+        // 来源在管理器线程中创建，端点检测和分段提交随readyRead在本线程进行
+        m_source = source;
+        connect(m_device, &QIODevice::readyRead, this, &DictationPipeline::onReadyRead);
+    }
+
+    m_endpointer.reset(new Endpointer());
+    m_requestId = requestId;
+    m_segments.clear();
+    m_results.clear();
+    m_nextSegment = 0;
+    m_nextResult = 0;
+    m_stopping = false;
+
+    // 中间结果与分段的最终识别在本线程按提交顺序执行，需要引擎已就绪
+    m_partials = m_partialMode != PartialOff && m_engine->isEnabled();
+    m_partialRequestedSample = 0;
+
+    qCDebug(lcDictation) << "🎤 开始听写，请求ID:" << requestId << "中间结果:" << (m_partials ? m_partialMode : PartialOff);
+    SessionRecorder::event(SessionRecorder::DictationStart, requestId);
+    emit statusChanged("听写中，停顿处自动分段识别...");
+}
+
+void DictationPipeline::stopSource()
+{
+    if (!m_source) {
+        return;
+    }
+    m_source->stop();
+    emit sourceStopped(m_source);
+    delete m_source;
+    m_source = nullptr;
+    m_device = nullptr;
+}
+
+void DictationPipeline::stop()
+{
+    if (!isActive() || m_stopping) {
+        return;
+    }
+
+    stopSource();
+    SessionRecorder::event(SessionRecorder::DictationStop, m_requestId);
+    m_stopping = true;
+    m_endpointer->flush();
+    submitSegments();
+
+    qCDebug(lcDictation) << "🎤 停止听写，分段数:" << m_nextSegment << "在途:" << m_segments.size();
+    if (m_segments.isEmpty()) {
+        deliverSegment(QString(), QString());
+    } else {
+        emit statusChanged("识别中...");
+    }
+}
+
+void DictationPipeline::cancel()
+{
+    if (!isActive()) {
+        return;
+    }
+
+    stopSource();
+    for (auto it = m_segments.constBegin(); it != m_segments.constEnd(); ++it) {
+        m_engine->cancel(it.key());
+    }
+
+    SessionRecorder::event(SessionRecorder::DictationCancel, m_requestId);
+    const QString requestId = m_requestId;
+    m_requestId.clear();
+    m_segments.clear();
+    m_results.clear();
+    m_endpointer.reset();
+
+    qCDebug(lcDictation) << "🎤 取消听写，请求ID:" << requestId;
+    emit statusChanged("听写已取消");
+    emit finished(requestId);
+}
+
+void DictationPipeline::onReadyRead()
+{
+    const QByteArray chunk = m_device->readAll();
+    if (chunk.size() >= 2) {
+        feed(chunk);
+    }
+}
+
+void DictationPipeline::feed(const QByteArray &chunk)
+{
+    SessionRecorder::audio(chunk.constData(), chunk.size());
+    m_endpointer->acceptWaveform(reinterpret_cast<const qint16*>(chunk.constData()), chunk.size() / 2);
+    submitSegments();
+    if (m_partials) {
+        requestPartial();
+    }
+}
+
+void DictationPipeline::submitSegments()
+{
+    Endpointer::Segment segment;
+    while (m_endpointer->popSegment(segment)) {
+        const int index = m_nextSegment++;
+        const QString segmentId = m_requestId + DICTATION_SEGMENT_TAG + QString::number(index);
+        const QByteArray pcm(reinterpret_cast<const char*>(segment.samples.data()),
+                             static_cast<int>(segment.samples.size() * sizeof(qint16)));
+        m_segments.insert(segmentId, index);
+        qCDebug(lcDictation) << "🎤 听写分段" << index << "起点(s):" << segment.startSample / 16000.0
+                             << "时长(ms):" << segment.samples.size() / 16 << "在途分段:" << m_segments.size();
+
+        // 每段独立识别，延迟只取决于分段长度，与听写总时长无关
+        if (m_partials) {
+            QMetaObject::invokeMethod(this, "decodeFinal", Qt::QueuedConnection,
+                                      Q_ARG(QByteArray, pcm), Q_ARG(QString, segmentId), Q_ARG(int, index));
+        } else {
+            emit segmentReady(segmentId, pcm);
+        }
+    }
+}
+
+void DictationPipeline::requestPartial()
+{
+    const qint64 accepted = m_endpointer->samplesAccepted();
+    if (!m_endpointer->inSpeech() || accepted - m_partialRequestedSample < 16 * DICTATION_PARTIAL_INTERVAL) {
+        return;
+    }
+    if (m_partialInFlight) {
+        return;
+    }
+
+    std::vector<int16_t> samples;
+    if (!m_endpointer->currentSegment(samples)) {
+        return;
+    }
+    m_partialInFlight = true;
+    m_partialRequestedSample = accepted;
+    const QByteArray pcm(reinterpret_cast<const char*>(samples.data()),
+                         static_cast<int>(samples.size() * sizeof(int16_t)));
+    QMetaObject::invokeMethod(this, "decodePartial", Qt::QueuedConnection, Q_ARG(QByteArray, pcm),
+                              Q_ARG(QString, m_requestId), Q_ARG(int, m_nextSegment));
+}
+
+bool DictationPipeline::takePartialDelta(QString *committedDelta, QString *tentative)
+{
+    // 定稿部分只会在末尾增长，解码后的文字也只在末尾增长
+    const QString committed = m_engine->decodeTokens(m_partialTracker.committedIds());
+    const QString all = m_engine->decodeTokens(m_partialTracker.allIds());
+    *committedDelta = committed.startsWith(m_partialCommitted) ? committed.mid(m_partialCommitted.size()) : QString();
+    *tentative = all.startsWith(committed) ? all.mid(committed.size()) : QString();
+
+    const bool changed = !committedDelta->isEmpty() || *tentative != m_partialTentative;
+    m_partialCommitted += *committedDelta;
+    m_partialTentative = *tentative;
+    return changed;
+}
+
+void DictationPipeline::decodePartial(const QByteArray &pcm, const QString &requestId, int segment)
+{
+    m_partialInFlight = false;
+    if (requestId != m_requestId || !m_engine->isEnabled() || segment < m_nextResult) {
+        return;
+    }
+    if (segment != m_partialSegment) {
+        m_partialTracker.reset();
+        m_partialSegment = segment;
+        m_partialCommitted.clear();
+        m_partialTentative.clear();
+    }
+
+    m_engine->alignTokens(pcm, m_partialTokens);
+    QString committedDelta;
+    QString tentative;
+    if (m_partialMode == PartialReplace) {
+        // 对照方式：每次整段替换
+        tentative = m_engine->alignedText();
+        if (tentative == m_partialTentative) {
+            return;
+        }
+        m_partialTentative = tentative;
+    } else {
+        m_partialTracker.update(m_partialTokens, pcm.size() / 32);
+        if (!takePartialDelta(&committedDelta, &tentative)) {
+            return;
+        }
+    }
+    emit partialReady(committedDelta, tentative, requestId);
+}
+
+void DictationPipeline::decodeFinal(const QByteArray &pcm, const QString &segmentId, int segment)
+{
+    if (!m_segments.contains(segmentId)) {
+        return;
+    }
+    if (!m_engine->isEnabled()) {
+        emit segmentReady(segmentId, pcm);
+        return;
+    }
+    if (segment != m_partialSegment) {
+        m_partialTracker.reset();
+        m_partialCommitted.clear();
+        m_partialTentative.clear();
+    }
+
+    // 已发出的定稿文字保持不变，其后接上最终结果中时间上在它之后的部分
+    m_engine->alignTokens(pcm, m_partialTokens);
+    QString remaining;
+    if (m_partialMode == PartialReplace) {
+        remaining = m_engine->alignedText();
+    } else {
+        m_partialTracker.finish(m_partialTokens);
+        QString tentative;
+        takePartialDelta(&remaining, &tentative);
+    }
+    const bool hadTentative = !m_partialTentative.isEmpty();
+    m_partialTracker.reset();
+    m_partialSegment = -1;
+    m_partialCommitted.clear();
+    m_partialTentative.clear();
+
+    if (remaining.isEmpty() && hadTentative) {
+        emit partialReady(QString(), QString(), m_requestId);
+    }
+    deliverSegment(segmentId, remaining);
+}
+
+void DictationPipeline::deliverSegment(const QString &segmentId, const QString &text)
+{
+    // 取消后才返回的分段、或超时后又返回的重复结果
+    if (!segmentId.isEmpty()) {
+        auto it = m_segments.find(segmentId);
+        if (it == m_segments.end()) {
+            return;
+        }
+        m_results.insert(it.value(), text);
+        m_segments.erase(it);
+    }
+
+    // 前面的分段未返回时先保存，保证按说话顺序追加
+    while (!m_results.isEmpty() && m_results.firstKey() == m_nextResult) {
+        const QString segmentText = m_results.take(m_nextResult++);
+        if (!segmentText.isEmpty()) {
+            SessionRecorder::result(m_requestId, segmentText);
+            emit textReady(segmentText, m_requestId);
+        }
+    }
+
+    if (m_stopping && m_segments.isEmpty()) {
+        const QString requestId = m_requestId;
+        m_requestId.clear();
+        m_stopping = false;
+        m_endpointer.reset();
+        qCDebug(lcDictation) << "🎤 听写结束，请求ID:" << requestId;
+        emit statusChanged("识别完成");
+        emit finished(requestId);
+    }
+}
+
+void DictationPipeline::failSegment(const QString &segmentId, const QString &error)
+{
+    qCWarning(lcDictation) << "🎤 听写分段识别失败，跳过:" << segmentId << error;
+    deliverSegment(segmentId, QString());
+}
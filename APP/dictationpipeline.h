@@ -0,0 +1,207 @@
+#ifndef DICTATIONPIPELINE_H
+#define DICTATIONPIPELINE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QScopedPointer>
+#include <QString>
+#include <vector>
+#include "endpointer.h"
+#include "stableprefixtracker.h"
+
+class AudioSource;
+class EnginePipeline;
+class QIODevice;
+
+/**
+ * 函数名称：`DictationPipeline`
+ * 功能描述：连续听写：持续录音，按停顿切成分段，每段说完即送去识别（录音不停），结果按分段顺序发出；
+ *           内置引擎就绪时说话过程中重新识别当前分段，按token时间戳提交稳定的前缀
+ * 设计特点：
+ *   - 分段的整句识别经segmentReady交给管理器（引擎调度器或识别服务），结果由管理器调用deliverSegment送回
+ *   - 中间结果和开启中间结果时的最终识别在本线程按提交顺序排队执行，使用EnginePipeline的对齐工作区
+ *   - 免按键模式下不另开设备，由管理器把监听流经feed送入
+ * 线程归属：由VoiceRecognitionManager作为子对象创建，随管理器一起moveToThread到管理器线程；
+ *           听写来源在该线程中启动，端点检测、分段提交和解码都在该线程执行
+ */
+class DictationPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * 中间结果方式，与VoiceRecognitionManager::PartialMode一一对应
+     */
+    enum PartialMode {
+        PartialOff,                     // 不出中间结果，每段说完才出字
+        PartialReplace,                 // 每次重新识别后整段替换
+        PartialStable                   // 按token时间戳提交稳定的前缀，只改写未定稿的尾部
+    };
+
+    /**
+     * 函数名称：`DictationPipeline`
+     * 参数说明：
+     *     - engine：EnginePipeline*，同一线程的内置引擎流水线，用于中间结果的对齐识别
+     *     - parent：QObject*，父对象
+     */
+    explicit DictationPipeline(EnginePipeline *engine, QObject *parent = nullptr);
+    ~DictationPipeline();
+
+    /**
+     * 函数名称：`isSegmentId`
+     * 功能描述：请求ID是否为听写分段（"<控件ID>#dictation-<序号>"）
+     */
+    static bool isSegmentId(const QString &requestId);
+
+    void setPartialMode(PartialMode mode) { m_partialMode = mode; }
+    PartialMode partialMode() const { return m_partialMode; }
+
+    /**
+     * 函数名称：`isActive`
+     * 功能描述：是否正在听写（含停止后等待在途分段）
+     */
+    bool isActive() const { return !m_requestId.isEmpty(); }
+    QString requestId() const { return m_requestId; }
+
+    /**
+     * 函数名称：`isListeningToMonitor`
+     * 功能描述：是否正在从免按键监听流取音频（管理器据此把监听到的音频经feed送入）
+     */
+    bool isListeningToMonitor() const { return isActive() && !m_stopping && !m_source; }
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始听写；来源无法启动时发出statusChanged和finished
+     * 参数说明：
+     *     - requestId：QString，请求ID，用于标识目标控件
+     *     - source：AudioSource*，已准备好的听写来源，转移所有权；为nullptr时由feed送入监听流
+     * 返回值：void
+     */
+    void start(const QString &requestId, AudioSource *source);
+
+    /**
+     * 函数名称：`stop`
+     * 功能描述：停止录音，最后一段送去识别，全部分段的结果发出后发finished
+     */
+    void stop();
+
+    /**
+     * 函数名称：`cancel`
+     * 功能描述：停止录音，撤销引擎中排队的分段，丢弃尚未返回的结果
+     */
+    void cancel();
+
+    /**
+     * 函数名称：`feed`
+     * 功能描述：听写音频送入端点检测，切出的分段立即提交识别
+     * 参数说明：
+     *     - chunk：QByteArray，16kHz单声道16位PCM
+     * 返回值：void
+     */
+    void feed(const QByteArray &chunk);
+
+    /**
+     * 函数名称：`deliverSegment`
+     * 功能描述：某个分段的识别结果返回：按分段顺序发出，结束时发finished
+     * 参数说明：
+     *     - segmentId：QString，分段的请求ID，为空时只检查是否已全部返回
+     *     - text：QString，识别文本，失败时为空
+     * 返回值：void
+     */
+    void deliverSegment(const QString &segmentId, const QString &text);
+
+    /**
+     * 函数名称：`failSegment`
+     * 功能描述：分段识别失败：记为空结果，不打断听写
+     */
+    void failSegment(const QString &segmentId, const QString &error);
+
+signals:
+    /**
+     * 信号名称：`segmentReady`
+     * 功能描述：一个分段需要整句识别，管理器提交给引擎调度器或识别服务，结果经deliverSegment送回
+     */
+    void segmentReady(const QString &segmentId, const QByteArray &pcm);
+
+    void textReady(const QString &text, const QString &requestId);
+    void partialReady(const QString &committedText, const QString &tentativeText, const QString &requestId);
+    void finished(const QString &requestId);
+    void statusChanged(const QString &status);
+
+    /**
+     * 信号名称：`sourceStopped`
+     * 功能描述：听写来源已停止、即将释放，管理器据此汇总采集健康状况
+     */
+    void sourceStopped(AudioSource *source);
+
+private slots:
+    void onReadyRead();
+
+    /**
+     * 函数名称：`decodePartial`
+     * 功能描述：重新识别正在进行的分段，更新并发出中间结果
+     * 参数说明：
+     *     - pcm：QByteArray，分段起点至今的音频
+     *     - requestId：QString，听写的请求ID，听写已结束或已重新开始时丢弃
+     *     - segment：int，分段序号
+     * 返回值：void
+     */
+    void decodePartial(const QByteArray &pcm, const QString &requestId, int segment);
+
+    /**
+     * 函数名称：`decodeFinal`
+     * 功能描述：识别已结束的分段：与之前的中间结果排在同一队列，按时间戳接在已定稿部分之后
+     * 参数说明：
+     *     - pcm：QByteArray，分段音频
+     *     - segmentId：QString，分段的请求ID
+     *     - segment：int，分段序号
+     * 返回值：void
+     */
+    void decodeFinal(const QByteArray &pcm, const QString &segmentId, int segment);
+
+private:
+    void stopSource();
+    void submitSegments();
+
+    /**
+     * 函数名称：`requestPartial`
+     * 功能描述：说话中且距上次已过DICTATION_PARTIAL_INTERVAL时，取当前分段排队重新识别；
+     *           上一次还没算完则跳过，识别慢时自动降低频率
+     */
+    void requestPartial();
+
+    /**
+     * 函数名称：`takePartialDelta`
+     * 功能描述：按m_partialTracker的当前状态计算新定稿的文字和未定稿的文字，并记为已发出
+     * 返回值：bool，与上次发出的内容相比是否有变化
+     */
+    bool takePartialDelta(QString *committedDelta, QString *tentative);
+
+    EnginePipeline *m_engine;
+    QString m_requestId;                // 听写目标，为空表示未在听写
+    AudioSource *m_source;              // 听写录音，免按键模式下为nullptr
+    QIODevice *m_device;
+    QScopedPointer<Endpointer> m_endpointer;
+    QHash<QString, int> m_segments;     // 在途分段：请求ID → 序号
+    QMap<int, QString> m_results;       // 已返回、等待前面分段的结果
+    int m_nextSegment;                  // 下一个分段的序号
+    int m_nextResult;                   // 下一个要发出的结果序号
+    bool m_stopping;                    // 已停止录音，等待在途分段
+
+    // 中间结果（内置引擎）
+    PartialMode m_partialMode;
+    bool m_partials;                    // 本次听写是否出中间结果
+    qint64 m_partialRequestedSample;    // 上次请求中间结果时端点检测已接收的采样数
+    bool m_partialInFlight;             // 已排队、尚未算完的中间结果请求
+    StablePrefixTracker m_partialTracker;
+    std::vector<StablePrefixTracker::Token> m_partialTokens;
+    int m_partialSegment;               // m_partialTracker对应的分段序号，-1表示无
+    QString m_partialCommitted;         // 当前分段已发出的定稿文字
+    QString m_partialTentative;         // 当前分段已发出的未定稿文字
+
+    static const int DICTATION_PARTIAL_INTERVAL = 500;  // 中间结果的识别间隔(毫秒录音)
+};
+
+#endif // DICTATIONPIPELINE_H
@@ -0,0 +1,352 @@
+#include "commandgrammar.h"
+#include "enginekernels.h"
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int MAX_EXPANDED_PHRASES = 4096;      // 单条语法展开后的短语数上限
+const QChar WORD_BOUNDARY(0x2581);          // SentencePiece的词首标记"▁"
+const float NEG_INF = -std::numeric_limits<float>::infinity();
+
+/**
+ * 函数名称：`isFiller`
+ * 功能描述：token是否只由标点、空白或"▁"组成，这类token与blank同等看待
+ */
+bool isFiller(const QString &token)
+{
+    if (token.isEmpty() || token.startsWith("<|")) {
+        return false;
+    }
+    for (const QChar &c : token) {
+        if (c != WORD_BOUNDARY && !c.isPunct() && !c.isSpace()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 函数名称：`normalizeForMatch`
+ * 功能描述：编辑距离比较前统一大小写并去掉空白和标点
+ */
+QString normalizeForMatch(const QString &text)
+{
+    QString normalized;
+    for (const QChar &c : text.toLower()) {
+        if (!c.isSpace() && !c.isPunct()) {
+            normalized += c;
+        }
+    }
+    return normalized;
+}
+
+int editDistance(const QString &a, const QString &b)
+{
+    std::vector<int> previous(b.size() + 1);
+    std::vector<int> current(b.size() + 1);
+    for (int j = 0; j <= b.size(); ++j) {
+        previous[j] = j;
+    }
+    for (int i = 1; i <= a.size(); ++i) {
+        current[0] = i;
+        for (int j = 1; j <= b.size(); ++j) {
+            const int substitute = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            current[j] = std::min(substitute, std::min(previous[j], current[j - 1]) + 1);
+        }
+        previous.swap(current);
+    }
+    return previous[b.size()];
+}
+
+} // namespace
+
+CommandGrammar::CommandGrammar()
+{
+}
+
+bool CommandGrammar::compile(const QStringList &patterns, const QStringList &tokens, int blankId,
+                             QString *errorMessage)
+{
+    m_nodes.clear();
+    m_fillers.clear();
+    m_phrases.clear();
+
+    // 小写token到ID的映射，大小写不同的同名token取ID较小者
+    QHash<QString, int> vocabulary;
+    int maxTokenLength = 1;
+    for (int id = 0; id < tokens.size(); ++id) {
+        const QString &token = tokens.at(id);
+        if (id == blankId || isFiller(token)) {
+            m_fillers.push_back(id);
+            continue;
+        }
+        if (token.startsWith('<') && token.endsWith('>')) {
+            continue;           // 标签和<unk>等特殊token不参与切分
+        }
+        const QString key = token.toLower();
+        if (!vocabulary.contains(key)) {
+            vocabulary.insert(key, id);
+            maxTokenLength = std::max(maxTokenLength, key.size());
+        }
+    }
+    if (std::find(m_fillers.begin(), m_fillers.end(), blankId) == m_fillers.end()) {
+        m_fillers.push_back(blankId);
+    }
+
+    Node root = {-1, -1, -1};
+    m_nodes.push_back(root);
+    QHash<QPair<int, int>, int> children;      // (父节点, token) -> 子节点
+    std::vector<int> ids;
+    QStringList phrases;
+    for (const QString &pattern : patterns) {
+        const QStringList expanded = expand(pattern, errorMessage);
+        if (expanded.isEmpty()) {
+            m_nodes.clear();
+            return false;
+        }
+        for (const QString &phrase : expanded) {
+            if (phrases.contains(phrase)) {
+                continue;
+            }
+            if (!tokenize(phrase, vocabulary, maxTokenLength, ids)) {
+                if (errorMessage) {
+                    *errorMessage = QString("短语\"%1\"含有词表外的字符").arg(phrase);
+                }
+                m_nodes.clear();
+                return false;
+            }
+
+            int node = 0;
+            for (int token : ids) {
+                const QPair<int, int> key(node, token);
+                auto it = children.constFind(key);
+                if (it == children.constEnd()) {
+                    Node child = {token, node, -1};
+                    m_nodes.push_back(child);
+                    it = children.insert(key, static_cast<int>(m_nodes.size()) - 1);
+                }
+                node = it.value();
+            }
+            // 切分相同的短语（如只差标点）只保留第一个
+            if (m_nodes[node].phrase < 0) {
+                m_nodes[node].phrase = phrases.size();
+                phrases.append(phrase);
+            }
+        }
+    }
+
+    if (phrases.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = "词表为空";
+        }
+        m_nodes.clear();
+        return false;
+    }
+    m_phrases = phrases;
+    return true;
+}
+
+QStringList CommandGrammar::expand(const QString &pattern, QString *errorMessage)
+{
+    QStringList results(QString(""));
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == ')' || c == ']') {
+            if (errorMessage) {
+                *errorMessage = QString("语法\"%1\"括号不匹配").arg(pattern);
+            }
+            return QStringList();
+        }
+        if (c != '(' && c != '[') {
+            for (QString &result : results) {
+                result += c;
+            }
+            continue;
+        }
+
+        const int close = pattern.indexOf(c == '(' ? ')' : ']', i + 1);
+        const QString inner = close < 0 ? QString() : pattern.mid(i + 1, close - i - 1);
+        if (close < 0 || inner.contains('(') || inner.contains('[')) {
+            if (errorMessage) {
+                *errorMessage = QString("语法\"%1\"括号不匹配或嵌套").arg(pattern);
+            }
+            return QStringList();
+        }
+        QStringList alternatives = inner.split('|');
+        if (c == '[') {
+            alternatives.append(QString());
+        }
+        if (results.size() * alternatives.size() > MAX_EXPANDED_PHRASES) {
+            if (errorMessage) {
+                *errorMessage = QString("语法\"%1\"展开后超过%2条").arg(pattern).arg(MAX_EXPANDED_PHRASES);
+            }
+            return QStringList();
+        }
+
+        QStringList combined;
+        for (const QString &result : results) {
+            for (const QString &alternative : alternatives) {
+                combined.append(result + alternative);
+            }
+        }
+        results = combined;
+        i = close;
+    }
+
+    QStringList phrases;
+    for (const QString &result : results) {
+        const QString phrase = result.simplified();
+        if (!phrase.isEmpty() && !phrases.contains(phrase)) {
+            phrases.append(phrase);
+        }
+    }
+    if (phrases.isEmpty() && errorMessage) {
+        *errorMessage = QString("语法\"%1\"没有可用的短语").arg(pattern);
+    }
+    return phrases;
+}
+
+bool CommandGrammar::tokenize(const QString &phrase, const QHash<QString, int> &vocabulary, int maxTokenLength,
+                              std::vector<int> &ids)
+{
+    ids.clear();
+    for (const QString &word : phrase.toLower().split(' ', QString::SkipEmptyParts)) {
+        // 拉丁字母开头的词按SentencePiece的习惯带词首标记，中日韩文字逐字切分
+        QString text = word;
+        if (text.at(0).unicode() < 0x2E80) {
+            text.prepend(WORD_BOUNDARY);
+        }
+
+        int position = 0;
+        while (position < text.size()) {
+            int length = std::min(maxTokenLength, text.size() - position);
+            for (; length > 0; --length) {
+                auto it = vocabulary.constFind(text.mid(position, length));
+                if (it != vocabulary.constEnd()) {
+                    ids.push_back(it.value());
+                    break;
+                }
+            }
+            if (length == 0) {
+                // 标点和单独的词首标记按blank处理，直接跳过；其余字符无法切分
+                if (text.at(position) != WORD_BOUNDARY && !text.at(position).isPunct()) {
+                    return false;
+                }
+                length = 1;
+            }
+            position += length;
+        }
+    }
+    return !ids.empty();
+}
+
+CommandGrammar::Match CommandGrammar::matchText(const QStringList &phrases, const QString &text)
+{
+    Match match;
+    const QString normalized = normalizeForMatch(text);
+    int bestDistance = std::numeric_limits<int>::max();
+    for (int i = 0; i < phrases.size(); ++i) {
+        const QString candidate = normalizeForMatch(phrases.at(i));
+        const int distance = editDistance(normalized, candidate);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            const int longest = std::max(normalized.size(), candidate.size());
+            match.index = i;
+            match.text = phrases.at(i);
+            match.confidence = longest > 0 ? 1.0f - static_cast<float>(distance) / longest : 0.0f;
+        }
+    }
+    return match;
+}
+
+CommandGrammar::Search::Search()
+    : m_grammar(nullptr)
+    , m_freeScore(0.0f)
+    , m_frames(0)
+{
+}
+
+void CommandGrammar::Search::reset(const CommandGrammar *grammar)
+{
+    m_grammar = grammar;
+    m_freeScore = 0.0f;
+    m_frames = 0;
+    const size_t nodes = grammar ? grammar->m_nodes.size() : 0;
+    m_blank.assign(nodes, NEG_INF);
+    m_emit.assign(nodes, NEG_INF);
+    m_nextBlank.resize(nodes);
+    m_nextEmit.resize(nodes);
+    if (nodes > 0) {
+        m_blank[0] = 0.0f;
+    }
+}
+
+void CommandGrammar::Search::advance(const float *logits, int rows, int vocab)
+{
+    if (!m_grammar || m_blank.empty()) {
+        return;
+    }
+    const std::vector<Node> &nodes = m_grammar->m_nodes;
+    const std::vector<int> &fillers = m_grammar->m_fillers;
+    const int count = static_cast<int>(nodes.size());
+
+    for (int r = 0; r < rows; ++r) {
+        const float *row = logits + static_cast<size_t>(r) * vocab;
+        const float logZ = EngineKernels::logSumExp(row, vocab);
+        m_freeScore += row[EngineKernels::argmax(row, vocab)] - logZ;
+
+        float filler = NEG_INF;
+        for (int id : fillers) {
+            filler = std::max(filler, row[id]);
+        }
+        filler -= logZ;
+
+        // CTC的Viterbi递推：停留在节点上（blank/标点，或重复同一token），或从父节点前进一个token；
+        // 父子token相同时中间必须隔一个blank
+        m_nextBlank[0] = m_blank[0] + filler;
+        m_nextEmit[0] = NEG_INF;
+        for (int n = 1; n < count; ++n) {
+            const Node &node = nodes[n];
+            m_nextBlank[n] = std::max(m_blank[n], m_emit[n]) + filler;
+            float from = std::max(m_emit[n], m_blank[node.parent]);
+            if (nodes[node.parent].token != node.token) {
+                from = std::max(from, m_emit[node.parent]);
+            }
+            m_nextEmit[n] = from + (row[node.token] - logZ);
+        }
+        m_blank.swap(m_nextBlank);
+        m_emit.swap(m_nextEmit);
+    }
+    m_frames += rows;
+}
+
+CommandGrammar::Match CommandGrammar::Search::best() const
+{
+    Match match;
+    if (!m_grammar || m_frames == 0) {
+        return match;
+    }
+    const std::vector<Node> &nodes = m_grammar->m_nodes;
+    float bestScore = NEG_INF;
+    for (size_t n = 1; n < nodes.size(); ++n) {
+        if (nodes[n].phrase < 0) {
+            continue;
+        }
+        const float score = std::max(m_blank[n], m_emit[n]);
+        if (score > bestScore) {
+            bestScore = score;
+            match.index = nodes[n].phrase;
+        }
+    }
+    // 帧数少于短语的token数时所有终点都不可达
+    if (match.index < 0 || std::isinf(bestScore)) {
+        return Match();
+    }
+    match.text = m_grammar->m_phrases.at(match.index);
+    match.score = bestScore;
+    match.confidence = std::min(1.0f, std::exp((bestScore - m_freeScore) / m_frames));
+    return match;
+}
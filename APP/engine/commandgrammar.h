@@ -0,0 +1,149 @@
+#ifndef COMMANDGRAMMAR_H
+#define COMMANDGRAMMAR_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * 函数名称：`CommandGrammar`
+ * 功能描述：命令/取值类输入框的受限词表：把允许的短语切分为token序列并编译成前缀树，
+ *           识别时CTC解码只在前缀树内搜索，直接得到最匹配的短语和置信度，不再自由解码后再纠正
+ * 设计特点：
+ *   - 短语支持简单语法：(a|b)为多选一，[a]为可省略，如"(打开|关闭)[一下]灯光"，展开后共用前缀
+ *   - 切分按词表最长匹配，英文单词前加"▁"并忽略大小写；标点和单独的"▁"与blank同等看待，
+ *     模型输出的标点（ITN）不会拉低匹配分数
+ *   - 编译结果只读，可被多个识别会话共享；每个会话的搜索状态保存在Search中，逐帧推进，
+ *     分块识别时录音过程中即已算完，松键后只需处理最后一块
+ */
+class CommandGrammar
+{
+public:
+    /**
+     * 匹配结果
+     */
+    struct Match {
+        int index = -1;                 // 短语在phrases()中的下标，-1表示无结果
+        QString text;                   // 匹配的短语（展开后的原文）
+        float score = 0.0f;             // 最优对齐路径的对数概率
+        float confidence = 0.0f;        // 与不受限最优路径的逐帧平均概率之比，(0, 1]
+
+        bool isValid() const { return index >= 0; }
+    };
+
+    CommandGrammar();
+
+    /**
+     * 函数名称：`compile`
+     * 功能描述：展开短语并按模型词表切分，编译为前缀树
+     * 参数说明：
+     *     - patterns：QStringList，允许的短语或语法
+     *     - tokens：QStringList，模型词表（SenseVoiceModel::tokens()）
+     *     - blankId：int，CTC blank的token ID
+     *     - errorMessage：QString*，失败时写入错误信息，可为nullptr
+     * 返回值：bool，是否编译成功（任一短语无法切分即失败）
+     */
+    bool compile(const QStringList &patterns, const QStringList &tokens, int blankId,
+                 QString *errorMessage = nullptr);
+
+    bool isCompiled() const { return !m_phrases.isEmpty(); }
+    const QStringList &phrases() const { return m_phrases; }
+    int nodeCount() const { return static_cast<int>(m_nodes.size()); }
+
+    /**
+     * 函数名称：`expand`
+     * 功能描述：展开短语中的(a|b)和[a]，不支持嵌套
+     * 参数说明：
+     *     - pattern：QString，短语或语法
+     *     - errorMessage：QString*，括号不匹配或展开过多时写入错误信息，可为nullptr
+     * 返回值：QStringList，展开后的短语，失败时为空
+     */
+    static QStringList expand(const QString &pattern, QString *errorMessage = nullptr);
+
+    /**
+     * 函数名称：`matchText`
+     * 功能描述：按字符编辑距离把一段已识别的文本对应到最接近的短语，
+     *           用于识别服务等无法受限解码的路径
+     * 参数说明：
+     *     - phrases：QStringList，展开后的短语
+     *     - text：QString，识别文本
+     * 返回值：Match，confidence为1 - 编辑距离/较长者长度，score为0
+     */
+    static Match matchText(const QStringList &phrases, const QString &text);
+
+    /**
+     * 函数名称：`Search`
+     * 功能描述：一句话的受限CTC搜索状态（Viterbi），逐帧推进，跨句复用
+     * 线程安全：只能在一个线程中使用
+     */
+    class Search
+    {
+    public:
+        Search();
+
+        /**
+         * 函数名称：`reset`
+         * 功能描述：开始新的一句话，状态数组只在前缀树变大时扩容
+         * 参数说明：
+         *     - grammar：const CommandGrammar*，已编译的词表，不转移所有权，使用期间须保持有效
+         * 返回值：void
+         */
+        void reset(const CommandGrammar *grammar);
+
+        /**
+         * 函数名称：`advance`
+         * 功能描述：送入若干帧CTC logits（不含查询帧）
+         * 参数说明：
+         *     - logits：const float*，[rows, vocab]，未归一化
+         *     - rows：int，帧数
+         *     - vocab：int，词表大小
+         * 返回值：void
+         */
+        void advance(const float *logits, int rows, int vocab);
+
+        /**
+         * 函数名称：`best`
+         * 功能描述：当前得分最高的完整短语，尚无帧时无结果
+         */
+        Match best() const;
+
+        int frames() const { return m_frames; }
+
+    private:
+        const CommandGrammar *m_grammar;
+        std::vector<float> m_blank;     // 各节点以blank（或标点）结尾的最优得分
+        std::vector<float> m_emit;      // 各节点以自身token结尾的最优得分
+        std::vector<float> m_nextBlank;
+        std::vector<float> m_nextEmit;
+        float m_freeScore;              // 不受限时的最优路径得分（逐帧取最大）
+        int m_frames;
+    };
+
+private:
+    struct Node {
+        int token;                      // 到达本节点的token，根节点为-1
+        int parent;                     // 父节点下标，总小于本节点下标
+        int phrase;                     // 在此结束的短语下标，-1表示非终点
+    };
+
+    /**
+     * 函数名称：`tokenize`
+     * 功能描述：按词表最长匹配切分短语
+     * 参数说明：
+     *     - phrase：QString，短语
+     *     - vocabulary：const QHash<QString, int>&，小写token到ID的映射
+     *     - maxTokenLength：int，最长token的字符数
+     *     - ids：std::vector<int>&，输出的token序列
+     * 返回值：bool，是否切分成功
+     */
+    static bool tokenize(const QString &phrase, const QHash<QString, int> &vocabulary, int maxTokenLength,
+                         std::vector<int> &ids);
+
+private:
+    std::vector<Node> m_nodes;          // 0为根节点，父节点总在子节点之前
+    std::vector<int> m_fillers;         // blank、标点和单独的"▁"
+    QStringList m_phrases;
+};
+
+#endif // COMMANDGRAMMAR_H
@@ -0,0 +1,87 @@
+#include "cpufeatures.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPUFEATURES_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(CPUFEATURES_X86)
+
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<unsigned>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures detect()
+{
+    CpuFeatures features;
+    unsigned regs[4] = {0, 0, 0, 0};
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    if (maxLeaf < 7) {
+        return features;
+    }
+
+    // 操作系统须通过XSAVE保存YMM（位1-2）和ZMM/opmask（位5-7）状态
+    cpuid(1, 0, regs);
+    const bool osxsave = (regs[2] >> 27) & 1;
+    const bool fma = (regs[2] >> 12) & 1;
+    if (!osxsave) {
+        return features;
+    }
+    const unsigned long long xcr0 = xgetbv0();
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    cpuid(7, 0, regs);
+    const unsigned ebx = regs[1];
+    const unsigned ecx = regs[2];
+    features.avx2 = ymmState && ((ebx >> 5) & 1);
+    features.fma = ymmState && fma;
+    features.avx512f = zmmState && ((ebx >> 16) & 1);
+    features.avx512bw = features.avx512f && ((ebx >> 30) & 1);
+    features.avx512vnni = features.avx512bw && ((ecx >> 11) & 1);
+    return features;
+}
+
+#else
+
+CpuFeatures detect()
+{
+    return CpuFeatures();
+}
+
+#endif
+
+} // namespace
+
+const CpuFeatures &CpuFeatures::host()
+{
+    static const CpuFeatures features = detect();
+    return features;
+}
@@ -0,0 +1,28 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+/**
+ * 函数名称：`CpuFeatures`
+ * 功能描述：运行时检测CPU指令集，推理内核据此选择实现
+ * 设计特点：
+ *   - 同时检查CPUID和操作系统是否保存对应寄存器状态（XGETBV），避免在不支持AVX-512的系统上误用
+ *   - 非x86平台全部为false，只使用通用实现
+ *   - 不依赖Qt，检测结果进程内只计算一次
+ */
+struct CpuFeatures {
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512bw = false;              // 8/16位整数运算，int8内核的AVX-512版本需要
+    bool avx512vnni = false;            // VPDPBUSD，u8×s8点积累加
+
+    /**
+     * 函数名称：`host`
+     * 功能描述：本机CPU的检测结果
+     * 参数说明：无
+     * 返回值：const CpuFeatures&
+     */
+    static const CpuFeatures &host();
+};
+
+#endif // CPUFEATURES_H
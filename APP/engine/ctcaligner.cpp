@@ -0,0 +1,93 @@
+#include "ctcaligner.h"
+#include <algorithm>
+#include <limits>
+
+bool CtcAligner::align(const float *logProbs, int frames, int vocab, const int *targets, int count, int blank,
+                       std::vector<int> &alignment, std::vector<TokenSpan> *spans)
+{
+    alignment.clear();
+    if (spans) {
+        spans->clear();
+    }
+
+    // 相邻重复的token之间必须隔一个blank
+    int required = count;
+    for (int i = 1; i < count; ++i) {
+        required += targets[i] == targets[i - 1] ? 1 : 0;
+    }
+    if (frames <= 0 || frames < required) {
+        return false;
+    }
+
+    const int states = 2 * count + 1;
+    m_labels.resize(states);
+    for (int s = 0; s < states; ++s) {
+        m_labels[s] = (s & 1) ? targets[s / 2] : blank;
+    }
+
+    const float negInf = -std::numeric_limits<float>::infinity();
+    m_score.assign(states, negInf);
+    m_nextScore.resize(states);
+    m_backpointers.assign(static_cast<size_t>(frames) * states, 0);
+
+    m_score[0] = logProbs[blank];
+    if (states > 1) {
+        m_score[1] = logProbs[m_labels[1]];
+    }
+
+    for (int t = 1; t < frames; ++t) {
+        const float *row = logProbs + static_cast<size_t>(t) * vocab;
+        uint8_t *back = m_backpointers.data() + static_cast<size_t>(t) * states;
+        for (int s = 0; s < states; ++s) {
+            // 与Python版相同的取舍：得分相同时优先停留，其次前进一步
+            float best = m_score[s];
+            uint8_t step = 0;
+            if (s >= 1 && m_score[s - 1] > best) {
+                best = m_score[s - 1];
+                step = 1;
+            }
+            if (s >= 2 && m_labels[s] != m_labels[s - 2] && m_score[s - 2] > best) {
+                best = m_score[s - 2];
+                step = 2;
+            }
+            m_nextScore[s] = best + row[m_labels[s]];
+            back[s] = step;
+        }
+        m_score.swap(m_nextScore);
+    }
+
+    // 结束于最后一个token或其后的blank
+    int state = states - 1;
+    if (states >= 2 && m_score[states - 2] >= m_score[states - 1]) {
+        state = states - 2;
+    }
+    if (m_score[state] == negInf) {
+        return false;
+    }
+
+    m_path.resize(frames);
+    for (int t = frames - 1; t >= 0; --t) {
+        m_path[t] = state;
+        state -= m_backpointers[static_cast<size_t>(t) * states + state];
+    }
+
+    alignment.resize(frames);
+    for (int t = 0; t < frames; ++t) {
+        alignment[t] = m_labels[m_path[t]];
+    }
+    if (spans) {
+        spans->resize(count);
+        for (int t = 0; t < frames; ++t) {
+            const int s = m_path[t];
+            if (s & 1) {
+                TokenSpan &span = (*spans)[s / 2];
+                if (t == 0 || m_path[t - 1] != s) {
+                    span.token = m_labels[s];
+                    span.startFrame = t;
+                }
+                span.endFrame = t + 1;
+            }
+        }
+    }
+    return true;
+}
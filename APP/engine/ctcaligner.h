@@ -0,0 +1,54 @@
+#ifndef CTCALIGNER_H
+#define CTCALIGNER_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * 函数名称：`CtcAligner`
+ * 功能描述：CTC强制对齐（utils/ctc_alignment.py中ctc_forced_align的C++实现）：
+ *           给定逐帧输出和已知的token序列，求概率最大的对齐路径，得到每个token占据的帧
+ * 设计特点：
+ *   - 扩展序列为blank, t1, blank, t2, ..., blank，每帧可停留、前进一步，或在相邻token不同时跳过中间的blank
+ *   - 每条路径每帧恰好取一个标签，逐帧减去常数不改变最优路径，因此可直接传入logits，不必先做log_softmax
+ *   - 回溯指针每个状态1字节，临时内存跨调用复用
+ * 线程安全：只能在一个线程中使用
+ */
+class CtcAligner
+{
+public:
+    /**
+     * 一个token的对齐结果，帧区间为[startFrame, endFrame)
+     */
+    struct TokenSpan {
+        int token = 0;
+        int startFrame = 0;
+        int endFrame = 0;
+    };
+
+    /**
+     * 函数名称：`align`
+     * 功能描述：强制对齐
+     * 参数说明：
+     *     - logProbs：const float*，逐帧输出 [frames, vocab]，log概率或logits
+     *     - frames：int，帧数
+     *     - vocab：int，词表大小
+     *     - targets：const int*，token序列，不含blank
+     *     - count：int，token数
+     *     - blank：int，blank的ID
+     *     - alignment：std::vector<int>&，输出每帧的标签（blank或token），与Python版的返回值相同
+     *     - spans：std::vector<TokenSpan>*，输出每个token的帧区间，可为nullptr
+     * 返回值：bool，帧数不足以容纳token序列（含相邻重复token之间必需的blank）时返回false
+     */
+    bool align(const float *logProbs, int frames, int vocab, const int *targets, int count, int blank,
+               std::vector<int> &alignment, std::vector<TokenSpan> *spans = nullptr);
+
+private:
+    std::vector<int> m_labels;          // 扩展序列
+    std::vector<float> m_score;         // 当前帧各状态的最优得分
+    std::vector<float> m_nextScore;
+    std::vector<uint8_t> m_backpointers; // [frames, states]，前驱状态的回退步数0/1/2
+    std::vector<int> m_path;            // 每帧所在状态
+};
+
+#endif // CTCALIGNER_H
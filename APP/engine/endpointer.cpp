@@ -0,0 +1,144 @@
+#include "endpointer.h"
+#include <algorithm>
+
+namespace {
+
+const int FORCED_CUT_SEARCH_MS = 1000;      // 强制切分时在最近多长时间内找能量最低的帧
+
+} // namespace
+
+Endpointer::Endpointer()
+    : Endpointer(Options())
+{
+}
+
+Endpointer::Endpointer(const Options &options)
+    : m_options(options)
+    , m_frameLength(options.sampleRate * options.frameMs / 1000)
+    , m_paddingSamples(options.sampleRate * options.paddingMs / 1000)
+    , m_noiseFloor(options.frameMs, 1.0f, NoiseFloor::MIN_DB)
+{
+    // 保留的静音按帧对齐，切分点都落在帧边界上
+    m_paddingSamples -= m_paddingSamples % m_frameLength;
+    reset();
+}
+
+void Endpointer::reset()
+{
+    m_buffer.clear();
+    m_frameEnergy.clear();
+    m_bufferStart = 0;
+    m_nextFrame = 0;
+    m_noiseFloor.reset();
+    m_inSegment = false;
+    m_segmentStart = 0;
+    m_lastSpeechEnd = 0;
+    m_speechFrames = 0;
+    m_silenceFrames = 0;
+    m_segments.clear();
+}
+
+void Endpointer::acceptWaveform(const int16_t *samples, int count)
+{
+    m_buffer.insert(m_buffer.end(), samples, samples + count);
+    while (m_nextFrame + m_frameLength <= samplesAccepted()) {
+        const int64_t start = m_nextFrame;
+        m_nextFrame += m_frameLength;
+        processFrame(start);
+    }
+}
+
+void Endpointer::flush()
+{
+    if (m_inSegment) {
+        finishSegment(std::min(m_lastSpeechEnd + m_paddingSamples, m_nextFrame));
+    }
+}
+
+bool Endpointer::popSegment(Segment &segment)
+{
+    if (m_segments.empty()) {
+        return false;
+    }
+    segment.samples.swap(m_segments.front().samples);
+    segment.startSample = m_segments.front().startSample;
+    m_segments.pop_front();
+    return true;
+}
+
+bool Endpointer::currentSegment(std::vector<int16_t> &samples) const
+{
+    if (!m_inSegment) {
+        return false;
+    }
+    samples.assign(m_buffer.begin() + (m_segmentStart - m_bufferStart), m_buffer.end());
+    return true;
+}
+
+void Endpointer::processFrame(int64_t start)
+{
+    const float energy = EnergyFramer::energyDb(m_buffer.data() + (start - m_bufferStart), m_frameLength);
+    m_frameEnergy.push_back(energy);
+    const float noiseFloor = m_noiseFloor.update(energy);
+
+    const int64_t end = start + m_frameLength;
+    if (energy > noiseFloor + m_options.speechMarginDb) {
+        if (!m_inSegment) {
+            m_inSegment = true;
+            m_segmentStart = std::max(m_bufferStart, start - m_paddingSamples);
+            m_speechFrames = 0;
+        }
+        ++m_speechFrames;
+        m_lastSpeechEnd = end;
+        m_silenceFrames = 0;
+    } else if (m_inSegment) {
+        ++m_silenceFrames;
+        if (m_silenceFrames * m_options.frameMs >= m_options.minSilenceMs) {
+            finishSegment(std::min(m_lastSpeechEnd + m_paddingSamples, end));
+        }
+    }
+
+    // 一直不停顿：在最近1秒内能量最低的帧之后切开，后半截作为下一段的开头
+    if (m_inSegment && (end - m_segmentStart) * 1000 >= static_cast<int64_t>(m_options.maxSegmentMs) * m_options.sampleRate) {
+        const int searchFrames = std::min(FORCED_CUT_SEARCH_MS / m_options.frameMs,
+                                          static_cast<int>(m_frameEnergy.size()) - 1);
+        const int quietest = EnergyFramer::quietestFrame(m_frameEnergy, searchFrames);
+        const int64_t cut = m_bufferStart + static_cast<int64_t>(quietest + 1) * m_frameLength;
+        const int remainderFrames = static_cast<int>((end - cut) / m_frameLength);
+        finishSegment(cut);
+        m_inSegment = remainderFrames > 0;
+        m_segmentStart = cut;
+        m_speechFrames = remainderFrames;
+    }
+
+    if (!m_inSegment) {
+        discardBefore(end - m_paddingSamples);
+    }
+}
+
+void Endpointer::finishSegment(int64_t end)
+{
+    if (m_speechFrames * m_options.frameMs >= m_options.minSpeechMs && end > m_segmentStart) {
+        Segment segment;
+        segment.startSample = m_segmentStart;
+        segment.samples.assign(m_buffer.begin() + (m_segmentStart - m_bufferStart),
+                               m_buffer.begin() + (end - m_bufferStart));
+        m_segments.push_back(std::move(segment));
+    }
+    m_inSegment = false;
+    m_speechFrames = 0;
+    m_silenceFrames = 0;
+    discardBefore(end);
+}
+
+void Endpointer::discardBefore(int64_t position)
+{
+    const int64_t drop = std::min(position, m_nextFrame) - m_bufferStart;
+    const int64_t frames = drop / m_frameLength;
+    if (frames <= 0) {
+        return;
+    }
+    m_buffer.erase(m_buffer.begin(), m_buffer.begin() + frames * m_frameLength);
+    m_frameEnergy.erase(m_frameEnergy.begin(), m_frameEnergy.begin() + frames);
+    m_bufferStart += frames * m_frameLength;
+}
@@ -0,0 +1,126 @@
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include "frameenergy.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * 函数名称：`Endpointer`
+ * 功能描述：连续听写的端点检测：麦克风音频逐块送入，按停顿切成一段段语音，
+ *           每段说完即可送去识别，录音继续进行
+ * 设计特点：
+ *   - 10ms帧的对数能量与自适应噪声底比较判断语音/静音，不依赖模型，开销可忽略
+ *   - 停顿超过minSilenceMs切分，分段首尾各保留paddingMs静音；语音不足minSpeechMs的分段（咳嗽、键盘声）丢弃
+ *   - 一直不停顿时，分段达到maxSegmentMs后在最近1秒内能量最低的位置强制切分
+ *   - 只缓存当前分段的音频，内存上限约为maxSegmentMs，与听写总时长无关
+ * 线程安全：只能在一个线程中使用
+ */
+class Endpointer
+{
+public:
+    /**
+     * 切分参数
+     */
+    struct Options {
+        int sampleRate = 16000;
+        int frameMs = 10;
+        float speechMarginDb = 9.0f;    // 帧能量高出噪声底多少dB视为语音
+        int minSpeechMs = 250;          // 分段内语音少于此值视为杂音丢弃
+        int minSilenceMs = 600;         // 停顿多久切分
+        int paddingMs = 200;            // 分段首尾保留的静音
+        int maxSegmentMs = 20000;       // 分段最长时长
+    };
+
+    /**
+     * 切出的一段语音
+     */
+    struct Segment {
+        std::vector<int16_t> samples;
+        int64_t startSample = 0;        // 自reset()起的采样序号
+    };
+
+    Endpointer();
+    explicit Endpointer(const Options &options);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：丢弃缓存的音频和未取走的分段，重新开始
+     */
+    void reset();
+
+    /**
+     * 函数名称：`acceptWaveform`
+     * 功能描述：送入一块音频，切出的分段通过popSegment取走
+     * 参数说明：
+     *     - samples：const int16_t*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：void
+     */
+    void acceptWaveform(const int16_t *samples, int count);
+
+    /**
+     * 函数名称：`flush`
+     * 功能描述：听写结束：正在进行的分段若有足够语音，作为最后一段输出
+     */
+    void flush();
+
+    /**
+     * 函数名称：`popSegment`
+     * 功能描述：按时间顺序取出一个已切出的分段
+     * 参数说明：
+     *     - segment：Segment&，输出分段
+     * 返回值：bool，没有分段时返回false
+     */
+    bool popSegment(Segment &segment);
+
+    /**
+     * 函数名称：`currentSegment`
+     * 功能描述：正在进行的分段（自分段起点至今，含开头的静音）的副本，供中间结果识别
+     * 参数说明：
+     *     - samples：std::vector<int16_t>&，输出音频
+     * 返回值：bool，当前不在分段中时返回false
+     */
+    bool currentSegment(std::vector<int16_t> &samples) const;
+
+    bool inSpeech() const { return m_inSegment; }
+    int64_t samplesAccepted() const { return m_bufferStart + static_cast<int64_t>(m_buffer.size()); }
+    int bufferedSamples() const { return static_cast<int>(m_buffer.size()); }
+
+private:
+    void processFrame(int64_t start);
+
+    /**
+     * 函数名称：`finishSegment`
+     * 功能描述：在end处结束当前分段，语音足够时放入输出队列
+     */
+    void finishSegment(int64_t end);
+
+    /**
+     * 函数名称：`discardBefore`
+     * 功能描述：丢弃position之前的缓存音频（按帧对齐）
+     */
+    void discardBefore(int64_t position);
+
+private:
+    Options m_options;
+    int m_frameLength;                  // 每帧采样数
+    int m_paddingSamples;
+
+    std::vector<int16_t> m_buffer;      // 缓存的音频，首个采样的序号为m_bufferStart
+    std::vector<float> m_frameEnergy;   // 缓存中每帧的能量(dB)，与m_buffer按帧对齐
+    int64_t m_bufferStart;
+    int64_t m_nextFrame;                // 下一帧的起始采样
+
+    NoiseFloor m_noiseFloor;            // 噪声底(dB)
+    bool m_inSegment;
+    int64_t m_segmentStart;
+    int64_t m_lastSpeechEnd;            // 最近一个语音帧的结束采样
+    int m_speechFrames;                 // 当前分段的语音帧数
+    int m_silenceFrames;                // 当前连续静音帧数
+
+    std::deque<Segment> m_segments;
+};
+
+#endif // ENDPOINTER_H
@@ -0,0 +1,42 @@
+# 内置语音识别引擎（SenseVoiceSmall的C++实现）
+# 由APP.pro和tools下的工具工程共同引用
+# 日志使用APP/voicelogging.h中的lcEngine类别，引用的工程需一并编译voicelogging.cpp
+
+INCLUDEPATH += $$PWD $$PWD/..
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/cpufeatures.cpp \
+    $$PWD/enginekernels.cpp \
+    $$PWD/inferencearena.cpp \
+    $$PWD/intraoppool.cpp \
+    $$PWD/wavfrontend.cpp \
+    $$PWD/sensevoicemodel.cpp \
+    $$PWD/commandgrammar.cpp \
+    $$PWD/ctcaligner.cpp \
+    $$PWD/stableprefixtracker.cpp \
+    $$PWD/frameenergy.cpp \
+    $$PWD/keywordspotter.cpp \
+    $$PWD/endpointer.cpp \
+    $$PWD/prefixsegmenter.cpp \
+    $$PWD/sensevoiceengine.cpp \
+    $$PWD/inferencescheduler.cpp \
+    $$PWD/engineautotuner.cpp
+
+HEADERS += \
+    $$PWD/cpufeatures.h \
+    $$PWD/enginekernels.h \
+    $$PWD/inferencearena.h \
+    $$PWD/intraoppool.h \
+    $$PWD/wavfrontend.h \
+    $$PWD/sensevoicemodel.h \
+    $$PWD/commandgrammar.h \
+    $$PWD/ctcaligner.h \
+    $$PWD/stableprefixtracker.h \
+    $$PWD/frameenergy.h \
+    $$PWD/keywordspotter.h \
+    $$PWD/endpointer.h \
+    $$PWD/prefixsegmenter.h \
+    $$PWD/sensevoiceengine.h \
+    $$PWD/inferencescheduler.h \
+    $$PWD/engineautotuner.h
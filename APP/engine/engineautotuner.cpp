@@ -0,0 +1,159 @@
+#include "engineautotuner.h"
+#include "sensevoiceengine.h"
+#include "voicelogging.h"
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+
+EngineAutotuner::Result EngineAutotuner::run(const SenseVoiceEngine &engine, const Options &options)
+{
+    Result result;
+    if (!engine.isLoaded()) {
+        return result;
+    }
+
+    const int budget = options.threadBudget > 0 ? options.threadBudget : QThread::idealThreadCount();
+    const int requests = qMax(1, options.requestsPerSession);
+    const QByteArray pcm = probeAudio(qMax(1, options.probeSeconds), engine.model().config().sampleRate);
+
+    QVector<int> intraCandidates;
+    for (int threads = 1; threads < budget; threads *= 2) {
+        intraCandidates.append(threads);
+    }
+    intraCandidates.append(budget);
+
+    for (int intra : intraCandidates) {
+        QVector<int> sessionCandidates = {1};
+        if (budget / intra > 1) {
+            sessionCandidates.append(budget / intra);
+        }
+        for (int sessions : sessionCandidates) {
+            Measurement measurement = measure(engine, pcm, intra, sessions, requests);
+            qCDebug(lcEngine) << "🧠 线程配置" << intra << "x" << sessions << "p95(ms):" << measurement.p95LatencyMs
+                              << "吞吐(语音秒/秒):" << measurement.throughput;
+            result.measurements.append(measurement);
+        }
+    }
+
+    // 满足延迟目标的配置中取吞吐最高者；都不满足时取延迟最低者
+    const Measurement *chosen = nullptr;
+    for (const Measurement &measurement : result.measurements) {
+        if (measurement.p95LatencyMs > options.targetLatencyMs) {
+            continue;
+        }
+        if (!chosen || measurement.throughput > chosen->throughput) {
+            chosen = &measurement;
+        }
+    }
+    if (!chosen) {
+        for (const Measurement &measurement : result.measurements) {
+            if (!chosen || measurement.p95LatencyMs < chosen->p95LatencyMs) {
+                chosen = &measurement;
+            }
+        }
+    }
+
+    // 交互会话：单请求延迟最低的线程数，差距在5%以内时取线程更少的，把核心留给其他请求
+    const Measurement *fastest = nullptr;
+    for (const Measurement &measurement : result.measurements) {
+        if (measurement.sessions != 1) {
+            continue;
+        }
+        if (!fastest || measurement.p95LatencyMs < fastest->p95LatencyMs * 0.95) {
+            fastest = &measurement;
+        }
+    }
+
+    result.valid = true;
+    result.intraOpThreads = chosen->intraOpThreads;
+    result.sessions = chosen->sessions;
+    result.p95LatencyMs = chosen->p95LatencyMs;
+    result.throughput = chosen->throughput;
+    result.interactiveThreads = fastest ? fastest->intraOpThreads : 1;
+    result.threadBudget = budget;
+    return result;
+}
+
+QString EngineAutotuner::summary(const Result &result)
+{
+    if (!result.valid) {
+        return "未调优";
+    }
+    return QString("并发%1个会话×每会话%2线程（p95 %3 ms，吞吐 %4 语音秒/秒），交互%5线程，共%6核")
+        .arg(result.sessions)
+        .arg(result.intraOpThreads)
+        .arg(result.p95LatencyMs, 0, 'f', 1)
+        .arg(result.throughput, 0, 'f', 1)
+        .arg(result.interactiveThreads)
+        .arg(result.threadBudget);
+}
+
+EngineAutotuner::Measurement EngineAutotuner::measure(const SenseVoiceEngine &engine, const QByteArray &pcm,
+                                                      int intraOpThreads, int sessions, int requests)
+{
+    QVector<QVector<double>> latencies(sessions);
+    QSemaphore ready;
+    QSemaphore start;
+    QList<QThread *> threads;
+    for (int s = 0; s < sessions; ++s) {
+        QVector<double> &sessionLatencies = latencies[s];
+        threads.append(QThread::create([&engine, &pcm, &ready, &start, &sessionLatencies,
+                                        intraOpThreads, requests]() {
+            SenseVoiceEngine::Workspace workspace(engine, intraOpThreads);
+            engine.reserveWorkspace(workspace, 1);
+            const QVector<QByteArray> utterances = {pcm};
+            engine.recognizeBatch(utterances, workspace);
+            sessionLatencies.reserve(requests);
+
+            // 所有会话预热完成后同时开始计时
+            ready.release();
+            start.acquire();
+            for (int r = 0; r < requests; ++r) {
+                QElapsedTimer timer;
+                timer.start();
+                engine.recognizeBatch(utterances, workspace);
+                sessionLatencies.append(timer.nsecsElapsed() / 1e6);
+            }
+        }));
+        threads.last()->start();
+    }
+
+    ready.acquire(sessions);
+    QElapsedTimer wall;
+    wall.start();
+    start.release(sessions);
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    const double wallSeconds = wall.nsecsElapsed() / 1e9;
+
+    QVector<double> all;
+    for (const QVector<double> &sessionLatencies : latencies) {
+        all += sessionLatencies;
+    }
+    std::sort(all.begin(), all.end());
+
+    Measurement measurement;
+    measurement.intraOpThreads = intraOpThreads;
+    measurement.sessions = sessions;
+    measurement.p95LatencyMs = all.isEmpty() ? 0.0 : all[qMin(all.size() - 1, (all.size() * 95) / 100)];
+    const double audioSeconds = static_cast<double>(sessions) * requests * (pcm.size() / 2)
+                              / engine.model().config().sampleRate;
+    measurement.throughput = wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0;
+    return measurement;
+}
+
+QByteArray EngineAutotuner::probeAudio(int seconds, int sampleRate)
+{
+    // 低幅伪随机噪声：推理耗时只与时长有关，与内容无关
+    QByteArray pcm(seconds * sampleRate * 2, Qt::Uninitialized);
+    qint16 *samples = reinterpret_cast<qint16 *>(pcm.data());
+    quint32 seed = 1;
+    for (int i = 0; i < seconds * sampleRate; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        samples[i] = static_cast<qint16>(static_cast<int>((seed >> 16) % 201) - 100);
+    }
+    return pcm;
+}
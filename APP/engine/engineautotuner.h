@@ -0,0 +1,79 @@
+#ifndef ENGINEAUTOTUNER_H
+#define ENGINEAUTOTUNER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class SenseVoiceEngine;
+
+/**
+ * 函数名称：`EngineAutotuner`
+ * 功能描述：在本机上实测不同的线程配置，选出满足延迟目标时吞吐最高的组合：
+ *           每次推理的intra-op线程数 × 并发推理的会话数
+ * 设计特点：
+ *   - 候选为intra-op线程数取1、2、4…直到核心数，并发会话数取1和"核心数/线程数"
+ *   - 每个候选的会话各自持有Workspace，同时开始识别同一段探测语音，统计单条p95延迟和总吞吐
+ *   - 同时给出单请求延迟最低的线程数，供交互（流式）会话使用
+ *   - 只读使用引擎，可在后台线程中与正常识别并行运行（结果会受当时负载影响）
+ */
+class EngineAutotuner
+{
+public:
+    /**
+     * 调优参数
+     */
+    struct Options {
+        int targetLatencyMs = 500;      // 单条请求p95延迟上限
+        int probeSeconds = 5;           // 探测语音时长，取一句典型输入的长度
+        int requestsPerSession = 3;     // 每个会话计时的请求数（另有1次不计时的预热）
+        int threadBudget = 0;           // 可用核心数，<=0时取QThread::idealThreadCount()
+    };
+
+    /**
+     * 单个候选配置的实测结果
+     */
+    struct Measurement {
+        int intraOpThreads = 1;
+        int sessions = 1;
+        double p95LatencyMs = 0.0;
+        double throughput = 0.0;        // 每秒处理的语音秒数（所有会话合计）
+    };
+
+    /**
+     * 调优结果
+     */
+    struct Result {
+        bool valid = false;
+        int intraOpThreads = 1;         // 并发时每个会话的线程数
+        int sessions = 1;               // 并发推理的会话数
+        int interactiveThreads = 1;     // 单请求延迟最低的线程数
+        int threadBudget = 1;
+        double p95LatencyMs = 0.0;      // 所选配置的p95延迟
+        double throughput = 0.0;        // 所选配置的吞吐
+        QVector<Measurement> measurements;
+    };
+
+    /**
+     * 函数名称：`run`
+     * 功能描述：依次测量全部候选配置并选出结果，耗时约为候选数 × 每个会话的请求数 × 单次推理时间
+     * 参数说明：
+     *     - engine：const SenseVoiceEngine&，已加载的引擎
+     *     - options：Options，调优参数
+     * 返回值：Result，引擎未加载时valid为false
+     */
+    static Result run(const SenseVoiceEngine &engine, const Options &options);
+
+    /**
+     * 函数名称：`summary`
+     * 功能描述：结果的单行描述，用于日志
+     */
+    static QString summary(const Result &result);
+
+private:
+    static Measurement measure(const SenseVoiceEngine &engine, const QByteArray &pcm, int intraOpThreads,
+                               int sessions, int requests);
+    static QByteArray probeAudio(int seconds, int sampleRate);
+};
+
+#endif // ENGINEAUTOTUNER_H
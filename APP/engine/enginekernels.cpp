@@ -0,0 +1,799 @@
+#include "enginekernels.h"
+#include "cpufeatures.h"
+#include "intraoppool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ENGINE_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC/Clang按函数启用指令集，整个工程仍按基线指令集编译；MSVC无需标注即可使用intrinsics
+#if defined(ENGINE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ENGINE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ENGINE_TARGET(isa)
+#endif
+
+namespace EngineKernels {
+
+namespace {
+
+std::atomic<int> g_isa(-1);
+
+// fp32矩阵乘分块：一块输出通道的权重（LINEAR_PANEL×inDim）留在L2中被所有行复用，
+// 块内每次计算ROW_TILE行×若干输出通道，同一组输入行在L1中被多个输出通道复用
+const int LINEAR_PANEL = 48;
+const int ROW_TILE = 4;
+const int MAX_FSMN_KERNEL = 64;
+
+// 乘加次数低于此值时不拆分给线程池，唤醒线程的开销会超过收益
+const long PARALLEL_MIN_MACS = 1L << 18;
+const int INT8_OUTPUT_BLOCK = 64;       // int8矩阵乘按输出通道拆分的块大小
+const int FSMN_ROW_BLOCK = 16;          // FSMN按帧拆分的块大小
+
+inline bool worthParallel(long macs)
+{
+    return macs >= PARALLEL_MIN_MACS;
+}
+
+// fp32的AVX2内核使用FMA，AVX2而无FMA的CPU退回通用实现
+inline bool fp32Avx2()
+{
+    return activeIsa() >= Avx2 && CpuFeatures::host().fma;
+}
+
+// 取一组行指针，不足一组的部分指向第一行，结果丢弃，微内核因此不必处理边界
+template <int N>
+void tilePointers(const float *base, int stride, int begin, int count, const float *ptrs[N])
+{
+    for (int i = 0; i < N; ++i) {
+        ptrs[i] = base + static_cast<long>(begin + (i < count ? i : 0)) * stride;
+    }
+}
+
+template <int OUT_TILE>
+void linearBlocked(const float *x, int rows, int inDim, const float *weight, const float *bias,
+                   int outDim, float *y,
+                   void (*tile)(const float *const *, const float *const *, int, float (*)[OUT_TILE]))
+{
+    // 各输出通道块互不相关，按块分给线程池
+    const int panels = (outDim + LINEAR_PANEL - 1) / LINEAR_PANEL;
+    auto panel = [=](int index) {
+        const int p0 = index * LINEAR_PANEL;
+        const int p1 = std::min(outDim, p0 + LINEAR_PANEL);
+        for (int r0 = 0; r0 < rows; r0 += ROW_TILE) {
+            const int nr = std::min(ROW_TILE, rows - r0);
+            const float *xs[ROW_TILE];
+            tilePointers<ROW_TILE>(x, inDim, r0, nr, xs);
+            for (int o0 = p0; o0 < p1; o0 += OUT_TILE) {
+                const int no = std::min(OUT_TILE, p1 - o0);
+                const float *ws[OUT_TILE];
+                tilePointers<OUT_TILE>(weight, inDim, o0, no, ws);
+                float out[ROW_TILE][OUT_TILE];
+                tile(xs, ws, inDim, out);
+                for (int r = 0; r < nr; ++r) {
+                    float *yr = y + static_cast<long>(r0 + r) * outDim + o0;
+                    for (int o = 0; o < no; ++o) {
+                        yr[o] = out[r][o] + (bias ? bias[o0 + o] : 0.0f);
+                    }
+                }
+            }
+        }
+    };
+    if (worthParallel(static_cast<long>(rows) * inDim * outDim)) {
+        IntraOpPool::forEach(panels, panel);
+    } else {
+        for (int index = 0; index < panels; ++index) {
+            panel(index);
+        }
+    }
+}
+
+void tileGeneric(const float *const *x, const float *const *w, int inDim, float (*out)[4])
+{
+    float acc[ROW_TILE][4] = {};
+    for (int i = 0; i < inDim; ++i) {
+        for (int r = 0; r < ROW_TILE; ++r) {
+            const float xi = x[r][i];
+            for (int o = 0; o < 4; ++o) {
+                acc[r][o] += xi * w[o][i];
+            }
+        }
+    }
+    for (int r = 0; r < ROW_TILE; ++r) {
+        for (int o = 0; o < 4; ++o) {
+            out[r][o] = acc[r][o];
+        }
+    }
+}
+
+// 一行LayerNorm；a非空时先把残差a（及b）累加进x并写回sum，再对累加结果归一化
+void normRowGeneric(const float *x, const float *a, const float *b, float *sum, int dim,
+                    const float *gamma, const float *beta, float eps, float *y)
+{
+    float mean = 0.0f;
+    if (a) {
+        for (int i = 0; i < dim; ++i) {
+            const float value = x[i] + a[i] + (b ? b[i] : 0.0f);
+            sum[i] = value;
+            mean += value;
+        }
+        x = sum;
+    } else {
+        for (int i = 0; i < dim; ++i) {
+            mean += x[i];
+        }
+    }
+    mean /= dim;
+
+    float var = 0.0f;
+    for (int i = 0; i < dim; ++i) {
+        float d = x[i] - mean;
+        var += d * d;
+    }
+    var /= dim;
+
+    float inv = 1.0f / std::sqrt(var + eps);
+    for (int i = 0; i < dim; ++i) {
+        y[i] = (x[i] - mean) * inv * gamma[i] + beta[i];
+    }
+}
+
+// 帧t第j个抽头对应的输入行，越界帧为nullptr
+inline const float *fsmnSource(const float *history, int historyRows, const float *v, int rows, int stride,
+                               int dim, int t, int j, int leftPadding)
+{
+    const int src = t + j - leftPadding;
+    if (src >= 0 && src < rows) {
+        return v + static_cast<long>(src) * stride;
+    }
+    if (src < 0 && historyRows + src >= 0 && history) {
+        return history + static_cast<long>(historyRows + src) * dim;
+    }
+    return nullptr;
+}
+
+void fsmnGeneric(const float *history, int historyRows, const float *v, int rows, int stride, int dim,
+                 const float *taps, int kernelSize, int leftPadding, float *out, int tBegin, int tEnd)
+{
+    for (int t = tBegin; t < tEnd; ++t) {
+        float *ot = out + static_cast<long>(t) * dim;
+        std::memcpy(ot, v + static_cast<long>(t) * stride, sizeof(float) * dim);
+        for (int j = 0; j < kernelSize; ++j) {
+            const float *row = fsmnSource(history, historyRows, v, rows, stride, dim, t, j, leftPadding);
+            if (!row) {
+                continue;
+            }
+            const float *tap = taps + static_cast<long>(j) * dim;
+            for (int c = 0; c < dim; ++c) {
+                ot[c] += tap[c] * row[c];
+            }
+        }
+    }
+}
+
+inline int32_t dotGeneric(const int8_t *a, const int8_t *b, int n)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += static_cast<int32_t>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+void linearInt8Generic(const int8_t *xq, const float *xScales, int rows, int inDim,
+                       const Int8Matrix &weight, const float *bias, int outDim, float *y,
+                       int oBegin, int oEnd)
+{
+    // 输出通道在外层：一行权重在L1中被所有输入行复用
+    for (int o = oBegin; o < oEnd; ++o) {
+        const int8_t *wo = weight.data + static_cast<long>(o) * inDim;
+        const float scale = weight.scales[o];
+        const float b = bias ? bias[o] : 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            int32_t dot = dotGeneric(xq + static_cast<long>(r) * inDim, wo, inDim);
+            y[static_cast<long>(r) * outDim + o] = dot * (xScales[r] * scale) + b;
+        }
+    }
+}
+
+#if defined(ENGINE_X86)
+
+ENGINE_TARGET("avx2")
+inline int32_t dotAvx2(const int8_t *a, const int8_t *b, int n)
+{
+    // 符号扩展到16位后用VPMADDWD两两相乘相加，不存在VPMADDUBSW的饱和问题
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum) + dotGeneric(a + i, b + i, n - i);
+}
+
+ENGINE_TARGET("avx2")
+void linearInt8Avx2(const int8_t *xq, const float *xScales, int rows, int inDim,
+                    const Int8Matrix &weight, const float *bias, int outDim, float *y,
+                    int oBegin, int oEnd)
+{
+    for (int o = oBegin; o < oEnd; ++o) {
+        const int8_t *wo = weight.data + static_cast<long>(o) * inDim;
+        const float scale = weight.scales[o];
+        const float b = bias ? bias[o] : 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            int32_t dot = dotAvx2(xq + static_cast<long>(r) * inDim, wo, inDim);
+            y[static_cast<long>(r) * outDim + o] = dot * (xScales[r] * scale) + b;
+        }
+    }
+}
+
+ENGINE_TARGET("avx512f")
+inline int32_t reduceAdd512(__m512i v)
+{
+    // 经内存归约：GCC 12的_mm512_reduce_add_epi32/extract系列在-Wall下有误报
+    alignas(64) int32_t lanes[16];
+    _mm512_store_si512(lanes, v);
+    int32_t sum = 0;
+    for (int i = 0; i < 16; ++i) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+ENGINE_TARGET("avx512f,avx512bw")
+inline int32_t dotAvx512(const int8_t *a, const int8_t *b, int n)
+{
+    __m512i acc = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i va = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+        __m512i vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(va, vb));
+    }
+    return reduceAdd512(acc) + dotGeneric(a + i, b + i, n - i);
+}
+
+ENGINE_TARGET("avx512f,avx512bw")
+void linearInt8Avx512(const int8_t *xq, const float *xScales, int rows, int inDim,
+                      const Int8Matrix &weight, const float *bias, int outDim, float *y,
+                      int oBegin, int oEnd)
+{
+    for (int o = oBegin; o < oEnd; ++o) {
+        const int8_t *wo = weight.data + static_cast<long>(o) * inDim;
+        const float scale = weight.scales[o];
+        const float b = bias ? bias[o] : 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            int32_t dot = dotAvx512(xq + static_cast<long>(r) * inDim, wo, inDim);
+            y[static_cast<long>(r) * outDim + o] = dot * (xScales[r] * scale) + b;
+        }
+    }
+}
+
+ENGINE_TARGET("avx512f,avx512bw,avx512vnni")
+inline int32_t dotVnni(const int8_t *a, const int8_t *b, int n)
+{
+    // VPDPBUSD要求一侧为无符号：激活异或0x80即a+128，结果多出的128*sum(b)由调用方扣除；
+    // 尾部用掩码加载，被屏蔽的权重为0，不影响结果
+    const __m512i offset = _mm512_set1_epi8(static_cast<char>(0x80));
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < n; i += 64) {
+        const int remain = n - i;
+        const __mmask64 mask = remain >= 64 ? ~0ULL : ((1ULL << remain) - 1);
+        __m512i va = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, a + i), offset);
+        __m512i vb = _mm512_maskz_loadu_epi8(mask, b + i);
+        acc = _mm512_dpbusd_epi32(acc, va, vb);
+    }
+    return reduceAdd512(acc);
+}
+
+ENGINE_TARGET("avx512f,avx512bw,avx512vnni")
+void linearInt8Vnni(const int8_t *xq, const float *xScales, int rows, int inDim,
+                    const Int8Matrix &weight, const float *bias, int outDim, float *y,
+                    int oBegin, int oEnd)
+{
+    for (int o = oBegin; o < oEnd; ++o) {
+        const int8_t *wo = weight.data + static_cast<long>(o) * inDim;
+        const int32_t correction = 128 * weight.rowSums[o];
+        const float scale = weight.scales[o];
+        const float b = bias ? bias[o] : 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            int32_t dot = dotVnni(xq + static_cast<long>(r) * inDim, wo, inDim) - correction;
+            y[static_cast<long>(r) * outDim + o] = dot * (xScales[r] * scale) + b;
+        }
+    }
+}
+
+ENGINE_TARGET("avx2")
+inline float reduceAdd256(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+ENGINE_TARGET("avx2,fma")
+void tileAvx2(const float *const *x, const float *const *w, int inDim, float (*out)[3])
+{
+    // 4行×3通道共12个累加器，加上3个权重和1个输入寄存器正好用满16个YMM
+    __m256 acc[ROW_TILE][3];
+    for (int r = 0; r < ROW_TILE; ++r) {
+        for (int o = 0; o < 3; ++o) {
+            acc[r][o] = _mm256_setzero_ps();
+        }
+    }
+    int i = 0;
+    for (; i + 8 <= inDim; i += 8) {
+        const __m256 w0 = _mm256_loadu_ps(w[0] + i);
+        const __m256 w1 = _mm256_loadu_ps(w[1] + i);
+        const __m256 w2 = _mm256_loadu_ps(w[2] + i);
+        for (int r = 0; r < ROW_TILE; ++r) {
+            const __m256 xr = _mm256_loadu_ps(x[r] + i);
+            acc[r][0] = _mm256_fmadd_ps(xr, w0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(xr, w1, acc[r][1]);
+            acc[r][2] = _mm256_fmadd_ps(xr, w2, acc[r][2]);
+        }
+    }
+    for (int r = 0; r < ROW_TILE; ++r) {
+        for (int o = 0; o < 3; ++o) {
+            float sum = reduceAdd256(acc[r][o]);
+            for (int k = i; k < inDim; ++k) {
+                sum += x[r][k] * w[o][k];
+            }
+            out[r][o] = sum;
+        }
+    }
+}
+
+ENGINE_TARGET("avx512f")
+inline float reduceAdd512(__m512 v)
+{
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float sum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+ENGINE_TARGET("avx512f")
+void tileAvx512(const float *const *x, const float *const *w, int inDim, float (*out)[4])
+{
+    // 4行×4通道共16个累加器，尾部用掩码加载，被屏蔽的元素为0
+    __m512 acc[ROW_TILE][4];
+    for (int r = 0; r < ROW_TILE; ++r) {
+        for (int o = 0; o < 4; ++o) {
+            acc[r][o] = _mm512_setzero_ps();
+        }
+    }
+    for (int i = 0; i < inDim; i += 16) {
+        const int remain = inDim - i;
+        const __mmask16 mask = remain >= 16 ? 0xffff : static_cast<__mmask16>((1u << remain) - 1);
+        const __m512 w0 = _mm512_maskz_loadu_ps(mask, w[0] + i);
+        const __m512 w1 = _mm512_maskz_loadu_ps(mask, w[1] + i);
+        const __m512 w2 = _mm512_maskz_loadu_ps(mask, w[2] + i);
+        const __m512 w3 = _mm512_maskz_loadu_ps(mask, w[3] + i);
+        for (int r = 0; r < ROW_TILE; ++r) {
+            const __m512 xr = _mm512_maskz_loadu_ps(mask, x[r] + i);
+            acc[r][0] = _mm512_fmadd_ps(xr, w0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(xr, w1, acc[r][1]);
+            acc[r][2] = _mm512_fmadd_ps(xr, w2, acc[r][2]);
+            acc[r][3] = _mm512_fmadd_ps(xr, w3, acc[r][3]);
+        }
+    }
+    for (int r = 0; r < ROW_TILE; ++r) {
+        for (int o = 0; o < 4; ++o) {
+            out[r][o] = reduceAdd512(acc[r][o]);
+        }
+    }
+}
+
+ENGINE_TARGET("avx2,fma")
+void normRowAvx2(const float *x, const float *a, const float *b, float *sum, int dim,
+                 const float *gamma, const float *beta, float eps, float *y)
+{
+    const int body = dim & ~7;
+    __m256 acc = _mm256_setzero_ps();
+    float tail = 0.0f;
+    if (a) {
+        for (int i = 0; i < body; i += 8) {
+            __m256 value = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(a + i));
+            if (b) {
+                value = _mm256_add_ps(value, _mm256_loadu_ps(b + i));
+            }
+            _mm256_storeu_ps(sum + i, value);
+            acc = _mm256_add_ps(acc, value);
+        }
+        for (int i = body; i < dim; ++i) {
+            sum[i] = x[i] + a[i] + (b ? b[i] : 0.0f);
+            tail += sum[i];
+        }
+        x = sum;
+    } else {
+        for (int i = 0; i < body; i += 8) {
+            acc = _mm256_add_ps(acc, _mm256_loadu_ps(x + i));
+        }
+        for (int i = body; i < dim; ++i) {
+            tail += x[i];
+        }
+    }
+    const float mean = (reduceAdd256(acc) + tail) / dim;
+
+    const __m256 vmean = _mm256_set1_ps(mean);
+    acc = _mm256_setzero_ps();
+    tail = 0.0f;
+    for (int i = 0; i < body; i += 8) {
+        const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), vmean);
+        acc = _mm256_fmadd_ps(d, d, acc);
+    }
+    for (int i = body; i < dim; ++i) {
+        tail += (x[i] - mean) * (x[i] - mean);
+    }
+    const float inv = 1.0f / std::sqrt((reduceAdd256(acc) + tail) / dim + eps);
+
+    const __m256 vinv = _mm256_set1_ps(inv);
+    for (int i = 0; i < body; i += 8) {
+        const __m256 scaled = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), vmean), vinv),
+                                            _mm256_loadu_ps(gamma + i));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(scaled, _mm256_loadu_ps(beta + i)));
+    }
+    for (int i = body; i < dim; ++i) {
+        y[i] = (x[i] - mean) * inv * gamma[i] + beta[i];
+    }
+}
+
+ENGINE_TARGET("avx2,fma")
+void fsmnAvx2(const float *history, int historyRows, const float *v, int rows, int stride, int dim,
+              const float *taps, int kernelSize, int leftPadding, float *out, int tBegin, int tEnd)
+{
+    // 每8个通道在寄存器中累加残差和全部抽头，输出只写一次
+    const float *sources[MAX_FSMN_KERNEL];
+    const int body = dim & ~7;
+    for (int t = tBegin; t < tEnd; ++t) {
+        float *ot = out + static_cast<long>(t) * dim;
+        const float *vt = v + static_cast<long>(t) * stride;
+        for (int j = 0; j < kernelSize; ++j) {
+            sources[j] = fsmnSource(history, historyRows, v, rows, stride, dim, t, j, leftPadding);
+        }
+        for (int c = 0; c < body; c += 8) {
+            __m256 acc = _mm256_loadu_ps(vt + c);
+            for (int j = 0; j < kernelSize; ++j) {
+                if (sources[j]) {
+                    acc = _mm256_fmadd_ps(_mm256_loadu_ps(taps + static_cast<long>(j) * dim + c),
+                                          _mm256_loadu_ps(sources[j] + c), acc);
+                }
+            }
+            _mm256_storeu_ps(ot + c, acc);
+        }
+        for (int c = body; c < dim; ++c) {
+            float acc = vt[c];
+            for (int j = 0; j < kernelSize; ++j) {
+                if (sources[j]) {
+                    acc += taps[static_cast<long>(j) * dim + c] * sources[j][c];
+                }
+            }
+            ot[c] = acc;
+        }
+    }
+}
+
+#endif // ENGINE_X86
+
+} // namespace
+
+Isa bestIsa()
+{
+    const CpuFeatures &cpu = CpuFeatures::host();
+    if (cpu.avx512vnni) {
+        return Avx512Vnni;
+    }
+    if (cpu.avx512bw) {
+        return Avx512;
+    }
+    if (cpu.avx2) {
+        return Avx2;
+    }
+    return Generic;
+}
+
+Isa activeIsa()
+{
+    int isa = g_isa.load(std::memory_order_relaxed);
+    if (isa < 0) {
+        isa = bestIsa();
+        g_isa.store(isa, std::memory_order_relaxed);
+    }
+    return static_cast<Isa>(isa);
+}
+
+Isa setIsa(Isa isa)
+{
+    const Isa best = bestIsa();
+    if (isa > best) {
+        isa = best;
+    }
+    g_isa.store(isa, std::memory_order_relaxed);
+    return isa;
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Avx2:
+        return "avx2";
+    case Avx512:
+        return "avx512";
+    case Avx512Vnni:
+        return "avx512vnni";
+    default:
+        return "generic";
+    }
+}
+
+bool parseIsa(const char *name, Isa *isa)
+{
+    if (std::strcmp(name, "auto") == 0) {
+        *isa = bestIsa();
+        return true;
+    }
+    for (Isa candidate : {Generic, Avx2, Avx512, Avx512Vnni}) {
+        if (std::strcmp(name, isaName(candidate)) == 0) {
+            *isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void linear(const float *x, int rows, int inDim,
+            const float *weight, const float *bias, int outDim, float *y)
+{
+#if defined(ENGINE_X86)
+    if (activeIsa() >= Avx512) {
+        linearBlocked<4>(x, rows, inDim, weight, bias, outDim, y, tileAvx512);
+        return;
+    }
+    if (fp32Avx2()) {
+        linearBlocked<3>(x, rows, inDim, weight, bias, outDim, y, tileAvx2);
+        return;
+    }
+#endif
+    linearBlocked<4>(x, rows, inDim, weight, bias, outDim, y, tileGeneric);
+}
+
+void layerNorm(const float *x, int rows, int dim,
+               const float *gamma, const float *beta, float eps, float *y)
+{
+#if defined(ENGINE_X86)
+    const bool avx2 = fp32Avx2();
+#endif
+    for (int r = 0; r < rows; ++r) {
+        const float *xr = x + static_cast<long>(r) * dim;
+        float *yr = y + static_cast<long>(r) * dim;
+#if defined(ENGINE_X86)
+        if (avx2) {
+            normRowAvx2(xr, nullptr, nullptr, nullptr, dim, gamma, beta, eps, yr);
+            continue;
+        }
+#endif
+        normRowGeneric(xr, nullptr, nullptr, nullptr, dim, gamma, beta, eps, yr);
+    }
+}
+
+void addLayerNorm(float *x, const float *a, const float *b, int rows, int dim,
+                  const float *gamma, const float *beta, float eps, float *y)
+{
+#if defined(ENGINE_X86)
+    const bool avx2 = fp32Avx2();
+#endif
+    for (int r = 0; r < rows; ++r) {
+        const long offset = static_cast<long>(r) * dim;
+        const float *br = b ? b + offset : nullptr;
+#if defined(ENGINE_X86)
+        if (avx2) {
+            normRowAvx2(x + offset, a + offset, br, x + offset, dim, gamma, beta, eps, y + offset);
+            continue;
+        }
+#endif
+        normRowGeneric(x + offset, a + offset, br, x + offset, dim, gamma, beta, eps, y + offset);
+    }
+}
+
+void relu(float *x, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (x[i] < 0.0f) {
+            x[i] = 0.0f;
+        }
+    }
+}
+
+void addInPlace(float *y, const float *x, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        y[i] += x[i];
+    }
+}
+
+void softmax(float *x, int count)
+{
+    float maxValue = x[0];
+    for (int i = 1; i < count; ++i) {
+        if (x[i] > maxValue) {
+            maxValue = x[i];
+        }
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        x[i] = std::exp(x[i] - maxValue);
+        sum += x[i];
+    }
+    float inv = 1.0f / sum;
+    for (int i = 0; i < count; ++i) {
+        x[i] *= inv;
+    }
+}
+
+void logSoftmax(float *x, int count)
+{
+    float logSum = logSumExp(x, count);
+    for (int i = 0; i < count; ++i) {
+        x[i] -= logSum;
+    }
+}
+
+float logSumExp(const float *x, int count)
+{
+    float maxValue = x[0];
+    for (int i = 1; i < count; ++i) {
+        if (x[i] > maxValue) {
+            maxValue = x[i];
+        }
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        sum += std::exp(x[i] - maxValue);
+    }
+    return maxValue + std::log(sum);
+}
+
+int argmax(const float *x, int count)
+{
+    int best = 0;
+    for (int i = 1; i < count; ++i) {
+        if (x[i] > x[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void fsmnMemory(const float *history, int historyRows,
+                const float *v, int rows, int stride, int dim,
+                const float *taps, int kernelSize, int leftPadding, float *out)
+{
+    // 帧t的输出 = v[t] + sum_j taps[j] * v[t + j - leftPadding]，越界帧视为0
+    typedef void (*Kernel)(const float *, int, const float *, int, int, int, const float *, int, int, float *,
+                           int, int);
+    Kernel kernel = fsmnGeneric;
+#if defined(ENGINE_X86)
+    if (fp32Avx2() && kernelSize <= MAX_FSMN_KERNEL) {
+        kernel = fsmnAvx2;
+    }
+#endif
+    const int blocks = (rows + FSMN_ROW_BLOCK - 1) / FSMN_ROW_BLOCK;
+    auto block = [=](int index) {
+        const int tBegin = index * FSMN_ROW_BLOCK;
+        kernel(history, historyRows, v, rows, stride, dim, taps, kernelSize, leftPadding, out, tBegin,
+               std::min(rows, tBegin + FSMN_ROW_BLOCK));
+    };
+    if (worthParallel(static_cast<long>(rows) * dim * kernelSize)) {
+        IntraOpPool::forEach(blocks, block);
+    } else {
+        kernel(history, historyRows, v, rows, stride, dim, taps, kernelSize, leftPadding, out, 0, rows);
+    }
+}
+
+void transposeFsmnWeight(const float *weight, int dim, int kernelSize, float *taps)
+{
+    for (int c = 0; c < dim; ++c) {
+        for (int j = 0; j < kernelSize; ++j) {
+            taps[static_cast<long>(j) * dim + c] = weight[static_cast<long>(c) * kernelSize + j];
+        }
+    }
+}
+
+void quantizeWeights(const float *weight, int outDim, int inDim, int8_t *data, float *scales)
+{
+    for (int o = 0; o < outDim; ++o) {
+        const float *wo = weight + static_cast<long>(o) * inDim;
+        int8_t *qo = data + static_cast<long>(o) * inDim;
+        float maxAbs = 0.0f;
+        for (int i = 0; i < inDim; ++i) {
+            maxAbs = std::max(maxAbs, std::fabs(wo[i]));
+        }
+        const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+        const float inv = 1.0f / scale;
+        for (int i = 0; i < inDim; ++i) {
+            qo[i] = static_cast<int8_t>(std::lrint(wo[i] * inv));
+        }
+        scales[o] = scale;
+    }
+}
+
+void weightRowSums(const int8_t *data, int outDim, int inDim, int32_t *rowSums)
+{
+    for (int o = 0; o < outDim; ++o) {
+        const int8_t *qo = data + static_cast<long>(o) * inDim;
+        int32_t sum = 0;
+        for (int i = 0; i < inDim; ++i) {
+            sum += qo[i];
+        }
+        rowSums[o] = sum;
+    }
+}
+
+void quantizeRows(const float *x, int rows, int dim, int8_t *q, float *scales)
+{
+    for (int r = 0; r < rows; ++r) {
+        const float *xr = x + static_cast<long>(r) * dim;
+        int8_t *qr = q + static_cast<long>(r) * dim;
+        float maxAbs = 0.0f;
+        for (int i = 0; i < dim; ++i) {
+            maxAbs = std::max(maxAbs, std::fabs(xr[i]));
+        }
+        const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+        const float inv = 1.0f / scale;
+        for (int i = 0; i < dim; ++i) {
+            qr[i] = static_cast<int8_t>(std::lrint(xr[i] * inv));
+        }
+        scales[r] = scale;
+    }
+}
+
+void linearInt8(const int8_t *xq, const float *xScales, int rows, int inDim,
+                const Int8Matrix &weight, const float *bias, int outDim, float *y)
+{
+    typedef void (*Kernel)(const int8_t *, const float *, int, int, const Int8Matrix &, const float *, int,
+                           float *, int, int);
+    Kernel kernel = linearInt8Generic;
+    switch (activeIsa()) {
+#if defined(ENGINE_X86)
+    case Avx512Vnni:
+        kernel = weight.rowSums ? linearInt8Vnni : linearInt8Avx512;
+        break;
+    case Avx512:
+        kernel = linearInt8Avx512;
+        break;
+    case Avx2:
+        kernel = linearInt8Avx2;
+        break;
+#endif
+    default:
+        break;
+    }
+
+    const int blocks = (outDim + INT8_OUTPUT_BLOCK - 1) / INT8_OUTPUT_BLOCK;
+    auto block = [=, &weight](int index) {
+        const int oBegin = index * INT8_OUTPUT_BLOCK;
+        kernel(xq, xScales, rows, inDim, weight, bias, outDim, y, oBegin,
+               std::min(outDim, oBegin + INT8_OUTPUT_BLOCK));
+    };
+    if (worthParallel(static_cast<long>(rows) * inDim * outDim)) {
+        IntraOpPool::forEach(blocks, block);
+    } else {
+        kernel(xq, xScales, rows, inDim, weight, bias, outDim, y, 0, outDim);
+    }
+}
+
+} // namespace EngineKernels
@@ -0,0 +1,228 @@
+#ifndef ENGINEKERNELS_H
+#define ENGINEKERNELS_H
+
+#include <cstdint>
+
+/**
+ * 模块名称：`EngineKernels`
+ * 功能描述：内置推理引擎的基础数值内核，全部基于行优先的float数组
+ * 设计原则：不依赖Qt和第三方库，调用方负责分配输出缓冲区
+ */
+namespace EngineKernels {
+
+/**
+ * 内核指令集级别，由低到高；fp32和int8内核都按当前级别分派
+ */
+enum Isa {
+    Generic,                            // 标量实现，任意平台
+    Avx2,                               // AVX2（int8按16位乘加）
+    Avx512,                             // AVX-512BW
+    Avx512Vnni                          // AVX-512 VNNI（VPDPBUSD）
+};
+
+/**
+ * 函数名称：`bestIsa`
+ * 功能描述：本机CPU支持的最高级别
+ */
+Isa bestIsa();
+
+/**
+ * 函数名称：`activeIsa`
+ * 功能描述：当前使用的级别，默认为bestIsa()
+ */
+Isa activeIsa();
+
+/**
+ * 函数名称：`setIsa`
+ * 功能描述：指定内核级别（用于对比测试或规避个别CPU上的降频），超出本机支持时降为bestIsa()
+ * 参数说明：
+ *     - isa：Isa，期望级别
+ * 返回值：Isa，实际生效的级别
+ */
+Isa setIsa(Isa isa);
+
+/**
+ * 函数名称：`isaName`
+ * 功能描述：级别名称：generic/avx2/avx512/avx512vnni
+ */
+const char *isaName(Isa isa);
+
+/**
+ * 函数名称：`parseIsa`
+ * 功能描述：解析级别名称，"auto"解析为bestIsa()
+ * 参数说明：
+ *     - name：const char*，名称
+ *     - isa：Isa*，输出
+ * 返回值：bool，名称是否有效
+ */
+bool parseIsa(const char *name, Isa *isa);
+
+/**
+ * 函数名称：`linear`
+ * 功能描述：全连接层 y = x * W^T + b，按输出通道分块、4行一组计算，按activeIsa()分派（AVX2需同时支持FMA）
+ * 参数说明：
+ *     - x：const float*，输入矩阵 [rows, inDim]
+ *     - rows：int，行数
+ *     - inDim：int，输入维度
+ *     - weight：const float*，权重矩阵 [outDim, inDim]（PyTorch布局）
+ *     - bias：const float*，偏置 [outDim]，可为nullptr
+ *     - outDim：int，输出维度
+ *     - y：float*，输出矩阵 [rows, outDim]
+ * 返回值：void
+ */
+void linear(const float *x, int rows, int inDim,
+            const float *weight, const float *bias, int outDim, float *y);
+
+/**
+ * 函数名称：`layerNorm`
+ * 功能描述：逐行LayerNorm
+ * 参数说明：
+ *     - x：const float*，输入 [rows, dim]
+ *     - gamma/beta：const float*，缩放与偏移 [dim]
+ *     - eps：float，数值稳定项
+ *     - y：float*，输出 [rows, dim]，可与x相同
+ * 返回值：void
+ */
+void layerNorm(const float *x, int rows, int dim,
+               const float *gamma, const float *beta, float eps, float *y);
+
+/**
+ * 函数名称：`addLayerNorm`
+ * 功能描述：残差相加与LayerNorm融合：x += a (+ b)，再 y = LayerNorm(x)，每行只读写一遍x
+ * 参数说明：
+ *     - x：float*，[rows, dim]，原地累加残差
+ *     - a：const float*，残差 [rows, dim]
+ *     - b：const float*，第二个残差 [rows, dim]，可为nullptr
+ *     - gamma/beta：const float*，缩放与偏移 [dim]
+ *     - eps：float，数值稳定项
+ *     - y：float*，输出 [rows, dim]，不可与x相同
+ * 返回值：void
+ */
+void addLayerNorm(float *x, const float *a, const float *b, int rows, int dim,
+                  const float *gamma, const float *beta, float eps, float *y);
+
+/**
+ * 函数名称：`relu`
+ * 功能描述：原地ReLU
+ */
+void relu(float *x, int count);
+
+/**
+ * 函数名称：`addInPlace`
+ * 功能描述：y += x
+ */
+void addInPlace(float *y, const float *x, int count);
+
+/**
+ * 函数名称：`softmax`
+ * 功能描述：对单行做原地softmax
+ */
+void softmax(float *x, int count);
+
+/**
+ * 函数名称：`logSoftmax`
+ * 功能描述：对单行做原地log-softmax
+ */
+void logSoftmax(float *x, int count);
+
+/**
+ * 函数名称：`logSumExp`
+ * 功能描述：log(sum(exp(x)))，即单行log-softmax的归一化项
+ */
+float logSumExp(const float *x, int count);
+
+/**
+ * 函数名称：`argmax`
+ * 功能描述：返回单行最大值下标
+ */
+int argmax(const float *x, int count);
+
+/**
+ * 函数名称：`fsmnMemory`
+ * 功能描述：SANM的FSMN记忆块：深度可分离1D卷积 + 残差，对应model.py中的forward_fsmn；
+ *          每组通道在寄存器中累加全部抽头后只写一次输出
+ * 参数说明：
+ *     - history：const float*，左侧历史帧 [historyRows, dim]（流式缓存，离线时为nullptr）
+ *     - historyRows：int，历史帧数，不足leftPadding的部分按0填充
+ *     - v：const float*，当前帧的value [rows, stride]，取前dim列
+ *     - rows：int，当前帧数
+ *     - stride：int，v的行跨度
+ *     - dim：int，通道数
+ *     - taps：const float*，按抽头存放的卷积核 [kernelSize, dim]（模型文件v3起即按此布局存放，旧版文件见transposeFsmnWeight）
+ *     - kernelSize：int，卷积核长度
+ *     - leftPadding：int，左侧填充帧数
+ *     - out：float*，输出 [rows, dim]
+ * 返回值：void
+ */
+void fsmnMemory(const float *history, int historyRows,
+                const float *v, int rows, int stride, int dim,
+                const float *taps, int kernelSize, int leftPadding, float *out);
+
+/**
+ * 函数名称：`transposeFsmnWeight`
+ * 功能描述：把旧版模型文件（v1/v2）的fsmn_block.weight [dim, kernelSize] 转为按抽头存放 [kernelSize, dim]，使同一抽头的通道连续
+ * 参数说明：
+ *     - weight：const float*，[dim, kernelSize]
+ *     - dim/kernelSize：int，形状
+ *     - taps：float*，输出 [kernelSize, dim]
+ * 返回值：void
+ */
+void transposeFsmnWeight(const float *weight, int dim, int kernelSize, float *taps);
+
+/**
+ * 按输出通道对称量化的int8权重矩阵 [outDim, inDim]，反量化为 w = data * scales[o]
+ */
+struct Int8Matrix {
+    const int8_t *data = nullptr;
+    const float *scales = nullptr;      // [outDim]
+    const int32_t *rowSums = nullptr;   // [outDim] 每行权重之和，VNNI内核（u8×s8）的零点补偿
+};
+
+/**
+ * 函数名称：`quantizeWeights`
+ * 功能描述：按输出通道对称量化float权重，scale = max|w| / 127
+ * 参数说明：
+ *     - weight：const float*，权重 [outDim, inDim]
+ *     - outDim/inDim：int，形状
+ *     - data：int8_t*，输出 [outDim, inDim]
+ *     - scales：float*，输出 [outDim]
+ * 返回值：void
+ */
+void quantizeWeights(const float *weight, int outDim, int inDim, int8_t *data, float *scales);
+
+/**
+ * 函数名称：`weightRowSums`
+ * 功能描述：计算int8权重每行之和
+ */
+void weightRowSums(const int8_t *data, int outDim, int inDim, int32_t *rowSums);
+
+/**
+ * 函数名称：`quantizeRows`
+ * 功能描述：激活按行动态对称量化为int8
+ * 参数说明：
+ *     - x：const float*，输入 [rows, dim]
+ *     - q：int8_t*，输出 [rows, dim]
+ *     - scales：float*，每行反量化系数 [rows]
+ * 返回值：void
+ */
+void quantizeRows(const float *x, int rows, int dim, int8_t *q, float *scales);
+
+/**
+ * 函数名称：`linearInt8`
+ * 功能描述：int8全连接层 y = dequant(xq * Wq^T) + b，int32累加，按activeIsa()分派
+ * 参数说明：
+ *     - xq：const int8_t*，quantizeRows的输出 [rows, inDim]
+ *     - xScales：const float*，每行反量化系数 [rows]
+ *     - rows/inDim：int，输入形状
+ *     - weight：Int8Matrix，量化权重 [outDim, inDim]
+ *     - bias：const float*，偏置 [outDim]，可为nullptr
+ *     - outDim：int，输出维度
+ *     - y：float*，输出 [rows, outDim]
+ * 返回值：void
+ */
+void linearInt8(const int8_t *xq, const float *xScales, int rows, int inDim,
+                const Int8Matrix &weight, const float *bias, int outDim, float *y);
+
+} // namespace EngineKernels
+
+#endif // ENGINEKERNELS_H
@@ -0,0 +1,65 @@
+#include "frameenergy.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float NOISE_RISE_DB_PER_SEC = 1.0f;   // 噪声底上升速度，长句不会被当成噪声
+const float NOISE_FALL_RATE = 0.2f;         // 噪声底下降的平滑系数，单帧掉零不会拉低噪声底
+
+} // namespace
+
+const float NoiseFloor::MIN_DB = 10.0f;
+
+NoiseFloor::NoiseFloor(int frameMs, float unitsPerDb, float minimum)
+    : m_risePerFrame(NOISE_RISE_DB_PER_SEC * unitsPerDb * frameMs / 1000.0f)
+    , m_minimum(minimum)
+{
+    reset();
+}
+
+void NoiseFloor::reset()
+{
+    m_value = m_minimum;
+    m_started = false;
+}
+
+float NoiseFloor::update(float energy)
+{
+    if (!m_started) {
+        m_value = energy;
+        m_started = true;
+    } else if (energy < m_value) {
+        m_value += NOISE_FALL_RATE * (energy - m_value);
+    } else {
+        m_value += m_risePerFrame;
+    }
+    m_value = std::max(m_value, m_minimum);
+    return m_value;
+}
+
+EnergyFramer::EnergyFramer(int frameLength)
+    : m_frameLength(static_cast<size_t>(std::max(frameLength, 1)))
+{
+}
+
+float EnergyFramer::energyDb(const int16_t *frame, int length)
+{
+    double power = 0.0;
+    for (int i = 0; i < length; ++i) {
+        power += static_cast<double>(frame[i]) * frame[i];
+    }
+    return static_cast<float>(10.0 * std::log10(power / length + 1.0));
+}
+
+int EnergyFramer::quietestFrame(const std::vector<float> &energy, int searchFrames)
+{
+    const int frames = static_cast<int>(energy.size());
+    int quietest = frames - 1;
+    for (int f = frames - std::min(searchFrames, frames); f < frames; ++f) {
+        if (energy[f] < energy[quietest]) {
+            quietest = f;
+        }
+    }
+    return quietest;
+}
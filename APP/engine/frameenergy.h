@@ -0,0 +1,108 @@
+#ifndef FRAMEENERGY_H
+#define FRAMEENERGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 函数名称：`NoiseFloor`
+ * 功能描述：逐帧跟踪背景噪声的能量：低于噪声底时较快跟随，高于时缓慢上升，
+ *           唤醒词检测、听写端点检测和投机识别的切分共用
+ * 设计特点：
+ *   - 第一帧直接作为噪声底，之后慢升快降：长句的能量不会被当成噪声，单帧掉零也不会拉低噪声底
+ *   - 能量单位由调用方决定（dB或自然对数能量），上升速度按unitsPerDb换算
+ * 线程安全：只能在一个线程中使用
+ */
+class NoiseFloor
+{
+public:
+    static const float MIN_DB;          // dB能量的默认下限，约3个LSB的底噪
+
+    /**
+     * 参数说明：
+     *     - frameMs：int，帧移（毫秒），决定每帧上升多少
+     *     - unitsPerDb：float，1dB对应的能量单位，dB能量为1，自然对数能量为ln(10)/10
+     *     - minimum：float，噪声底下限（同一单位），数字静音后不把底噪当语音
+     */
+    NoiseFloor(int frameMs, float unitsPerDb, float minimum);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：重新开始，下一帧作为初始噪声底
+     */
+    void reset();
+
+    /**
+     * 函数名称：`update`
+     * 功能描述：送入一帧的能量，更新噪声底
+     * 参数说明：
+     *     - energy：float，帧能量
+     * 返回值：float，更新后的噪声底
+     */
+    float update(float energy);
+
+    float value() const { return m_value; }
+
+private:
+    float m_risePerFrame;
+    float m_minimum;
+    float m_value;
+    bool m_started;
+};
+
+/**
+ * 函数名称：`EnergyFramer`
+ * 功能描述：把任意长度的音频块切成定长帧，逐帧计算对数能量(dB)，不足一帧的采样留到下一块
+ * 线程安全：只能在一个线程中使用
+ */
+class EnergyFramer
+{
+public:
+    explicit EnergyFramer(int frameLength);
+
+    void reset() { m_partial.clear(); }
+
+    /**
+     * 函数名称：`accept`
+     * 功能描述：送入一块音频，每凑满一帧调用一次onFrame(energyDb)
+     * 参数说明：
+     *     - samples：const int16_t*，PCM
+     *     - count：int，采样数
+     *     - onFrame：可调用对象，参数为该帧的能量(dB)
+     * 返回值：void
+     */
+    template <typename OnFrame>
+    void accept(const int16_t *samples, int count, OnFrame onFrame)
+    {
+        m_partial.insert(m_partial.end(), samples, samples + count);
+        size_t offset = 0;
+        while (offset + m_frameLength <= m_partial.size()) {
+            onFrame(energyDb(m_partial.data() + offset, m_frameLength));
+            offset += m_frameLength;
+        }
+        m_partial.erase(m_partial.begin(), m_partial.begin() + offset);
+    }
+
+    /**
+     * 函数名称：`energyDb`
+     * 功能描述：一帧的对数能量，10·log10(均方 + 1)，全零帧为0dB
+     */
+    static float energyDb(const int16_t *frame, int length);
+
+    /**
+     * 函数名称：`quietestFrame`
+     * 功能描述：最后searchFrames帧中能量最低的一帧，供一直不停顿时选强制切分点
+     * 参数说明：
+     *     - energy：const std::vector<float>&，逐帧能量
+     *     - searchFrames：int，向前查找的帧数，超过帧数时按帧数计
+     * 返回值：int，帧下标；多帧同为最低时取最早的一帧，但最后一帧已是最低时取最后一帧；energy为空时返回-1
+     */
+    static int quietestFrame(const std::vector<float> &energy, int searchFrames);
+
+private:
+    size_t m_frameLength;
+    std::vector<int16_t> m_partial;     // 不足一帧的剩余采样
+};
+
+#endif // FRAMEENERGY_H
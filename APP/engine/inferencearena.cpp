@@ -0,0 +1,127 @@
+#include "inferencearena.h"
+#include <cstdlib>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+std::atomic<uint64_t> InferenceArena::s_totalHeapAllocations(0);
+
+namespace {
+
+inline size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+inline void freeBlock(void *block)
+{
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+} // namespace
+
+InferenceArena::InferenceArena()
+    : m_block(nullptr)
+    , m_capacity(0)
+    , m_offset(0)
+    , m_used(0)
+    , m_highWater(0)
+    , m_overflow(nullptr)
+    , m_heapAllocations(0)
+{
+}
+
+InferenceArena::~InferenceArena()
+{
+    releaseOverflow();
+    freeBlock(m_block);
+}
+
+void InferenceArena::reserve(size_t bytes)
+{
+    bytes = alignUp(bytes, ALIGNMENT);
+    if (bytes <= m_capacity) {
+        return;
+    }
+    // 只在没有未回收分配时更换主内存块，否则等到reset()时合并
+    if (m_offset == 0 && !m_overflow) {
+        freeBlock(m_block);
+        m_block = nullptr;
+        m_capacity = 0;
+        m_block = allocateBlock(bytes);
+        m_capacity = bytes;
+    } else if (bytes > m_highWater) {
+        m_highWater = bytes;
+    }
+}
+
+void *InferenceArena::allocateBytes(size_t bytes)
+{
+    bytes = alignUp(bytes == 0 ? 1 : bytes, ALIGNMENT);
+    m_used += bytes;
+    if (m_used > m_highWater) {
+        m_highWater = m_used;
+    }
+
+    if (m_offset + bytes <= m_capacity) {
+        void *result = m_block + m_offset;
+        m_offset += bytes;
+        return result;
+    }
+
+    // 容量不足：单独申请溢出块，块头用于串成链表，数据部分保持对齐
+    char *block = allocateBlock(ALIGNMENT + bytes);
+    OverflowBlock *header = reinterpret_cast<OverflowBlock *>(block);
+    header->next = m_overflow;
+    m_overflow = header;
+    return block + ALIGNMENT;
+}
+
+void InferenceArena::reset()
+{
+    if (m_overflow || m_highWater > m_capacity) {
+        // 本次推理发生过溢出，按最大用量重新申请主内存块，之后的同等规模推理不再分配
+        releaseOverflow();
+        freeBlock(m_block);
+        m_block = nullptr;
+        m_capacity = 0;
+        m_offset = 0;
+        m_used = 0;
+        m_block = allocateBlock(alignUp(m_highWater, ALIGNMENT));
+        m_capacity = alignUp(m_highWater, ALIGNMENT);
+    }
+    m_offset = 0;
+    m_used = 0;
+}
+
+char *InferenceArena::allocateBlock(size_t bytes)
+{
+    void *block = nullptr;
+#if defined(_WIN32)
+    block = _aligned_malloc(bytes, ALIGNMENT);
+#else
+    if (posix_memalign(&block, ALIGNMENT, bytes) != 0) {
+        block = nullptr;
+    }
+#endif
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    ++m_heapAllocations;
+    ++s_totalHeapAllocations;
+    return static_cast<char *>(block);
+}
+
+void InferenceArena::releaseOverflow()
+{
+    while (m_overflow) {
+        OverflowBlock *next = m_overflow->next;
+        freeBlock(m_overflow);
+        m_overflow = next;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef INFERENCEARENA_H
+#define INFERENCEARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 函数名称：`InferenceArena`
+ * 功能描述：推理用的线性（bump）分配器，一次推理中的特征、补齐后的批、中间激活和logits都从这里分配，
+ *           推理结束后reset()整体回收，下次推理复用同一块内存
+ * 设计特点：
+ *   - 每个工作线程/识别会话一个，不加锁
+ *   - 容量按最长语音预留（reserve），稳态下不再向系统申请内存
+ *   - 超出容量时临时申请溢出块，reset()时合并为一块足够大的内存，之后不再溢出
+ *   - heapAllocations()统计向系统申请内存的次数，基准工具据此检查稳态零分配
+ */
+class InferenceArena
+{
+public:
+    InferenceArena();
+    ~InferenceArena();
+
+    /**
+     * 函数名称：`reserve`
+     * 功能描述：确保单次推理可用的容量不小于bytes
+     * 参数说明：
+     *     - bytes：size_t，字节数
+     * 返回值：void
+     */
+    void reserve(size_t bytes);
+
+    /**
+     * 函数名称：`allocate`
+     * 功能描述：分配count个T，按64字节对齐，内容未初始化；指针在下次reset()前有效
+     * 参数说明：
+     *     - count：size_t，元素个数
+     * 返回值：T*
+     */
+    template <typename T>
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(allocateBytes(count * sizeof(T)));
+    }
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：回收本次推理的全部分配
+     * 参数说明：无
+     * 返回值：void
+     */
+    void reset();
+
+    size_t capacity() const { return m_capacity; }
+    size_t used() const { return m_used; }
+    size_t highWater() const { return m_highWater; }
+    uint64_t heapAllocations() const { return m_heapAllocations; }
+
+    /**
+     * 函数名称：`totalHeapAllocations`
+     * 功能描述：进程内所有arena向系统申请内存的总次数
+     */
+    static uint64_t totalHeapAllocations() { return s_totalHeapAllocations.load(); }
+
+    static const size_t ALIGNMENT = 64;
+
+private:
+    InferenceArena(const InferenceArena &) = delete;
+    InferenceArena &operator=(const InferenceArena &) = delete;
+
+    void *allocateBytes(size_t bytes);
+    char *allocateBlock(size_t bytes);
+    void releaseOverflow();
+
+private:
+    struct OverflowBlock {
+        OverflowBlock *next;
+    };
+
+    char *m_block;                      // 主内存块
+    size_t m_capacity;
+    size_t m_offset;                    // 主内存块已用字节
+    size_t m_used;                      // 本次推理已分配字节（含溢出块）
+    size_t m_highWater;                 // 历史单次推理最大用量
+    OverflowBlock *m_overflow;          // 本次推理中的溢出块链表
+    uint64_t m_heapAllocations;
+
+    static std::atomic<uint64_t> s_totalHeapAllocations;
+};
+
+#endif // INFERENCEARENA_H
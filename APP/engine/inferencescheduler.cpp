@@ -0,0 +1,193 @@
+#include "inferencescheduler.h"
+#include "sensevoiceengine.h"
+#include "voicelogging.h"
+#include <QMutexLocker>
+#include <QVector>
+#include <algorithm>
+#include <cstdlib>
+
+InferenceScheduler::InferenceScheduler(const SenseVoiceEngine *engine, const Options &options,
+                                       QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_options(options)
+    , m_busyWorkers(0)
+    , m_stopping(false)
+{
+    m_options.maxBatchSize = qMax(1, m_options.maxBatchSize);
+    m_options.batchWorkers = qMax(1, m_options.batchWorkers);
+    m_options.intraOpThreads = qMax(1, m_options.intraOpThreads);
+    if (m_options.threadBudget <= 0) {
+        m_options.threadBudget = QThread::idealThreadCount();
+    }
+
+    m_workers.append(QThread::create([this]() { workerLoop(Interactive); }));
+    for (int i = 0; i < m_options.batchWorkers; ++i) {
+        m_workers.append(QThread::create([this]() { workerLoop(Batch); }));
+    }
+    for (QThread *worker : m_workers) {
+        worker->start();
+    }
+}
+
+InferenceScheduler::~InferenceScheduler()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_interactiveReady.wakeAll();
+        m_batchReady.wakeAll();
+    }
+    for (QThread *worker : m_workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void InferenceScheduler::submit(const QString &requestId, const QByteArray &pcm, Priority priority,
+                                const QSharedPointer<const CommandGrammar> &grammar)
+{
+    Request request;
+    request.requestId = requestId;
+    request.pcm = pcm;
+    request.grammar = grammar;
+    request.queued.start();
+
+    QMutexLocker locker(&m_mutex);
+    if (priority == Interactive) {
+        m_interactiveQueue.append(request);
+        m_interactiveReady.wakeOne();
+    } else {
+        m_batchQueue.append(request);
+        m_batchReady.wakeOne();
+    }
+}
+
+bool InferenceScheduler::cancel(const QString &requestId)
+{
+    QMutexLocker locker(&m_mutex);
+    for (QList<Request> *queue : {&m_interactiveQueue, &m_batchQueue}) {
+        for (int i = 0; i < queue->size(); ++i) {
+            if (queue->at(i).requestId == requestId) {
+                queue->removeAt(i);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int InferenceScheduler::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_interactiveQueue.size() + m_batchQueue.size();
+}
+
+QList<InferenceScheduler::PendingRequest> InferenceScheduler::takePending()
+{
+    QMutexLocker locker(&m_mutex);
+    QList<PendingRequest> pending;
+    for (const Request &request : m_interactiveQueue) {
+        pending.append({request.requestId, request.pcm, Interactive, request.grammar});
+    }
+    for (const Request &request : m_batchQueue) {
+        pending.append({request.requestId, request.pcm, Batch, request.grammar});
+    }
+    m_interactiveQueue.clear();
+    m_batchQueue.clear();
+    return pending;
+}
+
+void InferenceScheduler::workerLoop(Priority lane)
+{
+    QList<Request> &queue = (lane == Interactive) ? m_interactiveQueue : m_batchQueue;
+    QWaitCondition &ready = (lane == Interactive) ? m_interactiveReady : m_batchReady;
+
+    // 每个工作线程一个工作区，按最长语音和最大批量预留，之后的推理复用
+    SenseVoiceEngine::Workspace workspace(*m_engine, m_options.intraOpThreads);
+    m_engine->reserveWorkspace(workspace, m_options.maxBatchSize);
+
+    forever {
+        QList<Request> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopping && queue.isEmpty()) {
+                ready.wait(&m_mutex);
+            }
+
+            // Batch队列：未凑满一批时，等到最早的请求用完延迟预算
+            if (lane == Batch) {
+                while (!m_stopping && !queue.isEmpty() && queue.size() < m_options.maxBatchSize) {
+                    qint64 remaining = m_options.latencyBudgetMs - queue.first().queued.elapsed();
+                    if (remaining <= 0) {
+                        break;
+                    }
+                    ready.wait(&m_mutex, static_cast<unsigned long>(remaining));
+                }
+            }
+
+            if (m_stopping) {
+                return;
+            }
+            if (queue.isEmpty()) {
+                continue;       // 等待期间被取消或被其他线程取走
+            }
+            takeBatch(queue, batch);
+        }
+
+        QVector<QByteArray> utterances;
+        QVector<const CommandGrammar *> grammars;
+        utterances.reserve(batch.size());
+        grammars.reserve(batch.size());
+        for (const Request &request : batch) {
+            utterances.append(request.pcm);
+            grammars.append(request.grammar.data());
+        }
+
+        // 按此刻同时推理的工作线程数分配核心，负载下降后下一批自动放宽
+        const int busy = m_busyWorkers.fetchAndAddRelaxed(1) + 1;
+        workspace.pool.setActiveThreads(qBound(1, m_options.threadBudget / busy, m_options.intraOpThreads));
+
+        QElapsedTimer timer;
+        timer.start();
+        QStringList texts = m_engine->recognizeBatch(utterances, workspace, grammars);
+        m_busyWorkers.fetchAndAddRelaxed(-1);
+        qCTrace(lcEngine) << "🧠 批量推理完成，队列:" << (lane == Interactive ? "interactive" : "batch")
+                          << "条数:" << batch.size() << "线程:" << workspace.pool.activeThreads()
+                          << "最早请求等待(ms):" << batch.first().queued.elapsed() - timer.elapsed()
+                          << "推理耗时(ms):" << timer.elapsed();
+
+        for (int i = 0; i < batch.size(); ++i) {
+            if (batch[i].grammar) {
+                emit commandFinished(batch[i].requestId, texts.value(i), workspace.matches[i].confidence);
+            } else {
+                emit requestFinished(batch[i].requestId, texts.value(i));
+            }
+        }
+    }
+}
+
+void InferenceScheduler::takeBatch(QList<Request> &queue, QList<Request> &batch) const
+{
+    if (queue.size() <= m_options.maxBatchSize) {
+        batch.swap(queue);
+        return;
+    }
+
+    // 最早的请求必定入选（避免饿死），其余按与它的时长差从小到大挑选
+    const int anchorSize = queue.first().pcm.size();
+    QVector<int> candidates;
+    for (int i = 1; i < queue.size(); ++i) {
+        candidates.append(i);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&queue, anchorSize](int a, int b) {
+        return std::abs(queue[a].pcm.size() - anchorSize) < std::abs(queue[b].pcm.size() - anchorSize);
+    });
+    candidates.resize(m_options.maxBatchSize - 1);
+    candidates.prepend(0);
+    std::sort(candidates.begin(), candidates.end());
+
+    for (int i = candidates.size() - 1; i >= 0; --i) {
+        batch.prepend(queue.takeAt(candidates[i]));
+    }
+}
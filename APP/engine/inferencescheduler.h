@@ -0,0 +1,157 @@
+#ifndef INFERENCESCHEDULER_H
+#define INFERENCESCHEDULER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class SenseVoiceEngine;
+class CommandGrammar;
+
+/**
+ * 函数名称：`InferenceScheduler`
+ * 功能描述：内置引擎的推理调度器，把多个来源（多个控件、批量任务）的整句识别请求
+ *           在延迟预算内攒成批，按帧数排序补齐后一次推理，再把结果分发回各请求
+ * 设计特点：
+ *   - 两条队列：Interactive为当前聚焦控件的请求，Batch为后台批量任务
+ *   - 0号工作线程只处理Interactive队列，批量任务再多也不会让交互请求排队
+ *   - Interactive请求不等待延迟预算，只合并已经在队列中的交互请求
+ *   - 每个工作线程的intra-op线程池最多intraOpThreads个线程，实际宽度按同时推理的工作线程数
+ *     均分threadBudget：单个请求独占全部核心，并发时各请求自动收窄，避免超额订阅
+ * 线程安全：submit/cancel可在任意线程调用，结果通过requestFinished信号发出（来自工作线程）
+ */
+class InferenceScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Interactive,
+        Batch
+    };
+
+    /**
+     * 调度参数
+     */
+    struct Options {
+        int latencyBudgetMs = 30;       // Batch请求最多等待多久以凑批
+        int maxBatchSize = 8;           // 每批最多条数
+        int batchWorkers = 1;           // Batch队列的工作线程数（另有1个交互线程），即并发推理的会话数
+        int intraOpThreads = 1;         // 每个工作线程单次推理的最大并行线程数
+        int threadBudget = 0;           // 所有工作线程共用的核心数，<=0时取QThread::idealThreadCount()
+    };
+
+    /**
+     * 尚未开始推理的请求，重建调度器时用于迁移
+     */
+    struct PendingRequest {
+        QString requestId;
+        QByteArray pcm;
+        Priority priority;
+        QSharedPointer<const CommandGrammar> grammar;
+    };
+
+    explicit InferenceScheduler(const SenseVoiceEngine *engine, const Options &options,
+                                QObject *parent = nullptr);
+    ~InferenceScheduler();
+
+    /**
+     * 函数名称：`submit`
+     * 功能描述：提交一条整句识别请求
+     * 参数说明：
+     *     - requestId：QString，请求ID，随结果返回
+     *     - pcm：QByteArray，16kHz单声道16位PCM
+     *     - priority：Priority，所属队列
+     *     - grammar：QSharedPointer<const CommandGrammar>，受限词表，为空时自由识别；
+     *       指定时结果通过commandFinished发出
+     * 返回值：void
+     */
+    void submit(const QString &requestId, const QByteArray &pcm, Priority priority,
+                const QSharedPointer<const CommandGrammar> &grammar = QSharedPointer<const CommandGrammar>());
+
+    /**
+     * 函数名称：`cancel`
+     * 功能描述：取消尚未开始推理的请求，已在推理中的请求照常返回
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     * 返回值：bool，是否从队列中移除
+     */
+    bool cancel(const QString &requestId);
+
+    /**
+     * 函数名称：`pendingCount`
+     * 功能描述：两条队列中等待推理的请求数
+     */
+    int pendingCount() const;
+
+    /**
+     * 函数名称：`takePending`
+     * 功能描述：取出两条队列中全部尚未开始的请求（按提交顺序，交互请求在前），用于切换线程配置时迁移到新调度器
+     * 参数说明：无
+     * 返回值：QList<PendingRequest>
+     */
+    QList<PendingRequest> takePending();
+
+    const Options &options() const { return m_options; }
+
+signals:
+    /**
+     * 信号名称：`requestFinished`
+     * 功能描述：单条请求识别完成
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - text：QString，识别文本
+     */
+    void requestFinished(const QString &requestId, const QString &text);
+
+    /**
+     * 信号名称：`commandFinished`
+     * 功能描述：指定了受限词表的请求识别完成
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - phrase：QString，匹配的短语，无匹配时为空
+     *     - confidence：double，置信度(0, 1]
+     */
+    void commandFinished(const QString &requestId, const QString &phrase, double confidence);
+
+private:
+    struct Request {
+        QString requestId;
+        QByteArray pcm;
+        QSharedPointer<const CommandGrammar> grammar;
+        QElapsedTimer queued;
+    };
+
+    void workerLoop(Priority lane);
+
+    /**
+     * 函数名称：`takeBatch`
+     * 功能描述：从队列中取出一批：以最早的请求为基准，挑选时长最接近的若干条，减少补齐的浪费
+     * 参数说明：
+     *     - queue：QList<Request>&，队列（调用方已加锁）
+     *     - batch：QList<Request>&，输出的一批
+     * 返回值：void
+     */
+    void takeBatch(QList<Request> &queue, QList<Request> &batch) const;
+
+private:
+    const SenseVoiceEngine *m_engine;
+    Options m_options;
+    mutable QMutex m_mutex;
+    QWaitCondition m_interactiveReady;
+    QWaitCondition m_batchReady;
+    QList<Request> m_interactiveQueue;
+    QList<Request> m_batchQueue;
+    QList<QThread *> m_workers;
+    QAtomicInt m_busyWorkers;           // 正在推理的工作线程数，决定每个请求的intra-op宽度
+    bool m_stopping;
+};
+
+#endif // INFERENCESCHEDULER_H
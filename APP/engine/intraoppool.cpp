@@ -0,0 +1,111 @@
+#include "intraoppool.h"
+#include <algorithm>
+
+namespace {
+
+thread_local IntraOpPool *t_currentPool = nullptr;
+
+} // namespace
+
+IntraOpPool::IntraOpPool(int threads)
+    : m_active(std::max(1, threads))
+    , m_generation(0)
+    , m_helpers(0)
+    , m_pending(0)
+    , m_stopping(false)
+    , m_task(nullptr)
+    , m_context(nullptr)
+    , m_count(0)
+    , m_next(0)
+{
+    for (int i = 0; i + 1 < threads; ++i) {
+        m_workers.emplace_back([this, i]() { workLoop(i); });
+    }
+}
+
+IntraOpPool::~IntraOpPool()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
+
+void IntraOpPool::setActiveThreads(int count)
+{
+    m_active.store(std::max(1, std::min(count, threads())), std::memory_order_relaxed);
+}
+
+IntraOpPool *IntraOpPool::current()
+{
+    return t_currentPool;
+}
+
+IntraOpPool::Scope::Scope(IntraOpPool *pool)
+    : m_previous(t_currentPool)
+{
+    t_currentPool = pool;
+}
+
+IntraOpPool::Scope::~Scope()
+{
+    t_currentPool = m_previous;
+}
+
+void IntraOpPool::run(int count, Task task, void *context)
+{
+    const int helpers = std::min(activeThreads(), count) - 1;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_task = task;
+        m_context = context;
+        m_count = count;
+        m_next.store(0, std::memory_order_relaxed);
+        m_helpers = helpers;
+        m_pending = helpers;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // 调用线程同样领取任务，任务在线程间动态分配，较慢的线程少做几块
+    drainTasks();
+
+    std::unique_lock<std::mutex> locker(m_mutex);
+    m_done.wait(locker, [this]() { return m_pending == 0; });
+}
+
+void IntraOpPool::drainTasks()
+{
+    for (int index = m_next.fetch_add(1); index < m_count; index = m_next.fetch_add(1)) {
+        m_task(m_context, index);
+    }
+}
+
+void IntraOpPool::workLoop(int index)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            // 超出本轮参与数的线程继续等待下一轮
+            m_wake.wait(locker, [this, index, &seen]() {
+                return m_stopping || (m_generation != seen && index < m_helpers);
+            });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+        }
+
+        drainTasks();
+
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
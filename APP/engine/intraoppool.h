@@ -0,0 +1,122 @@
+#ifndef INTRAOPPOOL_H
+#define INTRAOPPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * 函数名称：`IntraOpPool`
+ * 功能描述：单次推理内部的并行线程池（intra-op），把矩阵乘等内核按输出块拆给多个线程
+ * 设计特点：
+ *   - 每个工作线程/识别会话一个，调用线程自己也参与计算，threads()个线程中只新建threads()-1个
+ *   - 内核不显式接收线程池：调用方用Scope把池绑定到当前线程，内核通过forEach()取用，未绑定时串行
+ *   - setActiveThreads()限制每次实际使用的线程数，调度器据此随并发请求数调整，不必重建线程
+ *   - 任务以函数指针+上下文传递，forEach不申请堆内存，不破坏推理路径的稳态零分配
+ *   - 不依赖Qt
+ */
+class IntraOpPool
+{
+public:
+    /**
+     * 函数名称：`IntraOpPool`
+     * 功能描述：创建线程池
+     * 参数说明：
+     *     - threads：int，总线程数（含调用线程），<=1时不创建线程
+     */
+    explicit IntraOpPool(int threads = 1);
+    ~IntraOpPool();
+
+    int threads() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    /**
+     * 函数名称：`setActiveThreads`
+     * 功能描述：之后每次并行最多使用的线程数，限制在[1, threads()]
+     * 参数说明：
+     *     - count：int，线程数
+     * 返回值：void
+     */
+    void setActiveThreads(int count);
+    int activeThreads() const { return m_active.load(std::memory_order_relaxed); }
+
+    /**
+     * 函数名称：`forEach`
+     * 功能描述：对[0, count)的每个下标调用fn(index)，使用当前线程绑定的池，未绑定时串行执行
+     * 参数说明：
+     *     - count：int，任务数
+     *     - fn：F，可调用对象，不同下标可能在不同线程中并发执行
+     * 返回值：void
+     */
+    template <typename F>
+    static void forEach(int count, F &&fn)
+    {
+        IntraOpPool *pool = current();
+        if (!pool || count <= 1 || pool->activeThreads() <= 1) {
+            for (int i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        pool->run(count, &invoke<typename std::remove_reference<F>::type>, &fn);
+    }
+
+    /**
+     * 函数名称：`current`
+     * 功能描述：当前线程绑定的池，未绑定时为nullptr
+     */
+    static IntraOpPool *current();
+
+    /**
+     * 函数名称：`Scope`
+     * 功能描述：在作用域内把池绑定到当前线程，析构时恢复之前的绑定
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(IntraOpPool *pool);
+        ~Scope();
+
+    private:
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        IntraOpPool *m_previous;
+    };
+
+private:
+    typedef void (*Task)(void *context, int index);
+
+    template <typename F>
+    static void invoke(void *context, int index)
+    {
+        (*static_cast<F *>(context))(index);
+    }
+
+    IntraOpPool(const IntraOpPool &) = delete;
+    IntraOpPool &operator=(const IntraOpPool &) = delete;
+
+    void run(int count, Task task, void *context);
+    void workLoop(int index);
+    void drainTasks();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::atomic<int> m_active;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // 新一轮任务
+    std::condition_variable m_done;     // 参与的线程全部完成
+    uint64_t m_generation;              // 每轮任务加1，工作线程据此判断是否有新任务
+    int m_helpers;                      // 本轮参与的工作线程数（不含调用线程）
+    int m_pending;                      // 本轮尚未完成的工作线程数
+    bool m_stopping;
+    Task m_task;
+    void *m_context;
+    int m_count;
+    std::atomic<int> m_next;            // 下一个待领取的下标
+};
+
+#endif // INTRAOPPOOL_H
@@ -0,0 +1,276 @@
+#include "keywordspotter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float INF_COST = 1e30f;
+const float LN_PER_DB = 0.2302585f;         // ln(10) / 10，dB换算为自然对数能量
+const float MIN_NOISE_FLOOR = 6.0f;         // 噪声底下限（自然对数能量，约几个LSB的底噪），数字静音后不把底噪当语音
+const int MIN_TEMPLATE_MS = 240;
+const int MAX_TEMPLATE_MS = 2000;
+const int CONFIRM_FRAMES = 3;               // 候选命中后再观察几帧，取代价最低的结束位置
+
+WavFrontend::Options frontendOptions(const KeywordSpotter::Options &options)
+{
+    // 不拼帧，只按帧移抽取Fbank帧，不做CMVN（帧内归一化代替）
+    WavFrontend::Options frontend;
+    frontend.melBins = options.melBins;
+    frontend.lfrM = 1;
+    frontend.lfrN = std::max(options.frameShiftMs / frontend.frameShiftMs, 1);
+    return frontend;
+}
+
+} // namespace
+
+KeywordSpotter::KeywordSpotter()
+    : KeywordSpotter(Options())
+{
+}
+
+KeywordSpotter::KeywordSpotter(const Options &options)
+    : m_options(options)
+    , m_frontendOptions(frontendOptions(options))
+    , m_frontend(m_frontendOptions, nullptr, nullptr)
+    , m_noiseFloor(m_frontendOptions.frameShiftMs * m_frontendOptions.lfrN, LN_PER_DB, MIN_NOISE_FLOOR)
+{
+    m_options.frameShiftMs = m_frontendOptions.frameShiftMs * m_frontendOptions.lfrN;
+    reset();
+}
+
+bool KeywordSpotter::addTemplate(const int16_t *samples, int count)
+{
+    const int dim = m_options.melBins;
+    WavFrontend frontend(m_frontendOptions, nullptr, nullptr);
+    frontend.acceptWaveform(samples, count);
+    std::vector<float> features;
+    const int frames = frontend.popFeatures(features, true);
+    if (frames == 0) {
+        return false;
+    }
+
+    std::vector<float> energy(frames);
+    for (int f = 0; f < frames; ++f) {
+        energy[f] = normalizeFrame(features.data() + static_cast<size_t>(f) * dim);
+    }
+
+    // 以最安静的10%帧为噪声底裁掉首尾静音
+    std::vector<float> sorted(energy);
+    std::nth_element(sorted.begin(), sorted.begin() + frames / 10, sorted.end());
+    const float speechLevel = sorted[frames / 10] + m_options.speechMarginDb * LN_PER_DB;
+    int first = 0;
+    int last = frames - 1;
+    while (first < last && energy[first] <= speechLevel) {
+        ++first;
+    }
+    while (last > first && energy[last] <= speechLevel) {
+        --last;
+    }
+    if (first == last) {
+        first = 0;                      // 录音里没有明显的静音段，整段作为模板
+        last = frames - 1;
+    }
+
+    const int length = last - first + 1;
+    if (length * m_options.frameShiftMs < MIN_TEMPLATE_MS || length * m_options.frameShiftMs > MAX_TEMPLATE_MS) {
+        return false;
+    }
+
+    Template keyword;
+    keyword.length = length;
+    keyword.frames.assign(features.begin() + static_cast<size_t>(first) * dim,
+                          features.begin() + static_cast<size_t>(last + 1) * dim);
+    keyword.cost.assign(length, INF_COST);
+    keyword.steps.assign(length, 0);
+    keyword.nextCost.assign(length, INF_COST);
+    keyword.nextSteps.assign(length, 0);
+    m_templates.push_back(keyword);
+    return true;
+}
+
+void KeywordSpotter::clearTemplates()
+{
+    m_templates.clear();
+    reset();
+}
+
+void KeywordSpotter::reset()
+{
+    m_frontend.reset();
+    m_samples = 0;
+    m_frames = 0;
+    m_matchedFrames = 0;
+    m_noiseFloor.reset();
+    m_silentFrames = 0;
+    m_refractoryUntil = 0;
+    m_pending = false;
+    m_pendingFrame = 0;
+    m_pendingDetection = Detection();
+    m_detection = Detection();
+    m_detected = false;
+    m_searchActive = true;
+    resetSearch();
+}
+
+bool KeywordSpotter::acceptWaveform(const int16_t *samples, int count)
+{
+    m_detected = false;
+    m_samples += count;
+    m_frontend.acceptWaveform(samples, count);
+
+    m_features.clear();
+    const int frames = m_frontend.popFeatures(m_features, false);
+    for (int f = 0; f < frames; ++f) {
+        processFrame(m_features.data() + static_cast<size_t>(f) * m_options.melBins);
+    }
+    return m_detected;
+}
+
+float KeywordSpotter::normalizeFrame(float *frame) const
+{
+    const int dim = m_options.melBins;
+    float mean = 0.0f;
+    for (int d = 0; d < dim; ++d) {
+        mean += frame[d];
+    }
+    mean /= dim;
+
+    float norm = 0.0f;
+    for (int d = 0; d < dim; ++d) {
+        frame[d] -= mean;
+        norm += frame[d] * frame[d];
+    }
+    const float scale = norm > 1e-12f ? 1.0f / std::sqrt(norm) : 0.0f;
+    for (int d = 0; d < dim; ++d) {
+        frame[d] *= scale;
+    }
+    return mean;
+}
+
+void KeywordSpotter::processFrame(float *frame)
+{
+    const int64_t index = m_frames++;
+    const float energy = normalizeFrame(frame);
+    const float noiseFloor = m_noiseFloor.update(energy);
+
+    if (energy > noiseFloor + m_options.speechMarginDb * LN_PER_DB) {
+        m_silentFrames = 0;
+    } else {
+        ++m_silentFrames;
+    }
+
+    // 静音超过hangover：唤醒词不会跨越长静音，确认候选并清空代价，之后跳过匹配
+    if (m_silentFrames * m_options.frameShiftMs > m_options.hangoverMs) {
+        if (m_pending) {
+            confirmPending();
+        }
+        if (m_searchActive) {
+            resetSearch();
+        }
+        return;
+    }
+
+    matchFrame(frame, index);
+    ++m_matchedFrames;
+}
+
+void KeywordSpotter::matchFrame(const float *frame, int64_t index)
+{
+    const int dim = m_options.melBins;
+    m_searchActive = true;
+
+    int bestTemplate = -1;
+    float bestDistance = m_options.threshold;
+    for (size_t t = 0; t < m_templates.size(); ++t) {
+        Template &keyword = m_templates[t];
+        const int length = keyword.length;
+        const int maxSteps = 2 * length;
+
+        // 子序列DTW：输入每帧前进一步，模板停留、前进一帧或跳过一帧，
+        // 路径可从任意输入帧开始；按路径的平均代价选择前驱，长度不超过模板的2倍
+        for (int j = 0; j < length; ++j) {
+            const float *reference = keyword.frames.data() + static_cast<size_t>(j) * dim;
+            float dot = 0.0f;
+            for (int d = 0; d < dim; ++d) {
+                dot += frame[d] * reference[d];
+            }
+            const float distance = 1.0f - dot;
+
+            float cost = INF_COST;
+            int steps = 0;
+            float bestAverage = INF_COST;
+            auto consider = [&](float previousCost, int previousSteps) {
+                if (previousCost >= INF_COST || previousSteps + 1 > maxSteps) {
+                    return;
+                }
+                const float average = (previousCost + distance) / (previousSteps + 1);
+                if (average < bestAverage) {
+                    bestAverage = average;
+                    cost = previousCost + distance;
+                    steps = previousSteps + 1;
+                }
+            };
+            if (j == 0) {
+                consider(0.0f, 0);
+            }
+            consider(keyword.cost[j], keyword.steps[j]);
+            if (j >= 1) {
+                consider(keyword.cost[j - 1], keyword.steps[j - 1]);
+            }
+            if (j >= 2) {
+                consider(keyword.cost[j - 2], keyword.steps[j - 2]);
+            }
+            keyword.nextCost[j] = cost;
+            keyword.nextSteps[j] = steps;
+        }
+        keyword.cost.swap(keyword.nextCost);
+        keyword.steps.swap(keyword.nextSteps);
+
+        const int steps = keyword.steps[length - 1];
+        if (steps > 0 && keyword.cost[length - 1] < INF_COST) {
+            const float average = keyword.cost[length - 1] / steps;
+            if (average < bestDistance) {
+                bestDistance = average;
+                bestTemplate = static_cast<int>(t);
+            }
+        }
+    }
+
+    if (bestTemplate >= 0 && index >= m_refractoryUntil
+            && (!m_pending || bestDistance < m_pendingDetection.distance)) {
+        m_pending = true;
+        m_pendingFrame = index;
+        m_pendingDetection.templateIndex = bestTemplate;
+        m_pendingDetection.distance = bestDistance;
+        m_pendingDetection.endSample = frameEndSample(index);
+    }
+    if (m_pending && index - m_pendingFrame >= CONFIRM_FRAMES) {
+        confirmPending();
+    }
+}
+
+void KeywordSpotter::confirmPending()
+{
+    m_detection = m_pendingDetection;
+    m_detected = true;
+    m_pending = false;
+    m_pendingDetection = Detection();
+    m_refractoryUntil = m_frames + m_options.refractoryMs / m_options.frameShiftMs;
+    resetSearch();
+}
+
+void KeywordSpotter::resetSearch()
+{
+    for (Template &keyword : m_templates) {
+        std::fill(keyword.cost.begin(), keyword.cost.end(), INF_COST);
+        std::fill(keyword.steps.begin(), keyword.steps.end(), 0);
+    }
+    m_searchActive = false;
+}
+
+int64_t KeywordSpotter::frameEndSample(int64_t index) const
+{
+    const int64_t shift = m_frontendOptions.sampleRate * m_frontendOptions.frameShiftMs / 1000;
+    const int64_t length = m_frontendOptions.sampleRate * m_frontendOptions.frameLengthMs / 1000;
+    return index * m_frontendOptions.lfrN * shift + length;
+}
@@ -0,0 +1,146 @@
+#ifndef KEYWORDSPOTTER_H
+#define KEYWORDSPOTTER_H
+
+#include "wavfrontend.h"
+#include "frameenergy.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * 函数名称：`KeywordSpotter`
+ * 功能描述：常驻后台的唤醒词检测：操作员录几遍唤醒词作为模板，麦克风音频逐块送入，
+ *           用流式子序列DTW与模板比对，命中时给出唤醒词结束位置，由管理器开始正常录音
+ * 设计特点：
+ *   - 不依赖识别模型：40维Fbank每30ms取一帧，去掉帧内均值后归一化，逐帧余弦距离，
+ *     对音量和麦克风增益不敏感
+ *   - 能量门控：帧能量低于噪声底+speechMarginDb时不做匹配，安静环境下只剩Fbank的开销
+ *   - 每个模板只保存一列DTW代价，内存与模板长度成正比；稳态下不分配内存
+ *   - 同时给出语音/静音状态（trailingSilenceMs），供免按键录音判断说完
+ * 线程安全：只能在一个线程中使用
+ */
+class KeywordSpotter
+{
+public:
+    /**
+     * 检测参数
+     */
+    struct Options {
+        int melBins = 40;
+        int frameShiftMs = 30;          // 匹配帧移，须为10ms的整数倍
+        float threshold = 0.20f;        // 对齐路径的平均余弦距离低于此值判为命中，可用kwsbench按误唤醒率调整
+        float speechMarginDb = 9.0f;    // 帧能量高出噪声底多少dB视为语音
+        int hangoverMs = 300;           // 语音结束后继续匹配的时长，覆盖唤醒词末尾的弱音
+        int refractoryMs = 1500;        // 命中后多久内不再命中
+    };
+
+    /**
+     * 命中结果
+     */
+    struct Detection {
+        int templateIndex = -1;         // 命中的模板
+        float distance = 0.0f;          // 平均余弦距离
+        int64_t endSample = 0;          // 唤醒词结束位置，自reset()起的采样序号
+    };
+
+    KeywordSpotter();
+    explicit KeywordSpotter(const Options &options);
+
+    /**
+     * 函数名称：`addTemplate`
+     * 功能描述：添加一遍唤醒词录音作为模板，自动裁掉首尾静音
+     * 参数说明：
+     *     - samples：const int16_t*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：bool，裁剪后长度在0.24~2秒之间才有效
+     */
+    bool addTemplate(const int16_t *samples, int count);
+
+    void clearTemplates();
+    int templateCount() const { return static_cast<int>(m_templates.size()); }
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：清空流式状态（噪声底、DTW代价、采样计数），模板保留
+     */
+    void reset();
+
+    /**
+     * 函数名称：`acceptWaveform`
+     * 功能描述：送入一块麦克风音频
+     * 参数说明：
+     *     - samples：const int16_t*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：bool，本块内是否命中，命中信息见lastDetection()
+     */
+    bool acceptWaveform(const int16_t *samples, int count);
+
+    const Detection &lastDetection() const { return m_detection; }
+
+    /**
+     * 函数名称：`isSpeech`/`trailingSilenceMs`
+     * 功能描述：最近一帧是否为语音；末尾连续静音的时长
+     */
+    bool isSpeech() const { return m_silentFrames == 0 && m_frames > 0; }
+    int trailingSilenceMs() const { return m_silentFrames * m_options.frameShiftMs; }
+
+    /**
+     * 函数名称：`samplesAccepted`/`frames`/`matchedFrames`
+     * 功能描述：统计：送入的采样数、产出的帧数、其中做了DTW匹配的帧数（门控的效果）
+     */
+    int64_t samplesAccepted() const { return m_samples; }
+    int64_t frames() const { return m_frames; }
+    int64_t matchedFrames() const { return m_matchedFrames; }
+
+    const Options &options() const { return m_options; }
+
+private:
+    struct Template {
+        std::vector<float> frames;      // [length, melBins]，已归一化
+        int length = 0;
+        std::vector<float> cost;        // 当前帧的DTW累计代价 [length]
+        std::vector<int> steps;         // 对应路径的输入帧数 [length]
+        std::vector<float> nextCost;
+        std::vector<int> nextSteps;
+    };
+
+    /**
+     * 函数名称：`normalizeFrame`
+     * 功能描述：去掉帧内均值并归一化为单位长度，返回帧的平均对数能量
+     */
+    float normalizeFrame(float *frame) const;
+
+    void processFrame(float *frame);
+    void matchFrame(const float *frame, int64_t index);
+    void confirmPending();
+    void resetSearch();
+
+    /**
+     * 函数名称：`frameEndSample`
+     * 功能描述：第index个匹配帧对应音频的结束采样
+     */
+    int64_t frameEndSample(int64_t index) const;
+
+private:
+    Options m_options;
+    WavFrontend::Options m_frontendOptions;
+    WavFrontend m_frontend;
+    std::vector<float> m_features;      // popFeatures的输出，容量复用
+    std::vector<Template> m_templates;
+
+    int64_t m_samples;
+    int64_t m_frames;
+    int64_t m_matchedFrames;
+    NoiseFloor m_noiseFloor;            // 噪声底（自然对数能量）
+    int m_silentFrames;                 // 末尾连续静音帧数
+    int64_t m_refractoryUntil;          // 此帧之前不再命中
+    bool m_searchActive;                // DTW代价是否有效，静音时清空一次后跳过
+
+    // 候选命中：等代价不再下降时才确认，取对齐最好的结束位置
+    bool m_pending;
+    int64_t m_pendingFrame;
+    Detection m_pendingDetection;
+    Detection m_detection;
+    bool m_detected;
+};
+
+#endif // KEYWORDSPOTTER_H
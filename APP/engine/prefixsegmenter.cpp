@@ -0,0 +1,91 @@
+#include "prefixsegmenter.h"
+#include <algorithm>
+
+namespace {
+
+const int FORCED_CUT_SEARCH_MS = 1000;      // 强制切分时在最近多长时间内找能量最低的帧
+
+} // namespace
+
+PrefixSegmenter::PrefixSegmenter()
+    : PrefixSegmenter(Options())
+{
+}
+
+PrefixSegmenter::PrefixSegmenter(const Options &options)
+    : m_options(options)
+    , m_frameLength(options.sampleRate * options.frameMs / 1000)
+    , m_framer(m_frameLength)
+    , m_noiseFloor(options.frameMs, 1.0f, NoiseFloor::MIN_DB)
+{
+    reset();
+}
+
+void PrefixSegmenter::reset()
+{
+    m_framer.reset();
+    m_frameEnergy.clear();
+    m_energyStart = 0;
+    m_samples = 0;
+    m_frames = 0;
+    m_noiseFloor.reset();
+    m_quietFrames = 0;
+    m_lastCut = 0;
+    m_cuts.clear();
+}
+
+void PrefixSegmenter::acceptWaveform(const int16_t *samples, int count)
+{
+    m_samples += count;
+    m_framer.accept(samples, count, [this](float energy) { processFrame(energy); });
+}
+
+bool PrefixSegmenter::takeCut(int64_t &cutSample)
+{
+    if (m_cuts.empty()) {
+        return false;
+    }
+    cutSample = m_cuts.front();
+    m_cuts.erase(m_cuts.begin());
+    return true;
+}
+
+void PrefixSegmenter::processFrame(float energy)
+{
+    const int64_t start = m_frames++ * m_frameLength;
+    const int64_t end = start + m_frameLength;
+    m_frameEnergy.push_back(energy);
+    const float noiseFloor = m_noiseFloor.update(energy);
+
+    m_quietFrames = energy <= noiseFloor + m_options.pauseMarginDb ? m_quietFrames + 1 : 0;
+
+    const int64_t elapsedMs = (end - m_lastCut) * 1000 / m_options.sampleRate;
+    if (elapsedMs < m_options.intervalMs) {
+        return;
+    }
+
+    // 停顿：切在低能量段的中点，两边的字都不会被切开
+    const int pauseFrames = std::max(m_options.pauseMs / m_options.frameMs, 1);
+    if (m_quietFrames >= pauseFrames) {
+        cutAt(end - static_cast<int64_t>(m_quietFrames) * m_frameLength / 2);
+        return;
+    }
+
+    // 一直不停顿：在最近1秒内能量最低的帧中点切开
+    if (elapsedMs >= m_options.maxIntervalMs) {
+        const int quietest = EnergyFramer::quietestFrame(m_frameEnergy, FORCED_CUT_SEARCH_MS / m_options.frameMs);
+        cutAt(m_energyStart + static_cast<int64_t>(quietest) * m_frameLength + m_frameLength / 2);
+    }
+}
+
+void PrefixSegmenter::cutAt(int64_t sample)
+{
+    m_cuts.push_back(sample);
+    m_lastCut = sample;
+    m_quietFrames = 0;
+
+    // 切点所在帧之后的能量保留，供下一次强制切分查找
+    const int64_t dropFrames = (sample - m_energyStart) / m_frameLength;
+    m_frameEnergy.erase(m_frameEnergy.begin(), m_frameEnergy.begin() + dropFrames);
+    m_energyStart += dropFrames * m_frameLength;
+}
@@ -0,0 +1,86 @@
+#ifndef PREFIXSEGMENTER_H
+#define PREFIXSEGMENTER_H
+
+#include "frameenergy.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * 函数名称：`PrefixSegmenter`
+ * 功能描述：按键录音期间为投机识别选切分点：每隔intervalMs在停顿处切一刀，
+ *           切点之前的音频可先送去识别，松键后只需识别最后一段
+ * 设计特点：
+ *   - 与Endpointer共用10ms帧能量和自适应噪声底（frameenergy.h），但不丢弃任何音频，分段首尾相接覆盖整段录音
+ *   - 距上一切点超过intervalMs后，遇到连续pauseMs的低能量帧即在其中点切分；pauseMs取短语之间的停顿，
+ *     塞音成阻（约50~100ms）等词内的短暂静音不会被当成切点
+ *   - 一直不停顿时，达到maxIntervalMs后在最近1秒内能量最低的帧中点强制切分
+ *   - 只保存上一切点之后的帧能量，内存与录音时长无关
+ * 线程安全：只能在一个线程中使用
+ */
+class PrefixSegmenter
+{
+public:
+    /**
+     * 切分参数
+     */
+    struct Options {
+        int sampleRate = 16000;
+        int frameMs = 10;
+        int intervalMs = 4000;          // 分段的最短时长
+        int maxIntervalMs = 8000;       // 找不到停顿时的最长时长
+        int pauseMs = 300;              // 多长的低能量视为停顿（短语间的停顿，不短于250ms）
+        float pauseMarginDb = 6.0f;     // 帧能量不超过噪声底多少dB视为低能量
+    };
+
+    PrefixSegmenter();
+    explicit PrefixSegmenter(const Options &options);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：重新开始，采样序号归零
+     */
+    void reset();
+
+    /**
+     * 函数名称：`acceptWaveform`
+     * 功能描述：送入一块音频，产生的切点通过takeCut取走
+     * 参数说明：
+     *     - samples：const int16_t*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：void
+     */
+    void acceptWaveform(const int16_t *samples, int count);
+
+    /**
+     * 函数名称：`takeCut`
+     * 功能描述：取出一个切点
+     * 参数说明：
+     *     - cutSample：int64_t&，切点的采样序号（自reset()起）
+     * 返回值：bool，没有新切点时返回false
+     */
+    bool takeCut(int64_t &cutSample);
+
+    int64_t samplesAccepted() const { return m_samples; }
+    int64_t lastCut() const { return m_lastCut; }
+
+private:
+    void processFrame(float energy);
+    void cutAt(int64_t sample);
+
+private:
+    Options m_options;
+    int m_frameLength;                  // 每帧采样数
+
+    EnergyFramer m_framer;
+    std::vector<float> m_frameEnergy;   // 上一切点之后每帧的能量(dB)
+    int64_t m_energyStart;              // m_frameEnergy首帧的起始采样
+    int64_t m_samples;
+    int64_t m_frames;
+
+    NoiseFloor m_noiseFloor;            // 噪声底(dB)
+    int m_quietFrames;                  // 当前连续低能量帧数
+    int64_t m_lastCut;
+    std::vector<int64_t> m_cuts;        // 未取走的切点
+};
+
+#endif // PREFIXSEGMENTER_H
@@ -0,0 +1,386 @@
+#include "sensevoiceengine.h"
+#include "enginekernels.h"
+#include "voicelogging.h"
+#include <QRegularExpression>
+#include <algorithm>
+
+SenseVoiceEngine::SenseVoiceEngine()
+    : m_languageId(0)
+    , m_textNormId(15)
+{
+}
+
+bool SenseVoiceEngine::load(const QString &modelFile, QString *errorMessage)
+{
+    // auto：按文件中的权重，int8文件用int8、fp32文件用fp32，权重都直接指向只读映射；
+    // 显式指定int8时fp32文件在加载时量化到堆上（每个进程一份），多实例部署应改用export_native.py --quantize导出的文件
+    SenseVoiceModel::Precision precision = SenseVoiceModel::Float32;
+    if (m_options.precision == "int8") {
+        precision = SenseVoiceModel::Int8;
+    } else if (m_options.precision != "fp32" && m_options.precision != "auto") {
+        qCWarning(lcEngine) << "🧠 未知精度" << m_options.precision << "，使用fp32";
+    }
+
+    EngineKernels::Isa isa = EngineKernels::bestIsa();
+    if (!EngineKernels::parseIsa(m_options.kernels.toLatin1().constData(), &isa)) {
+        qCWarning(lcEngine) << "🧠 未知内核指令集" << m_options.kernels << "，使用" << EngineKernels::isaName(isa);
+    }
+    EngineKernels::setIsa(isa);
+
+    if (!m_model.load(modelFile, errorMessage, precision)) {
+        return false;
+    }
+    setOptions(m_options);
+    return true;
+}
+
+void SenseVoiceEngine::setOptions(const Options &options)
+{
+    {
+        // 工作区的前端和线程池按模型配置和参数创建
+        QMutexLocker locker(&m_workspaceMutex);
+        m_workspace.reset();
+    }
+    m_options = options;
+    const SenseVoiceModel::Config &config = m_model.config();
+    m_languageId = config.languageIds.value(m_options.language, 0);
+    m_textNormId = config.textNormIds.value(m_options.useItn ? "withitn" : "woitn", 15);
+}
+
+WavFrontend::Options SenseVoiceEngine::frontendOptions() const
+{
+    const SenseVoiceModel::Config &config = m_model.config();
+    WavFrontend::Options options;
+    options.sampleRate = config.sampleRate;
+    options.melBins = config.melBins;
+    options.frameLengthMs = config.frameLengthMs;
+    options.frameShiftMs = config.frameShiftMs;
+    options.lfrM = config.lfrM;
+    options.lfrN = config.lfrN;
+    return options;
+}
+
+void SenseVoiceEngine::queryEmbeddings(float *out) const
+{
+    m_model.queryEmbeddings(m_languageId, m_textNormId, out);
+}
+
+SenseVoiceEngine::Workspace::Workspace(const SenseVoiceEngine &engine, int intraOpThreads)
+    : frontend(engine.frontendOptions(), engine.model().cmvnMeans(), engine.model().cmvnVars())
+    , pool(intraOpThreads > 0 ? intraOpThreads : engine.options().intraOpThreads)
+{
+}
+
+void SenseVoiceEngine::reserveWorkspace(Workspace &workspace, int maxBatch) const
+{
+    const SenseVoiceModel::Config &config = m_model.config();
+    const int maxSamples = m_options.maxUtteranceSeconds * config.sampleRate;
+    const int maxRows = SenseVoiceModel::QUERY_ROWS + workspace.frontend.lfrFrameCount(maxSamples);
+    const size_t align = InferenceArena::ALIGNMENT;
+
+    // 与recognizeTokens中的分配一一对应：输入数组、排序下标、长度、补齐后的特征，再加编码器
+    size_t bytes = static_cast<size_t>(maxBatch) * (sizeof(Utterance) + 2 * sizeof(int)) + 3 * align
+                 + static_cast<size_t>(maxBatch) * maxRows * config.inputSize * sizeof(float) + align
+                 + m_model.scratchBytes(maxBatch, maxRows);
+    workspace.arena.reserve(bytes);
+    workspace.tokenIds.resize(maxBatch);
+    workspace.matches.resize(maxBatch);
+    for (std::vector<int> &ids : workspace.tokenIds) {
+        ids.reserve(maxRows);
+    }
+}
+
+QString SenseVoiceEngine::recognize(const qint16 *samples, int count) const
+{
+    QMutexLocker locker(&m_workspaceMutex);
+    if (!m_workspace) {
+        m_workspace.reset(new Workspace(*this));
+        reserveWorkspace(*m_workspace, 1);
+    }
+    Utterance utterance = {samples, count};
+    recognizeTokens(&utterance, 1, *m_workspace);
+    return decodeTokens(m_workspace->tokenIds[0]);
+}
+
+QStringList SenseVoiceEngine::recognizeBatch(const QVector<QByteArray> &utterances, Workspace &workspace,
+                                             const QVector<const CommandGrammar *> &grammars) const
+{
+    const int batch = utterances.size();
+    workspace.arena.reset();
+    Utterance *inputs = workspace.arena.allocate<Utterance>(batch);
+    for (int i = 0; i < batch; ++i) {
+        inputs[i].samples = reinterpret_cast<const qint16 *>(utterances[i].constData());
+        inputs[i].count = utterances[i].size() / 2;
+        inputs[i].grammar = grammars.value(i, nullptr);
+    }
+    recognizeTokens(inputs, batch, workspace);
+
+    QStringList results;
+    for (int i = 0; i < batch; ++i) {
+        results.append(grammars.value(i, nullptr) ? workspace.matches[i].text : decodeTokens(workspace.tokenIds[i]));
+    }
+    return results;
+}
+
+void SenseVoiceEngine::recognizeTokens(const Utterance *utterances, int batch, Workspace &workspace) const
+{
+    const int dim = m_model.config().inputSize;
+    const int d = m_model.config().outputSize;
+    const int queryRows = SenseVoiceModel::QUERY_ROWS;
+    InferenceArena &arena = workspace.arena;
+
+    if (static_cast<int>(workspace.tokenIds.size()) < batch) {
+        workspace.tokenIds.resize(batch);
+    }
+    if (static_cast<int>(workspace.matches.size()) < batch) {
+        workspace.matches.resize(batch);
+    }
+    for (int i = 0; i < batch; ++i) {
+        workspace.tokenIds[i].clear();
+        workspace.matches[i] = CommandGrammar::Match();
+    }
+    if (batch == 0) {
+        return;
+    }
+
+    // 帧数可由采样数直接算出，按帧数从长到短排序后一次分配补齐的输入
+    int *order = arena.allocate<int>(batch);
+    int *lengths = arena.allocate<int>(batch);
+    for (int i = 0; i < batch; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order, order + batch, [utterances](int a, int b) {
+        return utterances[a].count > utterances[b].count;
+    });
+    const int maxRows = queryRows + workspace.frontend.lfrFrameCount(utterances[order[0]].count);
+    float *padded = arena.allocate<float>(static_cast<size_t>(batch) * maxRows * dim);
+
+    // 逐条提取特征，直接写入补齐后的位置（每条前面拼接查询向量，尾部补零）
+    for (int b = 0; b < batch; ++b) {
+        const Utterance &utterance = utterances[order[b]];
+        float *row = padded + static_cast<size_t>(b) * maxRows * dim;
+        queryEmbeddings(row);
+        workspace.frontend.reset();
+        workspace.frontend.acceptWaveform(utterance.samples, utterance.count);
+        lengths[b] = queryRows + workspace.frontend.popFeatures(row + static_cast<size_t>(queryRows) * dim, true);
+        std::fill(row + static_cast<size_t>(lengths[b]) * dim, row + static_cast<size_t>(maxRows) * dim, 0.0f);
+    }
+
+    IntraOpPool::Scope poolScope(&workspace.pool);
+    const float *encoded = m_model.encodeBatch(padded, lengths, batch, maxRows, arena);
+
+    // CTC只算有效帧，结果按原始顺序放回；受限解码跳过查询帧（只输出语种、情感等标签）
+    const int vocab = m_model.config().vocabSize;
+    for (int b = 0; b < batch; ++b) {
+        const float *logits = m_model.ctcLogits(encoded + static_cast<size_t>(b) * maxRows * d,
+                                                lengths[b], arena);
+        const CommandGrammar *grammar = utterances[order[b]].grammar;
+        if (grammar) {
+            workspace.search.reset(grammar);
+            workspace.search.advance(logits + static_cast<size_t>(queryRows) * vocab, lengths[b] - queryRows, vocab);
+            workspace.matches[order[b]] = workspace.search.best();
+        } else {
+            int lastToken = -1;
+            greedyDecode(logits, lengths[b], lastToken, workspace.tokenIds[order[b]]);
+        }
+    }
+    arena.reset();
+}
+
+void SenseVoiceEngine::recognizeAligned(const qint16 *samples, int count, Workspace &workspace,
+                                        std::vector<StablePrefixTracker::Token> &tokens) const
+{
+    const SenseVoiceModel::Config &config = m_model.config();
+    const int dim = config.inputSize;
+    const int queryRows = SenseVoiceModel::QUERY_ROWS;
+    InferenceArena &arena = workspace.arena;
+    tokens.clear();
+    if (workspace.tokenIds.empty()) {
+        workspace.tokenIds.resize(1);
+    }
+    std::vector<int> &tokenIds = workspace.tokenIds[0];
+    tokenIds.clear();
+
+    arena.reset();
+    int rows = queryRows + workspace.frontend.lfrFrameCount(count);
+    float *input = arena.allocate<float>(static_cast<size_t>(rows) * dim);
+    queryEmbeddings(input);
+    workspace.frontend.reset();
+    workspace.frontend.acceptWaveform(samples, count);
+    rows = queryRows + workspace.frontend.popFeatures(input + static_cast<size_t>(queryRows) * dim, true);
+
+    IntraOpPool::Scope poolScope(&workspace.pool);
+    const float *encoded = m_model.encodeBatch(input, &rows, 1, rows, arena);
+    const float *logits = m_model.ctcLogits(encoded, rows, arena);
+    int lastToken = -1;
+    greedyDecode(logits, rows, lastToken, tokenIds);
+
+    // 贪心结果本身就是一条合法路径，强制对齐只是在同一token序列下取概率最大的边界
+    if (workspace.aligner.align(logits, rows, config.vocabSize, tokenIds.data(), static_cast<int>(tokenIds.size()),
+                                config.blankId, workspace.alignment, &workspace.spans)) {
+        const int frameMs = config.frameShiftMs * config.lfrN;
+        tokens.resize(workspace.spans.size());
+        for (size_t i = 0; i < workspace.spans.size(); ++i) {
+            const CtcAligner::TokenSpan &span = workspace.spans[i];
+            tokens[i].id = span.token;
+            tokens[i].startMs = qMax(0, span.startFrame - queryRows) * frameMs;
+            tokens[i].endMs = qMax(0, span.endFrame - queryRows) * frameMs;
+        }
+    }
+    arena.reset();
+}
+
+void SenseVoiceEngine::greedyDecode(const float *logits, int rows, int &lastToken,
+                                    std::vector<int> &tokenIds) const
+{
+    const int vocab = m_model.config().vocabSize;
+    const int blank = m_model.config().blankId;
+    for (int r = 0; r < rows; ++r) {
+        int token = EngineKernels::argmax(logits + static_cast<size_t>(r) * vocab, vocab);
+        if (token != lastToken && token != blank) {
+            tokenIds.push_back(token);
+        }
+        lastToken = token;
+    }
+}
+
+QString SenseVoiceEngine::decodeTokens(const std::vector<int> &tokenIds) const
+{
+    static const QRegularExpression tagPattern("<\\|[^|]*\\|>");
+    const QStringList &tokens = m_model.tokens();
+
+    QString text;
+    for (int id : tokenIds) {
+        if (id >= 0 && id < tokens.size()) {
+            text += tokens.at(id);
+        }
+    }
+    text.replace(QChar(0x2581), QChar(' '));
+    text.remove(tagPattern);
+    return text.trimmed();
+}
+
+SenseVoiceStream::SenseVoiceStream(const SenseVoiceEngine *engine, int intraOpThreads)
+    : m_engine(engine)
+    , m_frontend(engine->frontendOptions(), engine->model().cmvnMeans(), engine->model().cmvnVars())
+    , m_pool(intraOpThreads > 0 ? intraOpThreads : engine->options().intraOpThreads)
+    , m_grammar(nullptr)
+    , m_lastToken(-1)
+    , m_finished(false)
+{
+    // 按最长语音预留：特征、token，以及整句注意力缓存下单块推理所需的arena
+    const SenseVoiceEngine::Options &options = engine->options();
+    const SenseVoiceModel &model = engine->model();
+    const int maxRows = SenseVoiceModel::QUERY_ROWS
+                      + m_frontend.lfrFrameCount(options.maxUtteranceSeconds * model.config().sampleRate);
+    const int chunkRows = SenseVoiceModel::QUERY_ROWS + qMax(1, options.chunkFrames) + qMax(0, options.lookaheadFrames);
+    const int cacheRows = options.lookBackFrames >= 0 ? options.lookBackFrames + chunkRows : maxRows;
+    m_arena.reserve(model.scratchBytes(1, chunkRows, cacheRows));
+    m_pending.reserve(static_cast<size_t>(chunkRows) * 2 * model.config().inputSize);
+    m_tokenIds.reserve(maxRows);
+    reset();
+
+    // 限定回看帧数时注意力缓存有上限，直接预留；整句回看则随最长的一句增长后复用
+    if (options.lookBackFrames >= 0) {
+        const size_t cacheFloats = static_cast<size_t>(cacheRows) * model.config().outputSize;
+        for (SenseVoiceModel::EncoderState::LayerCache &cache : m_state.layers) {
+            cache.keys.reserve(cacheFloats);
+            cache.values.reserve(cacheFloats);
+        }
+    }
+}
+
+void SenseVoiceStream::reset(const CommandGrammar *grammar)
+{
+    const SenseVoiceModel &model = m_engine->model();
+    model.resetState(m_state, true, m_engine->options().lookBackFrames);
+    m_frontend.reset();
+    m_pending.resize(static_cast<size_t>(SenseVoiceModel::QUERY_ROWS) * model.config().inputSize);
+    m_engine->queryEmbeddings(m_pending.data());
+    m_tokenIds.clear();
+    m_lastToken = -1;
+    m_finished = false;
+    m_grammar = grammar;
+    m_search.reset(grammar);
+}
+
+void SenseVoiceStream::acceptWaveform(const qint16 *samples, int count)
+{
+    if (m_finished || count <= 0) {
+        return;
+    }
+    m_frontend.acceptWaveform(samples, count);
+    m_frontend.popFeatures(m_pending, false);
+    processChunks(false);
+}
+
+void SenseVoiceStream::inputFinished()
+{
+    if (!m_finished) {
+        m_frontend.popFeatures(m_pending, true);
+        processChunks(true);
+        m_finished = true;
+    }
+}
+
+QString SenseVoiceStream::finish()
+{
+    inputFinished();
+    return partialText();
+}
+
+CommandGrammar::Match SenseVoiceStream::finishCommand()
+{
+    inputFinished();
+    return m_grammar ? m_search.best() : CommandGrammar::Match();
+}
+
+QString SenseVoiceStream::partialText() const
+{
+    return m_engine->decodeTokens(m_tokenIds);
+}
+
+void SenseVoiceStream::processChunks(bool isFinal)
+{
+    const SenseVoiceModel &model = m_engine->model();
+    const int dim = model.config().inputSize;
+    const int chunk = qMax(1, m_engine->options().chunkFrames);
+    const int lookahead = qMax(0, m_engine->options().lookaheadFrames);
+
+    IntraOpPool::Scope poolScope(&m_pool);
+    int available = static_cast<int>(m_pending.size() / dim);
+    int consumed = 0;
+    while (available - consumed > 0) {
+        int rows = 0;
+        int commit = 0;
+        if (available - consumed >= chunk + lookahead) {
+            rows = chunk + lookahead;
+            commit = chunk;
+        } else if (isFinal) {
+            // 最后一块：剩余帧全部提交
+            rows = available - consumed;
+            commit = rows;
+        } else {
+            break;
+        }
+
+        m_arena.reset();
+        const bool firstChunk = m_state.position == 0;
+        const float *encoded = model.encode(m_pending.data() + static_cast<size_t>(consumed) * dim,
+                                            rows, commit, m_state, m_arena);
+        const float *logits = model.ctcLogits(encoded, commit, m_arena);
+        if (m_grammar) {
+            // 受限解码逐块推进，首块跳过查询帧
+            const int vocab = model.config().vocabSize;
+            const int skip = firstChunk ? qMin(commit, static_cast<int>(SenseVoiceModel::QUERY_ROWS)) : 0;
+            m_search.advance(logits + static_cast<size_t>(skip) * vocab, commit - skip, vocab);
+        } else {
+            m_engine->greedyDecode(logits, commit, m_lastToken, m_tokenIds);
+        }
+        consumed += commit;
+    }
+
+    if (consumed > 0) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<size_t>(consumed) * dim);
+    }
+}
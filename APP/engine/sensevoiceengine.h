@@ -0,0 +1,300 @@
+#ifndef SENSEVOICEENGINE_H
+#define SENSEVOICEENGINE_H
+
+#include "sensevoicemodel.h"
+#include "wavfrontend.h"
+#include "inferencearena.h"
+#include "intraoppool.h"
+#include "commandgrammar.h"
+#include "ctcaligner.h"
+#include "stableprefixtracker.h"
+#include <QMutex>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+/**
+ * 函数名称：`SenseVoiceEngine`
+ * 功能描述：内置语音识别引擎，在进程内完成特征提取、编码和CTC解码，不依赖Python服务
+ * 设计特点：
+ *   - 模型只读共享，每句话的状态保存在SenseVoiceStream中，每个工作线程的临时内存保存在Workspace中
+ *   - Workspace和SenseVoiceStream跨调用复用，按最长语音预留容量后稳态推理不再分配堆内存
+ *   - recognize()为整句识别，recognizeBatch()为多句批量识别（由InferenceScheduler调度），
+ *     SenseVoiceStream为边录边算的分块识别
+ *   - 每句话可指定CommandGrammar，此时CTC在词表的前缀树内解码，直接返回最匹配的短语
+ */
+class SenseVoiceEngine
+{
+public:
+    /**
+     * 识别参数
+     */
+    struct Options {
+        QString language = "auto";      // 语种：auto/zh/en/yue/ja/ko
+        bool useItn = true;             // 是否输出标点与逆文本正则化
+        int chunkFrames = 10;           // 分块模式每块提交的LFR帧数（每帧60ms）
+        int lookaheadFrames = 5;        // 每块的右侧前瞻帧数
+        int lookBackFrames = -1;        // 注意力回看的已提交帧数，-1表示整句
+        int maxUtteranceSeconds = 30;   // 预留内存时按此时长估算
+        QString precision = "auto";     // 线性层精度：fp32/int8/auto（按模型文件的权重精度），仅在load()时生效
+        QString kernels = "auto";       // 内核指令集：auto/generic/avx2/avx512/avx512vnni，load()时设置，进程内全局生效
+        int intraOpThreads = 1;         // 单次推理内部的并行线程数（新建的Workspace/SenseVoiceStream按此创建线程池）
+    };
+
+    /**
+     * 一段待识别的PCM（不持有数据）
+     */
+    struct Utterance {
+        const qint16 *samples;
+        int count;
+        const CommandGrammar *grammar;  // 受限词表，nullptr（聚合初始化时省略）为自由识别
+    };
+
+    /**
+     * 函数名称：`Workspace`
+     * 功能描述：一个工作线程的推理工作区：arena、前端、intra-op线程池以及解码结果，跨调用复用
+     * 参数说明：
+     *     - intraOpThreads：int，线程池大小，<=0时取Options::intraOpThreads
+     * 线程安全：只能在一个线程中使用
+     */
+    struct Workspace {
+        explicit Workspace(const SenseVoiceEngine &engine, int intraOpThreads = 0);
+
+        InferenceArena arena;
+        WavFrontend frontend;
+        IntraOpPool pool;
+        CommandGrammar::Search search;
+        std::vector<std::vector<int>> tokenIds;     // recognizeTokens的结果，与输入顺序一致
+        std::vector<CommandGrammar::Match> matches; // 指定了词表的条目的匹配结果，与输入顺序一致
+        CtcAligner aligner;                         // recognizeAligned的对齐临时内存
+        std::vector<int> alignment;
+        std::vector<CtcAligner::TokenSpan> spans;
+    };
+
+    SenseVoiceEngine();
+
+    /**
+     * 函数名称：`load`
+     * 功能描述：加载模型权重，精度按Options::precision选择（需先调用setOptions）
+     * 参数说明：
+     *     - modelFile：QString，export_native.py导出的权重文件
+     *     - errorMessage：QString*，失败时写入错误信息，可为nullptr
+     * 返回值：bool，是否加载成功
+     */
+    bool load(const QString &modelFile, QString *errorMessage = nullptr);
+
+    bool isLoaded() const { return m_model.isLoaded(); }
+    const SenseVoiceModel &model() const { return m_model; }
+
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    /**
+     * 函数名称：`recognize`
+     * 功能描述：整句识别，使用引擎自带的工作区（首次调用时按maxUtteranceSeconds预留，之后复用）；
+     *           多个线程同时调用时依次执行，需要并发时各线程用自己的Workspace调用recognizeBatch
+     * 参数说明：
+     *     - samples：const qint16*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：QString，识别文本
+     */
+    QString recognize(const qint16 *samples, int count) const;
+
+    /**
+     * 函数名称：`recognizeTokens`
+     * 功能描述：多句整句识别合并为一次批量推理，按帧数排序后补齐（同infer_utils.py中的pad_list），
+     *           全部临时内存来自workspace.arena，结果写入workspace.tokenIds；
+     *           指定了grammar的条目改为受限解码，结果写入workspace.matches
+     * 参数说明：
+     *     - utterances：const Utterance*，每条为16kHz单声道16位PCM
+     *     - batch：int，条数
+     *     - workspace：Workspace&，当前线程的工作区
+     * 返回值：void
+     */
+    void recognizeTokens(const Utterance *utterances, int batch, Workspace &workspace) const;
+
+    /**
+     * 函数名称：`recognizeBatch`
+     * 功能描述：recognizeTokens并转换为文本
+     * 参数说明：
+     *     - utterances：QVector<QByteArray>，每条为16kHz单声道16位PCM
+     *     - workspace：Workspace&，当前线程的工作区
+     *     - grammars：QVector<const CommandGrammar*>，每条的受限词表，为空或元素为nullptr时自由识别
+     * 返回值：QStringList，与输入顺序一致的识别文本，受限解码的条目为匹配的短语（完整结果见workspace.matches）
+     */
+    QStringList recognizeBatch(const QVector<QByteArray> &utterances, Workspace &workspace,
+                               const QVector<const CommandGrammar *> &grammars
+                               = QVector<const CommandGrammar *>()) const;
+
+    /**
+     * 函数名称：`recognizeAligned`
+     * 功能描述：整句识别，再把结果强制对齐到CTC输出，给出每个token的时间戳（供中间结果的稳定前缀提交）
+     * 参数说明：
+     *     - samples：const qint16*，16kHz单声道PCM
+     *     - count：int，采样数
+     *     - workspace：Workspace&，当前线程的工作区
+     *     - tokens：std::vector<StablePrefixTracker::Token>&，输出token及其在音频中的起止毫秒，
+     *       语种、情感等标签token落在查询帧上，时间为0；不带时间戳的贪心结果同时留在workspace.tokenIds[0]
+     * 返回值：void
+     */
+    void recognizeAligned(const qint16 *samples, int count, Workspace &workspace,
+                          std::vector<StablePrefixTracker::Token> &tokens) const;
+
+    /**
+     * 函数名称：`reserveWorkspace`
+     * 功能描述：按Options::maxUtteranceSeconds预留工作区容量，避免首次推理时扩容
+     * 参数说明：
+     *     - workspace：Workspace&，工作区
+     *     - maxBatch：int，每批最多条数
+     * 返回值：void
+     */
+    void reserveWorkspace(Workspace &workspace, int maxBatch) const;
+
+    /**
+     * 函数名称：`decodeTokens`
+     * 功能描述：将CTC输出的token序列转换为文本，并去除<|...|>标签
+     * 参数说明：
+     *     - tokenIds：std::vector<int>，token ID序列
+     * 返回值：QString，文本
+     */
+    QString decodeTokens(const std::vector<int> &tokenIds) const;
+
+    /**
+     * 函数名称：`frontendOptions`
+     * 功能描述：根据模型配置生成前端参数
+     */
+    WavFrontend::Options frontendOptions() const;
+
+    /**
+     * 函数名称：`queryEmbeddings`
+     * 功能描述：按当前识别参数生成查询向量
+     * 参数说明：
+     *     - out：float*，输出 [QUERY_ROWS, inputSize]
+     */
+    void queryEmbeddings(float *out) const;
+
+    /**
+     * 函数名称：`greedyDecode`
+     * 功能描述：对logits逐帧取最大值，合并连续重复并去除blank
+     * 参数说明：
+     *     - logits：const float*，CTC logits [rows, vocabSize]
+     *     - rows：int，帧数
+     *     - lastToken：int&，上一帧的token，跨块合并重复用
+     *     - tokenIds：std::vector<int>&，追加输出的token
+     * 返回值：void
+     */
+    void greedyDecode(const float *logits, int rows, int &lastToken, std::vector<int> &tokenIds) const;
+
+private:
+    SenseVoiceModel m_model;
+    Options m_options;
+    int m_languageId;                   // 由m_options换算的查询向量ID，避免推理时查表
+    int m_textNormId;
+    mutable QMutex m_workspaceMutex;
+    mutable QScopedPointer<Workspace> m_workspace;     // recognize()的工作区，加载或修改参数后重建
+};
+
+/**
+ * 函数名称：`SenseVoiceStream`
+ * 功能描述：一次分块识别会话：录音过程中不断送入PCM，凑满一块就执行编码和解码，
+ *           松开按键时只需处理最后一块
+ * 线程安全：单个会话只能在一个线程中使用
+ */
+class SenseVoiceStream
+{
+public:
+    /**
+     * 函数名称：`SenseVoiceStream`
+     * 功能描述：创建识别会话并按最长语音预留容量
+     * 参数说明：
+     *     - engine：const SenseVoiceEngine*，已加载的引擎
+     *     - intraOpThreads：int，每块推理的线程池大小，<=0时取Options::intraOpThreads
+     */
+    explicit SenseVoiceStream(const SenseVoiceEngine *engine, int intraOpThreads = 0);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：开始新的一句话，保留上一句的缓冲区和缓存容量
+     * 参数说明：
+     *     - grammar：const CommandGrammar*，本句的受限词表，nullptr为自由识别；不转移所有权，本句结束前须保持有效
+     * 返回值：void
+     */
+    void reset(const CommandGrammar *grammar = nullptr);
+
+    /**
+     * 函数名称：`acceptWaveform`
+     * 功能描述：送入PCM并处理所有已就绪的块
+     * 参数说明：
+     *     - samples：const qint16*，16kHz单声道PCM
+     *     - count：int，采样数
+     * 返回值：void
+     */
+    void acceptWaveform(const qint16 *samples, int count);
+
+    /**
+     * 函数名称：`inputFinished`
+     * 功能描述：处理剩余音频（最后一块，无前瞻），不生成文本
+     * 参数说明：无
+     * 返回值：void
+     */
+    void inputFinished();
+
+    /**
+     * 函数名称：`finish`
+     * 功能描述：inputFinished()并返回完整识别结果
+     * 参数说明：无
+     * 返回值：QString，识别文本
+     */
+    QString finish();
+
+    /**
+     * 函数名称：`finishCommand`
+     * 功能描述：inputFinished()并返回受限解码的匹配结果，未指定词表时无结果
+     * 参数说明：无
+     * 返回值：CommandGrammar::Match，匹配的短语及置信度
+     */
+    CommandGrammar::Match finishCommand();
+
+    const CommandGrammar *grammar() const { return m_grammar; }
+
+    /**
+     * 函数名称：`partialText`
+     * 功能描述：当前已提交帧的识别结果
+     */
+    QString partialText() const;
+
+    /**
+     * 函数名称：`committedFrames`
+     * 功能描述：已完成编码的帧数（含4个查询帧）
+     */
+    int committedFrames() const { return m_state.position; }
+
+    const std::vector<int> &tokenIds() const { return m_tokenIds; }
+    const InferenceArena &arena() const { return m_arena; }
+
+    /**
+     * 函数名称：`intraOpThreads`
+     * 功能描述：每块推理使用的线程数
+     */
+    int intraOpThreads() const { return m_pool.threads(); }
+
+private:
+    void processChunks(bool isFinal);
+
+private:
+    const SenseVoiceEngine *m_engine;
+    WavFrontend m_frontend;
+    SenseVoiceModel::EncoderState m_state;
+    InferenceArena m_arena;             // 每块推理的临时内存
+    IntraOpPool m_pool;
+    const CommandGrammar *m_grammar;    // 本句的受限词表，指定时不做自由解码
+    CommandGrammar::Search m_search;
+    std::vector<float> m_pending;       // 待编码的特征帧（首块包含查询向量）
+    std::vector<int> m_tokenIds;
+    int m_lastToken;
+    bool m_finished;
+};
+
+#endif // SENSEVOICEENGINE_H
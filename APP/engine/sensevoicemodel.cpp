@@ -0,0 +1,640 @@
+#include "sensevoicemodel.h"
+#include "enginekernels.h"
+#include "inferencearena.h"
+#include "voicelogging.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace EngineKernels;
+
+const float SenseVoiceModel::LAYER_NORM_EPS = 1e-5f;
+
+namespace {
+
+const char MODEL_MAGIC[4] = {'S', 'V', 'N', 'W'};
+const quint32 MODEL_VERSION_V1 = 1;        // 4字节对齐
+const quint32 MODEL_VERSION_V2 = 2;        // 64字节对齐，FSMN为[size, kernel]
+const quint32 MODEL_VERSION = 3;           // 64字节对齐，FSMN按抽头[kernel, size]，全部张量可mmap直接使用
+const qint64 MODEL_ALIGNMENT = 64;
+
+void setError(QString *errorMessage, const QString &message)
+{
+    if (errorMessage) {
+        *errorMessage = message;
+    }
+}
+
+} // namespace
+
+SenseVoiceModel::SenseVoiceModel()
+    : m_loaded(false)
+    , m_fileData(nullptr)
+    , m_fileSize(0)
+    , m_mapped(false)
+    , m_tensorBase(nullptr)
+    , m_precision(Float32)
+    , m_afterNormWeight(nullptr)
+    , m_afterNormBias(nullptr)
+    , m_tpNormWeight(nullptr)
+    , m_tpNormBias(nullptr)
+    , m_ctcWeight(nullptr)
+    , m_ctcBias(nullptr)
+    , m_embedWeight(nullptr)
+    , m_cmvnMeans(nullptr)
+    , m_cmvnVars(nullptr)
+{
+}
+
+bool SenseVoiceModel::load(const QString &fileName, QString *errorMessage, Precision precision)
+{
+    m_loaded = false;
+    m_mapped = false;
+    m_data.clear();
+    m_file.close();
+    m_ownedInt8.clear();
+    m_precision = precision;
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, "无法打开模型文件: " + fileName);
+        return false;
+    }
+
+    // 只读映射，页面由内核按需调入并在进程间共享；映射失败（如部分网络文件系统）时读入内存
+    m_fileSize = m_file.size();
+    uchar *mapped = m_file.map(0, m_fileSize);
+    if (mapped) {
+        m_fileData = reinterpret_cast<const char *>(mapped);
+        m_mapped = true;
+    } else {
+        qCWarning(lcEngine) << "🧠 模型文件无法映射，读入内存:" << m_file.errorString();
+        m_data = m_file.readAll();
+        m_file.close();
+        m_fileData = m_data.constData();
+        m_fileSize = m_data.size();
+    }
+
+    if (m_fileSize < 12 || std::memcmp(m_fileData, MODEL_MAGIC, 4) != 0) {
+        setError(errorMessage, "模型文件格式错误: " + fileName);
+        return false;
+    }
+    quint32 version = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(m_fileData + 4));
+    quint32 headerSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(m_fileData + 8));
+    if ((version != MODEL_VERSION && version != MODEL_VERSION_V2 && version != MODEL_VERSION_V1)
+        || 12 + static_cast<qint64>(headerSize) > m_fileSize) {
+        setError(errorMessage, "不支持的模型文件版本: " + QString::number(version));
+        return false;
+    }
+    if (version == MODEL_VERSION_V1) {
+        qCWarning(lcEngine) << "🧠 旧版模型文件(v1)，建议用export_native.py重新导出以获得64字节对齐";
+    } else if (version == MODEL_VERSION_V2) {
+        qCWarning(lcEngine) << "🧠 旧版模型文件(v2)，FSMN卷积核在加载时转置到堆上，建议用export_native.py重新导出";
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(m_fileData + 12, headerSize),
+                                                &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        setError(errorMessage, "模型头部解析失败: " + parseError.errorString());
+        return false;
+    }
+    QJsonObject header = doc.object();
+
+    // 结构参数
+    QJsonObject config = header["config"].toObject();
+    m_config.inputSize = config["input_size"].toInt(560);
+    m_config.outputSize = config["output_size"].toInt(512);
+    m_config.attentionHeads = config["attention_heads"].toInt(4);
+    m_config.linearUnits = config["linear_units"].toInt(2048);
+    m_config.numBlocks = config["num_blocks"].toInt(50);
+    m_config.tpBlocks = config["tp_blocks"].toInt(20);
+    m_config.kernelSize = config["kernel_size"].toInt(11);
+    m_config.sanmShift = config["sanm_shfit"].toInt(0);
+    m_config.vocabSize = config["vocab_size"].toInt();
+    m_config.blankId = config["blank_id"].toInt(0);
+    m_config.sampleRate = config["fs"].toInt(16000);
+    m_config.melBins = config["n_mels"].toInt(80);
+    m_config.frameLengthMs = config["frame_length"].toInt(25);
+    m_config.frameShiftMs = config["frame_shift"].toInt(10);
+    m_config.lfrM = config["lfr_m"].toInt(7);
+    m_config.lfrN = config["lfr_n"].toInt(6);
+    QJsonObject lidDict = config["lid_dict"].toObject();
+    for (auto it = lidDict.begin(); it != lidDict.end(); ++it) {
+        m_config.languageIds.insert(it.key(), it.value().toInt());
+    }
+    QJsonObject textNormDict = config["textnorm_dict"].toObject();
+    for (auto it = textNormDict.begin(); it != textNormDict.end(); ++it) {
+        m_config.textNormIds.insert(it.key(), it.value().toInt());
+    }
+
+    // 词表
+    m_tokens.clear();
+    const QJsonArray tokens = header["tokens"].toArray();
+    m_tokens.reserve(tokens.size());
+    for (const QJsonValue &token : tokens) {
+        m_tokens.append(token.toString());
+    }
+
+    // 张量表，数据区起点按版本对齐（v1为4字节，v2起为64字节）
+    const qint64 alignment = (version == MODEL_VERSION_V1) ? 4 : MODEL_ALIGNMENT;
+    qint64 dataStart = 12 + headerSize;
+    dataStart = (dataStart + alignment - 1) & ~(alignment - 1);
+    m_tensorBase = m_fileData + dataStart;
+    qint64 dataSize = m_fileSize - dataStart;
+
+    m_tensorTable.clear();
+    bool hasInt8 = false;
+    QJsonObject tensors = header["tensors"].toObject();
+    for (auto it = tensors.begin(); it != tensors.end(); ++it) {
+        QJsonObject entry = it.value().toObject();
+        TensorEntry tensorEntry;
+        qint64 elements = 1;
+        for (const QJsonValue &dim : entry["shape"].toArray()) {
+            tensorEntry.shape.append(dim.toInt());
+            elements *= dim.toInt();
+        }
+        tensorEntry.int8 = entry["dtype"].toString("float32") == "int8";
+        tensorEntry.offset = static_cast<qint64>(entry["offset"].toDouble());
+        const qint64 offset = tensorEntry.offset;
+        if (offset < 0 || offset + elements * (tensorEntry.int8 ? 1 : 4) > dataSize) {
+            setError(errorMessage, "张量越界: " + it.key());
+            return false;
+        }
+        if (offset % alignment != 0) {
+            setError(errorMessage, "张量未对齐: " + it.key());
+            return false;
+        }
+        hasInt8 = hasInt8 || tensorEntry.int8;
+        m_tensorTable.insert(it.key(), tensorEntry);
+    }
+    if (hasInt8 && m_precision != Int8) {
+        qCInfo(lcEngine) << "🧠 模型文件为int8量化权重，按int8精度加载";
+        m_precision = Int8;
+    }
+
+    // 绑定各层权重
+    const int d = m_config.outputSize;
+    const int units = m_config.linearUnits;
+    const int kernel = m_config.kernelSize;
+    const int totalLayers = m_config.numBlocks + m_config.tpBlocks;
+    m_layers.assign(totalLayers, LayerWeights());
+    const bool tapLayout = version == MODEL_VERSION;
+    m_fsmnTaps.clear();
+    if (!tapLayout) {
+        m_fsmnTaps.assign(static_cast<size_t>(totalLayers) * kernel * d, 0.0f);
+    }
+    for (int l = 0; l < totalLayers; ++l) {
+        QString prefix;
+        if (l == 0) {
+            prefix = "encoder.encoders0.0.";
+        } else if (l < m_config.numBlocks) {
+            prefix = QString("encoder.encoders.%1.").arg(l - 1);
+        } else {
+            prefix = QString("encoder.tp_encoders.%1.").arg(l - m_config.numBlocks);
+        }
+
+        LayerWeights &layer = m_layers[l];
+        layer.inSize = (l == 0) ? m_config.inputSize : d;
+        const int in = layer.inSize;
+        layer.norm1Weight = tensor(prefix + "norm1.weight", {in}, errorMessage);
+        layer.norm1Bias = tensor(prefix + "norm1.bias", {in}, errorMessage);
+        layer.norm2Weight = tensor(prefix + "norm2.weight", {d}, errorMessage);
+        layer.norm2Bias = tensor(prefix + "norm2.bias", {d}, errorMessage);
+        layer.qkvBias = tensor(prefix + "self_attn.linear_q_k_v.bias", {3 * d}, errorMessage);
+        layer.outBias = tensor(prefix + "self_attn.linear_out.bias", {d}, errorMessage);
+        const QVector<int> fsmnShape = tapLayout ? QVector<int>({kernel, d}) : QVector<int>({d, kernel});
+        const float *fsmnWeight = tensor(prefix + "self_attn.fsmn_block.weight", fsmnShape, errorMessage);
+        layer.ffn1Bias = tensor(prefix + "feed_forward.w_1.bias", {units}, errorMessage);
+        layer.ffn2Bias = tensor(prefix + "feed_forward.w_2.bias", {d}, errorMessage);
+        if (!layer.norm1Weight || !layer.norm1Bias || !layer.norm2Weight || !layer.norm2Bias
+            || !layer.qkvBias || !layer.outBias || !fsmnWeight || !layer.ffn1Bias || !layer.ffn2Bias
+            || !bindLinear(prefix + "self_attn.linear_q_k_v.weight", 3 * d, in,
+                           &layer.qkvWeight, &layer.qkvInt8, errorMessage)
+            || !bindLinear(prefix + "self_attn.linear_out.weight", d, d,
+                           &layer.outWeight, &layer.outInt8, errorMessage)
+            || !bindLinear(prefix + "feed_forward.w_1.weight", units, d,
+                           &layer.ffn1Weight, &layer.ffn1Int8, errorMessage)
+            || !bindLinear(prefix + "feed_forward.w_2.weight", d, units,
+                           &layer.ffn2Weight, &layer.ffn2Int8, errorMessage)) {
+            return false;
+        }
+        if (tapLayout) {
+            layer.fsmnTaps = fsmnWeight;
+        } else {
+            float *taps = m_fsmnTaps.data() + static_cast<size_t>(l) * kernel * d;
+            EngineKernels::transposeFsmnWeight(fsmnWeight, d, kernel, taps);
+            layer.fsmnTaps = taps;
+        }
+    }
+
+    m_afterNormWeight = tensor("encoder.after_norm.weight", {d}, errorMessage);
+    m_afterNormBias = tensor("encoder.after_norm.bias", {d}, errorMessage);
+    m_tpNormWeight = tensor("encoder.tp_norm.weight", {d}, errorMessage);
+    m_tpNormBias = tensor("encoder.tp_norm.bias", {d}, errorMessage);
+    if (!bindLinear("ctc.ctc_lo.weight", m_config.vocabSize, d, &m_ctcWeight, &m_ctcInt8, errorMessage)) {
+        return false;
+    }
+    m_ctcBias = tensor("ctc.ctc_lo.bias", {m_config.vocabSize}, errorMessage);
+    m_embedWeight = tensor("embed.weight", {-1, m_config.inputSize}, errorMessage);
+    m_cmvnMeans = tensor("frontend.cmvn_means", {m_config.inputSize}, errorMessage);
+    m_cmvnVars = tensor("frontend.cmvn_vars", {m_config.inputSize}, errorMessage);
+    if (!m_afterNormWeight || !m_afterNormBias || !m_tpNormWeight || !m_tpNormBias
+        || !m_ctcBias || !m_embedWeight || !m_cmvnMeans || !m_cmvnVars) {
+        return false;
+    }
+
+    if (m_tokens.size() != m_config.vocabSize) {
+        setError(errorMessage, "词表大小与模型不一致");
+        return false;
+    }
+
+    m_loaded = true;
+    qCInfo(lcEngine) << "🧠 模型加载完成:" << fileName << "层数:" << totalLayers
+                     << "词表:" << m_config.vocabSize << (m_mapped ? "(只读映射)" : "(读入内存)")
+                     << "精度:" << (m_precision == Int8 ? "int8" : "fp32")
+                     << "内核:" << EngineKernels::isaName(EngineKernels::activeIsa());
+    return true;
+}
+
+const float *SenseVoiceModel::tensor(const QString &name, const QVector<int> &shape, QString *errorMessage)
+{
+    auto it = m_tensorTable.constFind(name);
+    if (it == m_tensorTable.constEnd()) {
+        setError(errorMessage, "模型缺少张量: " + name);
+        return nullptr;
+    }
+    const QVector<int> &actual = it.value().shape;
+    bool match = actual.size() == shape.size();
+    for (int i = 0; match && i < shape.size(); ++i) {
+        match = shape[i] < 0 || shape[i] == actual[i];
+    }
+    if (!match || it.value().int8) {
+        setError(errorMessage, "张量形状不匹配: " + name);
+        return nullptr;
+    }
+    return reinterpret_cast<const float *>(m_tensorBase + it.value().offset);
+}
+
+bool SenseVoiceModel::bindLinear(const QString &name, int outDim, int inDim, const float **weight,
+                                 EngineKernels::Int8Matrix *weightInt8, QString *errorMessage)
+{
+    *weight = nullptr;
+    *weightInt8 = EngineKernels::Int8Matrix();
+
+    auto it = m_tensorTable.constFind(name);
+    if (it == m_tensorTable.constEnd()) {
+        setError(errorMessage, "模型缺少张量: " + name);
+        return false;
+    }
+    if (it.value().shape != QVector<int>({outDim, inDim})) {
+        setError(errorMessage, "张量形状不匹配: " + name);
+        return false;
+    }
+
+    if (it.value().int8) {
+        // 文件中已是int8：数据和缩放直接指向映射区，只在堆上保存每行之和
+        const float *scales = tensor(name + "_scale", {outDim}, errorMessage);
+        if (!scales) {
+            return false;
+        }
+        m_ownedInt8.emplace_back();
+        OwnedInt8 &owned = m_ownedInt8.back();
+        weightInt8->data = reinterpret_cast<const int8_t *>(m_tensorBase + it.value().offset);
+        weightInt8->scales = scales;
+        owned.rowSums.resize(outDim);
+        EngineKernels::weightRowSums(weightInt8->data, outDim, inDim, owned.rowSums.data());
+        weightInt8->rowSums = owned.rowSums.data();
+        return true;
+    }
+
+    *weight = reinterpret_cast<const float *>(m_tensorBase + it.value().offset);
+    if (m_precision == Int8) {
+        m_ownedInt8.emplace_back();
+        OwnedInt8 &owned = m_ownedInt8.back();
+        owned.data.resize(static_cast<size_t>(outDim) * inDim);
+        owned.scales.resize(outDim);
+        owned.rowSums.resize(outDim);
+        EngineKernels::quantizeWeights(*weight, outDim, inDim, owned.data.data(), owned.scales.data());
+        EngineKernels::weightRowSums(owned.data.data(), outDim, inDim, owned.rowSums.data());
+        weightInt8->data = owned.data.data();
+        weightInt8->scales = owned.scales.data();
+        weightInt8->rowSums = owned.rowSums.data();
+    }
+    return true;
+}
+
+void SenseVoiceModel::project(const float *x, int rows, int inDim, const float *weight,
+                              const EngineKernels::Int8Matrix &weightInt8, const float *bias, int outDim,
+                              float *y, int8_t *quantized, float *quantScales) const
+{
+    if (weightInt8.data) {
+        quantizeRows(x, rows, inDim, quantized, quantScales);
+        linearInt8(quantized, quantScales, rows, inDim, weightInt8, bias, outDim, y);
+    } else {
+        linear(x, rows, inDim, weight, bias, outDim, y);
+    }
+}
+
+void SenseVoiceModel::queryEmbeddings(int languageId, int textNormId, float *out) const
+{
+    // 顺序与model.py的inference一致：[language, event(1), emotion(2), textnorm]
+    const int dim = m_config.inputSize;
+    const int ids[QUERY_ROWS] = {languageId, 1, 2, textNormId};
+    for (int r = 0; r < QUERY_ROWS; ++r) {
+        std::memcpy(out + static_cast<size_t>(r) * dim,
+                    m_embedWeight + static_cast<size_t>(ids[r]) * dim, sizeof(float) * dim);
+    }
+}
+
+void SenseVoiceModel::resetState(EncoderState &state, bool streaming, int lookBackFrames) const
+{
+    state.streaming = streaming;
+    state.lookBackFrames = lookBackFrames;
+    state.position = 0;
+
+    // 清空而不释放，同一会话识别下一句时复用上一句的缓存容量
+    const size_t layers = streaming ? m_layers.size() : 0;
+    if (state.layers.size() != layers) {
+        state.layers.resize(layers);
+    }
+    for (EncoderState::LayerCache &cache : state.layers) {
+        cache.keys.clear();
+        cache.values.clear();
+        cache.fsmnHistory.clear();
+    }
+}
+
+size_t SenseVoiceModel::scratchBytes(int batch, int maxRows, int cacheRows) const
+{
+    const size_t rows = static_cast<size_t>(batch) * maxRows;
+    const size_t d = m_config.outputSize;
+    const size_t width = std::max<size_t>(m_config.inputSize, d);
+    const size_t leftPadding = (m_config.kernelSize - 1) / 2 + m_config.sanmShift;
+    const size_t align = InferenceArena::ALIGNMENT;
+
+    // 与runLayers/encode中的分配一一对应，每项按对齐向上取整
+    auto bytes = [align](size_t count) { return (count * sizeof(float) + align - 1) / align * align; };
+    size_t quantizedBytes = 0;
+    if (m_precision == Int8) {
+        const size_t maxIn = std::max<size_t>(width, m_config.linearUnits);
+        quantizedBytes = (rows * maxIn + align - 1) / align * align + bytes(rows)    // 编码器激活量化
+                       + (rows * d + align - 1) / align * align + bytes(rows);      // CTC输入量化
+    }
+    return quantizedBytes
+         + bytes(batch)                                            // lengths
+         + 2 * bytes(rows * width)                                 // x, next
+         + bytes(rows * width)                                     // norm
+         + bytes(rows * 3 * d)                                     // qkv
+         + 2 * bytes(rows * d)                                     // fsmn, context
+         + bytes(rows * m_config.linearUnits)                      // hidden
+         + bytes(cacheRows + maxRows)                              // scores
+         + bytes((leftPadding + maxRows) * d)                      // FSMN历史拼接
+         + bytes(rows * d)                                         // tp_norm输出
+         + bytes(rows * m_config.vocabSize);                       // logits
+}
+
+const float *SenseVoiceModel::encode(const float *input, int rows, int commitRows,
+                                     EncoderState &state, InferenceArena &arena) const
+{
+    const int d = m_config.outputSize;
+
+    int *lengths = arena.allocate<int>(1);
+    lengths[0] = rows;
+    const int cacheRows = state.streaming && !state.layers.empty()
+                              ? static_cast<int>(state.layers[0].keys.size() / d) : 0;
+    Scratch scratch = allocateScratch(1, rows, cacheRows, lengths, arena);
+    addPositionalEncoding(input, 1, rows, state.position, scratch.x);
+    runLayers(1, rows, commitRows, &state, scratch);
+
+    float *out = arena.allocate<float>(static_cast<size_t>(commitRows) * d);
+    layerNorm(scratch.x, commitRows, d, m_tpNormWeight, m_tpNormBias, LAYER_NORM_EPS, out);
+    state.position += commitRows;
+    return out;
+}
+
+const float *SenseVoiceModel::encodeBatch(const float *input, const int *lengths, int batch, int maxRows,
+                                          InferenceArena &arena) const
+{
+    const int d = m_config.outputSize;
+    const int totalRows = batch * maxRows;
+
+    // 整句批量推理，不保存缓存
+    Scratch scratch = allocateScratch(batch, maxRows, 0, lengths, arena);
+    addPositionalEncoding(input, batch, maxRows, 0, scratch.x);
+    runLayers(batch, maxRows, maxRows, nullptr, scratch);
+
+    float *out = arena.allocate<float>(static_cast<size_t>(totalRows) * d);
+    layerNorm(scratch.x, totalRows, d, m_tpNormWeight, m_tpNormBias, LAYER_NORM_EPS, out);
+    return out;
+}
+
+SenseVoiceModel::Scratch SenseVoiceModel::allocateScratch(int batch, int maxRows, int cacheRows,
+                                                          const int *lengths, InferenceArena &arena) const
+{
+    const size_t rows = static_cast<size_t>(batch) * maxRows;
+    const size_t d = m_config.outputSize;
+    const size_t width = std::max<size_t>(m_config.inputSize, d);
+    const size_t leftPadding = (m_config.kernelSize - 1) / 2 + m_config.sanmShift;
+
+    Scratch scratch;
+    scratch.lengths = lengths;
+    scratch.quantized = nullptr;
+    scratch.quantScales = nullptr;
+    if (m_precision == Int8) {
+        const size_t maxIn = std::max<size_t>(width, m_config.linearUnits);
+        scratch.quantized = arena.allocate<int8_t>(rows * maxIn);
+        scratch.quantScales = arena.allocate<float>(rows);
+    }
+    scratch.x = arena.allocate<float>(rows * width);
+    scratch.next = arena.allocate<float>(rows * width);
+    scratch.norm = arena.allocate<float>(rows * width);
+    scratch.qkv = arena.allocate<float>(rows * 3 * d);
+    scratch.fsmn = arena.allocate<float>(rows * d);
+    scratch.context = arena.allocate<float>(rows * d);
+    scratch.hidden = arena.allocate<float>(rows * m_config.linearUnits);
+    scratch.scores = arena.allocate<float>(cacheRows + maxRows);
+    scratch.history = arena.allocate<float>((leftPadding + maxRows) * d);
+    return scratch;
+}
+
+void SenseVoiceModel::addPositionalEncoding(const float *input, int batch, int maxRows,
+                                            int position, float *x) const
+{
+    // xs *= sqrt(output_size)，再叠加正弦位置编码（位置从1开始，按绝对位置计算）
+    const int inSize = m_config.inputSize;
+    const float scale = std::sqrt(static_cast<float>(m_config.outputSize));
+    const int half = inSize / 2;
+    const float increment = std::log(10000.0f) / (half - 1);
+
+    for (int b = 0; b < batch; ++b) {
+        for (int r = 0; r < maxRows; ++r) {
+            const size_t row = static_cast<size_t>(b) * maxRows + r;
+            const float *src = input + row * inSize;
+            float *dst = x + row * inSize;
+            const float pos = static_cast<float>(position + r + 1);
+            for (int i = 0; i < half; ++i) {
+                float angle = pos * std::exp(-i * increment);
+                dst[i] = src[i] * scale + std::sin(angle);
+                dst[half + i] = src[half + i] * scale + std::cos(angle);
+            }
+        }
+    }
+}
+
+void SenseVoiceModel::runLayers(int batch, int maxRows, int commitRows, EncoderState *state,
+                                Scratch &scratch) const
+{
+    const int d = m_config.outputSize;
+    for (int l = 0; l < static_cast<int>(m_layers.size()); ++l) {
+        EncoderState::LayerCache *cache = state && state->streaming ? &state->layers[l] : nullptr;
+        forwardLayer(m_layers[l], batch, maxRows, commitRows, cache,
+                     state ? state->lookBackFrames : -1, scratch);
+        if (l == m_config.numBlocks - 1) {
+            layerNorm(scratch.x, batch * maxRows, d, m_afterNormWeight, m_afterNormBias,
+                      LAYER_NORM_EPS, scratch.x);
+        }
+    }
+}
+
+void SenseVoiceModel::forwardLayer(const LayerWeights &layer, int batch, int maxRows, int commitRows,
+                                   EncoderState::LayerCache *cache, int lookBackFrames,
+                                   Scratch &scratch) const
+{
+    const int d = m_config.outputSize;
+    const int heads = m_config.attentionHeads;
+    const int dk = d / heads;
+    const int inSize = layer.inSize;
+    const int stride = 3 * d;
+    const int rows = batch * maxRows;
+    const int leftPadding = (m_config.kernelSize - 1) / 2 + m_config.sanmShift;
+
+    // norm1 + QKV投影：整批一起做矩阵乘
+    layerNorm(scratch.x, rows, inSize, layer.norm1Weight, layer.norm1Bias, LAYER_NORM_EPS, scratch.norm);
+    project(scratch.norm, rows, inSize, layer.qkvWeight, layer.qkvInt8, layer.qkvBias, stride, scratch.qkv,
+            scratch.quantized, scratch.quantScales);
+
+    // FSMN和注意力按序列分别计算，填充帧不参与（等价于model.py中的mask）
+    const int cacheRows = cache ? static_cast<int>(cache->keys.size() / d) : 0;
+    const int historyRows = cache ? static_cast<int>(cache->fsmnHistory.size() / d) : 0;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(dk));
+    std::fill(scratch.fsmn, scratch.fsmn + static_cast<size_t>(rows) * d, 0.0f);
+    std::fill(scratch.context, scratch.context + static_cast<size_t>(rows) * d, 0.0f);
+
+    for (int b = 0; b < batch; ++b) {
+        const int length = scratch.lengths[b];
+        const size_t base = static_cast<size_t>(b) * maxRows;
+        const float *q = scratch.qkv + base * stride;
+        const float *k = q + d;
+        const float *v = q + 2 * d;
+
+        // FSMN记忆块，左侧上下文来自上一块
+        fsmnMemory(cache ? cache->fsmnHistory.data() : nullptr, historyRows,
+                   v, length, stride, d, layer.fsmnTaps, m_config.kernelSize, leftPadding,
+                   scratch.fsmn + base * d);
+
+        // 多头注意力：键值 = 缓存的已提交帧 + 本块全部帧
+        const int total = cacheRows + length;
+        for (int h = 0; h < heads; ++h) {
+            const int offset = h * dk;
+            for (int i = 0; i < length; ++i) {
+                const float *qi = q + static_cast<size_t>(i) * stride + offset;
+                float *scores = scratch.scores;
+                for (int j = 0; j < cacheRows; ++j) {
+                    const float *kj = cache->keys.data() + static_cast<size_t>(j) * d + offset;
+                    float sum = 0.0f;
+                    for (int c = 0; c < dk; ++c) {
+                        sum += qi[c] * kj[c];
+                    }
+                    scores[j] = sum * scale;
+                }
+                for (int j = 0; j < length; ++j) {
+                    const float *kj = k + static_cast<size_t>(j) * stride + offset;
+                    float sum = 0.0f;
+                    for (int c = 0; c < dk; ++c) {
+                        sum += qi[c] * kj[c];
+                    }
+                    scores[cacheRows + j] = sum * scale;
+                }
+                softmax(scores, total);
+
+                float *ctx = scratch.context + (base + i) * d + offset;
+                for (int j = 0; j < cacheRows; ++j) {
+                    const float *vj = cache->values.data() + static_cast<size_t>(j) * d + offset;
+                    for (int c = 0; c < dk; ++c) {
+                        ctx[c] += scores[j] * vj[c];
+                    }
+                }
+                for (int j = 0; j < length; ++j) {
+                    const float *vj = v + static_cast<size_t>(j) * stride + offset;
+                    const float p = scores[cacheRows + j];
+                    for (int c = 0; c < dk; ++c) {
+                        ctx[c] += p * vj[c];
+                    }
+                }
+            }
+        }
+    }
+
+    // 更新缓存：只缓存已提交帧，前瞻帧下一块重新计算（分块模式只有一个序列）
+    if (cache) {
+        const float *k = scratch.qkv + d;
+        const float *v = scratch.qkv + 2 * d;
+        float *history = scratch.history;
+        std::copy(cache->fsmnHistory.begin(), cache->fsmnHistory.end(), history);
+        int historyTotal = historyRows;
+        for (int r = 0; r < commitRows; ++r) {
+            const float *kr = k + static_cast<size_t>(r) * stride;
+            const float *vr = v + static_cast<size_t>(r) * stride;
+            cache->keys.insert(cache->keys.end(), kr, kr + d);
+            cache->values.insert(cache->values.end(), vr, vr + d);
+            std::copy(vr, vr + d, history + static_cast<size_t>(historyTotal++) * d);
+        }
+        if (lookBackFrames >= 0) {
+            size_t limit = static_cast<size_t>(lookBackFrames) * d;
+            if (cache->keys.size() > limit) {
+                cache->keys.erase(cache->keys.begin(), cache->keys.end() - limit);
+                cache->values.erase(cache->values.begin(), cache->values.end() - limit);
+            }
+        }
+        int keep = std::min(historyTotal, leftPadding);
+        cache->fsmnHistory.assign(history + static_cast<size_t>(historyTotal - keep) * d,
+                                  history + static_cast<size_t>(historyTotal) * d);
+    }
+
+    // 输出投影 + FSMN + 残差（encoders0的输入维度不同，没有残差），与norm2融合为一趟
+    project(scratch.context, rows, d, layer.outWeight, layer.outInt8, layer.outBias, d, scratch.next,
+            scratch.quantized, scratch.quantScales);
+    addLayerNorm(scratch.next, scratch.fsmn, inSize == d ? scratch.x : nullptr, rows, d,
+                 layer.norm2Weight, layer.norm2Bias, LAYER_NORM_EPS, scratch.norm);
+    std::swap(scratch.x, scratch.next);
+
+    // 前馈网络 + 残差
+    const int units = m_config.linearUnits;
+    project(scratch.norm, rows, d, layer.ffn1Weight, layer.ffn1Int8, layer.ffn1Bias, units, scratch.hidden,
+            scratch.quantized, scratch.quantScales);
+    relu(scratch.hidden, rows * units);
+    project(scratch.hidden, rows, units, layer.ffn2Weight, layer.ffn2Int8, layer.ffn2Bias, d, scratch.next,
+            scratch.quantized, scratch.quantScales);
+    addInPlace(scratch.x, scratch.next, rows * d);
+}
+
+const float *SenseVoiceModel::ctcLogits(const float *encoded, int rows, InferenceArena &arena) const
+{
+    const int vocab = m_config.vocabSize;
+    int8_t *quantized = nullptr;
+    float *quantScales = nullptr;
+    if (m_ctcInt8.data) {
+        quantized = arena.allocate<int8_t>(static_cast<size_t>(rows) * m_config.outputSize);
+        quantScales = arena.allocate<float>(rows);
+    }
+    float *out = arena.allocate<float>(static_cast<size_t>(rows) * vocab);
+    project(encoded, rows, m_config.outputSize, m_ctcWeight, m_ctcInt8, m_ctcBias, vocab, out,
+            quantized, quantScales);
+    return out;
+}
@@ -0,0 +1,272 @@
+#ifndef SENSEVOICEMODEL_H
+#define SENSEVOICEMODEL_H
+
+#include "enginekernels.h"
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <deque>
+#include <vector>
+
+class InferenceArena;
+
+/**
+ * 函数名称：`SenseVoiceModel`
+ * 功能描述：SenseVoiceSmall的C++实现（SenseVoiceEncoderSmall + CTC头），权重由SenseVoice/export_native.py导出
+ * 设计特点：
+ *   - 加载后只读，可被多个识别会话共享
+ *   - 编码器支持整句与分块两种模式，分块模式对应model.py中的forward_chunk，
+ *     FSMN记忆和注意力的K/V缓存在块之间延续
+ *   - 线性层支持fp32和int8两种精度：int8权重按输出通道量化，激活按行动态量化，int32累加
+ */
+class SenseVoiceModel
+{
+public:
+    /**
+     * 模型结构参数，对应config.yaml中的encoder_conf/frontend_conf
+     */
+    struct Config {
+        int inputSize = 560;
+        int outputSize = 512;
+        int attentionHeads = 4;
+        int linearUnits = 2048;
+        int numBlocks = 50;
+        int tpBlocks = 20;
+        int kernelSize = 11;
+        int sanmShift = 0;
+        int vocabSize = 0;
+        int blankId = 0;
+        int sampleRate = 16000;
+        int melBins = 80;
+        int frameLengthMs = 25;
+        int frameShiftMs = 10;
+        int lfrM = 7;
+        int lfrN = 6;
+        QHash<QString, int> languageIds;
+        QHash<QString, int> textNormIds;
+    };
+
+    /**
+     * 线性层精度
+     */
+    enum Precision {
+        Float32,
+        Int8
+    };
+
+    /**
+     * 单层SANM编码器权重，指针指向模型数据区；int8精度下线性层使用*Int8，对应的float指针可能为nullptr
+     */
+    struct LayerWeights {
+        int inSize = 0;
+        const float *norm1Weight = nullptr;
+        const float *norm1Bias = nullptr;
+        const float *norm2Weight = nullptr;
+        const float *norm2Bias = nullptr;
+        const float *qkvWeight = nullptr;
+        const float *qkvBias = nullptr;
+        const float *outWeight = nullptr;
+        const float *outBias = nullptr;
+        const float *fsmnTaps = nullptr;        // FSMN卷积核按抽头存放 [kernelSize, outputSize]
+        const float *ffn1Weight = nullptr;
+        const float *ffn1Bias = nullptr;
+        const float *ffn2Weight = nullptr;
+        const float *ffn2Bias = nullptr;
+        EngineKernels::Int8Matrix qkvInt8;
+        EngineKernels::Int8Matrix outInt8;
+        EngineKernels::Int8Matrix ffn1Int8;
+        EngineKernels::Int8Matrix ffn2Int8;
+    };
+
+    /**
+     * 编码器状态：分块推理时在块之间延续的缓存；临时缓冲区从调用方的InferenceArena分配
+     */
+    struct EncoderState {
+        struct LayerCache {
+            std::vector<float> keys;        // 已提交帧的K [frames, outputSize]
+            std::vector<float> values;      // 已提交帧的V [frames, outputSize]
+            std::vector<float> fsmnHistory; // FSMN左侧上下文 [<=leftPadding, outputSize]
+        };
+
+        bool streaming = false;             // false时不保存缓存（整句模式）
+        int lookBackFrames = -1;            // 注意力回看的已提交帧数上限，-1表示不限
+        int position = 0;                   // 已提交帧数，用于位置编码
+        std::vector<LayerCache> layers;
+    };
+
+    static const int QUERY_ROWS = 4;        // 拼接在语音特征前的查询向量数
+
+    SenseVoiceModel();
+
+    /**
+     * 函数名称：`load`
+     * 功能描述：从导出的权重文件加载模型。权重文件以只读方式mmap，张量直接指向映射区，
+     *           不复制到堆上，同一台机器上的多个进程共享page cache中的同一份权重
+     * 参数说明：
+     *     - fileName：QString，权重文件路径（model.svnw）
+     *     - errorMessage：QString*，失败时写入错误信息，可为nullptr
+     *     - precision：Precision，线性层精度。fp32文件选Int8时在加载时量化到堆上；
+     *       export_native.py --quantize导出的int8文件只能按Int8加载，量化权重同样可被多进程共享
+     * 返回值：bool，是否加载成功
+     */
+    bool load(const QString &fileName, QString *errorMessage = nullptr, Precision precision = Float32);
+
+    bool isLoaded() const { return m_loaded; }
+    bool isMapped() const { return m_mapped; }
+    Precision precision() const { return m_precision; }
+    const Config &config() const { return m_config; }
+    const QStringList &tokens() const { return m_tokens; }
+    const float *cmvnMeans() const { return m_cmvnMeans; }
+    const float *cmvnVars() const { return m_cmvnVars; }
+    int layerCount() const { return static_cast<int>(m_layers.size()); }
+
+    /**
+     * 函数名称：`queryEmbeddings`
+     * 功能描述：生成拼接在语音特征前的4个查询向量：语种、事件、情感、文本规整
+     * 参数说明：
+     *     - languageId：int，语种ID（lid_dict）
+     *     - textNormId：int，文本规整ID（textnorm_dict）
+     *     - out：float*，输出 [QUERY_ROWS, inputSize]
+     * 返回值：void
+     */
+    void queryEmbeddings(int languageId, int textNormId, float *out) const;
+
+    /**
+     * 函数名称：`resetState`
+     * 功能描述：为新的一句话初始化编码器状态，保留上一句缓存的容量
+     * 参数说明：
+     *     - state：EncoderState&，编码器状态
+     *     - streaming：bool，是否分块推理
+     *     - lookBackFrames：int，注意力回看帧数，-1表示不限
+     * 返回值：void
+     */
+    void resetState(EncoderState &state, bool streaming, int lookBackFrames = -1) const;
+
+    /**
+     * 函数名称：`scratchBytes`
+     * 功能描述：一次encode/encodeBatch加ctcLogits需要的arena容量，用于按最长语音预留
+     * 参数说明：
+     *     - batch：int，条数
+     *     - maxRows：int，每条最大帧数（含查询向量）
+     *     - cacheRows：int，分块模式下注意力缓存的最大帧数，整句模式为0
+     * 返回值：size_t，字节数
+     */
+    size_t scratchBytes(int batch, int maxRows, int cacheRows = 0) const;
+
+    /**
+     * 函数名称：`encode`
+     * 功能描述：对一块输入执行完整编码器（encoders0 + encoders + after_norm + tp_encoders + tp_norm）
+     * 参数说明：
+     *     - input：const float*，输入特征 [rows, inputSize]，首块需已拼接查询向量
+     *     - rows：int，本块总帧数（提交帧 + 右侧前瞻帧）
+     *     - commitRows：int，本块提交的帧数，前瞻帧只作为上下文，下一块会重新计算
+     *     - state：EncoderState&，编码器状态
+     *     - arena：InferenceArena&，中间结果和输出从这里分配
+     * 返回值：const float*，提交帧的编码结果 [commitRows, outputSize]，arena重置前有效
+     */
+    const float *encode(const float *input, int rows, int commitRows,
+                        EncoderState &state, InferenceArena &arena) const;
+
+    /**
+     * 函数名称：`encodeBatch`
+     * 功能描述：整句批量编码，输入按pad_list方式补齐到相同帧数，填充帧不参与FSMN和注意力
+     * 参数说明：
+     *     - input：const float*，补齐后的输入 [batch, maxRows, inputSize]，每条已拼接查询向量
+     *     - lengths：const int*，每条的有效帧数 [batch]
+     *     - batch：int，条数
+     *     - maxRows：int，补齐后的帧数
+     *     - arena：InferenceArena&，中间结果和输出从这里分配
+     * 返回值：const float*，编码结果 [batch, maxRows, outputSize]，填充帧的内容无意义
+     */
+    const float *encodeBatch(const float *input, const int *lengths, int batch, int maxRows,
+                             InferenceArena &arena) const;
+
+    /**
+     * 函数名称：`ctcLogits`
+     * 功能描述：CTC输出层 ctc_lo
+     * 参数说明：
+     *     - encoded：const float*，编码结果 [rows, outputSize]
+     *     - rows：int，帧数
+     *     - arena：InferenceArena&，输出从这里分配
+     * 返回值：const float*，logits [rows, vocabSize]
+     */
+    const float *ctcLogits(const float *encoded, int rows, InferenceArena &arena) const;
+
+private:
+    /**
+     * 单次编码的临时缓冲区，x/next为逐层交替的激活
+     */
+    struct Scratch {
+        const int *lengths;
+        int8_t *quantized;              // int8精度下量化后的激活
+        float *quantScales;
+        float *x;
+        float *next;
+        float *norm;
+        float *qkv;
+        float *fsmn;
+        float *context;
+        float *hidden;
+        float *scores;
+        float *history;
+    };
+
+    Scratch allocateScratch(int batch, int maxRows, int cacheRows, const int *lengths,
+                            InferenceArena &arena) const;
+    void addPositionalEncoding(const float *input, int batch, int maxRows, int position, float *x) const;
+    void runLayers(int batch, int maxRows, int commitRows, EncoderState *state, Scratch &scratch) const;
+    void forwardLayer(const LayerWeights &layer, int batch, int maxRows, int commitRows,
+                      EncoderState::LayerCache *cache, int lookBackFrames, Scratch &scratch) const;
+    void project(const float *x, int rows, int inDim, const float *weight,
+                 const EngineKernels::Int8Matrix &weightInt8, const float *bias, int outDim, float *y,
+                 int8_t *quantized, float *quantScales) const;
+    const float *tensor(const QString &name, const QVector<int> &shape, QString *errorMessage);
+    bool bindLinear(const QString &name, int outDim, int inDim, const float **weight,
+                    EngineKernels::Int8Matrix *weightInt8, QString *errorMessage);
+
+private:
+    bool m_loaded;
+    Config m_config;
+    QStringList m_tokens;
+    QFile m_file;                       // 权重文件，只读映射期间保持打开
+    const char *m_fileData;             // 映射地址（映射失败时指向m_data）
+    qint64 m_fileSize;
+    bool m_mapped;                      // 是否为只读mmap（多进程共享page cache）
+    QByteArray m_data;                  // 无法映射时退回读入内存
+    const char *m_tensorBase;           // 张量数据起始地址
+    struct TensorEntry {
+        QVector<int> shape;
+        qint64 offset;
+        bool int8;
+    };
+    QHash<QString, TensorEntry> m_tensorTable;
+    Precision m_precision;
+
+    // 加载时量化得到的int8权重（fp32文件按Int8加载时），deque保证已绑定的指针不失效
+    struct OwnedInt8 {
+        std::vector<int8_t> data;
+        std::vector<float> scales;
+        std::vector<int32_t> rowSums;
+    };
+    std::deque<OwnedInt8> m_ownedInt8;
+    std::vector<float> m_fsmnTaps;      // v1/v2文件的FSMN卷积核在加载时的转置；v3文件直接指向映射，为空
+
+    std::vector<LayerWeights> m_layers; // encoders0 + encoders + tp_encoders
+    const float *m_afterNormWeight;
+    const float *m_afterNormBias;
+    const float *m_tpNormWeight;
+    const float *m_tpNormBias;
+    const float *m_ctcWeight;
+    const float *m_ctcBias;
+    EngineKernels::Int8Matrix m_ctcInt8;
+    const float *m_embedWeight;
+    const float *m_cmvnMeans;
+    const float *m_cmvnVars;
+
+    static const float LAYER_NORM_EPS;
+};
+
+#endif // SENSEVOICEMODEL_H
@@ -0,0 +1,98 @@
+#include "stableprefixtracker.h"
+
+namespace {
+
+const int DEFAULT_STABLE_MS = 600;
+
+} // namespace
+
+StablePrefixTracker::StablePrefixTracker()
+    : StablePrefixTracker(DEFAULT_STABLE_MS)
+{
+}
+
+StablePrefixTracker::StablePrefixTracker(int stableMs)
+    : m_stableMs(stableMs)
+{
+}
+
+void StablePrefixTracker::reset()
+{
+    m_committed.clear();
+    m_tentative.clear();
+    m_stableSince.clear();
+}
+
+size_t StablePrefixTracker::spliceTail(const std::vector<Token> &hypothesis) const
+{
+    // 常见情况：新结果以已定稿部分开头
+    bool prefix = hypothesis.size() >= m_committed.size();
+    for (size_t i = 0; prefix && i < m_committed.size(); ++i) {
+        prefix = hypothesis[i].id == m_committed[i].id;
+    }
+    if (prefix) {
+        return m_committed.size();
+    }
+
+    // 已定稿部分被改写：按时间接上，从已定稿最后一个token结束之后开始的token取起
+    const int committedEnd = m_committed.empty() ? 0 : m_committed.back().endMs;
+    size_t start = 0;
+    while (start < hypothesis.size() && hypothesis[start].startMs < committedEnd) {
+        ++start;
+    }
+    return start;
+}
+
+int StablePrefixTracker::update(const std::vector<Token> &hypothesis, int audioMs)
+{
+    const size_t start = spliceTail(hypothesis);
+
+    // 与上次未定稿部分逐个比较，相同的前缀保留最早出现的时间
+    std::vector<Token> tentative(hypothesis.begin() + start, hypothesis.end());
+    std::vector<int> since(tentative.size(), audioMs);
+    for (size_t i = 0; i < tentative.size() && i < m_tentative.size(); ++i) {
+        if (tentative[i].id != m_tentative[i].id) {
+            break;
+        }
+        since[i] = m_stableSince[i];
+    }
+
+    // 从头提交：内容保持够久，且不在录音末尾（后面的语音可能改变它）
+    size_t commit = 0;
+    while (commit < tentative.size() && audioMs - since[commit] >= m_stableMs
+           && tentative[commit].endMs <= audioMs - m_stableMs) {
+        ++commit;
+    }
+    m_committed.insert(m_committed.end(), tentative.begin(), tentative.begin() + commit);
+    m_tentative.assign(tentative.begin() + commit, tentative.end());
+    m_stableSince.assign(since.begin() + commit, since.end());
+    return static_cast<int>(commit);
+}
+
+int StablePrefixTracker::finish(const std::vector<Token> &hypothesis)
+{
+    const size_t start = spliceTail(hypothesis);
+    m_committed.insert(m_committed.end(), hypothesis.begin() + start, hypothesis.end());
+    m_tentative.clear();
+    m_stableSince.clear();
+    return static_cast<int>(hypothesis.size() - start);
+}
+
+std::vector<int> StablePrefixTracker::committedIds() const
+{
+    std::vector<int> ids;
+    ids.reserve(m_committed.size());
+    for (const Token &token : m_committed) {
+        ids.push_back(token.id);
+    }
+    return ids;
+}
+
+std::vector<int> StablePrefixTracker::allIds() const
+{
+    std::vector<int> ids = committedIds();
+    for (const Token &token : m_tentative) {
+        ids.push_back(token.id);
+    }
+    return ids;
+}
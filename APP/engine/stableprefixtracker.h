@@ -0,0 +1,81 @@
+#ifndef STABLEPREFIXTRACKER_H
+#define STABLEPREFIXTRACKER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * 函数名称：`StablePrefixTracker`
+ * 功能描述：中间结果的稳定前缀提交：同一段语音随录音增长反复重新识别，每次得到带时间戳的token序列，
+ *           连续stableMs保持不变、且已离开录音末尾stableMs的token提交为定稿，之后不再改写；
+ *           界面只重写未定稿的尾部，避免整段文字反复替换造成的闪烁和重排
+ * 设计特点：
+ *   - 新结果与已定稿部分不一致时不回改，按时间戳从已定稿的最后一个token之后接上新结果的尾部
+ *   - 稳定性按录音时间而非墙上时间计算，识别快慢不影响提交时机
+ * 线程安全：只能在一个线程中使用
+ */
+class StablePrefixTracker
+{
+public:
+    /**
+     * 带时间戳的token，时间为该段语音内的毫秒数，区间为[startMs, endMs)
+     */
+    struct Token {
+        int id = 0;
+        int startMs = 0;
+        int endMs = 0;
+    };
+
+    StablePrefixTracker();
+    explicit StablePrefixTracker(int stableMs);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：开始新的一段语音
+     */
+    void reset();
+
+    /**
+     * 函数名称：`update`
+     * 功能描述：送入一次识别结果，更新定稿和未定稿部分
+     * 参数说明：
+     *     - hypothesis：std::vector<Token>，本次识别的完整token序列
+     *     - audioMs：int，本次识别的音频时长
+     * 返回值：int，本次新定稿的token数
+     */
+    int update(const std::vector<Token> &hypothesis, int audioMs);
+
+    /**
+     * 函数名称：`finish`
+     * 功能描述：最终结果：接在已定稿部分之后全部定稿
+     * 参数说明：
+     *     - hypothesis：std::vector<Token>，最终识别结果
+     * 返回值：int，本次新定稿的token数
+     */
+    int finish(const std::vector<Token> &hypothesis);
+
+    const std::vector<Token> &committed() const { return m_committed; }
+    const std::vector<Token> &tentative() const { return m_tentative; }
+
+    /**
+     * 函数名称：`committedIds`/`allIds`
+     * 功能描述：定稿部分的token ID；定稿与未定稿部分合起来的token ID
+     */
+    std::vector<int> committedIds() const;
+    std::vector<int> allIds() const;
+
+private:
+    /**
+     * 函数名称：`spliceTail`
+     * 功能描述：新结果中接在已定稿部分之后的起始下标
+     */
+    size_t spliceTail(const std::vector<Token> &hypothesis) const;
+
+private:
+    int m_stableMs;
+    std::vector<Token> m_committed;
+    std::vector<Token> m_tentative;
+    std::vector<int> m_stableSince;     // 未定稿token最早以当前内容出现时的录音时长，与m_tentative对应
+};
+
+#endif // STABLEPREFIXTRACKER_H
@@ -0,0 +1,271 @@
+#include "wavfrontend.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+const float PREEMPH_COEFF = 0.97f;
+const float LOW_FREQ = 20.0f;
+const double PI = 3.14159265358979323846;
+
+inline float melScale(float freq)
+{
+    return 1127.0f * std::log(1.0f + freq / 700.0f);
+}
+
+} // namespace
+
+WavFrontend::WavFrontend(const Options &options, const float *cmvnMeans, const float *cmvnVars)
+    : m_options(options)
+    , m_frameLength(options.sampleRate * options.frameLengthMs / 1000)
+    , m_frameShift(options.sampleRate * options.frameShiftMs / 1000)
+    , m_fftSize(1)
+    , m_fbankOffset(0)
+    , m_fbankFrames(0)
+    , m_lfrFrames(0)
+{
+    while (m_fftSize < m_frameLength) {
+        m_fftSize <<= 1;
+    }
+
+    int dim = featureDim();
+    if (cmvnMeans && cmvnVars) {
+        m_cmvnMeans.assign(cmvnMeans, cmvnMeans + dim);
+        m_cmvnVars.assign(cmvnVars, cmvnVars + dim);
+    }
+
+    // 汉明窗，与knf的window_type="hamming"一致
+    m_window.resize(m_frameLength);
+    for (int i = 0; i < m_frameLength; ++i) {
+        m_window[i] = static_cast<float>(0.54 - 0.46 * std::cos(2.0 * PI * i / (m_frameLength - 1)));
+    }
+
+    // Kaldi梅尔滤波器组（不含奈奎斯特频点）
+    int fftBins = m_fftSize / 2;
+    float binWidth = static_cast<float>(options.sampleRate) / m_fftSize;
+    float melLow = melScale(LOW_FREQ);
+    float melHigh = melScale(options.sampleRate / 2.0f);
+    float melDelta = (melHigh - melLow) / (options.melBins + 1);
+    m_melBanks.assign(static_cast<size_t>(options.melBins) * fftBins, 0.0f);
+    for (int b = 0; b < options.melBins; ++b) {
+        float left = melLow + b * melDelta;
+        float center = left + melDelta;
+        float right = center + melDelta;
+        for (int i = 0; i < fftBins; ++i) {
+            float mel = melScale(binWidth * i);
+            if (mel > left && mel < right) {
+                float weight = mel <= center ? (mel - left) / (center - left)
+                                             : (right - mel) / (right - center);
+                m_melBanks[static_cast<size_t>(b) * fftBins + i] = weight;
+            }
+        }
+    }
+
+    // FFT位反转表和旋转因子
+    int bits = 0;
+    while ((1 << bits) < m_fftSize) {
+        ++bits;
+    }
+    m_bitReverse.resize(m_fftSize);
+    for (int i = 0; i < m_fftSize; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) {
+                r |= 1 << (bits - 1 - b);
+            }
+        }
+        m_bitReverse[i] = r;
+    }
+    m_cosTable.resize(m_fftSize / 2);
+    m_sinTable.resize(m_fftSize / 2);
+    for (int i = 0; i < m_fftSize / 2; ++i) {
+        m_cosTable[i] = static_cast<float>(std::cos(2.0 * PI * i / m_fftSize));
+        m_sinTable[i] = static_cast<float>(-std::sin(2.0 * PI * i / m_fftSize));
+    }
+
+    m_frameBuffer.resize(m_frameLength);
+    m_re.resize(m_fftSize);
+    m_im.resize(m_fftSize);
+}
+
+void WavFrontend::reset()
+{
+    m_pendingSamples.clear();
+    m_fbank.clear();
+    m_fbankOffset = 0;
+    m_fbankFrames = 0;
+    m_lfrFrames = 0;
+}
+
+void WavFrontend::acceptWaveform(const int16_t *samples, int count)
+{
+    // knf要求输入放大到int16范围，这里直接使用原始采样值
+    m_pendingSamples.reserve(m_pendingSamples.size() + count);
+    for (int i = 0; i < count; ++i) {
+        m_pendingSamples.push_back(static_cast<float>(samples[i]));
+    }
+
+    // snip_edges=true：只计算完整的帧
+    size_t consumed = 0;
+    while (m_pendingSamples.size() - consumed >= static_cast<size_t>(m_frameLength)) {
+        size_t base = m_fbank.size();
+        m_fbank.resize(base + m_options.melBins);
+        computeFbankFrame(m_pendingSamples.data() + consumed, m_fbank.data() + base);
+        consumed += m_frameShift;
+        ++m_fbankFrames;
+    }
+    if (consumed > 0) {
+        m_pendingSamples.erase(m_pendingSamples.begin(), m_pendingSamples.begin() + consumed);
+    }
+}
+
+const float *WavFrontend::fbankFrame(int index) const
+{
+    return m_fbank.data() + static_cast<size_t>(index - m_fbankOffset) * m_options.melBins;
+}
+
+int WavFrontend::readyFrames(bool isFinal) const
+{
+    const int lfrM = m_options.lfrM;
+    const int lfrN = m_options.lfrN;
+    const int left = (lfrM - 1) / 2;
+    const int total = m_fbankFrames;
+
+    // 非最终块：LFR帧i需要原始帧 i*lfrN-left .. i*lfrN-left+lfrM-1 全部就绪
+    // 最终块：按apply_lfr的规则补齐到 ceil(T / lfrN) 帧，越界帧用首/尾帧填充
+    int target = 0;
+    if (total == 0) {
+        target = 0;
+    } else if (isFinal) {
+        target = (total + lfrN - 1) / lfrN;
+    } else if (total - lfrM + left >= 0) {
+        target = (total - lfrM + left) / lfrN + 1;
+    }
+    return std::max(target - m_lfrFrames, 0);
+}
+
+int WavFrontend::lfrFrameCount(int sampleCount) const
+{
+    if (sampleCount < m_frameLength) {
+        return 0;
+    }
+    int fbankFrames = (sampleCount - m_frameLength) / m_frameShift + 1;
+    return (fbankFrames + m_options.lfrN - 1) / m_options.lfrN;
+}
+
+int WavFrontend::popFeatures(std::vector<float> &out, bool isFinal)
+{
+    size_t base = out.size();
+    out.resize(base + static_cast<size_t>(readyFrames(isFinal)) * featureDim());
+    return popFeatures(out.data() + base, isFinal);
+}
+
+int WavFrontend::popFeatures(float *out, bool isFinal)
+{
+    const int lfrM = m_options.lfrM;
+    const int lfrN = m_options.lfrN;
+    const int left = (lfrM - 1) / 2;
+    const int melBins = m_options.melBins;
+    const int dim = featureDim();
+    const int total = m_fbankFrames;
+    const int produced = readyFrames(isFinal);
+
+    for (int n = 0; n < produced; ++n) {
+        const int i = m_lfrFrames + n;
+        float *dst = out + static_cast<size_t>(n) * dim;
+        for (int k = 0; k < lfrM; ++k) {
+            int src = std::min(std::max(i * lfrN - left + k, 0), total - 1);
+            std::copy(fbankFrame(src), fbankFrame(src) + melBins, dst + k * melBins);
+        }
+        if (!m_cmvnMeans.empty()) {
+            for (int d = 0; d < dim; ++d) {
+                dst[d] = (dst[d] + m_cmvnMeans[d]) * m_cmvnVars[d];
+            }
+        }
+    }
+    m_lfrFrames += produced;
+    if (total == 0) {
+        return 0;
+    }
+
+    // 丢弃后续LFR帧不再需要的Fbank帧
+    int keepFrom = std::min(std::max(m_lfrFrames * lfrN - left, 0), total - 1);
+    if (keepFrom > m_fbankOffset) {
+        m_fbank.erase(m_fbank.begin(),
+                      m_fbank.begin() + static_cast<size_t>(keepFrom - m_fbankOffset) * melBins);
+        m_fbankOffset = keepFrom;
+    }
+    return produced;
+}
+
+void WavFrontend::computeFbankFrame(const float *frame, float *mel)
+{
+    float *buf = m_frameBuffer.data();
+
+    // 去直流
+    float mean = 0.0f;
+    for (int i = 0; i < m_frameLength; ++i) {
+        mean += frame[i];
+    }
+    mean /= m_frameLength;
+    for (int i = 0; i < m_frameLength; ++i) {
+        buf[i] = frame[i] - mean;
+    }
+
+    // 预加重
+    for (int i = m_frameLength - 1; i > 0; --i) {
+        buf[i] -= PREEMPH_COEFF * buf[i - 1];
+    }
+    buf[0] -= PREEMPH_COEFF * buf[0];
+
+    // 加窗并补零
+    for (int i = 0; i < m_fftSize; ++i) {
+        m_re[i] = i < m_frameLength ? buf[i] * m_window[i] : 0.0f;
+        m_im[i] = 0.0f;
+    }
+    fft(m_re.data(), m_im.data());
+
+    // 功率谱 -> 梅尔能量 -> 对数
+    int fftBins = m_fftSize / 2;
+    for (int i = 0; i < fftBins; ++i) {
+        m_re[i] = m_re[i] * m_re[i] + m_im[i] * m_im[i];
+    }
+    for (int b = 0; b < m_options.melBins; ++b) {
+        const float *bank = m_melBanks.data() + static_cast<size_t>(b) * fftBins;
+        float energy = 0.0f;
+        for (int i = 0; i < fftBins; ++i) {
+            energy += bank[i] * m_re[i];
+        }
+        mel[b] = std::log(std::max(energy, FLT_EPSILON));
+    }
+}
+
+void WavFrontend::fft(float *re, float *im) const
+{
+    for (int i = 0; i < m_fftSize; ++i) {
+        int j = m_bitReverse[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (int size = 2; size <= m_fftSize; size <<= 1) {
+        int half = size / 2;
+        int step = m_fftSize / size;
+        for (int start = 0; start < m_fftSize; start += size) {
+            for (int k = 0; k < half; ++k) {
+                float wr = m_cosTable[k * step];
+                float wi = m_sinTable[k * step];
+                int a = start + k;
+                int b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
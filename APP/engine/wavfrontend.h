@@ -0,0 +1,131 @@
+#ifndef WAVFRONTEND_H
+#define WAVFRONTEND_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * 函数名称：`WavFrontend`
+ * 功能描述：SenseVoice前端特征提取：Kaldi兼容Fbank + LFR拼帧 + CMVN，对应SenseVoice/utils/frontend.py
+ * 设计特点：
+ *   - 支持流式输入，录音过程中逐块送入PCM即可增量产出LFR特征
+ *   - 只保留尚未被LFR消费的Fbank帧，长录音内存有界
+ */
+class WavFrontend
+{
+public:
+    /**
+     * 前端配置，默认值与SenseVoiceSmall的frontend_conf一致
+     */
+    struct Options {
+        int sampleRate = 16000;
+        int melBins = 80;
+        int frameLengthMs = 25;
+        int frameShiftMs = 10;
+        int lfrM = 7;
+        int lfrN = 6;
+    };
+
+    /**
+     * 函数名称：`WavFrontend`
+     * 功能描述：构造前端
+     * 参数说明：
+     *     - options：Options，前端配置
+     *     - cmvnMeans：const float*，CMVN均值偏移 [melBins * lfrM]，可为nullptr
+     *     - cmvnVars：const float*，CMVN缩放 [melBins * lfrM]，可为nullptr
+     */
+    WavFrontend(const Options &options, const float *cmvnMeans, const float *cmvnVars);
+
+    /**
+     * 函数名称：`reset`
+     * 功能描述：清空流式状态，开始新的一句话
+     * 参数说明：无
+     * 返回值：void
+     */
+    void reset();
+
+    /**
+     * 函数名称：`acceptWaveform`
+     * 功能描述：送入16位PCM采样并计算可用的Fbank帧
+     * 参数说明：
+     *     - samples：const int16_t*，PCM采样
+     *     - count：int，采样数
+     * 返回值：void
+     */
+    void acceptWaveform(const int16_t *samples, int count);
+
+    /**
+     * 函数名称：`popFeatures`
+     * 功能描述：取出已就绪的LFR+CMVN特征，追加到out末尾
+     * 参数说明：
+     *     - out：std::vector<float>&，输出特征 [frames, featureDim()]
+     *     - isFinal：bool，是否为最后一次调用（按Python实现补齐尾帧）
+     * 返回值：int，本次产出的帧数
+     */
+    int popFeatures(std::vector<float> &out, bool isFinal);
+
+    /**
+     * 函数名称：`popFeatures`
+     * 功能描述：同上，写入调用方提供的缓冲区（不分配内存）
+     * 参数说明：
+     *     - out：float*，输出特征，容量不少于readyFrames(isFinal)帧
+     *     - isFinal：bool，是否为最后一次调用
+     * 返回值：int，本次产出的帧数
+     */
+    int popFeatures(float *out, bool isFinal);
+
+    /**
+     * 函数名称：`readyFrames`
+     * 功能描述：当前调用popFeatures可产出的LFR帧数
+     */
+    int readyFrames(bool isFinal) const;
+
+    /**
+     * 函数名称：`lfrFrameCount`
+     * 功能描述：一段采样数为sampleCount的整句音频产出的LFR帧数，用于预先分配缓冲区
+     */
+    int lfrFrameCount(int sampleCount) const;
+
+    /**
+     * 函数名称：`featureDim`
+     * 功能描述：LFR特征维度
+     */
+    int featureDim() const { return m_options.melBins * m_options.lfrM; }
+
+    /**
+     * 函数名称：`lfrFrameMs`
+     * 功能描述：单个LFR帧对应的时长（毫秒）
+     */
+    int lfrFrameMs() const { return m_options.frameShiftMs * m_options.lfrN; }
+
+private:
+    void computeFbankFrame(const float *frame, float *mel);
+    void fft(float *re, float *im) const;
+    const float *fbankFrame(int index) const;
+
+private:
+    Options m_options;
+    int m_frameLength;                  // 每帧采样数
+    int m_frameShift;                   // 帧移采样数
+    int m_fftSize;                      // FFT点数
+
+    std::vector<float> m_cmvnMeans;
+    std::vector<float> m_cmvnVars;
+    std::vector<float> m_window;        // 汉明窗
+    std::vector<float> m_melBanks;      // [melBins, fftSize/2]
+    std::vector<float> m_cosTable;      // FFT旋转因子
+    std::vector<float> m_sinTable;
+    std::vector<int> m_bitReverse;
+
+    std::vector<float> m_pendingSamples;    // 尚未凑满一帧的采样
+    std::vector<float> m_fbank;             // 已计算但未被LFR消费的Fbank帧
+    int m_fbankOffset;                      // m_fbank第一帧的全局下标
+    int m_fbankFrames;                      // 已计算的Fbank总帧数
+    int m_lfrFrames;                        // 已产出的LFR帧数
+
+    std::vector<float> m_frameBuffer;       // 单帧计算用临时缓冲
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+};
+
+#endif // WAVFRONTEND_H
@@ -0,0 +1,422 @@
+#include "enginepipeline.h"
+#include "voicerecognitionmanager.h"
+#include "capturestore.h"
+#include "voicelogging.h"
+#include <QElapsedTimer>
+#include <QVector>
+
+namespace {
+
+/**
+ * 后台加载的引擎和预热过的会话，交给流水线前由排队调用持有；成员按声明的逆序释放，会话先于引擎
+ */
+struct LoadedEngine {
+    QScopedPointer<SenseVoiceEngine> engine;
+    QScopedPointer<SenseVoiceStream> stream;
+};
+
+} // namespace
+
+EnginePipeline::EnginePipeline(QObject *parent)
+    : QObject(parent)
+    , m_streamActive(false)
+    , m_streaming(true)
+    , m_streamedBytes(0)
+    , m_state(Off)
+    , m_autotuneTargetMs(0)
+{
+    qRegisterMetaType<EnginePipeline::State>("EnginePipeline::State");
+}
+
+EnginePipeline::~EnginePipeline()
+{
+    // 加载无法中途停止：通知后台线程跳过预热并等它结束，尚未执行的adoptEngine随本对象丢弃
+    m_loaderCancelled.storeRelease(1);
+    if (m_loader) {
+        m_loader->wait();
+    }
+    blockSignals(true);
+    releaseEngine();
+}
+
+bool EnginePipeline::load(const QString &modelFile, const QString &precision, const QString &kernels)
+{
+    releaseEngine();
+
+    if (modelFile.isEmpty()) {
+        setState(Off);
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    SenseVoiceEngine *engine = createEngine(modelFile, precision, kernels, &error);
+    if (!engine) {
+        qCWarning(lcEngine) << "🎤 内置引擎加载失败:" << error;
+        setState(Failed);
+        emit loadFinished(false);
+        return false;
+    }
+
+    adoptEngine(engine, nullptr);
+    qCInfo(lcEngine) << "🎤 内置引擎已启用，模型:" << modelFile << "加载耗时(ms):" << timer.elapsed();
+    return true;
+}
+
+void EnginePipeline::loadAsync(const QString &modelFile, const QString &precision, const QString &kernels)
+{
+    if (m_loader) {
+        qCDebug(lcEngine) << "🎤 内置引擎正在后台加载，忽略本次请求";
+        return;
+    }
+
+    releaseEngine();
+    setState(Loading);
+
+    // 加载和预热都在后台线程完成，结果通过排队调用交回本对象所在的管理器线程；
+    // 本对象先析构时排队的调用随之丢弃，引擎和会话由调用持有的LoadedEngine释放
+    m_loaderCancelled.storeRelease(0);
+    m_loader = QThread::create([this, modelFile, precision, kernels]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        QString error;
+        QSharedPointer<LoadedEngine> loaded(new LoadedEngine);
+        loaded->engine.reset(createEngine(modelFile, precision, kernels, &error));
+        if (!loaded->engine) {
+            QMetaObject::invokeMethod(this, [this, error]() {
+                qCWarning(lcEngine) << "🎤 内置引擎加载失败:" << error;
+                setState(Failed);
+                emit loadFinished(false);
+            }, Qt::QueuedConnection);
+            return;
+        }
+        const qint64 loadMs = timer.restart();
+        VoiceRecognitionManager::markStartupPhase("engine_loaded");
+        if (m_loaderCancelled.loadAcquire()) {
+            return;             // 正在析构，不再预热
+        }
+        QMetaObject::invokeMethod(this, [this]() { setState(Warming); }, Qt::QueuedConnection);
+
+        loaded->stream.reset(new SenseVoiceStream(loaded->engine.data()));
+        warmUpEngine(*loaded->engine, *loaded->stream);
+        const qint64 warmUpMs = timer.elapsed();
+        VoiceRecognitionManager::markStartupPhase("engine_warmed");
+
+        QMetaObject::invokeMethod(this, [this, loaded, modelFile, loadMs, warmUpMs]() {
+            adoptEngine(loaded->engine.take(), loaded->stream.take());
+            qCInfo(lcEngine) << "🎤 内置引擎已启用，模型:" << modelFile << "加载耗时(ms):" << loadMs
+                             << "预热耗时(ms):" << warmUpMs;
+        }, Qt::QueuedConnection);
+    });
+    connect(m_loader.data(), &QThread::finished, m_loader.data(), &QObject::deleteLater);
+    m_loader->start(QThread::LowPriority);
+}
+
+SenseVoiceEngine *EnginePipeline::createEngine(const QString &modelFile, const QString &precision,
+                                               const QString &kernels, QString *errorMessage)
+{
+    QScopedPointer<SenseVoiceEngine> engine(new SenseVoiceEngine());
+    SenseVoiceEngine::Options options = engine->options();
+    options.precision = precision;
+    options.kernels = kernels;
+    engine->setOptions(options);
+    if (!engine->load(modelFile, errorMessage)) {
+        return nullptr;
+    }
+    return engine.take();
+}
+
+void EnginePipeline::warmUpEngine(const SenseVoiceEngine &engine, SenseVoiceStream &stream)
+{
+    // 1秒低幅伪随机噪声：与真实语音走同样的计算路径，又不会被识别出内容
+    QVector<qint16> samples(16000);
+    quint32 seed = 1;
+    for (qint16 &sample : samples) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = static_cast<qint16>(static_cast<int>((seed >> 16) % 201) - 100);
+    }
+
+    engine.recognize(samples.constData(), samples.size());
+
+    // 按录音送数节奏走一遍分块识别，会话的缓冲区和arena随之扩容，首次录音不再分配
+    const int block = 16000 * WARM_UP_BLOCK_MS / 1000;
+    stream.reset();
+    for (int offset = 0; offset < samples.size(); offset += block) {
+        stream.acceptWaveform(samples.constData() + offset, qMin(block, samples.size() - offset));
+    }
+    stream.finish();
+}
+
+void EnginePipeline::adoptEngine(SenseVoiceEngine *engine, SenseVoiceStream *stream)
+{
+    releaseEngine();
+    m_engine.reset(engine);
+    m_stream.reset(stream);
+    if (m_threadConfig.valid && (!stream || stream->intraOpThreads() != m_threadConfig.interactiveThreads)) {
+        m_stream.reset(new SenseVoiceStream(m_engine.data(), m_threadConfig.interactiveThreads));
+    }
+    createScheduler();
+
+    setState(Ready);
+    emit loadFinished(true);
+
+    if (m_autotuneTargetMs > 0) {
+        const int target = m_autotuneTargetMs;
+        m_autotuneTargetMs = 0;
+        autotune(target);
+    }
+}
+
+void EnginePipeline::createScheduler()
+{
+    InferenceScheduler::Options options;
+    if (m_threadConfig.valid) {
+        // 单个请求时可用到交互线程数，并发时调度器按忙碌的会话数均分核心
+        options.batchWorkers = m_threadConfig.sessions;
+        options.intraOpThreads = qMax(m_threadConfig.intraOpThreads, m_threadConfig.interactiveThreads);
+        options.threadBudget = m_threadConfig.threadBudget;
+    }
+    // 调度器的结果来自工作线程，经本对象的信号排队到管理器线程
+    m_scheduler.reset(new InferenceScheduler(m_engine.data(), options));
+    connect(m_scheduler.data(), &InferenceScheduler::requestFinished, this, &EnginePipeline::requestFinished);
+    connect(m_scheduler.data(), &InferenceScheduler::commandFinished, this, &EnginePipeline::commandFinished);
+}
+
+bool EnginePipeline::autotune(int targetLatencyMs)
+{
+    if (m_autotuner) {
+        qCDebug(lcEngine) << "🧠 线程配置调优进行中，忽略本次请求";
+        return false;
+    }
+    if (!m_engine) {
+        // 引擎加载中：就绪后再调优；未启用引擎时无需调优
+        if (isLoading()) {
+            m_autotuneTargetMs = targetLatencyMs;
+        }
+        return false;
+    }
+
+    // 引擎在调优期间只读使用；释放引擎前会等待本线程结束
+    const SenseVoiceEngine *engine = m_engine.data();
+    m_autotuner = QThread::create([this, engine, targetLatencyMs]() {
+        EngineAutotuner::Options options;
+        options.targetLatencyMs = targetLatencyMs;
+        const EngineAutotuner::Result result = EngineAutotuner::run(*engine, options);
+        QMetaObject::invokeMethod(this, [this, engine, result]() {
+            if (m_engine.data() == engine && result.valid) {
+                applyThreadConfig(result);
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(m_autotuner.data(), &QThread::finished, m_autotuner.data(), &QObject::deleteLater);
+    m_autotuner->start(QThread::LowPriority);
+    emit autotuneStarted();
+    return true;
+}
+
+void EnginePipeline::setThreads(int intraOpThreads, int sessions)
+{
+    EngineAutotuner::Result config;
+    config.valid = true;
+    config.intraOpThreads = qMax(1, intraOpThreads);
+    config.interactiveThreads = config.intraOpThreads;
+    config.sessions = qMax(1, sessions);
+    config.threadBudget = config.intraOpThreads * config.sessions;
+    applyThreadConfig(config);
+}
+
+void EnginePipeline::applyThreadConfig(const EngineAutotuner::Result &config)
+{
+    m_threadConfig = config;
+    const QString summary = EngineAutotuner::summary(config);
+    qCInfo(lcEngine) << "🧠 线程配置:" << summary;
+    emit threadConfigChanged(summary);
+    if (!m_engine) {
+        return;             // 引擎就绪时按此配置创建
+    }
+
+    // 未开始的请求迁移到新调度器；旧调度器析构时等待正在推理的批次完成
+    QList<InferenceScheduler::PendingRequest> pending;
+    if (m_scheduler) {
+        pending = m_scheduler->takePending();
+    }
+    createScheduler();
+    for (const InferenceScheduler::PendingRequest &request : pending) {
+        m_scheduler->submit(request.requestId, request.pcm, request.priority, request.grammar);
+    }
+
+    // 正在录音的会话保持不变，下次开始录音时再按新配置重建
+    if (!m_streamActive) {
+        m_stream.reset(new SenseVoiceStream(m_engine.data(), config.interactiveThreads));
+    }
+}
+
+void EnginePipeline::releaseEngine()
+{
+    if (m_autotuner) {
+        m_autotuner->wait();
+    }
+
+    // 会话、工作区和调度器都引用引擎，须先于引擎释放
+    const bool hadEngine = !m_engine.isNull();
+    m_stream.reset();
+    m_streamActive = false;
+    m_activeGrammar.reset();
+    m_scheduler.reset();
+    m_alignWorkspace.reset();
+    m_engine.reset();
+    if (hadEngine) {
+        emit engineReleased();
+    }
+}
+
+void EnginePipeline::setState(State state)
+{
+    if (m_state == state) {
+        return;
+    }
+    m_state = state;
+    emit stateChanged(state);
+}
+
+bool EnginePipeline::submit(const QString &requestId, const QByteArray &pcm, InferenceScheduler::Priority priority,
+                            const QSharedPointer<const CommandGrammar> &grammar)
+{
+    if (m_scheduler) {
+        m_scheduler->submit(requestId, pcm, priority, grammar);
+        return true;
+    }
+    // 引擎仍在后台加载或预热：先保留音频，就绪后再识别
+    if (isLoading()) {
+        m_pendingRequests.append({requestId, pcm, priority, grammar});
+        return true;
+    }
+    return false;
+}
+
+void EnginePipeline::cancel(const QString &requestId)
+{
+    if (m_scheduler) {
+        m_scheduler->cancel(requestId);
+    }
+    for (int i = m_pendingRequests.size() - 1; i >= 0; --i) {
+        if (m_pendingRequests[i].requestId == requestId) {
+            m_pendingRequests.removeAt(i);
+        }
+    }
+}
+
+QList<InferenceScheduler::PendingRequest> EnginePipeline::takePendingRequests()
+{
+    QList<InferenceScheduler::PendingRequest> pending;
+    pending.swap(m_pendingRequests);
+    return pending;
+}
+
+QSharedPointer<const CommandGrammar> EnginePipeline::compileGrammar(const QStringList &patterns) const
+{
+    if (!m_engine) {
+        return QSharedPointer<const CommandGrammar>();
+    }
+    QSharedPointer<CommandGrammar> grammar(new CommandGrammar());
+    QString error;
+    if (!grammar->compile(patterns, m_engine->model().tokens(), m_engine->model().config().blankId, &error)) {
+        qCWarning(lcEngine) << "🎤 词表编译失败，改为自由识别后匹配:" << error;
+        return QSharedPointer<const CommandGrammar>();
+    }
+    qCDebug(lcEngine) << "🎤 词表已编译，短语数:" << grammar->phrases().size() << "节点数:" << grammar->nodeCount();
+    return grammar;
+}
+
+bool EnginePipeline::beginStream(const QSharedPointer<const CommandGrammar> &grammar)
+{
+    if (!m_engine || !m_streaming) {
+        return false;
+    }
+
+    // 复用上一句的识别会话，缓冲区容量保留，稳态下不再分配；线程配置变更后重建
+    const int threads = m_threadConfig.valid ? m_threadConfig.interactiveThreads : 0;
+    if (!m_stream || (threads > 0 && m_stream->intraOpThreads() != threads)) {
+        m_stream.reset(new SenseVoiceStream(m_engine.data(), threads));
+    }
+    m_activeGrammar = grammar;
+    m_stream->reset(m_activeGrammar.data());
+    m_streamActive = true;
+    m_streamedBytes = 0;
+    return true;
+}
+
+void EnginePipeline::feedStream(const CaptureStore *store)
+{
+    if (!m_streamActive) {
+        return;
+    }
+
+    // 只送入完整的16位采样；新音频总在内存窗口中，读取缓冲区容量复用
+    const int available = static_cast<int>(store->bytesCaptured() - m_streamedBytes) & ~1;
+    if (available <= 0) {
+        return;
+    }
+
+    m_streamChunk.resize(available);
+    if (!store->readAt(m_streamedBytes, m_streamChunk.data(), available)) {
+        return;
+    }
+    const qint16 *samples = reinterpret_cast<const qint16*>(m_streamChunk.constData());
+    m_stream->acceptWaveform(samples, available / 2);
+    m_streamedBytes += available;
+}
+
+void EnginePipeline::finishStream(const CaptureStore *store, const QString &requestId)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 录音期间已完成的块无需重算，这里只处理最后一块
+    feedStream(store);
+    m_streamActive = false;
+    if (m_stream->grammar()) {
+        const CommandGrammar::Match match = m_stream->finishCommand();
+        qCInfo(lcEngine) << "🎤 内置引擎短语匹配完成，松键到出字耗时(ms):" << timer.elapsed();
+        emit commandFinished(requestId, match.text, match.confidence);
+        return;
+    }
+
+    const QString text = m_stream->finish();
+    qCInfo(lcEngine) << "🎤 内置引擎识别完成，松键到出字耗时(ms):" << timer.elapsed();
+    emit requestFinished(requestId, text);
+}
+
+void EnginePipeline::cancelStream()
+{
+    m_streamActive = false;
+}
+
+bool EnginePipeline::alignTokens(const QByteArray &pcm, std::vector<StablePrefixTracker::Token> &tokens)
+{
+    if (!m_engine) {
+        return false;
+    }
+    if (!m_alignWorkspace) {
+        m_alignWorkspace.reset(new SenseVoiceEngine::Workspace(*m_engine));
+    }
+    m_engine->recognizeAligned(reinterpret_cast<const qint16*>(pcm.constData()), pcm.size() / 2,
+                               *m_alignWorkspace, tokens);
+    return true;
+}
+
+QString EnginePipeline::alignedText() const
+{
+    if (!m_engine || !m_alignWorkspace || m_alignWorkspace->tokenIds.empty()) {
+        return QString();
+    }
+    return m_engine->decodeTokens(m_alignWorkspace->tokenIds[0]);
+}
+
+QString EnginePipeline::decodeTokens(const std::vector<int> &tokenIds) const
+{
+    return m_engine ? m_engine->decodeTokens(tokenIds) : QString();
+}
@@ -0,0 +1,246 @@
+#ifndef ENGINEPIPELINE_H
+#define ENGINEPIPELINE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThread>
+#include <vector>
+#include "sensevoiceengine.h"
+#include "inferencescheduler.h"
+#include "engineautotuner.h"
+
+class CaptureStore;
+
+/**
+ * 函数名称：`EnginePipeline`
+ * 功能描述：内置引擎的识别流水线：加载与预热、线程配置与调优、调度器、按键录音的分块识别会话，
+ *           以及加载期间积压的请求
+ * 线程归属：由VoiceRecognitionManager作为子对象创建，随管理器一起moveToThread到管理器线程，
+ *           全部方法只在该线程调用（管理器的公开入口先排队到本线程）；后台加载和调优线程的结果
+ *           以排队调用交回本对象，调度器工作线程的结果经本对象的信号转到管理器线程
+ */
+class EnginePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * 引擎状态，与VoiceRecognitionManager::EngineState一一对应
+     */
+    enum State {
+        Off,                            // 未启用内置引擎，使用识别服务
+        Loading,                        // 后台加载权重
+        Warming,                        // 后台预热推理
+        Ready,                          // 可以识别
+        Failed                          // 加载失败，退回识别服务
+    };
+
+    explicit EnginePipeline(QObject *parent = nullptr);
+    ~EnginePipeline();
+
+    /**
+     * 函数名称：`load`
+     * 功能描述：在调用线程中加载引擎并启用，不预热
+     * 参数说明：
+     *     - modelFile：QString，export_native.py导出的权重文件，为空则关闭引擎
+     *     - precision：QString，线性层精度：auto/fp32/int8
+     *     - kernels：QString，内核指令集：auto/generic/avx2/avx512/avx512vnni
+     * 返回值：bool，是否加载成功（关闭引擎时为true）
+     */
+    bool load(const QString &modelFile, const QString &precision, const QString &kernels);
+
+    /**
+     * 函数名称：`loadAsync`
+     * 功能描述：在后台线程加载并预热引擎，立即返回；完成时发出loadFinished
+     * 参数说明：同load
+     * 返回值：void
+     */
+    void loadAsync(const QString &modelFile, const QString &precision, const QString &kernels);
+
+    State state() const { return m_state; }
+    bool isEnabled() const { return !m_engine.isNull(); }
+    bool isLoading() const { return m_state == Loading || m_state == Warming; }
+
+    /**
+     * 函数名称：`autotune`
+     * 功能描述：在后台实测各线程配置并应用最优的一组；引擎加载中时就绪后执行，未启用引擎时忽略
+     * 参数说明：
+     *     - targetLatencyMs：int，单条请求p95延迟上限
+     * 返回值：bool，是否已开始调优
+     */
+    bool autotune(int targetLatencyMs);
+
+    /**
+     * 函数名称：`setThreads`
+     * 功能描述：手动指定线程配置，跳过调优
+     * 参数说明：
+     *     - intraOpThreads：int，每次推理的最大线程数，交互会话同样使用
+     *     - sessions：int，并发推理的批量会话数
+     * 返回值：void
+     */
+    void setThreads(int intraOpThreads, int sessions);
+
+    EngineAutotuner::Result threadConfig() const { return m_threadConfig; }
+
+    void setStreaming(bool enabled) { m_streaming = enabled; }
+    bool isStreaming() const { return m_streaming; }
+
+    /**
+     * 函数名称：`submit`
+     * 功能描述：提交一条整句识别：引擎就绪时进入调度器，加载/预热中时先积压，就绪后随loadFinished取出
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - pcm：QByteArray，16kHz单声道16位PCM
+     *     - priority：InferenceScheduler::Priority，所属队列
+     *     - grammar：QSharedPointer<const CommandGrammar>，受限词表，可为空
+     * 返回值：bool，未启用引擎时返回false，由调用方改用识别服务
+     */
+    bool submit(const QString &requestId, const QByteArray &pcm, InferenceScheduler::Priority priority,
+                const QSharedPointer<const CommandGrammar> &grammar = QSharedPointer<const CommandGrammar>());
+
+    /**
+     * 函数名称：`cancel`
+     * 功能描述：撤销调度器中和积压的同ID请求
+     */
+    void cancel(const QString &requestId);
+
+    /**
+     * 函数名称：`takePendingRequests`
+     * 功能描述：取出加载期间积压的请求（loadFinished之后由管理器补上词表重新提交，或转交识别服务）
+     */
+    QList<InferenceScheduler::PendingRequest> takePendingRequests();
+
+    /**
+     * 函数名称：`compileGrammar`
+     * 功能描述：按当前引擎的词表编译短语，失败或未启用引擎时返回空
+     */
+    QSharedPointer<const CommandGrammar> compileGrammar(const QStringList &patterns) const;
+
+    /**
+     * 函数名称：`beginStream`
+     * 功能描述：录音开始时准备分块识别会话（复用上一句的会话，线程配置变更后重建）
+     * 参数说明：
+     *     - grammar：QSharedPointer<const CommandGrammar>，本次录音的受限词表，录音期间保持有效
+     * 返回值：bool，是否边录边算
+     */
+    bool beginStream(const QSharedPointer<const CommandGrammar> &grammar);
+    bool isStreamActive() const { return m_streamActive; }
+
+    /**
+     * 函数名称：`feedStream`
+     * 功能描述：把录音存储中尚未送入的部分送入分块识别会话
+     */
+    void feedStream(const CaptureStore *store);
+
+    /**
+     * 函数名称：`finishStream`
+     * 功能描述：松键后处理最后一块，结果同调度器一样经requestFinished/commandFinished发出
+     * 参数说明：
+     *     - store：const CaptureStore*，已结束写入的录音
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void finishStream(const CaptureStore *store, const QString &requestId);
+
+    /**
+     * 函数名称：`cancelStream`
+     * 功能描述：放弃当前录音的分块识别，会话留待下次复用
+     */
+    void cancelStream();
+
+    /**
+     * 函数名称：`alignTokens`
+     * 功能描述：在本线程的工作区中整句识别并对齐出每个token的时间（听写中间结果使用）
+     * 参数说明：
+     *     - pcm：QByteArray，16kHz单声道16位PCM
+     *     - tokens：std::vector<StablePrefixTracker::Token>&，输出
+     * 返回值：bool，未启用引擎时返回false
+     */
+    bool alignTokens(const QByteArray &pcm, std::vector<StablePrefixTracker::Token> &tokens);
+
+    /**
+     * 函数名称：`alignedText`
+     * 功能描述：上一次alignTokens的贪心识别文本
+     */
+    QString alignedText() const;
+
+    /**
+     * 函数名称：`decodeTokens`
+     * 功能描述：把token ID序列解码为文本，未启用引擎时为空
+     */
+    QString decodeTokens(const std::vector<int> &tokenIds) const;
+
+signals:
+    void stateChanged(EnginePipeline::State state);
+    void threadConfigChanged(const QString &summary);
+
+    /**
+     * 信号名称：`loadFinished`
+     * 功能描述：加载结束（成功为Ready，失败为Failed），管理器据此重新编译词表并取出积压的请求
+     */
+    void loadFinished(bool ok);
+
+    /**
+     * 信号名称：`engineReleased`
+     * 功能描述：引擎已释放，按它编译的词表随之失效
+     */
+    void engineReleased();
+
+    void autotuneStarted();
+    void requestFinished(const QString &requestId, const QString &text);
+    void commandFinished(const QString &requestId, const QString &phrase, double confidence);
+
+private:
+    static SenseVoiceEngine *createEngine(const QString &modelFile, const QString &precision,
+                                          const QString &kernels, QString *errorMessage);
+
+    /**
+     * 函数名称：`warmUpEngine`
+     * 功能描述：用合成音频跑一遍整句和分块识别：调入权重页面、arena扩容到实际用量、预热缓存
+     */
+    static void warmUpEngine(const SenseVoiceEngine &engine, SenseVoiceStream &stream);
+
+    /**
+     * 函数名称：`adoptEngine`
+     * 功能描述：启用已加载的引擎（转移所有权），创建调度器，发出loadFinished，再执行等待中的调优
+     */
+    void adoptEngine(SenseVoiceEngine *engine, SenseVoiceStream *stream);
+
+    /**
+     * 函数名称：`releaseEngine`
+     * 功能描述：等待调优线程，按依赖顺序释放识别会话、工作区、调度器和引擎
+     */
+    void releaseEngine();
+
+    void setState(State state);
+    void applyThreadConfig(const EngineAutotuner::Result &config);
+    void createScheduler();
+
+    QScopedPointer<SenseVoiceEngine> m_engine;
+    QScopedPointer<InferenceScheduler> m_scheduler;     // 须在m_engine之前析构
+    QScopedPointer<SenseVoiceStream> m_stream;          // 识别会话，跨录音复用
+    QScopedPointer<SenseVoiceEngine::Workspace> m_alignWorkspace;   // 听写中间结果的工作区
+    QSharedPointer<const CommandGrammar> m_activeGrammar;   // 当前录音使用的词表
+    bool m_streamActive;                // 当前录音是否正在分块识别
+    bool m_streaming;                   // 是否边录边算
+    qint64 m_streamedBytes;             // 已送入会话的音频字节数
+    QByteArray m_streamChunk;           // 送入会话前的读取缓冲区，容量复用
+    State m_state;
+    QPointer<QThread> m_loader;         // 后台加载线程，结束后自动释放；析构时等待
+    QAtomicInt m_loaderCancelled;       // 析构中，后台加载跳过预热
+    QList<InferenceScheduler::PendingRequest> m_pendingRequests;   // 加载/预热期间提交的请求
+
+    EngineAutotuner::Result m_threadConfig;
+    QPointer<QThread> m_autotuner;      // 后台调优线程，结束后自动释放
+    int m_autotuneTargetMs;             // 引擎就绪后待执行的调优目标，0表示无
+
+    static const int WARM_UP_BLOCK_MS = 100;    // 预热分块识别的送数粒度，与管理器录音时的送数间隔一致
+};
+
+#endif // ENGINEPIPELINE_H
@@ -0,0 +1,168 @@
+#include "handsfreepipeline.h"
+#include "audiosource.h"
+#include "voicelogging.h"
+#include <QIODevice>
+
+HandsFreePipeline::HandsFreePipeline(QObject *parent)
+    : QObject(parent)
+    , m_source(nullptr)
+    , m_device(nullptr)
+    , m_wakeEndSample(0)
+    , m_wakePending(false)
+    , m_recording(false)
+    , m_handsFreeRecording(false)
+    , m_speechSeen(false)
+    , m_cpuNs(0)
+    , m_statsSamples(0)
+{
+}
+
+HandsFreePipeline::~HandsFreePipeline()
+{
+    delete m_source;
+}
+
+void HandsFreePipeline::setSpotter(const QSharedPointer<KeywordSpotter> &spotter)
+{
+    m_spotter = spotter;
+    m_wakePending = false;
+    m_cpuNs = 0;
+    m_statsSamples = 0;
+}
+
+bool HandsFreePipeline::start(AudioSource *source)
+{
+    // 来源在管理器线程中创建，数据在本线程的事件循环中送出：检测、录音追加和听写送数都在管理器线程完成
+    m_device = source->start();
+    if (!m_device) {
+        qCWarning(lcWake) << "🎤 无法启动麦克风监听";
+        delete source;
+        return false;
+    }
+    m_source = source;
+    connect(m_device, &QIODevice::readyRead, this, &HandsFreePipeline::onReadyRead);
+
+    m_spotter->reset();
+    m_cpuNs = 0;
+    m_statsSamples = 0;
+    m_preRoll.clear();
+    qCInfo(lcWake) << "🎤 免按键模式已开启，唤醒词模板:" << m_spotter->templateCount();
+    return true;
+}
+
+void HandsFreePipeline::stop()
+{
+    if (!m_source) {
+        return;
+    }
+    m_source->stop();
+    emit sourceStopped(m_source);
+    delete m_source;
+    m_source = nullptr;
+    m_device = nullptr;
+    m_preRoll.clear();
+    m_wakePending = false;
+    m_recording = false;
+    m_handsFreeRecording = false;
+    qCInfo(lcWake) << "🎤 免按键模式已关闭";
+}
+
+void HandsFreePipeline::armRecording()
+{
+    const KeywordSpotter::Detection &detection = m_spotter->lastDetection();
+    qCDebug(lcWake) << "🎤 检测到唤醒词，模板:" << detection.templateIndex << "距离:" << detection.distance;
+
+    m_wakeEndSample = detection.endSample;
+    m_wakePending = true;
+    m_wakeClock.start();
+}
+
+QByteArray HandsFreePipeline::beginRecording()
+{
+    m_recording = true;
+    m_handsFreeRecording = m_wakePending && m_wakeClock.elapsed() < WAKE_RESPONSE_TIMEOUT;
+    m_wakePending = false;
+    if (!m_handsFreeRecording) {
+        return QByteArray();
+    }
+    m_speechSeen = false;
+    m_recordingClock.start();
+    const qint64 bytes = (m_spotter->samplesAccepted() - m_wakeEndSample) * 2;
+    return m_preRoll.right(static_cast<int>(qBound<qint64>(0, bytes, m_preRoll.size())));
+}
+
+void HandsFreePipeline::endRecording()
+{
+    m_recording = false;
+    m_handsFreeRecording = false;
+}
+
+void HandsFreePipeline::onReadyRead()
+{
+    const QByteArray chunk = m_device->readAll();
+    if (chunk.size() < 2) {
+        return;
+    }
+
+    // 预录缓冲只保留最近PRE_ROLL_MS
+    m_preRoll.append(chunk);
+    const int preRollBytes = 16000 * 2 * PRE_ROLL_MS / 1000;
+    if (m_preRoll.size() > preRollBytes) {
+        m_preRoll.remove(0, m_preRoll.size() - preRollBytes);
+    }
+
+    // 录音期间也送入检测器：只用它的语音/静音状态判断说完，命中忽略
+    QElapsedTimer timer;
+    timer.start();
+    const bool detected = m_spotter->acceptWaveform(reinterpret_cast<const qint16*>(chunk.constData()),
+                                                    chunk.size() / 2);
+    m_cpuNs += timer.nsecsElapsed();
+
+    emit audioCaptured(chunk);
+
+    if (m_recording) {
+        if (m_handsFreeRecording) {
+            checkEndpoint();
+        }
+    } else if (detected) {
+        emit wakeWordSpotted();
+    }
+
+    const qint64 samples = m_spotter->samplesAccepted();
+    if (samples - m_statsSamples >= 16000LL * WAKE_STATS_INTERVAL) {
+        m_statsSamples = samples;
+        qCInfo(lcWake) << "🎤 唤醒词检测单核CPU占用(%):" << cpuLoad() * 100.0
+                       << "匹配帧比例(%):" << 100.0 * m_spotter->matchedFrames() / qMax<qint64>(m_spotter->frames(), 1);
+    }
+}
+
+void HandsFreePipeline::checkEndpoint()
+{
+    if (m_spotter->isSpeech()) {
+        m_speechSeen = true;
+    }
+
+    if (!m_speechSeen) {
+        if (m_recordingClock.elapsed() >= HANDS_FREE_NO_SPEECH_TIMEOUT) {
+            qCDebug(lcWake) << "🎤 唤醒后未检测到语音，取消录音";
+            emit noSpeechTimeout();
+        }
+        return;
+    }
+
+    if (m_spotter->trailingSilenceMs() >= HANDS_FREE_SILENCE_MS
+            || m_recordingClock.elapsed() >= HANDS_FREE_MAX_DURATION) {
+        qCDebug(lcWake) << "🎤 免按键录音结束，末尾静音(ms):" << m_spotter->trailingSilenceMs()
+                        << "录音时长(ms):" << m_recordingClock.elapsed();
+        emit speechEnded();
+    }
+}
+
+double HandsFreePipeline::cpuLoad() const
+{
+    const qint64 samples = m_spotter ? m_spotter->samplesAccepted() : 0;
+    if (samples == 0) {
+        return 0.0;
+    }
+    return (m_cpuNs / 1e9) / (samples / 16000.0);
+}
@@ -0,0 +1,138 @@
+#ifndef HANDSFREEPIPELINE_H
+#define HANDSFREEPIPELINE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "keywordspotter.h"
+
+class AudioSource;
+class QIODevice;
+
+/**
+ * 函数名称：`HandsFreePipeline`
+ * 功能描述：免按键模式：常驻监听麦克风，维护预录缓冲，做唤醒词检测，并判断唤醒触发的录音何时说完
+ * 设计特点：
+ *   - 监听到的每块音频经audioCaptured交给管理器，录音和听写直接取自监听流，不再另开设备
+ *   - 只报告检测结果（wakeWordSpotted、speechEnded、noSpeechTimeout），开始、结束录音由管理器决定
+ * 线程归属：由VoiceRecognitionManager作为子对象创建，随管理器一起moveToThread到管理器线程；
+ *           监听来源在该线程中启动，readyRead、检测和全部方法都在该线程执行
+ */
+class HandsFreePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HandsFreePipeline(QObject *parent = nullptr);
+    ~HandsFreePipeline();
+
+    /**
+     * 函数名称：`setSpotter`
+     * 功能描述：换上已加好模板的检测器（模板在调用方线程中提取）
+     * 参数说明：
+     *     - spotter：QSharedPointer<KeywordSpotter>，检测器
+     * 返回值：void
+     */
+    void setSpotter(const QSharedPointer<KeywordSpotter> &spotter);
+    int templateCount() const { return m_spotter ? m_spotter->templateCount() : 0; }
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始常驻监听
+     * 参数说明：
+     *     - source：AudioSource*，已按16kHz单声道准备好的来源，转移所有权（失败时释放）
+     * 返回值：bool，是否已开始监听
+     */
+    bool start(AudioSource *source);
+
+    /**
+     * 函数名称：`stop`
+     * 功能描述：停止监听，释放来源前发出sourceStopped
+     */
+    void stop();
+
+    bool isEnabled() const { return m_source != nullptr; }
+
+    /**
+     * 函数名称：`armRecording`
+     * 功能描述：管理器接受了这次唤醒：记下唤醒词结束位置，WAKE_RESPONSE_TIMEOUT内开始的录音带上其后的预录
+     */
+    void armRecording();
+
+    /**
+     * 函数名称：`beginRecording`
+     * 功能描述：录音开始取自监听流；由唤醒词触发时开始判断说完
+     * 返回值：QByteArray，唤醒词之后已采到的音频，不是由唤醒触发时为空
+     */
+    QByteArray beginRecording();
+
+    /**
+     * 函数名称：`endRecording`
+     * 功能描述：录音结束或取消，监听流不再作为录音
+     */
+    void endRecording();
+
+    bool isRecording() const { return m_recording; }
+
+    /**
+     * 函数名称：`cpuLoad`
+     * 功能描述：唤醒词检测占单核CPU的比例（检测耗时 / 监听时长）
+     */
+    double cpuLoad() const;
+
+signals:
+    /**
+     * 信号名称：`audioCaptured`
+     * 功能描述：监听到一块音频（在检测之后发出），管理器追加到正在进行的录音或听写
+     */
+    void audioCaptured(const QByteArray &chunk);
+
+    /**
+     * 信号名称：`wakeWordSpotted`
+     * 功能描述：未在录音时检测到唤醒词，管理器接受时调用armRecording
+     */
+    void wakeWordSpotted();
+
+    /**
+     * 信号名称：`speechEnded`/`noSpeechTimeout`
+     * 功能描述：唤醒触发的录音说完后静音HANDS_FREE_SILENCE_MS（或达到最长时长），或唤醒后一直未说话
+     */
+    void speechEnded();
+    void noSpeechTimeout();
+
+    /**
+     * 信号名称：`sourceStopped`
+     * 功能描述：监听来源已停止、即将释放，管理器据此汇总采集健康状况
+     */
+    void sourceStopped(AudioSource *source);
+
+private slots:
+    void onReadyRead();
+
+private:
+    void checkEndpoint();
+
+    AudioSource *m_source;              // 常驻监听的录音来源
+    QIODevice *m_device;
+    QSharedPointer<KeywordSpotter> m_spotter;
+    QByteArray m_preRoll;               // 最近PRE_ROLL_MS的监听音频
+    qint64 m_wakeEndSample;             // 最近一次唤醒词的结束位置（监听流的采样序号）
+    QElapsedTimer m_wakeClock;          // 唤醒后计时，超过WAKE_RESPONSE_TIMEOUT无控件响应则作废
+    bool m_wakePending;                 // 已唤醒，等待聚焦的输入框开始录音
+    bool m_recording;                   // 当前录音是否取自监听流
+    bool m_handsFreeRecording;          // 当前录音由唤醒词触发，说完自动结束
+    bool m_speechSeen;                  // 唤醒后是否已开始说话
+    QElapsedTimer m_recordingClock;
+    qint64 m_cpuNs;                     // 唤醒词检测累计耗时
+    qint64 m_statsSamples;              // 上次输出检测开销时的采样数
+
+    static const int PRE_ROLL_MS = 2000;            // 预录缓冲时长(毫秒)，覆盖唤醒到控件开始录音的间隔
+    static const int WAKE_RESPONSE_TIMEOUT = 1000;  // 唤醒后多久内开始录音才带预录(毫秒)
+    static const int HANDS_FREE_SILENCE_MS = 1200;  // 免按键录音说完后静音多久结束(毫秒)
+    static const int HANDS_FREE_NO_SPEECH_TIMEOUT = 5000;  // 唤醒后一直未说话则取消(毫秒)
+    static const int HANDS_FREE_MAX_DURATION = 30000;      // 免按键录音最长时长(毫秒)
+    static const int WAKE_STATS_INTERVAL = 60;      // 唤醒词检测开销的输出间隔(秒)
+};
+
+#endif // HANDSFREEPIPELINE_H
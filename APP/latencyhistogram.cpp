@@ -0,0 +1,90 @@
+#include "latencyhistogram.h"
+#include <QtAlgorithms>
+#include <cmath>
+#include <cstring>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    std::memset(m_counts, 0, sizeof(m_counts));
+    m_count = 0;
+    m_sumNs = 0;
+    m_minNs = 0;
+    m_maxNs = 0;
+}
+
+int LatencyHistogram::bucketIndex(quint64 us)
+{
+    if (us < SUB_BUCKET_COUNT) {
+        return static_cast<int>(us);
+    }
+    // 最高位在第msb位：右移到[64, 128)区间，移位数决定区间，余下的6位决定区间内的桶
+    const int msb = 63 - static_cast<int>(qCountLeadingZeroBits(us));
+    const int shift = msb - 6;
+    if (shift > MAX_SHIFT) {
+        return BUCKET_COUNT - 1;
+    }
+    const int sub = static_cast<int>(us >> shift) - HALF_SUB_BUCKET_COUNT;
+    return SUB_BUCKET_COUNT + (shift - 1) * HALF_SUB_BUCKET_COUNT + sub;
+}
+
+qint64 LatencyHistogram::bucketUpperUs(int index)
+{
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const int shift = (index - SUB_BUCKET_COUNT) / HALF_SUB_BUCKET_COUNT + 1;
+    const qint64 sub = (index - SUB_BUCKET_COUNT) % HALF_SUB_BUCKET_COUNT + HALF_SUB_BUCKET_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if (ns < 0) {
+        ns = 0;
+    }
+    ++m_counts[bucketIndex(static_cast<quint64>(ns / 1000))];
+    if (m_count == 0 || ns < m_minNs) {
+        m_minNs = ns;
+    }
+    if (ns > m_maxNs) {
+        m_maxNs = ns;
+    }
+    ++m_count;
+    m_sumNs += ns;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_minNs = m_count ? qMin(m_minNs, other.m_minNs) : other.m_minNs;
+    m_maxNs = qMax(m_maxNs, other.m_maxNs);
+    m_count += other.m_count;
+    m_sumNs += other.m_sumNs;
+}
+
+qint64 LatencyHistogram::percentileNs(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    const double clamped = qBound(0.0, percentile, 100.0);
+    const qint64 target = qMax<qint64>(1, static_cast<qint64>(std::ceil(clamped / 100.0 * m_count)));
+    qint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_counts[i];
+        if (seen >= target) {
+            return qBound(m_minNs, (bucketUpperUs(i) + 1) * 1000 - 1, m_maxNs);
+        }
+    }
+    return m_maxNs;
+}
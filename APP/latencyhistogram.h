@@ -0,0 +1,69 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+
+/**
+ * 函数名称：`LatencyHistogram`
+ * 功能描述：耗时直方图（HDR方式的对数-线性分桶），以固定内存记录任意多个样本，可查询任意分位数
+ * 设计特点：
+ *   - 以微秒为单位：128微秒以下每微秒一桶；以上每个2的幂区间分64桶，相对误差不超过1/64（约1.6%）；
+ *     上限约38小时，超出的计入最后一桶
+ *   - 记录为一次分桶计算和计数加一，不分配内存；直方图大小固定（约8KB），可直接复制、合并
+ *   - 分位数取所在桶的上界（不低于真实值），并以已记录的最大值为上限
+ * 线程安全：不加锁，由使用方同步
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    /**
+     * 函数名称：`record`
+     * 功能描述：记录一个耗时，负值按0计
+     * 参数说明：
+     *     - ns：qint64，耗时（纳秒）
+     * 返回值：void
+     */
+    void record(qint64 ns);
+
+    /**
+     * 函数名称：`merge`
+     * 功能描述：把另一个直方图的样本并入
+     */
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    qint64 count() const { return m_count; }
+    qint64 minNs() const { return m_count ? m_minNs : 0; }
+    qint64 maxNs() const { return m_maxNs; }
+    qint64 meanNs() const { return m_count ? m_sumNs / m_count : 0; }
+
+    /**
+     * 函数名称：`percentileNs`
+     * 功能描述：分位数
+     * 参数说明：
+     *     - percentile：double，0~100，如95、99.9
+     * 返回值：qint64，纳秒；没有样本时为0
+     */
+    qint64 percentileNs(double percentile) const;
+
+private:
+    static int bucketIndex(quint64 us);
+    static qint64 bucketUpperUs(int index);
+
+    enum {
+        SUB_BUCKET_COUNT = 128,         // 128微秒以下逐微秒分桶
+        HALF_SUB_BUCKET_COUNT = 64,     // 每个2的幂区间的桶数
+        MAX_SHIFT = 30,
+        BUCKET_COUNT = SUB_BUCKET_COUNT + MAX_SHIFT * HALF_SUB_BUCKET_COUNT
+    };
+
+    quint32 m_counts[BUCKET_COUNT];
+    qint64 m_count;
+    qint64 m_sumNs;
+    qint64 m_minNs;
+    qint64 m_maxNs;
+};
+
+#endif // LATENCYHISTOGRAM_H
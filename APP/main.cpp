@@ -1,11 +1,22 @@
 #include "mainwindow.h"
+#include "voicerecognitionmanager.h"
+#include "voicelogging.h"
 
 #include <QApplication>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+    // 日志由后台线程写出，不占用GUI线程和管理器线程；VOICE_LOG_FILE设置时同时追加写入该文件。
+    // 各类别的级别用QT_LOGGING_RULES调整，如"voiceinput.network.debug=true"
+    AsyncLogSink::install(qEnvironmentVariable("VOICE_LOG_FILE"));
     QApplication a(argc, argv);
+    VoiceRecognitionManager::markStartupPhase("main");
     MainWindow w;
     w.show();
-    return a.exec();
+    // 事件循环开始处理时窗口已可交互，之后的引擎加载与预热都在后台进行
+    QTimer::singleShot(0, []() { VoiceRecognitionManager::markStartupPhase("window_shown"); });
+    const int result = a.exec();
+    AsyncLogSink::uninstall();
+    return result;
 }
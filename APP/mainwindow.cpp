@@ -2,12 +2,16 @@
 #include "ui_mainwindow.h"
 #include "simplevoicetextedit.h"
 #include "voicerecognitionmanager.h"
+#include "pipelinetrace.h"
+#include "sessionrecorder.h"
+#include "voicelogging.h"
 #include <QVBoxLayout>
 #include <QWidget>
 #include <QStatusBar>
 #include <QTimer>
 #include <QMessageBox>
 #include <QApplication>
+#include <QShortcut>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -41,10 +45,102 @@ void MainWindow::initializeVoiceRecognitionManager()
     // 设置服务URL
     manager->setServiceUrl("http://127.0.0.1:8000");
     
+    // 设置环境变量VOICE_ENGINE_MODEL指向导出的权重文件时，使用内置推理引擎；
+    // VOICE_ENGINE_PRECISION(auto/fp32/int8)和VOICE_ENGINE_KERNELS(auto/generic/avx2/avx512/avx512vnni)可覆盖自动选择。
+    // 加载和预热在后台进行，窗口立即显示，控件在引擎就绪前提示"预热中"
+    QString engineModel = qEnvironmentVariable("VOICE_ENGINE_MODEL");
+    if (!engineModel.isEmpty()) {
+        manager->loadEngineAsync(engineModel, qEnvironmentVariable("VOICE_ENGINE_PRECISION", "auto"),
+                                 qEnvironmentVariable("VOICE_ENGINE_KERNELS", "auto"));
+
+        // VOICE_ENGINE_THREADS：auto为就绪后实测调优，"N"或"NxS"为每次推理N个线程、S个并发会话
+        QString engineThreads = qEnvironmentVariable("VOICE_ENGINE_THREADS", "auto");
+        if (engineThreads == "auto") {
+            manager->autotuneEngine();
+        } else {
+            QStringList parts = engineThreads.split('x');
+            manager->setEngineThreads(parts.value(0).toInt(), parts.value(1, "1").toInt());
+        }
+    }
+    
+    // VOICE_AUDIO_SOURCE：录音来源，默认麦克风；"file:<wav>?speed=N"回放文件，"synthetic:speech"合成信号，
+    // 没有麦克风的机器上也能跑完整的录音、分段和识别流程
+    const QString audioSource = qEnvironmentVariable("VOICE_AUDIO_SOURCE");
+    if (!audioSource.isEmpty()) {
+        manager->setAudioSource(audioSource);
+    }
+    
+    // VOICE_CAPTURE_MEMORY_MB：录音在内存中保留的上限，超出部分写入临时文件，0表示全部保留在内存中
+    bool captureLimitSet = false;
+    const int captureMemoryMb = qEnvironmentVariableIntValue("VOICE_CAPTURE_MEMORY_MB", &captureLimitSet);
+    if (captureLimitSet) {
+        manager->setCaptureMemoryLimit(captureMemoryMb * 1024LL * 1024LL);
+    }
+    
+    // VOICE_CAPTURE_BUFFER_MS：麦克风缓冲区的初始时长，默认由设备决定；采集线程没跟上时自动加倍
+    const int captureBufferMs = qEnvironmentVariableIntValue("VOICE_CAPTURE_BUFFER_MS");
+    if (captureBufferMs > 0) {
+        manager->setCaptureBufferMs(captureBufferMs);
+    }
+    
+    // VOICE_SPECULATIVE_INTERVAL_MS：使用识别服务时，录音期间约每隔多久在停顿处切一段先行识别（建议4000），默认0为关闭
+    bool speculativeSet = false;
+    const int speculativeInterval = qEnvironmentVariableIntValue("VOICE_SPECULATIVE_INTERVAL_MS", &speculativeSet);
+    if (speculativeSet) {
+        manager->setSpeculativeInterval(speculativeInterval);
+    }
+    
+    // VOICE_DICTATION_PARTIALS：内置引擎听写的中间结果，stable（默认，只改写未定稿的尾部）/replace（整段替换）/off
+    const QString partials = qEnvironmentVariable("VOICE_DICTATION_PARTIALS", "stable");
+    if (partials == "off") {
+        manager->setDictationPartialMode(VoiceRecognitionManager::PartialOff);
+    } else if (partials == "replace") {
+        manager->setDictationPartialMode(VoiceRecognitionManager::PartialReplace);
+    }
+    
+    // VOICE_TRACE_FILE：记录识别流程的时间线，按Ctrl+Shift+T或退出时写入该文件（Chrome trace JSON，
+    // 用ui.perfetto.dev或chrome://tracing打开），对照按键、录音、上传、服务端和插入文字各自的耗时
+    const QString traceFile = qEnvironmentVariable("VOICE_TRACE_FILE");
+    if (!traceFile.isEmpty()) {
+        PipelineTrace::setEnabled(true);
+        auto writeTrace = [this, traceFile]() {
+            QString error;
+            if (PipelineTrace::writeJson(traceFile, &error)) {
+                statusBar()->showMessage("时间线已写入 " + traceFile, 3000);
+            } else {
+                qCWarning(lcApp) << "🏠 时间线写入失败:" << traceFile << error;
+            }
+        };
+        connect(new QShortcut(QKeySequence("Ctrl+Shift+T"), this), &QShortcut::activated, this, writeTrace);
+        connect(qApp, &QCoreApplication::aboutToQuit, this, writeTrace);
+    }
+    
+    // VOICE_SESSION_FILE：把本次运行的录音、按键、请求与响应、结果和计时录制到该文件，
+    // 用sessionreplay按原来的节奏重放，复现只在真实时序下出现的问题
+    const QString sessionFile = qEnvironmentVariable("VOICE_SESSION_FILE");
+    if (!sessionFile.isEmpty()) {
+        QString error;
+        if (SessionRecorder::start(sessionFile, &error)) {
+            qCInfo(lcApp) << "🏠 会话录制到:" << sessionFile;
+            connect(qApp, &QCoreApplication::aboutToQuit, this, []() { SessionRecorder::stop(); });
+        } else {
+            qCWarning(lcApp) << "🏠 无法录制会话:" << sessionFile << error;
+        }
+    }
+    
     // 初始化管理器（启动工作线程）
     manager->initialize();
     
-    qDebug() << "🏠 语音识别管理器已初始化";
+    // 设置环境变量VOICE_WAKE_TEMPLATES（逗号分隔的唤醒词录音WAV，3~5遍）时开启免按键模式：
+    // 说出唤醒词后聚焦的输入框开始录音，说完自动结束；VOICE_WAKE_THRESHOLD可覆盖检测阈值（用kwsbench按误唤醒率选取）
+    QString wakeTemplates = qEnvironmentVariable("VOICE_WAKE_TEMPLATES");
+    if (!wakeTemplates.isEmpty()) {
+        manager->loadWakeWordTemplates(wakeTemplates.split(',', QString::SkipEmptyParts),
+                                       qEnvironmentVariable("VOICE_WAKE_THRESHOLD").toDouble());
+        manager->setHandsFreeEnabled(true);
+    }
+    
+    qCDebug(lcApp) << "🏠 语音识别管理器已初始化";
 }
 
 void MainWindow::setupVoiceTextEdit()
@@ -72,6 +72,16 @@ void MultiVoiceDemo::setupUI()
     m_bottomTextEdit->setPlaceholderText("这里可以输入备注说明...\n长按 'V' 键开始语音输入");
     rightLayout->addWidget(m_bottomTextEdit);
     
+    // 取值控件：只接受固定的几个状态，识别在短语中直接选择
+    QLabel* choiceLabel = new QLabel("🏷️ 处理状态（可选短语）", rightWidget);
+    choiceLabel->setStyleSheet("font-weight: bold; color: #8e44ad; margin-bottom: 5px;");
+    rightLayout->addWidget(choiceLabel);
+    
+    m_choiceTextEdit = new SimpleVoiceTextEdit(rightWidget);
+    m_choiceTextEdit->setVoiceVocabulary({"待处理", "处理中", "已完成", "已取消", "(是|否)"});
+    m_choiceTextEdit->setMaximumHeight(80);
+    rightLayout->addWidget(m_choiceTextEdit);
+    
     // 添加到分割器
     splitter->addWidget(leftWidget);
     splitter->addWidget(rightWidget);
@@ -100,6 +110,9 @@ void MultiVoiceDemo::connectStatusSignals()
             
     connect(m_bottomTextEdit, &SimpleVoiceTextEdit::statusChanged,
             this, &MultiVoiceDemo::onStatusChanged);
+            
+    connect(m_choiceTextEdit, &SimpleVoiceTextEdit::statusChanged,
+            this, &MultiVoiceDemo::onStatusChanged);
 }
 
 void MultiVoiceDemo::onStatusChanged(const QString &status)
@@ -52,6 +52,7 @@ private:
     SimpleVoiceTextEdit* m_leftTextEdit;      // 左侧文本编辑器
     SimpleVoiceTextEdit* m_topTextEdit;       // 右上文本编辑器
     SimpleVoiceTextEdit* m_bottomTextEdit;    // 右下文本编辑器
+    SimpleVoiceTextEdit* m_choiceTextEdit;    // 右下取值控件（可选短语）
     QLabel* m_statusLabel;                    // 状态显示标签
 };
 
@@ -0,0 +1,284 @@
+#include "pipelinetrace.h"
+#include "requestmetrics.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+
+std::atomic<bool> PipelineTrace::s_enabled(false);
+
+namespace {
+
+const int BUFFER_CAPACITY = 4096;       // 每个线程保留的事件数
+const int ARG_CAPACITY = 47;
+const int CLIENT_PID = 1;
+const int SERVER_PID = 2;
+
+enum Phase : char {
+    PhaseComplete = 'X',
+    PhaseAsync = 'b',                   // 导出为b/e两个事件
+    PhaseInstant = 'i',
+    PhaseServer = 's'                   // 导出为识别服务进程下的X事件
+};
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    qint64 beginNs;
+    qint64 durationNs;
+    char phase;
+    char arg[ARG_CAPACITY];
+};
+
+/**
+ * 一个线程的事件环：只有所属线程写入，head在事件写完后以release发布
+ */
+struct ThreadBuffer {
+    std::atomic<quint64> head{0};
+    int tid = 0;
+    QString threadName;
+    TraceEvent events[BUFFER_CAPACITY];
+};
+
+// 线程退出后缓冲区仍保留到进程结束，导出时能看到已结束线程的事件
+QMutex g_buffersMutex;
+QVector<ThreadBuffer *> g_buffers;
+std::atomic<qint64> g_clearedNs(0);
+std::atomic<qint64> g_originNs(0);
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+// 服务端阶段名来自响应头，保存一份供事件引用；种类很少，常驻不释放
+QMutex g_namesMutex;
+QSet<QByteArray> g_names;
+
+const char *internName(const QString &name)
+{
+    QMutexLocker locker(&g_namesMutex);
+    return g_names.insert(name.toUtf8())->constData();
+}
+
+ThreadBuffer *threadBuffer()
+{
+    if (t_buffer) {
+        return t_buffer;
+    }
+    ThreadBuffer *buffer = new ThreadBuffer;
+    QThread *thread = QThread::currentThread();
+    buffer->threadName = thread->objectName();
+    if (buffer->threadName.isEmpty()) {
+        const bool mainThread = QCoreApplication::instance() && QCoreApplication::instance()->thread() == thread;
+        buffer->threadName = mainThread ? QStringLiteral("GUI") : QString();
+    }
+    QMutexLocker locker(&g_buffersMutex);
+    g_buffers.append(buffer);
+    buffer->tid = g_buffers.size();
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = QString("thread-%1").arg(buffer->tid);
+    }
+    t_buffer = buffer;
+    return buffer;
+}
+
+void append(char phase, const char *category, const char *name, qint64 beginNs, qint64 durationNs,
+            const QString &arg)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    const quint64 head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[head % BUFFER_CAPACITY];
+    event.category = category;
+    event.name = name;
+    event.beginNs = beginNs;
+    event.durationNs = durationNs;
+    event.phase = phase;
+    // 请求ID等参数为ASCII，逐字符复制，不经过编码转换和内存分配
+    const int length = qMin(arg.size(), ARG_CAPACITY - 1);
+    const QChar *chars = arg.constData();
+    for (int i = 0; i < length; ++i) {
+        event.arg[i] = chars[i].unicode() < 0x80 ? static_cast<char>(chars[i].unicode()) : '?';
+    }
+    event.arg[length] = '\0';
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * 函数名称：`snapshot`
+ * 功能描述：复制一个线程缓冲区中仍有效的事件；复制期间可能被写入线程覆盖的事件丢弃
+ */
+QVector<TraceEvent> snapshot(const ThreadBuffer *buffer)
+{
+    const quint64 head = buffer->head.load(std::memory_order_acquire);
+    const quint64 first = head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0;
+    QVector<TraceEvent> events;
+    events.reserve(static_cast<int>(head - first));
+    for (quint64 i = first; i < head; ++i) {
+        events.append(buffer->events[i % BUFFER_CAPACITY]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // 写入线程此时最多正在写head之后的一个槽位：下标不大于latest-容量的槽位可能已被改写
+    const quint64 latest = buffer->head.load(std::memory_order_relaxed);
+    const quint64 valid = latest + 1 > BUFFER_CAPACITY ? latest + 1 - BUFFER_CAPACITY : 0;
+    if (valid > first) {
+        events.remove(0, static_cast<int>(qMin(valid - first, static_cast<quint64>(events.size()))));
+    }
+    return events;
+}
+
+QJsonObject metadataEvent(const char *name, int pid, int tid, const QString &value)
+{
+    QJsonObject event;
+    event["name"] = name;
+    event["ph"] = "M";
+    event["pid"] = pid;
+    event["tid"] = tid;
+    event["args"] = QJsonObject{{"name", value}};
+    return event;
+}
+
+} // namespace
+
+void PipelineTrace::setEnabled(bool enabled)
+{
+    qint64 expected = 0;
+    g_originNs.compare_exchange_strong(expected, RequestMetrics::now());
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void PipelineTrace::complete(const char *category, const char *name, qint64 beginNs, qint64 endNs,
+                             const QString &arg)
+{
+    if (isEnabled()) {
+        append(PhaseComplete, category, name, beginNs, endNs - beginNs, arg);
+    }
+}
+
+void PipelineTrace::async(const char *category, const char *name, const QString &id, qint64 beginNs, qint64 endNs)
+{
+    if (isEnabled()) {
+        append(PhaseAsync, category, name, beginNs, endNs - beginNs, id);
+    }
+}
+
+void PipelineTrace::instant(const char *category, const char *name, const QString &arg)
+{
+    if (isEnabled()) {
+        append(PhaseInstant, category, name, RequestMetrics::now(), 0, arg);
+    }
+}
+
+void PipelineTrace::server(const QString &name, qint64 beginNs, qint64 endNs, const QString &arg)
+{
+    if (isEnabled()) {
+        append(PhaseServer, "server", internName(name), beginNs, endNs - beginNs, arg);
+    }
+}
+
+void PipelineTrace::clear()
+{
+    g_clearedNs.store(RequestMetrics::now(), std::memory_order_relaxed);
+}
+
+QByteArray PipelineTrace::toJson()
+{
+    QVector<ThreadBuffer *> buffers;
+    {
+        QMutexLocker locker(&g_buffersMutex);
+        buffers = g_buffers;
+    }
+    const qint64 clearedNs = g_clearedNs.load(std::memory_order_relaxed);
+    const qint64 originNs = g_originNs.load(std::memory_order_relaxed);
+    auto micros = [originNs](qint64 ns) { return (ns - originNs) / 1000.0; };
+
+    QJsonArray events;
+    events.append(metadataEvent("process_name", CLIENT_PID, 0, QCoreApplication::applicationName()));
+    events.append(metadataEvent("process_name", SERVER_PID, 0, QStringLiteral("识别服务")));
+    events.append(metadataEvent("thread_name", SERVER_PID, 1, QStringLiteral("Server-Timing")));
+    for (const ThreadBuffer *buffer : buffers) {
+        events.append(metadataEvent("thread_name", CLIENT_PID, buffer->tid, buffer->threadName));
+        for (const TraceEvent &source : snapshot(buffer)) {
+            if (source.beginNs < clearedNs) {
+                continue;
+            }
+            QJsonObject event;
+            event["cat"] = source.category;
+            event["name"] = source.name;
+            event["ts"] = micros(source.beginNs);
+            event["pid"] = source.phase == PhaseServer ? SERVER_PID : CLIENT_PID;
+            event["tid"] = source.phase == PhaseServer ? 1 : buffer->tid;
+            if (source.arg[0]) {
+                event["args"] = QJsonObject{{"arg", QString::fromLatin1(source.arg)}};
+            }
+            switch (source.phase) {
+            case PhaseAsync: {
+                // 同一类别和id的b/e归为一行，按时间嵌套
+                event["ph"] = "b";
+                event["id"] = QString("0x%1").arg(qHash(QByteArray(source.arg)), 0, 16);
+                events.append(event);
+                event["ph"] = "e";
+                event["ts"] = micros(source.beginNs + source.durationNs);
+                event.remove("args");
+                break;
+            }
+            case PhaseInstant:
+                event["ph"] = "i";
+                event["s"] = "t";
+                break;
+            default:
+                event["ph"] = "X";
+                event["dur"] = source.durationNs / 1000.0;
+                break;
+            }
+            events.append(event);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool PipelineTrace::writeJson(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    const QByteArray json = toJson();
+    if (file.write(json) != json.size()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+TraceSpan::TraceSpan(const char *category, const char *name, const QString &arg)
+    : m_category(category)
+    , m_name(name)
+    , m_beginNs(0)
+{
+    if (PipelineTrace::isEnabled()) {
+        m_arg = arg;
+        m_beginNs = RequestMetrics::now();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_beginNs) {
+        PipelineTrace::complete(m_category, m_name, m_beginNs, RequestMetrics::now(), m_arg);
+    }
+}
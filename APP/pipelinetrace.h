@@ -0,0 +1,115 @@
+#ifndef PIPELINETRACE_H
+#define PIPELINETRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+/**
+ * 模块名称：`PipelineTrace`
+ * 功能描述：识别流程的时间线记录（按需开启），导出为Chrome trace-event JSON，
+ *           可直接在chrome://tracing或ui.perfetto.dev中打开，查看GUI线程、管理器线程、网络和服务端各自的耗时
+ * 设计特点：
+ *   - 默认关闭，关闭时每个埋点只是一次原子读取；setEnabled(true)后才开始记录
+ *   - 每个线程第一次记录时分配自己的环形缓冲区（4096个事件），写入只有本线程，不加锁；
+ *     写满后覆盖最早的事件，始终保留最近的一段
+ *   - 导出在任意线程进行，读取各线程缓冲区时不阻塞写入，导出期间被覆盖的事件丢弃
+ *   - 时间为steady_clock纳秒（RequestMetrics::now()），与请求计时共用同一时钟
+ *   - 服务端通过Server-Timing响应头返回的各段耗时记到单独的"识别服务"进程下，与客户端在同一视图中对齐
+ *   - 名称和类别须为字符串常量（只保存指针，服务端阶段名除外）；附加参数复制前46个字符
+ * 线程安全：全部接口可在任意线程调用
+ */
+class PipelineTrace
+{
+public:
+    /**
+     * 函数名称：`setEnabled`
+     * 功能描述：开启或关闭记录；已记录的事件保留，clear清空
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * 函数名称：`complete`
+     * 功能描述：记录当前线程上的一段耗时
+     * 参数说明：
+     *     - category：const char*，类别，如"widget"、"manager"、"network"
+     *     - name：const char*，名称
+     *     - beginNs/endNs：qint64，起止时间（RequestMetrics::now()）
+     *     - arg：QString，附加参数（通常为请求ID），可为空
+     * 返回值：void
+     */
+    static void complete(const char *category, const char *name, qint64 beginNs, qint64 endNs,
+                         const QString &arg = QString());
+
+    /**
+     * 函数名称：`async`
+     * 功能描述：记录一段跨线程的耗时，同一id的段在时间线上归为一行（如一次请求的各阶段）
+     * 参数说明：
+     *     - id：QString，归组的标识（请求ID），同时作为附加参数
+     * 返回值：void
+     */
+    static void async(const char *category, const char *name, const QString &id, qint64 beginNs, qint64 endNs);
+
+    /**
+     * 函数名称：`instant`
+     * 功能描述：记录当前线程上的一个时刻
+     */
+    static void instant(const char *category, const char *name, const QString &arg = QString());
+
+    /**
+     * 函数名称：`server`
+     * 功能描述：记录服务端的一段耗时（来自Server-Timing），显示在"识别服务"进程下
+     * 参数说明：
+     *     - name：QString，Server-Timing中的名称，首次出现时复制保存，之后复用
+     * 返回值：void
+     */
+    static void server(const QString &name, qint64 beginNs, qint64 endNs, const QString &arg = QString());
+
+    /**
+     * 函数名称：`clear`
+     * 功能描述：丢弃此前记录的事件（导出时按时间过滤，不触碰其它线程的缓冲区）
+     */
+    static void clear();
+
+    /**
+     * 函数名称：`toJson`
+     * 功能描述：导出当前所有线程缓冲区中的事件
+     * 返回值：QByteArray，Chrome trace-event JSON（{"traceEvents": [...]}）
+     */
+    static QByteArray toJson();
+
+    /**
+     * 函数名称：`writeJson`
+     * 功能描述：导出到文件
+     * 参数说明：
+     *     - path：QString，文件路径
+     *     - error：QString*，失败时写入错误信息，可为nullptr
+     * 返回值：bool，是否写入成功
+     */
+    static bool writeJson(const QString &path, QString *error = nullptr);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * 函数名称：`TraceSpan`
+ * 功能描述：作用域耗时：构造时记下开始时间，析构时记录一段complete事件；未开启记录时不做任何事
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const char *name, const QString &arg = QString());
+    ~TraceSpan();
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *m_category;
+    const char *m_name;
+    QString m_arg;
+    qint64 m_beginNs;                   // 0表示开始时未开启记录
+};
+
+#endif // PIPELINETRACE_H
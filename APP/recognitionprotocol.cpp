@@ -0,0 +1,137 @@
+#include "recognitionprotocol.h"
+#include <QHttpMultiPart>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrl>
+
+namespace RecognitionProtocol {
+
+QByteArray createWavHeader(qint64 pcmBytes)
+{
+    QByteArray header;
+    header.reserve(44);
+
+    // WAV文件参数
+    quint32 sampleRate = 16000;
+    quint16 channels = 1;
+    quint16 bitsPerSample = 16;
+    quint32 dataSize = static_cast<quint32>(pcmBytes);
+    quint32 fileSize = 36 + dataSize;
+
+    // RIFF头
+    header.append("RIFF");
+    header.append(reinterpret_cast<const char*>(&fileSize), 4);
+    header.append("WAVE");
+
+    // fmt子块
+    header.append("fmt ");
+    quint32 fmtSize = 16;
+    header.append(reinterpret_cast<const char*>(&fmtSize), 4);
+
+    quint16 audioFormat = 1; // PCM
+    header.append(reinterpret_cast<const char*>(&audioFormat), 2);
+    header.append(reinterpret_cast<const char*>(&channels), 2);
+    header.append(reinterpret_cast<const char*>(&sampleRate), 4);
+
+    quint32 byteRate = sampleRate * channels * bitsPerSample / 8;
+    header.append(reinterpret_cast<const char*>(&byteRate), 4);
+
+    quint16 blockAlign = channels * bitsPerSample / 8;
+    header.append(reinterpret_cast<const char*>(&blockAlign), 2);
+    header.append(reinterpret_cast<const char*>(&bitsPerSample), 2);
+
+    // data子块
+    header.append("data");
+    header.append(reinterpret_cast<const char*>(&dataSize), 4);
+
+    return header;
+}
+
+QNetworkRequest createRequest(const QString &serviceUrl)
+{
+    QNetworkRequest request(QUrl(serviceUrl + "/api/v1/asr"));
+    request.setRawHeader("User-Agent", "VoiceRecognitionManager");
+    return request;
+}
+
+QHttpMultiPart *createMultiPart(QHttpPart audioPart, QIODevice *body)
+{
+    // 创建多部分表单数据
+    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    if (body) {
+        body->setParent(multiPart);
+    }
+
+    // 添加音频文件部分
+    audioPart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
+    audioPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QVariant("form-data; name=\"files\"; filename=\"audio.wav\""));
+    multiPart->append(audioPart);
+
+    // 添加语言参数
+    QHttpPart languagePart;
+    languagePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                          QVariant("form-data; name=\"lang\""));
+    languagePart.setBody("auto");
+    multiPart->append(languagePart);
+
+    // 添加keys参数
+    QHttpPart keysPart;
+    keysPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                      QVariant("form-data; name=\"keys\""));
+    keysPart.setBody("audio_input");
+    multiPart->append(keysPart);
+
+    return multiPart;
+}
+
+bool parseResponse(const QByteArray &body, Result *result, QString *error)
+{
+    *result = Result();
+    if (body.isEmpty()) {
+        *error = "服务器返回空数据";
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        *error = "响应解析失败: " + parseError.errorString();
+        return false;
+    }
+
+    // {"result": [{"key": ..., "text": ..., "raw_text": ..., "clean_text": ...}, ...]}
+    const QJsonArray resultArray = doc.object().value("result").toArray();
+    if (!resultArray.isEmpty()) {
+        const QJsonObject first = resultArray.at(0).toObject();
+        result->text = first.value("text").toString();
+        result->rawText = first.value("raw_text").toString();
+        result->cleanText = first.value("clean_text").toString();
+    }
+    return true;
+}
+
+QVector<ServerTiming> parseServerTiming(const QByteArray &header)
+{
+    QVector<ServerTiming> timings;
+    for (const QByteArray &entry : header.split(',')) {
+        const QList<QByteArray> params = entry.split(';');
+        ServerTiming timing;
+        timing.name = QString::fromLatin1(params.at(0).trimmed());
+        if (timing.name.isEmpty()) {
+            continue;
+        }
+        for (int i = 1; i < params.size(); ++i) {
+            const QByteArray param = params.at(i).trimmed();
+            if (param.startsWith("dur=")) {
+                timing.durationMs = param.mid(4).toDouble();
+            }
+        }
+        timings.append(timing);
+    }
+    return timings;
+}
+
+} // namespace RecognitionProtocol
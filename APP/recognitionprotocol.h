@@ -0,0 +1,88 @@
+#ifndef RECOGNITIONPROTOCOL_H
+#define RECOGNITIONPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHttpPart>
+#include <QNetworkRequest>
+#include <QVector>
+
+class QHttpMultiPart;
+class QIODevice;
+
+/**
+ * 模块名称：`RecognitionProtocol`
+ * 功能描述：SenseVoice识别服务（api.py）的请求组装与响应解析：WAV头、/api/v1/asr的multipart表单、JSON结果
+ * 设计原则：不持有状态，VoiceRecognitionManager、基准和压测工具共用同一份实现
+ */
+namespace RecognitionProtocol {
+
+/**
+ * 识别接口返回的第一条结果
+ */
+struct Result {
+    QString text;                       // 后处理后的文本（去掉语种/情感标记，加标点）
+    QString rawText;                    // 模型原始输出
+    QString cleanText;                  // 去掉标记的原始输出
+};
+
+/**
+ * 服务端在Server-Timing响应头中报告的一段耗时
+ */
+struct ServerTiming {
+    QString name;                       // 如"decode"、"inference"、"total"
+    double durationMs = 0.0;
+};
+
+/**
+ * 函数名称：`createWavHeader`
+ * 功能描述：创建16kHz单声道16位PCM的WAV文件头（44字节）
+ * 参数说明：
+ *     - pcmBytes：qint64，PCM音频数据的字节数
+ * 返回值：QByteArray，WAV文件头
+ */
+QByteArray createWavHeader(qint64 pcmBytes);
+
+/**
+ * 函数名称：`createRequest`
+ * 功能描述：创建识别请求（POST <serviceUrl>/api/v1/asr）
+ * 参数说明：
+ *     - serviceUrl：QString，服务地址，如"http://127.0.0.1:8000"
+ * 返回值：QNetworkRequest
+ */
+QNetworkRequest createRequest(const QString &serviceUrl);
+
+/**
+ * 函数名称：`createMultiPart`
+ * 功能描述：组装表单：音频（files）、语言（lang=auto）、keys
+ * 参数说明：
+ *     - audioPart：QHttpPart，已设置内容（setBody或setBodyDevice）的音频部分
+ *     - body：QIODevice*，音频部分的请求体设备，随表单释放，可为nullptr
+ * 返回值：QHttpMultiPart*，调用方负责释放（通常设为QNetworkReply的子对象）
+ */
+QHttpMultiPart *createMultiPart(QHttpPart audioPart, QIODevice *body);
+
+/**
+ * 函数名称：`parseResponse`
+ * 功能描述：解析识别接口的JSON响应，取第一条结果；result为空数组时成功、文本为空
+ * 参数说明：
+ *     - body：QByteArray，响应体
+ *     - result：Result*，输出结果
+ *     - error：QString*，失败时写入错误信息（空响应、JSON无效）
+ * 返回值：bool，是否解析成功
+ */
+bool parseResponse(const QByteArray &body, Result *result, QString *error);
+
+/**
+ * 函数名称：`parseServerTiming`
+ * 功能描述：解析Server-Timing响应头（"decode;dur=12.5, inference;dur=230"），按出现顺序返回；
+ *           没有dur的条目按0计，desc等其它参数忽略
+ * 参数说明：
+ *     - header：QByteArray，响应头的值，为空时返回空列表
+ * 返回值：QVector<ServerTiming>
+ */
+QVector<ServerTiming> parseServerTiming(const QByteArray &header);
+
+} // namespace RecognitionProtocol
+
+#endif // RECOGNITIONPROTOCOL_H
@@ -0,0 +1,177 @@
+#ifndef REQUESTMETRICS_H
+#define REQUESTMETRICS_H
+
+#include "latencyhistogram.h"
+#include <QMetaType>
+#include <QString>
+#include <chrono>
+
+/**
+ * 函数名称：`RequestMetrics`
+ * 功能描述：一次识别请求（按键录音或recognizeAudio）各时间点的单调时钟时间戳，
+ *           相邻时间点之差即各阶段耗时，由VoiceRecognitionManager::requestCompleted发出
+ * 设计特点：
+ *   - 时间戳为steady_clock纳秒，未经过的时间点为0；阶段的起点取它之前最近一个已记录的时间点，
+ *     因此识别服务和内置引擎用同一组阶段：内置引擎没有编码、上传，识别耗时计入server
+ *   - FirstAudio取自录音存储的第一次写入；ResponseReceived未先记录FirstResponseByte时（内置引擎、无响应体）
+ *     两者相同，下载阶段为0
+ *   - TextInserted由插入文字的一方（输入框、基准工具）通过VoiceRecognitionManager::reportTextInserted报告，
+ *     未报告的请求在结果发出1秒后不带该时间点结束
+ * 线程安全：值类型，可跨线程复制
+ */
+struct RequestMetrics
+{
+    /**
+     * 时间点（按发生顺序）
+     */
+    enum Stamp {
+        KeyDown,                        // 开始录音
+        CaptureStarted,                 // 录音设备已启动（免按键模式为监听流接入）
+        FirstAudio,                     // 第一块录音数据写入
+        KeyUp,                          // 松键，停止录音
+        CaptureClosed,                  // 录音设备已停止、录音数据已封口
+        Submitted,                      // recognizeAudio收到整段音频（无按键录音）
+        RequestSent,                    // WAV头和表单已组装，请求已发出，开始上传
+        UploadDone,                     // 请求体已全部发出
+        FirstResponseByte,              // 收到响应的第一个字节；内置引擎与ResponseReceived相同
+        ResponseReceived,               // 服务响应已全部收到 / 内置引擎识别完成
+        ResultReady,                    // 结果已解析，发出recognitionFinished
+        TextInserted,                   // 文字已插入输入框（由输入框通过reportTextInserted报告）
+        StampCount
+    };
+
+    /**
+     * 阶段：以对应时间点为终点
+     */
+    enum Stage {
+        Startup,                        // 按键到录音设备启动
+        FirstBuffer,                    // 设备启动到第一块录音数据
+        Capture,                        // 松键到录音封口
+        Encode,                         // WAV头、表单组装
+        Upload,                         // 请求体上传
+        Server,                         // 上传完成到响应首字节（服务处理） / 内置引擎识别
+        Download,                       // 响应首字节到全部收到
+        Parse,                          // 解析响应、匹配短语
+        Insert,                         // 发出结果到文字插入
+        StageCount
+    };
+
+    QString requestId;
+    qint64 audioBytes = 0;              // 识别的音频字节数（16kHz单声道16位）
+    QString error;                      // 失败时的错误信息，成功为空
+    qint64 stamps[StampCount] = {};
+
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void stamp(Stamp point)
+    {
+        stamps[point] = now();
+        if (point == ResponseReceived && !stamps[FirstResponseByte]) {
+            stamps[FirstResponseByte] = stamps[point];
+        }
+    }
+    bool has(Stamp point) const { return stamps[point] != 0; }
+
+    /**
+     * 函数名称：`stageNs`
+     * 功能描述：阶段耗时（纳秒）
+     * 参数说明：
+     *     - stage：Stage，阶段
+     * 返回值：qint64，终点未记录时为-1
+     */
+    qint64 stageNs(Stage stage) const
+    {
+        const qint64 begin = stageBeginNs(stage);
+        return begin ? stamps[endStamp(stage)] - begin : -1;
+    }
+
+    /**
+     * 函数名称：`stageBeginNs`
+     * 功能描述：阶段的起点，即终点之前最近一个已记录的时间点
+     * 参数说明：
+     *     - stage：Stage，阶段
+     * 返回值：qint64，时间戳；终点或起点未记录时为0
+     */
+    qint64 stageBeginNs(Stage stage) const
+    {
+        const int end = endStamp(stage);
+        if (!stamps[end]) {
+            return 0;
+        }
+        for (int point = end - 1; point >= 0; --point) {
+            if (stamps[point]) {
+                return stamps[point];
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * 函数名称：`totalNs`
+     * 功能描述：松键（无按键录音时为提交）到最后一个已记录时间点的耗时（纳秒），即用户等待的时间
+     */
+    qint64 totalNs() const
+    {
+        const qint64 start = stamps[KeyUp] ? stamps[KeyUp] : stamps[Submitted];
+        for (int point = StampCount - 1; point >= 0 && start; --point) {
+            if (stamps[point]) {
+                return stamps[point] - start;
+            }
+        }
+        return -1;
+    }
+
+    static int endStamp(Stage stage)
+    {
+        static const Stamp ends[StageCount] = {CaptureStarted, FirstAudio, CaptureClosed, RequestSent, UploadDone,
+                                               FirstResponseByte, ResponseReceived, ResultReady, TextInserted};
+        return ends[stage];
+    }
+
+    static const char *stageName(Stage stage)
+    {
+        static const char *names[StageCount] = {"startup", "first-audio", "capture", "encode", "upload", "server",
+                                                "download", "parse", "insert"};
+        return names[stage];
+    }
+};
+
+/**
+ * 函数名称：`RequestStatistics`
+ * 功能描述：已结束请求的汇总：成功请求各阶段和total的耗时直方图、成功与失败次数，
+ *           由VoiceRecognitionManager常驻累计，requestStatistics()取快照
+ */
+struct RequestStatistics
+{
+    LatencyHistogram stages[RequestMetrics::StageCount];
+    LatencyHistogram total;
+    qint64 completed = 0;               // 成功
+    qint64 failed = 0;
+
+    void add(const RequestMetrics &metrics)
+    {
+        if (!metrics.error.isEmpty()) {
+            ++failed;
+            return;
+        }
+        ++completed;
+        for (int stage = 0; stage < RequestMetrics::StageCount; ++stage) {
+            const qint64 ns = metrics.stageNs(static_cast<RequestMetrics::Stage>(stage));
+            if (ns >= 0) {
+                stages[stage].record(ns);
+            }
+        }
+        const qint64 ns = metrics.totalNs();
+        if (ns >= 0) {
+            total.record(ns);
+        }
+    }
+};
+
+Q_DECLARE_METATYPE(RequestMetrics)
+
+#endif // REQUESTMETRICS_H
@@ -0,0 +1,231 @@
+#include "sessionrecorder.h"
+#include "requestmetrics.h"
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+#include <initializer_list>
+
+std::atomic<bool> SessionRecorder::s_recording(false);
+
+namespace {
+
+const char MAGIC[8] = {'V', 'S', 'R', 'E', 'C', 0, 0, 1};
+const int FILE_HEADER_SIZE = 32;
+const int RECORD_HEADER_SIZE = 16;
+const int SAMPLE_RATE = 16000;
+
+QMutex g_mutex;
+QFile g_file;
+
+int padding(qint64 size)
+{
+    return static_cast<int>((8 - size % 8) % 8);
+}
+
+template <typename T>
+void appendValue(QByteArray *buffer, T value)
+{
+    const T little = qToLittleEndian(value);
+    buffer->append(reinterpret_cast<const char *>(&little), sizeof(T));
+}
+
+/**
+ * 函数名称：`append`
+ * 功能描述：组装并写入一条记录；录音数据块只进文件缓冲，其余记录立即刷新
+ */
+void append(SessionRecorder::RecordType type, qint64 timeNs, std::initializer_list<QByteArray> fields)
+{
+    quint32 size = 0;
+    for (const QByteArray &field : fields) {
+        size += 4 + static_cast<quint32>(field.size());
+    }
+    QByteArray record;
+    record.reserve(RECORD_HEADER_SIZE + static_cast<int>(size) + 8);
+    appendValue<quint32>(&record, type);
+    appendValue<quint32>(&record, size);
+    appendValue<qint64>(&record, timeNs);
+    for (const QByteArray &field : fields) {
+        appendValue<quint32>(&record, static_cast<quint32>(field.size()));
+        record.append(field);
+    }
+    record.append(padding(size), '\0');
+
+    QMutexLocker locker(&g_mutex);
+    if (!g_file.isOpen()) {
+        return;
+    }
+    g_file.write(record);
+    if (type != SessionRecorder::Audio) {
+        g_file.flush();
+    }
+}
+
+} // namespace
+
+bool SessionRecorder::start(const QString &path, QString *error)
+{
+    stop();
+    QMutexLocker locker(&g_mutex);
+    g_file.setFileName(path);
+    if (!g_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = g_file.errorString();
+        }
+        return false;
+    }
+    QByteArray header(MAGIC, sizeof(MAGIC));
+    appendValue<quint32>(&header, SAMPLE_RATE);
+    appendValue<quint32>(&header, 0);
+    appendValue<qint64>(&header, QDateTime::currentMSecsSinceEpoch());
+    appendValue<qint64>(&header, RequestMetrics::now());
+    g_file.write(header);
+    g_file.flush();
+    s_recording.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    s_recording.store(false, std::memory_order_relaxed);
+    QMutexLocker locker(&g_mutex);
+    if (g_file.isOpen()) {
+        g_file.close();
+    }
+}
+
+void SessionRecorder::audio(const char *data, qint64 size)
+{
+    if (isRecording() && size > 0) {
+        const QByteArray pcm = QByteArray::fromRawData(data, static_cast<int>(size));
+        append(Audio, RequestMetrics::now(), {QByteArray(), pcm});
+    }
+}
+
+void SessionRecorder::event(RecordType type, const QString &requestId)
+{
+    if (isRecording()) {
+        append(type, RequestMetrics::now(), {requestId.toUtf8()});
+    }
+}
+
+void SessionRecorder::submit(const QString &requestId, const QByteArray &pcm)
+{
+    if (isRecording()) {
+        append(Submit, RequestMetrics::now(), {requestId.toUtf8(), pcm});
+    }
+}
+
+void SessionRecorder::request(const QString &requestId, const QString &url)
+{
+    if (isRecording()) {
+        append(Request, RequestMetrics::now(), {requestId.toUtf8(), url.toUtf8()});
+    }
+}
+
+void SessionRecorder::response(const QString &requestId, int statusCode, const QByteArray &serverTiming,
+                               const QByteArray &body)
+{
+    if (isRecording()) {
+        append(Response, RequestMetrics::now(),
+               {requestId.toUtf8(), QByteArray::number(statusCode), serverTiming, body});
+    }
+}
+
+void SessionRecorder::result(const QString &requestId, const QString &text)
+{
+    if (isRecording()) {
+        append(Result, RequestMetrics::now(), {requestId.toUtf8(), text.toUtf8()});
+    }
+}
+
+void SessionRecorder::completed(const RequestMetrics &metrics)
+{
+    if (!isRecording()) {
+        return;
+    }
+    QByteArray stamps;
+    for (int point = 0; point < RequestMetrics::StampCount; ++point) {
+        appendValue<qint64>(&stamps, metrics.stamps[point]);
+    }
+    append(Completed, RequestMetrics::now(), {metrics.requestId.toUtf8(), metrics.error.toUtf8(), stamps});
+}
+
+QByteArray SessionReader::Record::field(int index) const
+{
+    quint32 offset = 0;
+    for (int i = 0; offset + 4 <= size; ++i) {
+        const quint32 length = qFromLittleEndian<quint32>(payload + offset);
+        if (length > size - offset - 4) {
+            break;
+        }
+        if (i == index) {
+            return QByteArray::fromRawData(reinterpret_cast<const char *>(payload + offset + 4),
+                                           static_cast<int>(length));
+        }
+        offset += 4 + length;
+    }
+    return QByteArray();
+}
+
+SessionReader::SessionReader()
+    : m_data(nullptr)
+    , m_sampleRate(0)
+    , m_startWallMs(0)
+    , m_startNs(0)
+    , m_truncated(false)
+{
+}
+
+SessionReader::~SessionReader()
+{
+    close();
+}
+
+bool SessionReader::open(const QString &path, QString *error)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开: " + path;
+        return false;
+    }
+    const qint64 fileSize = m_file.size();
+    m_data = fileSize >= FILE_HEADER_SIZE ? m_file.map(0, fileSize) : nullptr;
+    if (!m_data || memcmp(m_data, MAGIC, sizeof(MAGIC)) != 0) {
+        *error = "不是会话录制文件: " + path;
+        close();
+        return false;
+    }
+    m_sampleRate = static_cast<int>(qFromLittleEndian<quint32>(m_data + 8));
+    m_startWallMs = qFromLittleEndian<qint64>(m_data + 16);
+    m_startNs = qFromLittleEndian<qint64>(m_data + 24);
+
+    qint64 offset = FILE_HEADER_SIZE;
+    while (offset + RECORD_HEADER_SIZE <= fileSize) {
+        Record record;
+        record.type = static_cast<SessionRecorder::RecordType>(qFromLittleEndian<quint32>(m_data + offset));
+        record.size = qFromLittleEndian<quint32>(m_data + offset + 4);
+        record.timeNs = qFromLittleEndian<qint64>(m_data + offset + 8);
+        record.payload = m_data + offset + RECORD_HEADER_SIZE;
+        if (record.size > fileSize - offset - RECORD_HEADER_SIZE) {
+            break;
+        }
+        m_records.append(record);
+        offset += RECORD_HEADER_SIZE + record.size + padding(record.size);
+    }
+    m_truncated = offset < fileSize;
+    return true;
+}
+
+void SessionReader::close()
+{
+    m_records.clear();
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_truncated = false;
+}
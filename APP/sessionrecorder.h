@@ -0,0 +1,146 @@
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+struct RequestMetrics;
+
+/**
+ * 模块名称：`SessionRecorder`
+ * 功能描述：会话录制（按需开启）：录音数据块、按键、提交、识别服务的请求与响应、识别结果和各请求的计时，
+ *           按发生时间追加写入一个紧凑的二进制文件；sessionreplay按原来的节奏（或加速）把它重新送入管理器，
+ *           复现与生产环境时序相关的问题
+ * 文件格式（小端）：
+ *   - 文件头32字节：magic "VSREC" 00 00 01（8）、采样率u32、保留u32、
+ *     开始时的墙钟毫秒i64、开始时的steady_clock纳秒i64
+ *   - 之后依次是记录：记录头16字节（类型u32、负载字节数u32、steady_clock纳秒i64），负载，补齐到8字节
+ *   - 负载由若干字段组成，每个字段为长度u32加内容；第一个字段为请求ID（录音数据块为空）
+ *   - 只追加、不改写：进程中途退出时最多缺最后一条不完整的记录，读取端在此停止
+ *   - 记录按8字节对齐，SessionReader映射整个文件后直接在映射上遍历，音频数据不复制
+ * 设计特点：
+ *   - 默认关闭，关闭时每个埋点只是一次原子读取
+ *   - 写入加锁，录音数据块只写入文件缓冲，其余记录写入后立即刷新
+ * 线程安全：全部接口可在任意线程调用
+ */
+class SessionRecorder
+{
+public:
+    enum RecordType : quint32 {
+        Audio = 1,                      // 录音数据块：[空, PCM]
+        KeyDown,                        // startRecording：[请求ID]
+        KeyUp,                          // stopRecording：[请求ID]
+        Cancel,                         // cancelRecording：[请求ID]
+        Submit,                         // recognizeAudio：[请求ID, PCM]
+        DictationStart,                 // startDictation：[请求ID]
+        DictationStop,                  // stopDictation：[请求ID]
+        DictationCancel,                // cancelDictation：[请求ID]
+        Request,                        // 发出识别服务请求：[请求ID, 服务地址]
+        Response,                       // 收到识别服务响应：[请求ID, HTTP状态码, Server-Timing, 响应体]
+        Result,                         // 识别结果（听写为每段）：[请求ID, 文本]
+        Completed                       // 请求结束：[请求ID, 错误信息, 各时间点i64×StampCount，0为未记录]
+    };
+
+    /**
+     * 函数名称：`start`
+     * 功能描述：开始录制到文件（覆盖已有文件）；正在录制时先结束上一个文件
+     * 参数说明：
+     *     - path：QString，文件路径
+     *     - error：QString*，失败时写入错误信息，可为nullptr
+     * 返回值：bool，文件是否已打开
+     */
+    static bool start(const QString &path, QString *error = nullptr);
+
+    /**
+     * 函数名称：`stop`
+     * 功能描述：刷新并关闭文件
+     */
+    static void stop();
+
+    static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+    /**
+     * 函数名称：`audio`
+     * 功能描述：记录一块录音数据（16kHz单声道16位）
+     */
+    static void audio(const char *data, qint64 size);
+
+    /**
+     * 函数名称：`event`
+     * 功能描述：记录按键、取消、听写开始与结束等只带请求ID的事件
+     */
+    static void event(RecordType type, const QString &requestId);
+
+    static void submit(const QString &requestId, const QByteArray &pcm);
+    static void request(const QString &requestId, const QString &url);
+    static void response(const QString &requestId, int statusCode, const QByteArray &serverTiming,
+                         const QByteArray &body);
+    static void result(const QString &requestId, const QString &text);
+    static void completed(const RequestMetrics &metrics);
+
+private:
+    static std::atomic<bool> s_recording;
+};
+
+/**
+ * 模块名称：`SessionReader`
+ * 功能描述：读取SessionRecorder的文件：映射整个文件，记录的负载直接指向映射
+ * 线程安全：打开后只读，可在任意线程读取
+ */
+class SessionReader
+{
+public:
+    /**
+     * 一条记录，payload指向映射，SessionReader关闭前有效
+     */
+    struct Record {
+        SessionRecorder::RecordType type;
+        qint64 timeNs;                  // steady_clock纳秒，与文件头的startNs同一时钟
+        const uchar *payload;
+        quint32 size;
+
+        /**
+         * 函数名称：`field`
+         * 功能描述：第index个字段，不复制（QByteArray::fromRawData）
+         * 返回值：QByteArray，字段不存在时为空
+         */
+        QByteArray field(int index) const;
+        QString requestId() const { return QString::fromUtf8(field(0)); }
+    };
+
+    SessionReader();
+    ~SessionReader();
+
+    /**
+     * 函数名称：`open`
+     * 功能描述：映射文件并建立记录索引
+     * 参数说明：
+     *     - path：QString，文件路径
+     *     - error：QString*，失败时写入错误信息
+     * 返回值：bool，文件头有效时返回true（末尾不完整的记录忽略，见truncated）
+     */
+    bool open(const QString &path, QString *error);
+    void close();
+
+    const QVector<Record> &records() const { return m_records; }
+    int sampleRate() const { return m_sampleRate; }
+    qint64 startWallMs() const { return m_startWallMs; }
+    qint64 startNs() const { return m_startNs; }
+    bool truncated() const { return m_truncated; }
+
+private:
+    Q_DISABLE_COPY(SessionReader)
+
+    QFile m_file;
+    uchar *m_data;
+    QVector<Record> m_records;
+    int m_sampleRate;
+    qint64 m_startWallMs;
+    qint64 m_startNs;
+    bool m_truncated;                   // 末尾有不完整的记录
+};
+
+#endif // SESSIONRECORDER_H
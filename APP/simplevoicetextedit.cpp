@@ -1,18 +1,25 @@
 #include "simplevoicetextedit.h"
-#include "voicerecognitionmanager.h"
+#include "pipelinetrace.h"
+#include "voicelogging.h"
 #include <QUuid>
 #include <QDebug>
 #include <QApplication>
+#include <QTextBlock>
 
 SimpleVoiceTextEdit::SimpleVoiceTextEdit(QWidget *parent)
     : QTextEdit(parent)
     , m_state(State::Idle)
     , m_longPressTimer(new QTimer(this))
     , m_hasFocus(false)
+    , m_engineWarming(false)
+    , m_dictating(false)
+    , m_tentativeRegion(this)
+    , m_documentChanges(0)
+    , m_relayoutChars(0)
 {
     // 生成唯一控件ID
     m_controlId = QUuid::createUuid().toString(QUuid::WithoutBraces);
-    qDebug() << "📝 SimpleVoiceTextEdit 创建，ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 SimpleVoiceTextEdit 创建，ID:" << m_controlId;
     
     // 配置长按计时器
     m_longPressTimer->setSingleShot(true);
@@ -27,7 +34,7 @@ SimpleVoiceTextEdit::SimpleVoiceTextEdit(QWidget *parent)
     setFocusPolicy(Qt::StrongFocus);
     
     // 设置初始提示
-    setPlaceholderText("长按 'V' 键开始语音输入...");
+    setPlaceholderText("长按 'V' 键语音输入，按 F2 连续听写...");
     
     // 设置信号连接
     setupConnections();
@@ -35,7 +42,7 @@ SimpleVoiceTextEdit::SimpleVoiceTextEdit(QWidget *parent)
 
 SimpleVoiceTextEdit::~SimpleVoiceTextEdit()
 {
-    qDebug() << "📝 SimpleVoiceTextEdit 析构，ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 SimpleVoiceTextEdit 析构，ID:" << m_controlId;
 }
 
 void SimpleVoiceTextEdit::setupConnections()
@@ -54,22 +61,72 @@ void SimpleVoiceTextEdit::setupConnections()
             
     connect(manager, &VoiceRecognitionManager::statusChanged,
             this, &SimpleVoiceTextEdit::onStatusChanged);
+            
+    connect(manager, &VoiceRecognitionManager::engineStateChanged,
+            this, &SimpleVoiceTextEdit::onEngineStateChanged);
+    onEngineStateChanged(manager->engineState());
+    
+    connect(manager, &VoiceRecognitionManager::wakeWordDetected,
+            this, &SimpleVoiceTextEdit::onWakeWordDetected);
+            
+    connect(manager, &VoiceRecognitionManager::recordingStopped,
+            this, &SimpleVoiceTextEdit::onRecordingStopped);
+            
+    connect(manager, &VoiceRecognitionManager::dictationTextReady,
+            this, &SimpleVoiceTextEdit::onDictationTextReady);
+            
+    connect(manager, &VoiceRecognitionManager::dictationFinished,
+            this, &SimpleVoiceTextEdit::onDictationFinished);
+            
+    connect(manager, &VoiceRecognitionManager::dictationPartialReady,
+            this, &SimpleVoiceTextEdit::onDictationPartialReady);
     
-    qDebug() << "📝 信号连接已建立，ID:" << m_controlId;
+    connect(document(), &QTextDocument::contentsChange,
+            this, &SimpleVoiceTextEdit::onDocumentContentsChange);
+    
+    qCTrace(lcWidget) << "📝 信号连接已建立，ID:" << m_controlId;
 }
 
 void SimpleVoiceTextEdit::keyPressEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_V && !event->isAutoRepeat()) {
         if (m_state == State::Idle && m_hasFocus) {
-            qDebug() << "📝 V键按下，开始等待长按确认，ID:" << m_controlId;
+            qCTrace(lcWidget) << "📝 V键按下，开始等待长按确认，ID:" << m_controlId;
+            PipelineTrace::instant("widget", "keyDown", m_controlId);
             setState(State::WaitingForLongPress);
             m_longPressTimer->start();
             return;
         }
+    } else if (event->key() == DICTATION_KEY && !event->isAutoRepeat() && m_vocabulary.isEmpty()) {
+        // 连续听写：按一下开始，再按一下结束，停顿处自动分段识别并追加
+        if (m_state == State::Idle && m_hasFocus) {
+            // 听写在管理器线程中开始，未能开始时随dictationFinished回到空闲
+            qCTrace(lcWidget) << "📝 开始连续听写，ID:" << m_controlId;
+            m_dictating = true;
+            m_documentChanges = 0;
+            m_relayoutChars = 0;
+            m_dictationClock.start();
+            moveCursor(QTextCursor::End);
+            m_tentativeRegion.begin();
+            setState(State::Dictating);
+            VoiceRecognitionManager::instance()->startDictation(m_controlId);
+            return;
+        } else if (m_state == State::Dictating) {
+            qCTrace(lcWidget) << "📝 结束连续听写，等待最后的分段，ID:" << m_controlId;
+            VoiceRecognitionManager::instance()->stopDictation();
+            if (m_dictating) {
+                setState(State::Recognizing);
+            }
+            return;
+        }
     } else if (event->key() == Qt::Key_Escape) {
+        if (m_dictating) {
+            qCTrace(lcWidget) << "📝 ESC键按下，取消听写，ID:" << m_controlId;
+            VoiceRecognitionManager::instance()->cancelDictation();
+            return;
+        }
         if (m_state != State::Idle) {
-            qDebug() << "📝 ESC键按下，取消录音，ID:" << m_controlId;
+            qCTrace(lcWidget) << "📝 ESC键按下，取消录音，ID:" << m_controlId;
             VoiceRecognitionManager::instance()->cancelRecording();
             setState(State::Idle);
             return;
@@ -87,13 +144,14 @@ void SimpleVoiceTextEdit::keyReleaseEvent(QKeyEvent *event)
     if (event->key() == Qt::Key_V && !event->isAutoRepeat()) {
         if (m_state == State::WaitingForLongPress) {
             // 短按，取消操作
-            qDebug() << "📝 V键短按，取消操作，ID:" << m_controlId;
+            qCTrace(lcWidget) << "📝 V键短按，取消操作，ID:" << m_controlId;
             m_longPressTimer->stop();
             setState(State::Idle);
             return;
         } else if (m_state == State::Recording) {
             // 结束录音
-            qDebug() << "📝 V键释放，结束录音，ID:" << m_controlId;
+            qCTrace(lcWidget) << "📝 V键释放，结束录音，ID:" << m_controlId;
+            TraceSpan span("widget", "keyUp", m_controlId);
             VoiceRecognitionManager::instance()->stopRecording();
             setState(State::Recognizing);
             return;
@@ -110,18 +168,18 @@ void SimpleVoiceTextEdit::focusInEvent(QFocusEvent *event)
 {
     QTextEdit::focusInEvent(event);
     m_hasFocus = true;
-    qDebug() << "📝 获得焦点，ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 获得焦点，ID:" << m_controlId;
 }
 
 void SimpleVoiceTextEdit::focusOutEvent(QFocusEvent *event)
 {
     QTextEdit::focusOutEvent(event);
     m_hasFocus = false;
-    qDebug() << "📝 失去焦点，ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 失去焦点，ID:" << m_controlId;
     
-    // 如果正在等待长按或录音中，取消操作
-    if (m_state != State::Idle) {
-        qDebug() << "📝 焦点丢失，取消当前语音操作，ID:" << m_controlId;
+    // 如果正在等待长按或录音中，取消操作；听写按控件ID追加结果，不需要焦点
+    if (m_state != State::Idle && !m_dictating) {
+        qCTrace(lcWidget) << "📝 焦点丢失，取消当前语音操作，ID:" << m_controlId;
         m_longPressTimer->stop();
         VoiceRecognitionManager::instance()->cancelRecording();
         setState(State::Idle);
@@ -131,16 +189,83 @@ void SimpleVoiceTextEdit::focusOutEvent(QFocusEvent *event)
 void SimpleVoiceTextEdit::onLongPressTimeout()
 {
     if (m_state == State::WaitingForLongPress && m_hasFocus) {
-        qDebug() << "📝 长按确认，开始录音，ID:" << m_controlId;
+        qCTrace(lcWidget) << "📝 长按确认，开始录音，ID:" << m_controlId;
+        TraceSpan span("widget", "longPress", m_controlId);
         setState(State::Recording);
         // 通知管理器开始录音，传递控件ID
         VoiceRecognitionManager::instance()->startRecording(m_controlId);
     }
 }
 
+void SimpleVoiceTextEdit::onWakeWordDetected()
+{
+    if (m_state == State::Idle && m_hasFocus) {
+        qCTrace(lcWidget) << "📝 唤醒词触发，开始录音，ID:" << m_controlId;
+        setState(State::Recording);
+        VoiceRecognitionManager::instance()->startRecording(m_controlId);
+    }
+}
+
+void SimpleVoiceTextEdit::onRecordingStopped(const QString &requestId)
+{
+    if (requestId == m_controlId && m_state == State::Recording) {
+        qCTrace(lcWidget) << "📝 录音已自动结束，等待识别结果，ID:" << m_controlId;
+        setState(State::Recognizing);
+    }
+}
+
+void SimpleVoiceTextEdit::onDictationTextReady(const QString &text, const QString &requestId)
+{
+    if (requestId == m_controlId) {
+        qCTrace(lcWidget) << "📝 追加听写分段，ID:" << m_controlId << "，文本:" << text;
+        m_tentativeRegion.commit(text);
+    }
+}
+
+void SimpleVoiceTextEdit::onDictationPartialReady(const QString &committedText, const QString &tentativeText,
+                                                  const QString &requestId)
+{
+    if (requestId != m_controlId || !m_dictating) {
+        return;
+    }
+    m_tentativeRegion.update(committedText, tentativeText);
+}
+
+void SimpleVoiceTextEdit::onDocumentContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (!m_dictating) {
+        return;
+    }
+    
+    // 排版以段落为单位：改动涉及的段落整段重新排版
+    ++m_documentChanges;
+    QTextBlock block = document()->findBlock(position);
+    const QTextBlock last = document()->findBlock(position + charsAdded);
+    while (block.isValid()) {
+        m_relayoutChars += block.length();
+        if (block == last) {
+            break;
+        }
+        block = block.next();
+    }
+}
+
+void SimpleVoiceTextEdit::onDictationFinished(const QString &requestId)
+{
+    if (requestId == m_controlId) {
+        m_tentativeRegion.clear();
+        const double seconds = qMax<qint64>(m_dictationClock.elapsed(), 1) / 1000.0;
+        qCInfo(lcWidget) << "📝 听写结束，ID:" << m_controlId << "，文档改动(次/秒):" << m_documentChanges / seconds
+                         << "，重排字符(个/秒):" << m_relayoutChars / seconds;
+        m_dictating = false;
+        setState(State::Idle);
+    }
+}
+
 void SimpleVoiceTextEdit::onRecognitionStarted()
 {
-    qDebug() << "📝 收到录音开始信号，ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 收到录音开始信号，ID:" << m_controlId;
     // 如果当前控件有焦点，更新状态
     if (m_hasFocus && m_state == State::Recording) {
         // UI状态已在setState中处理
@@ -149,14 +274,22 @@ void SimpleVoiceTextEdit::onRecognitionStarted()
 
 void SimpleVoiceTextEdit::onRecognitionFinished(const QString &text, const QString &requestId)
 {
-    qDebug() << "📝 收到识别完成信号，文本:" << text << "，请求ID:" << requestId << "，当前ID:" << m_controlId;
+    qCTrace(lcWidget) << "📝 收到识别完成信号，文本:" << text << "，请求ID:" << requestId << "，当前ID:" << m_controlId;
     
     // 只有请求ID匹配或为空时才处理（为空表示兼容旧版本）
     if (requestId.isEmpty() || requestId == m_controlId) {
+        TraceSpan span("widget", "insertText", requestId);
         // 只有当前有焦点的控件才插入文本
-        if (m_hasFocus) {
-            qDebug() << "📝 插入识别结果到当前控件，ID:" << m_controlId;
+        if (m_hasFocus && !m_vocabulary.isEmpty()) {
+            // 取值类控件：结果即为选中的短语，整体替换
+            qCTrace(lcWidget) << "📝 设置选中短语到当前控件，ID:" << m_controlId;
+            setPlainText(text);
+            moveCursor(QTextCursor::End);
+            VoiceRecognitionManager::instance()->reportTextInserted(requestId);
+        } else if (m_hasFocus) {
+            qCTrace(lcWidget) << "📝 插入识别结果到当前控件，ID:" << m_controlId;
             insertPlainText(text);
+            VoiceRecognitionManager::instance()->reportTextInserted(requestId);
         }
         setState(State::Idle);
     }
@@ -164,10 +297,12 @@ void SimpleVoiceTextEdit::onRecognitionFinished(const QString &text, const QStri
 
 void SimpleVoiceTextEdit::onRecognitionError(const QString &error)
 {
-    qDebug() << "📝 收到识别错误信号:" << error << "，ID:" << m_controlId;
+    qCDebug(lcWidget) << "📝 收到识别错误信号:" << error << "，ID:" << m_controlId;
     
-    // 所有控件都应该重置状态
-    setState(State::Idle);
+    // 所有控件都应该重置状态（听写的分段失败不经过这里，听写中的控件保持不变）
+    if (!m_dictating) {
+        setState(State::Idle);
+    }
     
     // 如果当前控件有焦点，显示错误状态
     if (m_hasFocus) {
@@ -183,15 +318,45 @@ void SimpleVoiceTextEdit::onStatusChanged(const QString &status)
     }
 }
 
+void SimpleVoiceTextEdit::onEngineStateChanged(VoiceRecognitionManager::EngineState state)
+{
+    m_engineWarming = (state == VoiceRecognitionManager::EngineLoading
+                       || state == VoiceRecognitionManager::EngineWarming);
+    updatePlaceholder();
+}
+
+void SimpleVoiceTextEdit::setVoiceVocabulary(const QStringList &phrases, double minConfidence)
+{
+    m_vocabulary = phrases;
+    VoiceRecognitionManager::instance()->setCommandVocabulary(m_controlId, phrases, minConfidence);
+    updatePlaceholder();
+}
+
+void SimpleVoiceTextEdit::updatePlaceholder()
+{
+    // 预热期间仍可录音，松键后的请求在引擎就绪时自动识别
+    if (m_engineWarming) {
+        setPlaceholderText("语音引擎预热中，可先长按 'V' 键录音...");
+    } else if (!m_vocabulary.isEmpty()) {
+        QStringList shown = m_vocabulary.mid(0, 5);
+        if (m_vocabulary.size() > shown.size()) {
+            shown << "...";
+        }
+        setPlaceholderText("长按 'V' 键说出：" + shown.join(" / "));
+    } else {
+        setPlaceholderText("长按 'V' 键语音输入，按 F2 连续听写...");
+    }
+}
+
 void SimpleVoiceTextEdit::setState(State newState)
 {
     if (m_state == newState) {
         return;
     }
     
-    qDebug() << "📝 状态变化，ID:" << m_controlId 
-             << "，从" << static_cast<int>(m_state) 
-             << "到" << static_cast<int>(newState);
+    qCTrace(lcWidget) << "📝 状态变化，ID:" << m_controlId 
+                      << "，从" << static_cast<int>(m_state) 
+                      << "到" << static_cast<int>(newState);
     
     m_state = newState;
     
@@ -212,6 +377,13 @@ void SimpleVoiceTextEdit::setState(State newState)
         setReadOnly(true);  // 使用只读模式
         break;
         
+    case State::Dictating:
+        // 听写中：只读，结果由管理器按分段追加到末尾
+        setStyleSheet(m_originalStyleSheet + 
+                     "QTextEdit { background-color: #eef6ee; color: #444444; }");
+        setReadOnly(true);
+        break;
+        
     case State::Recognizing:
         // 设置识别状态的视觉效果
         setStyleSheet(m_originalStyleSheet + 
@@ -4,6 +4,9 @@
 #include <QTextEdit>
 #include <QTimer>
 #include <QKeyEvent>
+#include <QElapsedTimer>
+#include "voicerecognitionmanager.h"
+#include "tentativetextregion.h"
 
 /**
  * 函数名称：`SimpleVoiceTextEdit`
@@ -22,7 +25,8 @@ public:
         Idle,                    // 空闲状态
         WaitingForLongPress,     // 等待长按确认
         Recording,               // 录音中
-        Recognizing             // 识别中
+        Recognizing,             // 识别中
+        Dictating                // 连续听写中
     };
 
     explicit SimpleVoiceTextEdit(QWidget *parent = nullptr);
@@ -36,6 +40,18 @@ public:
      */
     QString getControlId() const { return m_controlId; }
 
+    /**
+     * 函数名称：`setVoiceVocabulary`
+     * 功能描述：声明本控件只接受的短语（状态、编号、是/否等），语音输入只在其中选择，
+     *           结果替换控件内容而不是插入；为空则恢复自由输入
+     * 参数说明：
+     *     - phrases：QStringList，可选短语，支持(a|b)多选一和[a]可省略
+     *     - minConfidence：double，置信度下限，低于时提示未匹配，0表示总是取最接近的短语
+     * 返回值：void
+     */
+    void setVoiceVocabulary(const QStringList &phrases, double minConfidence = 0.0);
+    QStringList voiceVocabulary() const { return m_vocabulary; }
+
 protected:
     /**
      * 函数名称：`keyPressEvent`
@@ -73,6 +89,15 @@ protected:
      */
     void focusOutEvent(QFocusEvent *event) override;
 
+    /**
+     * 函数名称：`setState`
+     * 功能描述：设置控件状态并更新UI（样式表、只读）；子类和基准工具可直接驱动状态切换
+     * 参数说明：
+     *     - newState：State，新状态
+     * 返回值：void
+     */
+    void setState(State newState);
+
 private slots:
     /**
      * 函数名称：`onLongPressTimeout`
@@ -118,16 +143,74 @@ private slots:
      */
     void onStatusChanged(const QString &status);
 
-private:
     /**
-     * 函数名称：`setState`
-     * 功能描述：设置控件状态并更新UI
+     * 函数名称：`onEngineStateChanged`
+     * 功能描述：内置引擎状态变化时更新提示文字，加载/预热期间提示"预热中"
      * 参数说明：
-     *     - newState：State，新状态
+     *     - state：EngineState，引擎状态
      * 返回值：void
      */
-    void setState(State newState);
+    void onEngineStateChanged(VoiceRecognitionManager::EngineState state);
+
+    /**
+     * 函数名称：`onWakeWordDetected`
+     * 功能描述：免按键模式下检测到唤醒词，聚焦且空闲的控件开始录音，与长按V键走同一流程
+     * 参数说明：无
+     * 返回值：void
+     */
+    void onWakeWordDetected();
 
+    /**
+     * 函数名称：`onRecordingStopped`
+     * 功能描述：录音被管理器自动结束（说完后静音），本控件的录音进入识别中状态
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void onRecordingStopped(const QString &requestId);
+
+    /**
+     * 函数名称：`onDictationTextReady`
+     * 功能描述：听写的一个分段识别完成，追加到本控件末尾
+     * 参数说明：
+     *     - text：QString，分段文本
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void onDictationTextReady(const QString &text, const QString &requestId);
+
+    /**
+     * 函数名称：`onDictationFinished`
+     * 功能描述：听写结束且全部分段已追加，恢复空闲状态
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void onDictationFinished(const QString &requestId);
+
+    /**
+     * 函数名称：`onDictationPartialReady`
+     * 功能描述：听写的中间结果：新定稿的文字插入文档，未定稿的文字显示在插入点之后的灰色标签上并替换上次的未定稿部分，
+     *           不进入文档，不重排也不产生撤销记录
+     * 参数说明：
+     *     - committedText：QString，新定稿的文字
+     *     - tentativeText：QString，未定稿的文字
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void onDictationPartialReady(const QString &committedText, const QString &tentativeText,
+                                 const QString &requestId);
+
+    /**
+     * 函数名称：`onDocumentContentsChange`
+     * 功能描述：听写期间统计文档改动次数和需要重新排版的字符数（未定稿文字不在文档中，不计入），听写结束时输出每秒的平均值
+     * 参数说明：
+     *     - position/charsRemoved/charsAdded：int，同QTextDocument::contentsChange
+     * 返回值：void
+     */
+    void onDocumentContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
     /**
      * 函数名称：`setupConnections`
      * 功能描述：设置与VoiceRecognitionManager的信号连接
@@ -136,15 +219,31 @@ private:
      */
     void setupConnections();
 
+    /**
+     * 函数名称：`updatePlaceholder`
+     * 功能描述：按引擎状态和可选短语更新提示文字
+     * 参数说明：无
+     * 返回值：void
+     */
+    void updatePlaceholder();
+
 private:
     State m_state;                      // 当前状态
     QTimer* m_longPressTimer;           // 长按计时器
     QString m_originalStyleSheet;       // 原始样式表
     QString m_controlId;                // 控件唯一标识
     bool m_hasFocus;                    // 是否拥有焦点
+    bool m_engineWarming;               // 内置引擎是否在加载/预热
+    QStringList m_vocabulary;           // 可选短语，为空表示自由输入
+    bool m_dictating;                   // 本控件的听写是否未结束（含停止后等待最后几段）
+    TentativeTextRegion m_tentativeRegion;  // 听写的插入点和未定稿文字
+    QElapsedTimer m_dictationClock;     // 听写计时，用于统计每秒的重排
+    int m_documentChanges;              // 听写期间的文档改动次数
+    qint64 m_relayoutChars;             // 听写期间改动所在段落的字符总数（需要重新排版的量）
 
     // 常量
     static const int LONG_PRESS_DURATION = 500; // 长按持续时间(毫秒)
+    static const Qt::Key DICTATION_KEY = Qt::Key_F2; // 开始/结束连续听写
 
 signals:
     /**
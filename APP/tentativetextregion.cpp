@@ -0,0 +1,104 @@
+#include "tentativetextregion.h"
+#include <QAbstractTextDocumentLayout>
+#include <QScrollBar>
+
+TentativeTextRegion::TentativeTextRegion(QTextEdit *edit)
+    : m_edit(edit)
+{
+    // 背景取输入框底色并不透明：标签重绘时不需要先重绘下面的输入框
+    m_overlay = new QLabel(edit->viewport());
+    m_overlay->setTextFormat(Qt::PlainText);
+    m_overlay->setWordWrap(true);
+    m_overlay->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    m_overlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    QPalette palette = edit->viewport()->palette();
+    palette.setColor(QPalette::Text, Qt::gray);
+    m_overlay->setPalette(palette);
+    m_overlay->setForegroundRole(QPalette::Text);
+    m_overlay->setBackgroundRole(QPalette::Base);
+    m_overlay->setAutoFillBackground(true);
+    m_overlay->hide();
+
+    // 插入点之前的改动、输入框宽度变化都会重新排版，标签随之移动；滚动时视口连同子控件一起移动
+    QObject::connect(edit->document()->documentLayout(), &QAbstractTextDocumentLayout::update,
+                     m_overlay.data(), [this]() { place(); });
+}
+
+TentativeTextRegion::~TentativeTextRegion()
+{
+    delete m_overlay.data();
+}
+
+void TentativeTextRegion::begin()
+{
+    if (!m_edit) {
+        return;
+    }
+    clear();
+    m_tentative.clear();
+    m_cursor = m_edit->textCursor();
+    m_cursor.clearSelection();
+}
+
+void TentativeTextRegion::update(const QString &committedText, const QString &tentativeText)
+{
+    if (!m_edit || m_cursor.isNull() || (committedText.isEmpty() && tentativeText == m_tentative)) {
+        return;
+    }
+
+    // 定稿文字与键入一样写入文档，插入点和停在这里的输入框光标随之后移
+    if (!committedText.isEmpty()) {
+        const bool caretAtInsertion = m_edit->textCursor().position() == m_cursor.position();
+        m_cursor.insertText(committedText);
+        if (caretAtInsertion) {
+            m_edit->ensureCursorVisible();
+        }
+    }
+    m_tentative = tentativeText;
+    place();
+}
+
+void TentativeTextRegion::place()
+{
+    if (!m_edit || !m_overlay) {
+        return;
+    }
+    if (m_tentative.isEmpty() || m_cursor.isNull()) {
+        m_overlay->hide();
+        return;
+    }
+
+    const QFont font = m_cursor.charFormat().font();
+    if (m_overlay->font() != font) {
+        m_overlay->setFont(font);
+    }
+
+    // 从光标右侧开始，插入点离右边缘太近、且下一行仍在视口内时从下一行行首开始
+    const QWidget *viewport = m_edit->viewport();
+    const QRect caret = m_edit->cursorRect(m_cursor);
+    const QFontMetrics metrics(font);
+    QPoint origin(caret.right() + 1, caret.top());
+    if (viewport->width() - origin.x() < viewport->width() / 4
+            && caret.bottom() + 1 + metrics.lineSpacing() <= viewport->height()) {
+        const int margin = static_cast<int>(m_edit->document()->documentMargin());
+        origin = QPoint(margin - m_edit->horizontalScrollBar()->value(), caret.bottom() + 1);
+    }
+    const int width = qMax(1, viewport->width() - origin.x());
+
+    // 标签不撑大文档，超出视口底部的部分看不到：省略前面的文字，最新的文字总在末尾
+    const int maxHeight = qMax(metrics.lineSpacing(), viewport->height() - origin.y());
+    QString text = m_tentative;
+    if (metrics.boundingRect(0, 0, width, maxHeight, Qt::TextWordWrap, text).height() > maxHeight) {
+        const int lines = qMax(1, maxHeight / metrics.lineSpacing());
+        text = metrics.elidedText(text, Qt::ElideLeft, lines * width - width / 4);
+    }
+    if (m_overlay->text() != text) {
+        m_overlay->setText(text);
+    }
+
+    const QRect geometry(origin, QSize(width, m_overlay->heightForWidth(width)));
+    if (m_overlay->geometry() != geometry) {
+        m_overlay->setGeometry(geometry);
+    }
+    m_overlay->show();
+}
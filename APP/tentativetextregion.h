@@ -0,0 +1,75 @@
+#ifndef TENTATIVETEXTREGION_H
+#define TENTATIVETEXTREGION_H
+
+#include <QTextEdit>
+#include <QTextCursor>
+#include <QLabel>
+#include <QPointer>
+
+/**
+ * 函数名称：`TentativeTextRegion`
+ * 功能描述：输入框中的未定稿文字区域：中间结果画在持久光标之后的灰色标签上，不写入文档；
+ *           定稿文字才作为普通输入插入文档
+ * 设计特点：
+ *   - 未定稿文字不进入文档和排版，更新时只重绘标签；标签不透明，输入框本身不重绘，
+ *     开销与文档长度无关（editbench的region方式，--max-ratio 1.1）
+ *   - 每次只插入新定稿的文字，与上次相同的更新直接跳过；相连的定稿插入合并为一条撤销记录
+ *   - 插入点是持久的QTextCursor，文档其他位置的改动会自动调整它，标签随排版更新移动
+ *   - 标签只盖住插入点之后的区域（听写从文档末尾开始）；放不下时省略前面的文字，只显示最新的部分
+ * 线程安全：只能在GUI线程中使用
+ */
+class TentativeTextRegion
+{
+public:
+    explicit TentativeTextRegion(QTextEdit *edit);
+    ~TentativeTextRegion();
+
+    /**
+     * 函数名称：`begin`
+     * 功能描述：在输入框的当前光标处开始，之前残留的未定稿文字清除
+     */
+    void begin();
+
+    /**
+     * 函数名称：`update`
+     * 功能描述：插入新定稿的文字，并以灰色显示新的未定稿文字（替换上次的未定稿文字）
+     * 参数说明：
+     *     - committedText：QString，新定稿的文字，可为空
+     *     - tentativeText：QString，未定稿的文字
+     * 返回值：void
+     */
+    void update(const QString &committedText, const QString &tentativeText);
+
+    /**
+     * 函数名称：`commit`
+     * 功能描述：插入定稿的文字并清除未定稿文字
+     * 参数说明：
+     *     - text：QString，定稿文字
+     * 返回值：void
+     */
+    void commit(const QString &text) { update(text, QString()); }
+
+    /**
+     * 函数名称：`clear`
+     * 功能描述：清除未定稿文字
+     */
+    void clear() { update(QString(), QString()); }
+
+    QString tentativeText() const { return m_tentative; }
+
+private:
+    Q_DISABLE_COPY(TentativeTextRegion)
+
+    /**
+     * 函数名称：`place`
+     * 功能描述：把标签放到插入点之后，宽度到视口右边缘，按未定稿文字折行；没有未定稿文字时隐藏
+     */
+    void place();
+
+    QPointer<QTextEdit> m_edit;
+    QTextCursor m_cursor;               // 插入点
+    QString m_tentative;                // 当前显示的未定稿文字
+    QPointer<QLabel> m_overlay;         // 显示未定稿文字，视口的子控件
+};
+
+#endif // TENTATIVETEXTREGION_H
@@ -0,0 +1,270 @@
+#include "voicelogging.h"
+#include <QDateTime>
+#include <QFile>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// release构建默认只输出info及以上
+#ifdef QT_NO_DEBUG
+#  define VOICE_LOG_DEFAULT_LEVEL QtInfoMsg
+#else
+#  define VOICE_LOG_DEFAULT_LEVEL QtDebugMsg
+#endif
+
+Q_LOGGING_CATEGORY(lcApp, "voiceinput.app", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcManager, "voiceinput.manager", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcCapture, "voiceinput.capture", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcNetwork, "voiceinput.network", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcEngine, "voiceinput.engine", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcWake, "voiceinput.wake", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcDictation, "voiceinput.dictation", VOICE_LOG_DEFAULT_LEVEL)
+Q_LOGGING_CATEGORY(lcWidget, "voiceinput.widget", VOICE_LOG_DEFAULT_LEVEL)
+
+namespace {
+
+const int QUEUE_CAPACITY = 4096;
+
+/**
+ * 队列中的一条消息：只保存原始内容，格式化在写入线程进行
+ */
+struct LogEntry {
+    qint64 timeMs = 0;
+    QtMsgType type = QtDebugMsg;
+    const char *category = nullptr;     // 类别名为静态字符串
+    QString message;
+};
+
+/**
+ * 后台写入线程与环形队列
+ */
+class SinkState
+{
+public:
+    SinkState(const QString &filePath, bool console)
+        : m_entries(QUEUE_CAPACITY)
+        , m_console(console)
+    {
+        if (!filePath.isEmpty()) {
+            m_file.setFileName(filePath);
+            m_fileOpen = m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+        }
+        m_writer = std::thread([this]() { writeLoop(); });
+    }
+
+    /**
+     * 函数名称：`stop`
+     * 功能描述：写完队列中的消息后结束写入线程；之后入队的消息不再写出
+     */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_writer.join();
+    }
+
+    bool fileOpen() const { return m_fileOpen || m_file.fileName().isEmpty(); }
+
+    void enqueue(QtMsgType type, const char *category, const QString &message)
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            if (m_size == QUEUE_CAPACITY) {
+                m_head = (m_head + 1) % QUEUE_CAPACITY;
+                --m_size;
+                ++m_dropped;
+                ++m_droppedTotal;
+            }
+            LogEntry &entry = m_entries[(m_head + m_size) % QUEUE_CAPACITY];
+            entry.timeMs = QDateTime::currentMSecsSinceEpoch();
+            entry.type = type;
+            entry.category = category;
+            entry.message = message;
+            ++m_size;
+            ++m_enqueued;
+        }
+        m_wake.notify_one();
+    }
+
+    /**
+     * 函数名称：`writeNow`
+     * 功能描述：在调用线程上直接写出一条消息（fatal），先写完队列中更早的消息
+     */
+    void writeNow(QtMsgType type, const char *category, const QString &message)
+    {
+        flush();
+        LogEntry entry;
+        entry.timeMs = QDateTime::currentMSecsSinceEpoch();
+        entry.type = type;
+        entry.category = category;
+        entry.message = message;
+        std::lock_guard<std::mutex> locker(m_outputMutex);
+        write(format(entry));
+        if (m_console) {
+            std::fflush(stderr);
+        }
+        if (m_fileOpen) {
+            m_file.flush();
+        }
+    }
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+        const quint64 target = m_enqueued;
+        m_wake.notify_one();
+        m_drained.wait(locker, [this, target]() { return m_written >= target || m_stopping; });
+    }
+
+    qint64 dropped() const
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return m_droppedTotal;
+    }
+
+private:
+    void writeLoop()
+    {
+        std::vector<LogEntry> batch;
+        batch.reserve(QUEUE_CAPACITY);
+        for (;;) {
+            qint64 dropped = 0;
+            {
+                std::unique_lock<std::mutex> locker(m_mutex);
+                m_wake.wait(locker, [this]() { return m_size > 0 || m_stopping; });
+                if (m_size == 0 && m_stopping) {
+                    break;
+                }
+                // 整批取出后释放锁，写入期间产生消息的线程不必等待
+                for (int i = 0; i < m_size; ++i) {
+                    batch.push_back(std::move(m_entries[(m_head + i) % QUEUE_CAPACITY]));
+                }
+                m_head = (m_head + m_size) % QUEUE_CAPACITY;
+                dropped = m_dropped;
+                m_dropped = 0;
+                m_size = 0;
+            }
+
+            {
+                std::lock_guard<std::mutex> locker(m_outputMutex);
+                if (dropped > 0) {
+                    write(QString("日志队列已满，丢弃了%1条消息\n").arg(dropped).toUtf8());
+                }
+                for (const LogEntry &entry : batch) {
+                    write(format(entry));
+                }
+                if (m_fileOpen) {
+                    m_file.flush();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> locker(m_mutex);
+                m_written += batch.size() + static_cast<quint64>(dropped);
+            }
+            m_drained.notify_all();
+            batch.clear();
+        }
+        m_drained.notify_all();
+    }
+
+    static QByteArray format(const LogEntry &entry)
+    {
+        static const char *levels[] = {"D", "W", "C", "F", "I"};
+        QByteArray line = QDateTime::fromMSecsSinceEpoch(entry.timeMs).toString("HH:mm:ss.zzz").toLatin1();
+        line += ' ';
+        line += levels[entry.type];
+        line += " [";
+        line += entry.category ? entry.category : "default";
+        line += "] ";
+        line += entry.message.toUtf8();
+        line += '\n';
+        return line;
+    }
+
+    void write(const QByteArray &line)
+    {
+        if (m_console) {
+            std::fwrite(line.constData(), 1, line.size(), stderr);
+        }
+        if (m_fileOpen) {
+            m_file.write(line);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+    std::vector<LogEntry> m_entries;
+    int m_head = 0;
+    int m_size = 0;
+    qint64 m_dropped = 0;               // 上次写出后丢弃的条数
+    qint64 m_droppedTotal = 0;
+    quint64 m_enqueued = 0;             // 含被丢弃的
+    quint64 m_written = 0;              // 已写出或已丢弃
+    bool m_stopping = false;
+
+    std::mutex m_outputMutex;           // 写入线程与fatal消息的同步写出
+    bool m_console;
+    QFile m_file;
+    bool m_fileOpen = false;
+    std::thread m_writer;
+};
+
+// 卸载后对象不释放：其它线程可能恰好还在消息处理函数中，入队仍然安全，只是不再写出
+std::atomic<SinkState *> g_sink(nullptr);
+QtMessageHandler g_previousHandler = nullptr;
+
+void asyncMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    SinkState *sink = g_sink.load(std::memory_order_acquire);
+    if (!sink) {
+        return;
+    }
+    if (type == QtFatalMsg) {
+        sink->writeNow(type, context.category, message);
+        return;
+    }
+    sink->enqueue(type, context.category, message);
+}
+
+} // namespace
+
+bool AsyncLogSink::install(const QString &filePath, bool console)
+{
+    uninstall();
+    SinkState *sink = new SinkState(filePath, console);
+    g_sink.store(sink, std::memory_order_release);
+    g_previousHandler = qInstallMessageHandler(asyncMessageHandler);
+    return sink->fileOpen();
+}
+
+void AsyncLogSink::uninstall()
+{
+    SinkState *sink = g_sink.exchange(nullptr);
+    if (!sink) {
+        return;
+    }
+    qInstallMessageHandler(g_previousHandler);
+    g_previousHandler = nullptr;
+    sink->stop();
+}
+
+void AsyncLogSink::flush()
+{
+    if (SinkState *sink = g_sink.load(std::memory_order_acquire)) {
+        sink->flush();
+    }
+}
+
+qint64 AsyncLogSink::droppedMessages()
+{
+    SinkState *sink = g_sink.load(std::memory_order_acquire);
+    return sink ? sink->dropped() : 0;
+}
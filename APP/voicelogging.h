@@ -0,0 +1,76 @@
+#ifndef VOICELOGGING_H
+#define VOICELOGGING_H
+
+#include <QLoggingCategory>
+#include <QString>
+
+/**
+ * 模块名称：日志类别
+ * 功能描述：按子系统划分的QLoggingCategory，取代直接的qDebug
+ * 设计特点：
+ *   - 四个级别：trace（每次按键、焦点、状态切换、完整响应体等逐事件的细节）、debug（每句话的概要）、
+ *     info（启动、配置、每句话的耗时）、warning
+ *   - qCTrace在release构建中整句编译掉（参数不求值），debug构建中等同qCDebug；
+ *     release构建定义VOICE_LOG_TRACE可保留
+ *   - release构建中各类别默认只输出info及以上，关闭的级别只剩一次布尔判断；
+ *     运行时用QT_LOGGING_RULES打开，如"voiceinput.network.debug=true"或"voiceinput.*.debug=true"
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcApp)           // voiceinput.app：主窗口、启动
+Q_DECLARE_LOGGING_CATEGORY(lcManager)       // voiceinput.manager：录音与识别流程
+Q_DECLARE_LOGGING_CATEGORY(lcCapture)       // voiceinput.capture：录音设备、录音存储
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)       // voiceinput.network：识别服务请求与响应
+Q_DECLARE_LOGGING_CATEGORY(lcEngine)        // voiceinput.engine：内置引擎、线程配置、短语匹配
+Q_DECLARE_LOGGING_CATEGORY(lcWake)          // voiceinput.wake：唤醒词、免按键模式
+Q_DECLARE_LOGGING_CATEGORY(lcDictation)     // voiceinput.dictation：连续听写、投机识别分段
+Q_DECLARE_LOGGING_CATEGORY(lcWidget)        // voiceinput.widget：输入框
+
+#if defined(QT_NO_DEBUG) && !defined(VOICE_LOG_TRACE)
+#  define qCTrace(category) QT_NO_QDEBUG_MACRO()
+#else
+#  define qCTrace(category) qCDebug(category)
+#endif
+
+/**
+ * 函数名称：`AsyncLogSink`
+ * 功能描述：异步日志输出：消息处理函数只把消息放入环形队列，由后台线程格式化并写入stderr和日志文件，
+ *           控制台I/O不再发生在GUI线程和管理器线程上
+ * 设计特点：
+ *   - 队列容量固定（4096条），写入跟不上时丢弃最早的消息，并在输出中注明丢弃的条数
+ *   - 时间戳在产生消息时取，格式化（时间、级别、类别）在后台线程进行
+ *   - fatal消息同步写出并刷新，再交给Qt终止进程
+ *   - uninstall（或进程正常退出前）写完队列中剩余的消息，恢复原来的消息处理函数
+ * 线程安全：消息可在任意线程产生；install/uninstall在主线程调用
+ */
+class AsyncLogSink
+{
+public:
+    /**
+     * 函数名称：`install`
+     * 功能描述：安装为Qt的消息处理函数，启动后台写入线程；已安装时先卸载
+     * 参数说明：
+     *     - filePath：QString，同时追加写入的日志文件，为空时不写文件
+     *     - console：bool，是否写入stderr
+     * 返回值：bool，日志文件无法打开时返回false（仍会安装，只写stderr）
+     */
+    static bool install(const QString &filePath = QString(), bool console = true);
+
+    /**
+     * 函数名称：`uninstall`
+     * 功能描述：写完队列中的消息，停止后台线程，恢复原来的消息处理函数
+     */
+    static void uninstall();
+
+    /**
+     * 函数名称：`flush`
+     * 功能描述：等待此前产生的消息全部写出
+     */
+    static void flush();
+
+    /**
+     * 函数名称：`droppedMessages`
+     * 功能描述：安装以来因队列满丢弃的消息数
+     */
+    static qint64 droppedMessages();
+};
+
+#endif // VOICELOGGING_H
@@ -1,34 +1,187 @@
 #include "voicerecognitionmanager.h"
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include "recognitionprotocol.h"
+#include "pipelinetrace.h"
+#include "sessionrecorder.h"
+#include "voicelogging.h"
 #include <QHttpMultiPart>
 #include <QNetworkRequest>
 #include <QDebug>
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDataStream>
+#include <QFile>
 
 // 静态成员初始化
 VoiceRecognitionManager* VoiceRecognitionManager::m_instance = nullptr;
 
+namespace {
+
+// 启动阶段计时：首次markStartupPhase为起点
+QMutex g_startupMutex;
+QElapsedTimer g_startupClock;
+QVector<QPair<QString, qint64>> g_startupPhases;
+
+// 投机识别分段的请求ID为"<控件ID>#prefix-<录音编号>-<序号>"
+const QString PREFIX_SEGMENT_TAG = QStringLiteral("#prefix-");
+
+/**
+ * 函数名称：`joinSegmentText`
+ * 功能描述：按顺序拼接两个分段的文本：中文直接相连，英文单词、数字之间补一个空格
+ */
+QString joinSegmentText(const QString &left, const QString &right)
+{
+    if (left.isEmpty() || right.isEmpty()) {
+        return left + right;
+    }
+    const QChar last = left.at(left.size() - 1);
+    const QChar first = right.at(0);
+    const bool latinLeft = last.unicode() < 0x80 && (last.isLetterOrNumber() || QStringLiteral(".,!?;:").contains(last));
+    const bool latinRight = first.unicode() < 0x80 && first.isLetterOrNumber();
+    return latinLeft && latinRight ? left + ' ' + right : left + right;
+}
+
+/**
+ * 函数名称：`traceRequestStages`
+ * 功能描述：把一次请求的各阶段写入时间线，以请求ID归为一行，总跨度从第一个到最后一个时间点
+ */
+void traceRequestStages(const RequestMetrics &metrics)
+{
+    if (!PipelineTrace::isEnabled()) {
+        return;
+    }
+    qint64 first = 0;
+    qint64 last = 0;
+    for (qint64 stamp : metrics.stamps) {
+        if (stamp) {
+            first = first ? qMin(first, stamp) : stamp;
+            last = qMax(last, stamp);
+        }
+    }
+    if (!first) {
+        return;
+    }
+    PipelineTrace::async("request", metrics.error.isEmpty() ? "request" : "request (failed)",
+                         metrics.requestId, first, last);
+    for (int stage = 0; stage < RequestMetrics::StageCount; ++stage) {
+        const RequestMetrics::Stage current = static_cast<RequestMetrics::Stage>(stage);
+        const qint64 begin = metrics.stageBeginNs(current);
+        if (begin) {
+            PipelineTrace::async("request", RequestMetrics::stageName(current), metrics.requestId,
+                                 begin, metrics.stamps[RequestMetrics::endStamp(current)]);
+        }
+    }
+}
+
+/**
+ * 函数名称：`traceReply`
+ * 功能描述：把一次识别请求的网络往返和服务端Server-Timing写入时间线
+ * 设计特点：两端时钟不同，服务端各段按报告的顺序首尾相接，以收到响应的时刻为终点；
+ *           有total时以它为总跨度，其余各段从总跨度起点排起
+ */
+void traceReply(QNetworkReply *reply, const QString &requestId)
+{
+    const qint64 sentNs = reply->property("traceSentNs").toLongLong();
+    if (!PipelineTrace::isEnabled() || !sentNs) {
+        return;
+    }
+    const qint64 receivedNs = RequestMetrics::now();
+    PipelineTrace::async("network", "POST /api/v1/asr", requestId, sentNs, receivedNs);
+
+    const QVector<RecognitionProtocol::ServerTiming> timings =
+        RecognitionProtocol::parseServerTiming(reply->rawHeader("Server-Timing"));
+    double spanMs = 0.0;
+    for (const RecognitionProtocol::ServerTiming &timing : timings) {
+        if (timing.name == "total") {
+            spanMs = timing.durationMs;
+            break;
+        }
+        spanMs += timing.durationMs;
+    }
+    qint64 cursor = receivedNs - static_cast<qint64>(spanMs * 1e6);
+    for (const RecognitionProtocol::ServerTiming &timing : timings) {
+        const qint64 durationNs = static_cast<qint64>(timing.durationMs * 1e6);
+        if (timing.name == "total") {
+            PipelineTrace::server(timing.name, receivedNs - durationNs, receivedNs, requestId);
+            continue;
+        }
+        PipelineTrace::server(timing.name, cursor, cursor + durationNs, requestId);
+        cursor += durationNs;
+    }
+}
+
+} // namespace
+
 VoiceRecognitionManager::VoiceRecognitionManager(QObject *parent)
     : QObject(parent)
     , m_workerThread(nullptr)
     , m_serviceUrl("http://127.0.0.1:8000")
-    , m_audioInput(nullptr)
-    , m_audioBuffer(new QBuffer(this))
+    , m_audioSource(nullptr)
+    , m_captureStore(new CaptureStore(this))
     , m_networkManager(new QNetworkAccessManager(this))
+    , m_engine(new EnginePipeline(this))
+    , m_dictation(new DictationPipeline(m_engine, this))
+    , m_handsFree(new HandsFreePipeline(this))
+    , m_firstRecognitionDone(false)
+    , m_prefixScannedBytes(0)
+    , m_prefixCutBytes(0)
+    , m_prefixGeneration(0)
+    , m_speculativeIntervalMs(0)
+    , m_captureBufferMs(0)
 {
-    qDebug() << "🎤 VoiceRecognitionManager 构造函数";
+    qCTrace(lcManager) << "🎤 VoiceRecognitionManager 构造函数";
+    qRegisterMetaType<VoiceRecognitionManager::EngineState>("VoiceRecognitionManager::EngineState");
+    qRegisterMetaType<RequestMetrics>("RequestMetrics");
+    m_captureStore->setMemoryLimit(CAPTURE_MEMORY_LIMIT_MB * 1024LL * 1024LL);
+    
+    // 流水线是本对象的子对象，与本对象同线程，以下连接均为直接调用；
+    // 调度器工作线程的结果先经EnginePipeline的信号排队到管理器线程
+    connect(m_engine, &EnginePipeline::stateChanged, this, &VoiceRecognitionManager::onEngineStateChanged);
+    connect(m_engine, &EnginePipeline::loadFinished, this, &VoiceRecognitionManager::onEngineLoadFinished);
+    connect(m_engine, &EnginePipeline::threadConfigChanged, this, &VoiceRecognitionManager::engineThreadConfigChanged);
+    connect(m_engine, &EnginePipeline::requestFinished, this, &VoiceRecognitionManager::onSchedulerRequestFinished);
+    connect(m_engine, &EnginePipeline::commandFinished, this, &VoiceRecognitionManager::onSchedulerCommandFinished);
+    connect(m_engine, &EnginePipeline::autotuneStarted, this, [this]() {
+        emit statusChanged("正在测试最佳线程配置...");
+    });
+    connect(m_engine, &EnginePipeline::engineReleased, this, [this]() {
+        // 词表按引擎的token编号编译，随引擎失效
+        for (CommandVocabulary &vocabulary : m_commandVocabularies) {
+            vocabulary.grammar.reset();
+        }
+    });
+    
+    connect(m_dictation, &DictationPipeline::segmentReady, this, &VoiceRecognitionManager::onDictationSegmentReady);
+    connect(m_dictation, &DictationPipeline::textReady, this, &VoiceRecognitionManager::dictationTextReady);
+    connect(m_dictation, &DictationPipeline::partialReady, this, &VoiceRecognitionManager::dictationPartialReady);
+    connect(m_dictation, &DictationPipeline::finished, this, &VoiceRecognitionManager::dictationFinished);
+    connect(m_dictation, &DictationPipeline::statusChanged, this, &VoiceRecognitionManager::statusChanged);
+    connect(m_dictation, &DictationPipeline::sourceStopped, this, &VoiceRecognitionManager::finishCaptureHealth);
+    
+    connect(m_handsFree, &HandsFreePipeline::audioCaptured, this, &VoiceRecognitionManager::onMonitorAudio);
+    connect(m_handsFree, &HandsFreePipeline::wakeWordSpotted, this, &VoiceRecognitionManager::onWakeWordSpotted);
+    connect(m_handsFree, &HandsFreePipeline::speechEnded, this, [this]() {
+        emit recordingStopped(m_currentRequestId);
+        stopRecording();
+    });
+    connect(m_handsFree, &HandsFreePipeline::noSpeechTimeout, this, [this]() {
+        cancelRecording();
+        emit recognitionError("唤醒后未检测到语音");
+    });
+    connect(m_handsFree, &HandsFreePipeline::sourceStopped, this, &VoiceRecognitionManager::finishCaptureHealth);
 }
 
 VoiceRecognitionManager::~VoiceRecognitionManager()
 {
-    qDebug() << "🎤 VoiceRecognitionManager 析构函数";
+    qCTrace(lcManager) << "🎤 VoiceRecognitionManager 析构函数";
     
-    if (m_audioInput) {
-        m_audioInput->stop();
-        delete m_audioInput;
-    }
+    delete m_audioSource;
+    
+    // 按依赖顺序先于工作线程释放：听写引用引擎流水线；引擎流水线析构时等待后台加载和调优线程
+    delete m_handsFree;
+    delete m_dictation;
+    delete m_engine;
     
     if (m_workerThread) {
         m_workerThread->quit();
@@ -47,10 +200,11 @@ VoiceRecognitionManager* VoiceRecognitionManager::instance()
 
 void VoiceRecognitionManager::initialize()
 {
-    qDebug() << "🎤 初始化 VoiceRecognitionManager";
+    qCDebug(lcManager) << "🎤 初始化 VoiceRecognitionManager";
     
     // 创建工作线程
     m_workerThread = new QThread();
+    m_workerThread->setObjectName("VoiceRecognitionManager");
     
     // 将当前对象移到工作线程
     this->moveToThread(m_workerThread);
@@ -58,100 +212,312 @@ void VoiceRecognitionManager::initialize()
     // 启动工作线程
     m_workerThread->start();
     
-    qDebug() << "🎤 工作线程已启动，线程ID:" << m_workerThread->currentThreadId();
+    qCDebug(lcManager) << "🎤 工作线程已启动，线程ID:" << m_workerThread->currentThreadId();
 }
 
 void VoiceRecognitionManager::setServiceUrl(const QString &url)
 {
     m_serviceUrl = url;
-    qDebug() << "🎤 设置服务URL:" << url;
+    qCInfo(lcNetwork) << "🎤 设置服务URL:" << url;
+}
+
+bool VoiceRecognitionManager::setEngineModel(const QString &modelFile, const QString &precision,
+                                             const QString &kernels)
+{
+    if (modelFile.isEmpty()) {
+        qCInfo(lcEngine) << "🎤 关闭内置引擎，使用识别服务:" << m_serviceUrl;
+    }
+    return m_engine->load(modelFile, precision, kernels);
+}
+
+void VoiceRecognitionManager::loadEngineAsync(const QString &modelFile, const QString &precision,
+                                              const QString &kernels)
+{
+    if (postToManagerThread([this, modelFile, precision, kernels]() { loadEngineAsync(modelFile, precision, kernels); })) {
+        return;
+    }
+    m_engine->loadAsync(modelFile, precision, kernels);
+}
+
+void VoiceRecognitionManager::autotuneEngine(int targetLatencyMs)
+{
+    if (postToManagerThread([this, targetLatencyMs]() { autotuneEngine(targetLatencyMs); })) {
+        return;
+    }
+    m_engine->autotune(targetLatencyMs);
+}
+
+void VoiceRecognitionManager::setEngineThreads(int intraOpThreads, int sessions)
+{
+    if (postToManagerThread([this, intraOpThreads, sessions]() { setEngineThreads(intraOpThreads, sessions); })) {
+        return;
+    }
+    m_engine->setThreads(intraOpThreads, sessions);
+}
+
+void VoiceRecognitionManager::onEngineStateChanged(EnginePipeline::State state)
+{
+    emit engineStateChanged(static_cast<EngineState>(state));
+
+    switch (state) {
+    case EnginePipeline::Loading:
+        emit statusChanged("正在加载语音引擎...");
+        break;
+    case EnginePipeline::Warming:
+        emit statusChanged("语音引擎预热中...");
+        break;
+    case EnginePipeline::Ready:
+        emit statusChanged("语音引擎已就绪");
+        break;
+    case EnginePipeline::Failed:
+        emit statusChanged("内置引擎加载失败，使用识别服务");
+        break;
+    default:
+        break;
+    }
+}
+
+void VoiceRecognitionManager::onEngineLoadFinished(bool ok)
+{
+    // 词表按引擎的token编号编译，换引擎后重新编译
+    if (ok) {
+        for (CommandVocabulary &vocabulary : m_commandVocabularies) {
+            vocabulary.grammar = m_engine->compileGrammar(vocabulary.patterns);
+        }
+    }
+    flushPendingRequests();
+}
+
+void VoiceRecognitionManager::flushPendingRequests()
+{
+    const QList<InferenceScheduler::PendingRequest> pending = m_engine->takePendingRequests();
+    for (const InferenceScheduler::PendingRequest &request : pending) {
+        // 加载期间词表尚未编译，此时按来源补上
+        if (!m_engine->submit(request.requestId, request.pcm, request.priority,
+                              request.grammar ? request.grammar : commandGrammar(request.requestId))) {
+            sendRecognitionRequest(request.pcm, request.requestId);
+        }
+    }
+}
+
+void VoiceRecognitionManager::markStartupPhase(const QString &phase)
+{
+    QMutexLocker locker(&g_startupMutex);
+    if (!g_startupClock.isValid()) {
+        g_startupClock.start();
+    }
+    g_startupPhases.append(qMakePair(phase, g_startupClock.elapsed()));
+    qCInfo(lcApp) << "⏱️ 启动阶段:" << phase << g_startupClock.elapsed() << "ms";
+}
+
+QVector<QPair<QString, qint64>> VoiceRecognitionManager::startupTimings()
+{
+    QMutexLocker locker(&g_startupMutex);
+    return g_startupPhases;
 }
 
 void VoiceRecognitionManager::startRecording(const QString &requestId)
 {
-    qDebug() << "🎤 开始录音，请求ID:" << requestId;
+    // 按下的时刻在调用线程记下，排队等待的时间计入按键到出字的延迟
+    const qint64 keyDownAt = RequestMetrics::now();
+    if (postToManagerThread([this, requestId, keyDownAt]() { startRecordingAt(requestId, keyDownAt); })) {
+        return;
+    }
+    startRecordingAt(requestId, keyDownAt);
+}
+
+void VoiceRecognitionManager::startRecordingAt(const QString &requestId, qint64 keyDownAt)
+{
+    TraceSpan span("manager", "startRecording", requestId);
+    qCDebug(lcManager) << "🎤 开始录音，请求ID:" << requestId;
+    
+    // 上一句的投机分段仍未全部返回：录音存储即将被覆盖，先留一份整段录音，分段失败时整段上传
+    auto previous = m_prefixSessions.find(m_currentRequestId);
+    if (previous != m_prefixSessions.end() && previous->total >= 0) {
+        previous->pcm = m_captureStore->toByteArray();
+    }
     m_currentRequestId = requestId;
+    beginRequestMetrics(requestId, RequestMetrics::KeyDown, keyDownAt);
+    SessionRecorder::event(SessionRecorder::KeyDown, requestId);
     
     emit statusChanged("正在录音...");
     emit recognitionStarted();
     
-    // 配置音频格式
-    QAudioFormat format = setupAudioFormat();
-    
-    // 获取默认音频输入设备
-    QAudioDeviceInfo audioDevice = QAudioDeviceInfo::defaultInputDevice();
-    if (audioDevice.isNull()) {
-        emit recognitionError("未找到音频输入设备");
+    // 免按键模式：麦克风已在常驻监听，录音直接取自监听流；由唤醒词触发时带上唤醒词之后已采到的音频
+    if (m_handsFree->isEnabled()) {
+        stampRequest(requestId, RequestMetrics::CaptureStarted);
+        m_captureStore->open(QIODevice::WriteOnly);
+        m_captureStore->write(m_handsFree->beginRecording());
+        if (m_engine->beginStream(commandGrammar(requestId)) || beginSpeculation(requestId)) {
+            QMetaObject::invokeMethod(this, "onAudioNotify", Qt::QueuedConnection);
+        }
+        qCDebug(lcCapture) << "🎤 录音已开始（监听流），预录(ms):" << m_captureStore->bytesCaptured() / 32;
         return;
     }
     
-    // 检查格式支持
-    if (!audioDevice.isFormatSupported(format)) {
-        format = audioDevice.nearestFormat(format);
-    }
-
-    // 创建音频输入
-    if (m_audioInput) {
-        delete m_audioInput;
+    // 创建录音来源（麦克风、回放文件或合成信号），麦克风不支持时使用最接近的格式
+    delete m_audioSource;
+    QString error;
+    m_audioSource = createAudioSource(true, &error);
+    if (!m_audioSource) {
+        discardRequestMetrics(requestId);
+        emit recognitionError(error);
+        return;
     }
-    m_audioInput = new QAudioInput(audioDevice, format, this);
     
-    // 准备音频缓冲区
-    m_audioData.clear();
-    m_audioBuffer->setBuffer(&m_audioData);
-    m_audioBuffer->open(QIODevice::WriteOnly);
+    // 准备音频缓冲区：超过内存上限的部分写入临时文件
+    m_captureStore->open(QIODevice::WriteOnly);
     
-    // 开始录音
-    m_audioInput->start(m_audioBuffer);
+    // 内置引擎：录音过程中定时把新音频送入分块识别；识别服务：定时在停顿处切出分段先行识别
+    if (m_engine->beginStream(commandGrammar(requestId)) || beginSpeculation(requestId)) {
+        m_audioSource->setNotifyInterval(STREAM_NOTIFY_INTERVAL);
+        connect(m_audioSource, &AudioSource::notify, this, &VoiceRecognitionManager::onAudioNotify);
+    }
     
-    if (m_audioInput->state() != QAudio::ActiveState) {
+    // 开始录音
+    if (!m_audioSource->start(m_captureStore)) {
+        delete m_audioSource;
+        m_audioSource = nullptr;
+        discardRequestMetrics(requestId);
         emit recognitionError("无法启动音频录制");
         return;
     }
+    stampRequest(requestId, RequestMetrics::CaptureStarted);
     
-    qDebug() << "🎤 录音已开始，音频格式:" << format;
+    qCDebug(lcCapture) << "🎤 录音已开始，来源:" << m_audioSource->description() << "音频格式:" << m_audioSource->format();
 }
 
 void VoiceRecognitionManager::stopRecording()
 {
-    qDebug() << "🎤 停止录音";
+    const qint64 keyUpAt = RequestMetrics::now();
+    if (postToManagerThread([this, keyUpAt]() { stopRecordingAt(keyUpAt); })) {
+        return;
+    }
+    stopRecordingAt(keyUpAt);
+}
+
+void VoiceRecognitionManager::stopRecordingAt(qint64 keyUpAt)
+{
+    TraceSpan span("manager", "stopRecording", m_currentRequestId);
+    qCDebug(lcManager) << "🎤 停止录音";
+    stampRequest(m_currentRequestId, RequestMetrics::KeyUp, keyUpAt);
+    SessionRecorder::event(SessionRecorder::KeyUp, m_currentRequestId);
+    m_handsFree->endRecording();
     
-    if (m_audioInput) {
-        m_audioInput->stop();
-        m_audioBuffer->close();
+    if (m_audioSource) {
+        m_audioSource->stop();
+        finishCaptureHealth(m_audioSource);
         
-        delete m_audioInput;
-        m_audioInput = nullptr;
+        delete m_audioSource;
+        m_audioSource = nullptr;
     }
     
-    if (m_audioData.isEmpty()) {
+    m_captureStore->close();
+    stampRequest(m_currentRequestId, RequestMetrics::CaptureClosed);
+    
+    if (m_captureStore->bytesCaptured() == 0) {
         emit recognitionError("未录制到音频数据");
+        completeRequestMetrics(m_currentRequestId, "未录制到音频数据");
         return;
     }
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        auto metrics = m_requestMetrics.find(m_currentRequestId);
+        if (metrics != m_requestMetrics.end()) {
+            // 第一块数据到达的时间由录音存储记下，录音过程中不经过管理器
+            metrics->audioBytes = m_captureStore->bytesCaptured();
+            metrics->stamps[RequestMetrics::FirstAudio] = m_captureStore->firstWriteTime();
+        }
+    }
+    if (m_captureStore->spilledBytes() > 0) {
+        qCDebug(lcCapture) << "🎤 录音时长(s):" << m_captureStore->bytesCaptured() / 32000
+                           << "其中写入临时文件(MB):" << m_captureStore->spilledBytes() / (1024 * 1024);
+    }
     
     emit statusChanged("识别中...");
     
-    // 发送识别请求
-    sendRecognitionRequest(m_audioData);
+    if (m_engine->isStreamActive()) {
+        m_engine->finishStream(m_captureStore, m_currentRequestId);
+        return;
+    }
+    
+    // 录音期间已有分段送去识别服务：只上传最后一段，与已返回的分段拼接
+    if (finishSpeculation()) {
+        return;
+    }
+    
+    // 引擎仍在后台加载或预热时先保留音频，就绪后自动识别
+    if (m_engine->submit(m_currentRequestId, m_captureStore->toByteArray(), InferenceScheduler::Interactive,
+                         commandGrammar(m_currentRequestId))) {
+        if (m_engine->isLoading()) {
+            emit statusChanged("语音引擎预热中，就绪后自动识别...");
+        }
+        return;
+    }
+    
+    // 发送识别请求：请求体直接读取录音存储，不再在内存中拼出完整的WAV
+    sendRecognitionRequest(m_captureStore, m_currentRequestId);
 }
 
 void VoiceRecognitionManager::cancelRecording()
 {
-    qDebug() << "🎤 取消录音";
+    if (postToManagerThread([this]() { cancelRecording(); })) {
+        return;
+    }
+
+    TraceSpan span("manager", "cancelRecording", m_currentRequestId);
+    qCDebug(lcManager) << "🎤 取消录音";
+    SessionRecorder::event(SessionRecorder::Cancel, m_currentRequestId);
+    m_handsFree->endRecording();
     
-    if (m_audioInput) {
-        m_audioInput->stop();
-        m_audioBuffer->close();
-        delete m_audioInput;
-        m_audioInput = nullptr;
+    if (m_audioSource) {
+        m_audioSource->stop();
+        finishCaptureHealth(m_audioSource);
+        delete m_audioSource;
+        m_audioSource = nullptr;
     }
     
+    m_captureStore->close();
+    m_captureStore->clear();
+    discardRequestMetrics(m_currentRequestId);
+    
+    // 已提交的分段返回后找不到会话，直接丢弃
+    m_prefixSegmenter.reset();
+    m_prefixSessions.remove(m_currentRequestId);
+    
+    m_engine->cancelStream();
+    m_engine->cancel(m_currentRequestId);
+    
     // 取消网络请求
     m_networkManager->clearAccessCache();
     
     emit statusChanged("语音输入已取消");
 }
 
+void VoiceRecognitionManager::recognizeAudio(const QByteArray &pcmData, const QString &requestId)
+{
+    if (postToManagerThread([this, pcmData, requestId]() { recognizeAudio(pcmData, requestId); })) {
+        return;
+    }
+
+    TraceSpan span("manager", "recognizeAudio", requestId);
+    qCDebug(lcManager) << "🎤 识别音频，请求ID:" << requestId << "数据大小:" << pcmData.size();
+    beginRequestMetrics(requestId, RequestMetrics::Submitted, RequestMetrics::now(), pcmData.size());
+    SessionRecorder::submit(requestId, pcmData);
+    
+    if (pcmData.isEmpty()) {
+        emit recognitionError("未录制到音频数据");
+        completeRequestMetrics(requestId, "未录制到音频数据");
+        return;
+    }
+    
+    if (m_engine->submit(requestId, pcmData, InferenceScheduler::Batch, commandGrammar(requestId))) {
+        return;
+    }
+    
+    sendRecognitionRequest(pcmData, requestId);
+}
+
 QAudioFormat VoiceRecognitionManager::setupAudioFormat()
 {
     QAudioFormat format;
@@ -164,54 +530,138 @@ QAudioFormat VoiceRecognitionManager::setupAudioFormat()
     return format;
 }
 
-void VoiceRecognitionManager::sendRecognitionRequest(const QByteArray &audioData)
+AudioSource *VoiceRecognitionManager::createAudioSource(bool allowNearest, QString *error)
 {
-    qDebug() << "🎤 发送识别请求，音频数据大小:" << audioData.size();
+    AudioSource *source = AudioSource::create(m_audioSourceSpec, setupAudioFormat(), nullptr, error);
+    if (source && !source->prepare(allowNearest, error)) {
+        delete source;
+        return nullptr;
+    }
+    if (source) {
+        if (m_captureBufferMs > 0) {
+            source->setBufferSize(source->format().bytesForDuration(m_captureBufferMs * 1000LL));
+        }
+        connect(source, &AudioSource::captureGap, this, &VoiceRecognitionManager::onCaptureGap);
+    }
+    return source;
+}
+
+void VoiceRecognitionManager::onCaptureGap(qint64 lostUs)
+{
+    PipelineTrace::instant("capture", "gap");
+    qCWarning(lcCapture) << "🎤 采集出现空洞，丢失音频(ms):" << lostUs / 1000.0 << "采集线程没有及时取走数据";
+}
+
+void VoiceRecognitionManager::finishCaptureHealth(AudioSource *source)
+{
+    const CaptureHealth &health = source->health();
+    if (health.callbacks == 0) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        m_captureHealth.merge(health);
+    }
+    qCDebug(lcCapture) << "🎤 采集健康，回调:" << health.callbacks
+                       << "周期p99(ms):" << health.period.percentileNs(99) / 1e6
+                       << "抖动p99(ms):" << health.jitter.percentileNs(99) / 1e6
+                       << "最大水位(%):" << health.maxFillPercent << "最大偏差(ms):" << health.maxDriftUs / 1000.0;
+    if (!health.fallingBehind()) {
+        return;
+    }
     
-    // 将PCM数据转换为WAV格式
-    QByteArray wavData = createWavHeader(audioData) + audioData;
+    // 缓冲区大小只能在启动设备前设置：加倍后从下一路采集开始生效
+    int currentMs = m_captureBufferMs;
+    if (currentMs <= 0) {
+        currentMs = static_cast<int>(source->format().durationForBytes(health.bufferBytes) / 1000);
+    }
+    if (currentMs > 0 && currentMs < MAX_CAPTURE_BUFFER_MS) {
+        m_captureBufferMs = qMin(currentMs * 2, static_cast<int>(MAX_CAPTURE_BUFFER_MS));
+        qCWarning(lcCapture) << "🎤 采集线程没跟上，空洞:" << health.gaps << "丢失(ms):" << health.lostUs / 1000
+                             << "高水位回调:" << health.highFillCallbacks << "设备错误:" << health.errors
+                             << "，麦克风缓冲区" << currentMs << "ms →" << m_captureBufferMs << "ms";
+    } else {
+        qCWarning(lcCapture) << "🎤 采集线程没跟上，空洞:" << health.gaps << "丢失(ms):" << health.lostUs / 1000
+                             << "高水位回调:" << health.highFillCallbacks << "设备错误:" << health.errors;
+    }
+}
+
+bool VoiceRecognitionManager::setAudioSource(const QString &spec)
+{
+    // 先试建一次，文件不存在等错误在设置时就报出
+    QString error;
+    QScopedPointer<AudioSource> source(AudioSource::create(spec, setupAudioFormat(), nullptr, &error));
+    if (!source) {
+        qCWarning(lcCapture) << "🎤 录音来源无效:" << error;
+        return false;
+    }
+    qCInfo(lcCapture) << "🎤 录音来源:" << source->description();
+    if (!postToManagerThread([this, spec]() { m_audioSourceSpec = spec; })) {
+        m_audioSourceSpec = spec;
+    }
+    return true;
+}
+
+void VoiceRecognitionManager::sendRecognitionRequest(const QByteArray &audioData, const QString &requestId)
+{
+    TraceSpan span("network", "encode", requestId);
+    qCDebug(lcNetwork) << "🎤 发送识别请求，音频数据大小:" << audioData.size();
     
-    // 创建多部分表单数据
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    // 将PCM数据转换为WAV格式
+    QByteArray wavData = RecognitionProtocol::createWavHeader(audioData.size()) + audioData;
     
     // 添加音频文件部分
     QHttpPart audioPart;
-    audioPart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
-    audioPart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                       QVariant("form-data; name=\"files\"; filename=\"audio.wav\""));
     audioPart.setBody(wavData);
-    multiPart->append(audioPart);
-    
-    // 添加语言参数
-    QHttpPart languagePart;
-    languagePart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                          QVariant("form-data; name=\"lang\""));
-    languagePart.setBody("auto");
-    multiPart->append(languagePart);
-    
-    // 添加keys参数
-    QHttpPart keysPart;
-    keysPart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                      QVariant("form-data; name=\"keys\""));
-    keysPart.setBody("audio_input");
-    multiPart->append(keysPart);
-    
-    // 创建请求
-    QNetworkRequest request(QUrl(m_serviceUrl + "/api/v1/asr"));
-    request.setRawHeader("User-Agent", "VoiceRecognitionManager");
+    postRecognitionRequest(audioPart, nullptr, requestId);
+}
+
+void VoiceRecognitionManager::sendRecognitionRequest(const CaptureStore *store, const QString &requestId)
+{
+    TraceSpan span("network", "encode", requestId);
+    qCDebug(lcNetwork) << "🎤 发送识别请求，音频数据大小:" << store->bytesCaptured()
+                       << "其中临时文件:" << store->spilledBytes();
+    
+    // 请求体按WAV头、临时文件、内存窗口的顺序流式读取
+    QIODevice *body = store->createReader(RecognitionProtocol::createWavHeader(store->bytesCaptured()));
+    QHttpPart audioPart;
+    audioPart.setBodyDevice(body);
+    postRecognitionRequest(audioPart, body, requestId);
+}
+
+void VoiceRecognitionManager::postRecognitionRequest(QHttpPart audioPart, QIODevice *body, const QString &requestId)
+{
+    // 创建多部分表单数据（音频、语言、keys）和请求
+    QHttpMultiPart *multiPart = RecognitionProtocol::createMultiPart(audioPart, body);
+    QNetworkRequest request = RecognitionProtocol::createRequest(m_serviceUrl);
     
     // 发送POST请求
     QNetworkReply *reply = m_networkManager->post(request, multiPart);
     multiPart->setParent(reply);
+    stampRequest(requestId, RequestMetrics::RequestSent);
+    SessionRecorder::request(requestId, m_serviceUrl);
+    if (PipelineTrace::isEnabled()) {
+        reply->setProperty("traceSentNs", RequestMetrics::now());
+    }
+    if (isRequestTracked(requestId)) {
+        connect(reply, &QNetworkReply::uploadProgress, this, [this, requestId](qint64 sent, qint64 total) {
+            if (total > 0 && sent == total) {
+                stampRequest(requestId, RequestMetrics::UploadDone);
+            }
+        });
+        connect(reply, &QNetworkReply::readyRead, this, [this, requestId]() {
+            stampRequest(requestId, RequestMetrics::FirstResponseByte);
+        });
+    }
     
     // 设置超时
     QTimer *timeoutTimer = new QTimer(this);
     timeoutTimer->setSingleShot(true);
     timeoutTimer->setInterval(RECOGNITION_TIMEOUT);
     
-    connect(timeoutTimer, &QTimer::timeout, [reply, this]() {
+    connect(timeoutTimer, &QTimer::timeout, [reply, this, requestId]() {
         reply->abort();
-        emit recognitionError("识别超时，请重试");
+        reportRecognitionError("识别超时，请重试", requestId);
     });
     
     connect(reply, &QNetworkReply::finished, this, [this, reply, timeoutTimer]() {
@@ -222,6 +672,7 @@ void VoiceRecognitionManager::sendRecognitionRequest(const QByteArray &audioData
     
     // 存储reply引用，供finished槽函数使用
     reply->setProperty("voiceReply", true);
+    reply->setProperty("requestId", requestId);
     
     timeoutTimer->start();
 }
@@ -242,132 +693,641 @@ void VoiceRecognitionManager::onRecognitionReplyFinished()
     }
     
     if (!reply) {
-        qDebug() << "🎤 错误：无法获取网络响应对象";
+        qCWarning(lcNetwork) << "🎤 错误：无法获取网络响应对象";
         emit recognitionError("网络响应错误");
         return;
     }
     
     // 获取HTTP状态码
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    qDebug() << "🎤 HTTP状态码:" << statusCode;
+    qCTrace(lcNetwork) << "🎤 HTTP状态码:" << statusCode;
     
     // 读取响应数据
     QByteArray responseData = reply->readAll();
-    qDebug() << "🎤 响应数据:" << responseData;
+    QString requestId = reply->property("requestId").toString();
+    stampRequest(requestId, RequestMetrics::ResponseReceived);
+    SessionRecorder::response(requestId, statusCode, reply->rawHeader("Server-Timing"), responseData);
+    traceReply(reply, requestId);
+    TraceSpan span("network", "parse", requestId);
+    qCTrace(lcNetwork) << "🎤 响应数据:" << responseData;
     
     // 确保reply被正确删除
     reply->deleteLater();
     
     // 检查网络错误
     if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "🎤 网络错误:" << reply->error() << reply->errorString();
-        emit recognitionError("识别失败: " + reply->errorString());
+        qCWarning(lcNetwork) << "🎤 网络错误:" << reply->error() << reply->errorString();
+        reportRecognitionError("识别失败: " + reply->errorString(), requestId);
         return;
     }
     
     // 检查HTTP状态码
     if (statusCode != 200) {
-        qDebug() << "🎤 HTTP错误，状态码:" << statusCode;
-        emit recognitionError("服务器错误: HTTP " + QString::number(statusCode));
+        qCWarning(lcNetwork) << "🎤 HTTP错误，状态码:" << statusCode;
+        reportRecognitionError("服务器错误: HTTP " + QString::number(statusCode), requestId);
         return;
     }
     
-    // 检查响应数据是否为空
-    if (responseData.isEmpty()) {
-        qDebug() << "🎤 空响应数据";
-        emit recognitionError("服务器返回空数据");
+    // 解析JSON响应
+    RecognitionProtocol::Result result;
+    QString parseError;
+    if (!RecognitionProtocol::parseResponse(responseData, &result, &parseError)) {
+        qCWarning(lcNetwork) << "🎤 响应无效:" << parseError;
+        reportRecognitionError(parseError, requestId);
         return;
     }
     
-    // 解析JSON响应
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
+    qCTrace(lcNetwork) << "🎤 =========== 识别管理器解析结果 ===========";
+    qCTrace(lcNetwork) << "🎤 🔤 原始文本:" << result.rawText;
+    qCTrace(lcNetwork) << "🎤 🧹 清理文本:" << result.cleanText;
+    qCTrace(lcNetwork) << "🎤 ✨ 最终文本:" << result.text;
+    qCTrace(lcNetwork) << "🎤 =============================================";
+    
+    deliverText(result.text, requestId);
+}
+
+void VoiceRecognitionManager::onAudioNotify()
+{
+    m_engine->feedStream(m_captureStore);
+    feedSpeculation();
+}
+
+void VoiceRecognitionManager::onMonitorAudio(const QByteArray &chunk)
+{
+    if (m_dictation->isListeningToMonitor()) {
+        m_dictation->feed(chunk);
+    }
+    
+    if (m_handsFree->isRecording()) {
+        m_captureStore->write(chunk);
+        if (m_engine->isStreamActive() || m_prefixSegmenter) {
+            onAudioNotify();
+        }
+    }
+}
+
+void VoiceRecognitionManager::onWakeWordSpotted()
+{
+    if (isDictating()) {
+        return;
+    }
+    m_handsFree->armRecording();
+    emit statusChanged("已唤醒，请说话...");
+    emit wakeWordDetected();
+}
+
+int VoiceRecognitionManager::setWakeWordTemplates(const QList<QByteArray> &samples, double threshold)
+{
+    KeywordSpotter::Options options;
+    if (threshold > 0.0) {
+        options.threshold = static_cast<float>(threshold);
+    }
+    QSharedPointer<KeywordSpotter> spotter(new KeywordSpotter(options));
+    for (const QByteArray &pcm : samples) {
+        if (!spotter->addTemplate(reinterpret_cast<const qint16*>(pcm.constData()), pcm.size() / 2)) {
+            qCWarning(lcWake) << "🎤 唤醒词模板无效（裁掉首尾静音后须为0.24~2秒），已忽略";
+        }
+    }
+    const int templateCount = spotter->templateCount();
+    qCInfo(lcWake) << "🎤 唤醒词模板:" << templateCount << "阈值:" << spotter->options().threshold;
+    
+    // 模板提取在调用线程完成，监听中的检测器只在管理器线程中替换
+    if (!postToManagerThread([this, spotter]() { adoptWakeSpotter(spotter); })) {
+        adoptWakeSpotter(spotter);
+    }
+    return templateCount;
+}
+
+void VoiceRecognitionManager::adoptWakeSpotter(const QSharedPointer<KeywordSpotter> &spotter)
+{
+    m_handsFree->setSpotter(spotter);
     
-    if (parseError.error != QJsonParseError::NoError) {
-        qDebug() << "🎤 JSON解析错误:" << parseError.errorString();
-        emit recognitionError("响应解析失败: " + parseError.errorString());
+    if (m_handsFree->templateCount() == 0 && m_handsFree->isEnabled()) {
+        setHandsFreeEnabled(false);
+    }
+}
+
+int VoiceRecognitionManager::loadWakeWordTemplates(const QStringList &wavFiles, double threshold)
+{
+    QList<QByteArray> samples;
+    for (const QString &path : wavFiles) {
+        QByteArray pcm;
+        QString error;
+        if (!AudioSource::readWavFile(path.trimmed(), &pcm, &error)) {
+            qCWarning(lcWake) << "🎤 读取唤醒词模板失败:" << error;
+            continue;
+        }
+        samples.append(pcm);
+    }
+    return setWakeWordTemplates(samples, threshold);
+}
+
+void VoiceRecognitionManager::setHandsFreeEnabled(bool enabled)
+{
+    if (postToManagerThread([this, enabled]() { setHandsFreeEnabled(enabled); })) {
         return;
     }
     
-    QJsonObject obj = doc.object();
-    QString recognizedText;
+    if (!enabled) {
+        if (m_handsFree->isEnabled()) {
+            if (m_handsFree->isRecording()) {
+                cancelRecording();
+            }
+            m_handsFree->stop();
+        }
+        emit handsFreeChanged(false);
+        return;
+    }
     
-    qDebug() << "🎤 =========== 识别管理器解析结果 ===========";
-    qDebug() << "🎤 JSON键:" << obj.keys();
+    if (m_handsFree->isEnabled()) {
+        emit handsFreeChanged(true);
+        return;
+    }
+    if (m_handsFree->templateCount() == 0) {
+        qCWarning(lcWake) << "🎤 没有唤醒词模板，无法开启免按键模式";
+        emit handsFreeChanged(false);
+        return;
+    }
     
-    // 解析识别结果
-    if (obj.contains("result")) {
-        QJsonArray resultArray = obj["result"].toArray();
-        qDebug() << "🎤 结果数组大小:" << resultArray.size();
-        
-        if (!resultArray.isEmpty()) {
-            QJsonObject firstResult = resultArray[0].toObject();
-            qDebug() << "🎤 第一个结果的键:" << firstResult.keys();
-            
-            QString rawText = firstResult["raw_text"].toString();
-            QString cleanText = firstResult["clean_text"].toString();
-            QString finalText = firstResult["text"].toString();
-            
-            qDebug() << "🎤 🔤 原始文本:" << rawText;
-            qDebug() << "🎤 🧹 清理文本:" << cleanText;
-            qDebug() << "🎤 ✨ 最终文本:" << finalText;
-            
-            recognizedText = finalText;
+    // 检测器按16kHz单声道工作，不接受近似格式
+    QString error;
+    AudioSource *source = createAudioSource(false, &error);
+    if (!source) {
+        qCWarning(lcWake) << "🎤" << error << "，无法开启免按键模式";
+        emit handsFreeChanged(false);
+        return;
+    }
+    emit handsFreeChanged(m_handsFree->start(source));
+}
+
+double VoiceRecognitionManager::wakeWordCpuLoad() const
+{
+    return m_handsFree->cpuLoad();
+}
+
+void VoiceRecognitionManager::startDictation(const QString &requestId)
+{
+    if (postToManagerThread([this, requestId]() { startDictation(requestId); })) {
+        return;
+    }
+    
+    if (isDictating() || m_audioSource || m_handsFree->isRecording()) {
+        qCWarning(lcDictation) << "🎤 正在录音或听写，不能开始听写";
+        emit statusChanged("正在录音或听写，不能开始听写");
+        if (requestId != m_dictation->requestId()) {
+            emit dictationFinished(requestId);
         }
+        return;
     }
     
-    qDebug() << "🎤 =============================================";
+    // 免按键模式下麦克风已在监听，直接取监听流；否则单独打开一路录音
+    AudioSource *source = nullptr;
+    if (!m_handsFree->isEnabled()) {
+        QString error;
+        source = createAudioSource(false, &error);
+        if (!source) {
+            emit statusChanged(error + "，无法听写");
+            emit dictationFinished(requestId);
+            return;
+        }
+    }
+    m_dictation->start(requestId, source);
+}
+
+void VoiceRecognitionManager::stopDictation()
+{
+    if (postToManagerThread([this]() { stopDictation(); })) {
+        return;
+    }
+    m_dictation->stop();
+}
+
+void VoiceRecognitionManager::cancelDictation()
+{
+    if (postToManagerThread([this]() { cancelDictation(); })) {
+        return;
+    }
+    m_dictation->cancel();
+}
+
+void VoiceRecognitionManager::onDictationSegmentReady(const QString &segmentId, const QByteArray &pcm)
+{
+    if (!m_engine->submit(segmentId, pcm, InferenceScheduler::Interactive)) {
+        sendRecognitionRequest(pcm, segmentId);
+    }
+}
+
+void VoiceRecognitionManager::reportRecognitionError(const QString &error, const QString &requestId)
+{
+    if (DictationPipeline::isSegmentId(requestId)) {
+        m_dictation->failSegment(requestId, error);
+        return;
+    }
+    if (requestId.contains(PREFIX_SEGMENT_TAG)) {
+        qCWarning(lcDictation) << "🎤 投机识别分段失败:" << requestId << error;
+        deliverPrefixSegment(requestId, QString(), error);
+        return;
+    }
+    emit recognitionError(error);
+    completeRequestMetrics(requestId, error);
+}
+
+bool VoiceRecognitionManager::beginSpeculation(const QString &requestId)
+{
+    m_prefixSegmenter.reset();
+    if (m_speculativeIntervalMs <= 0 || m_engine->isEnabled() || m_engine->isLoading()
+            || m_commandVocabularies.contains(requestId)) {
+        return false;
+    }
+    
+    PrefixSegmenter::Options options;
+    options.intervalMs = m_speculativeIntervalMs;
+    options.maxIntervalMs = 2 * m_speculativeIntervalMs;
+    m_prefixSegmenter.reset(new PrefixSegmenter(options));
+    m_prefixScannedBytes = 0;
+    m_prefixCutBytes = 0;
+    
+    // 同一控件上一次录音的分段结果随之作废
+    PrefixSession session;
+    session.generation = ++m_prefixGeneration;
+    m_prefixSessions.insert(requestId, session);
+    return true;
+}
+
+void VoiceRecognitionManager::feedSpeculation()
+{
+    if (!m_prefixSegmenter) {
+        return;
+    }
+    
+    const int available = static_cast<int>(m_captureStore->bytesCaptured() - m_prefixScannedBytes) & ~1;
+    if (available <= 0) {
+        return;
+    }
+    m_prefixChunk.resize(available);
+    if (!m_captureStore->readAt(m_prefixScannedBytes, m_prefixChunk.data(), available)) {
+        return;
+    }
+    m_prefixSegmenter->acceptWaveform(reinterpret_cast<const qint16*>(m_prefixChunk.constData()), available / 2);
+    m_prefixScannedBytes += available;
+    
+    int64_t cutSample = 0;
+    while (m_prefixSegmenter->takeCut(cutSample)) {
+        submitPrefixSegment(cutSample * 2);
+    }
+}
+
+void VoiceRecognitionManager::submitPrefixSegment(qint64 endBytes)
+{
+    auto it = m_prefixSessions.find(m_currentRequestId);
+    const qint64 length = endBytes - m_prefixCutBytes;
+    if (it == m_prefixSessions.end() || !it->error.isEmpty() || length <= 0) {
+        return;             // 已有分段失败：松键后整段上传，不再提交分段
+    }
+    QByteArray pcm(static_cast<int>(length), Qt::Uninitialized);
+    if (!m_captureStore->readAt(m_prefixCutBytes, pcm.data(), length)) {
+        return;
+    }
+    
+    const int index = it->submitted++;
+    const QString segmentId = m_currentRequestId + PREFIX_SEGMENT_TAG + QString::number(it->generation)
+                              + '-' + QString::number(index);
+    qCDebug(lcDictation) << "🎤 投机识别分段" << index << "起点(s):" << m_prefixCutBytes / 32000.0 << "时长(ms):" << length / 32;
+    m_prefixCutBytes = endBytes;
+    sendRecognitionRequest(pcm, segmentId);
+}
+
+bool VoiceRecognitionManager::finishSpeculation()
+{
+    if (!m_prefixSegmenter) {
+        return false;
+    }
+    m_prefixSegmenter.reset();
+    
+    auto it = m_prefixSessions.find(m_currentRequestId);
+    if (it == m_prefixSessions.end()) {
+        return false;
+    }
+    if (it->submitted == 0 || !it->error.isEmpty()) {
+        // 短句：整段上传与原来相同；录音期间已有分段失败：同样整段上传，仍在途的分段返回后丢弃
+        if (!it->error.isEmpty()) {
+            qCWarning(lcDictation) << "🎤 投机识别分段失败，改为整段上传:" << it->error;
+        }
+        m_prefixSessions.erase(it);
+        return false;
+    }
+    
+    it->releaseClock.start();
+    const qint64 totalBytes = m_captureStore->bytesCaptured() & ~1;
+    qCDebug(lcDictation) << "🎤 投机识别：松键后只识别最后一段(ms):" << (totalBytes - m_prefixCutBytes) / 32
+                         << "录音总长(ms):" << totalBytes / 32;
+    submitPrefixSegment(totalBytes);
+    it->total = it->submitted;
+    completePrefixSession(m_currentRequestId);
+    return true;
+}
+
+void VoiceRecognitionManager::deliverPrefixSegment(const QString &segmentId, const QString &text,
+                                                   const QString &error)
+{
+    // 解析"<控件ID>#prefix-<录音编号>-<序号>"；取消或被新录音替换后才返回的分段直接丢弃
+    const int tag = segmentId.lastIndexOf(PREFIX_SEGMENT_TAG);
+    const QString requestId = segmentId.left(tag);
+    const QStringList numbers = segmentId.mid(tag + PREFIX_SEGMENT_TAG.size()).split('-');
+    auto it = m_prefixSessions.find(requestId);
+    if (it == m_prefixSessions.end() || numbers.size() != 2 || numbers[0].toInt() != it->generation) {
+        return;
+    }
+    
+    it->results.insert(numbers[1].toInt(), text);
+    if (!error.isEmpty()) {
+        it->error = error;
+    }
+    completePrefixSession(requestId);
+}
+
+void VoiceRecognitionManager::completePrefixSession(const QString &requestId)
+{
+    auto it = m_prefixSessions.find(requestId);
+    if (it == m_prefixSessions.end() || it->total < 0) {
+        return;
+    }
     
-    if (recognizedText.isEmpty()) {
+    // 松键后有分段失败：不等其余分段，整段录音作为一个普通请求重新上传，结果和错误按整句处理
+    if (!it->error.isEmpty()) {
+        const PrefixSession session = it.value();
+        m_prefixSessions.erase(it);
+        qCWarning(lcDictation) << "🎤 投机识别分段失败，改为整段上传:" << session.error;
+        if (!session.pcm.isEmpty()) {
+            sendRecognitionRequest(session.pcm, requestId);
+        } else {
+            sendRecognitionRequest(m_captureStore, requestId);
+        }
+        return;
+    }
+    if (it->results.size() < it->total) {
+        return;
+    }
+    const PrefixSession session = it.value();
+    m_prefixSessions.erase(it);
+    stampRequest(requestId, RequestMetrics::ResponseReceived);
+
+    QString text;
+    for (const QString &segmentText : session.results) {
+        text = joinSegmentText(text, segmentText);
+    }
+    qCInfo(lcDictation) << "🎤 投机识别完成，分段数:" << session.total << "松键到出字耗时(ms):" << session.releaseClock.elapsed();
+    deliverText(text, requestId);
+}
+
+void VoiceRecognitionManager::onSchedulerRequestFinished(const QString &requestId, const QString &text)
+{
+    stampRequest(requestId, RequestMetrics::ResponseReceived);
+    deliverText(text, requestId);
+}
+
+void VoiceRecognitionManager::onSchedulerCommandFinished(const QString &requestId, const QString &phrase,
+                                                         double confidence)
+{
+    stampRequest(requestId, RequestMetrics::ResponseReceived);
+    emitCommandResult(phrase, confidence, requestId);
+}
+
+void VoiceRecognitionManager::setCommandVocabulary(const QString &requestId, const QStringList &phrases,
+                                                   double minConfidence)
+{
+    if (postToManagerThread([this, requestId, phrases, minConfidence]() {
+            setCommandVocabulary(requestId, phrases, minConfidence);
+        })) {
+        return;
+    }
+    if (phrases.isEmpty()) {
+        m_commandVocabularies.remove(requestId);
+        qCDebug(lcEngine) << "🎤 恢复自由识别，请求ID:" << requestId;
+        return;
+    }
+
+    CommandVocabulary vocabulary;
+    vocabulary.patterns = phrases;
+    vocabulary.minConfidence = minConfidence;
+    for (const QString &pattern : phrases) {
+        QString error;
+        const QStringList expanded = CommandGrammar::expand(pattern, &error);
+        if (expanded.isEmpty()) {
+            qCWarning(lcEngine) << "🎤 忽略短语:" << error;
+        }
+        vocabulary.phrases += expanded;
+    }
+    vocabulary.grammar = m_engine->compileGrammar(phrases);
+    m_commandVocabularies.insert(requestId, vocabulary);
+    qCDebug(lcEngine) << "🎤 设置可选短语，请求ID:" << requestId << "短语数:" << vocabulary.phrases.size();
+}
+
+QSharedPointer<const CommandGrammar> VoiceRecognitionManager::commandGrammar(const QString &requestId) const
+{
+    return m_commandVocabularies.value(requestId).grammar;
+}
+
+void VoiceRecognitionManager::deliverText(const QString &text, const QString &requestId)
+{
+    // 听写分段：按分段顺序追加到控件，不走整句的结果处理
+    if (DictationPipeline::isSegmentId(requestId)) {
+        m_dictation->deliverSegment(requestId, text);
+        return;
+    }
+    if (requestId.contains(PREFIX_SEGMENT_TAG)) {
+        deliverPrefixSegment(requestId, text, QString());
+        return;
+    }
+    
+    auto it = m_commandVocabularies.constFind(requestId);
+    if (it == m_commandVocabularies.constEnd() || it->phrases.isEmpty() || text.isEmpty()) {
+        emitRecognitionResult(text, requestId);
+        return;
+    }
+    const CommandGrammar::Match match = CommandGrammar::matchText(it->phrases, text);
+    qCTrace(lcEngine) << "🎤 识别文本" << text << "对应到短语" << match.text;
+    emitCommandResult(match.text, match.confidence, requestId);
+}
+
+void VoiceRecognitionManager::emitCommandResult(const QString &phrase, double confidence, const QString &requestId)
+{
+    const double minConfidence = m_commandVocabularies.value(requestId).minConfidence;
+    if (phrase.isEmpty() || confidence < minConfidence) {
+        qCDebug(lcEngine) << "🎤 未匹配到可选项，最接近:" << phrase << "置信度:" << confidence;
+        stampRequest(requestId, RequestMetrics::ResultReady);
+        emit recognitionError("未匹配到可选项");
+        completeRequestMetrics(requestId, "未匹配到可选项");
+        return;
+    }
+    qCDebug(lcEngine) << "🎤 短语匹配:" << phrase << "置信度:" << confidence;
+    emit commandRecognized(phrase, confidence, requestId);
+    emitRecognitionResult(phrase, requestId);
+}
+
+void VoiceRecognitionManager::emitRecognitionResult(const QString &text, const QString &requestId)
+{
+    TraceSpan span("manager", "emitRecognitionResult", requestId);
+    if (!m_firstRecognitionDone) {
+        m_firstRecognitionDone = true;
+        markStartupPhase("first_recognition");
+        QStringList phases;
+        for (const QPair<QString, qint64> &phase : startupTimings()) {
+            phases << QString("%1=%2ms").arg(phase.first).arg(phase.second);
+        }
+        qCInfo(lcApp) << "⏱️ 启动耗时:" << phases.join(" ");
+    }
+    
+    stampRequest(requestId, RequestMetrics::ResultReady);
+    SessionRecorder::result(requestId, text);
+    if (text.isEmpty()) {
         emit recognitionError("未识别到有效内容");
+        completeRequestMetrics(requestId, "未识别到有效内容");
     } else {
-        qDebug() << "🎤 ✅ 识别成功，发送结果:" << recognizedText;
-        emit recognitionFinished(recognizedText, m_currentRequestId);
+        qCDebug(lcManager) << "🎤 ✅ 识别成功，发送结果:" << text;
+        emit recognitionFinished(text, requestId);
         emit statusChanged("识别成功");
         
         // 3秒后清除状态消息
         QTimer::singleShot(3000, [this]() {
             emit statusChanged("");
         });
+        awaitTextInserted(requestId);
     }
 }
 
-QByteArray VoiceRecognitionManager::createWavHeader(const QByteArray &pcmData)
+void VoiceRecognitionManager::beginRequestMetrics(const QString &requestId, RequestMetrics::Stamp point,
+                                                  qint64 at, qint64 audioBytes)
 {
-    QByteArray header;
-    
-    // WAV文件参数
-    quint32 sampleRate = 16000;
-    quint16 channels = 1;
-    quint16 bitsPerSample = 16;
-    quint32 dataSize = pcmData.size();
-    quint32 fileSize = 36 + dataSize;
-    
-    // RIFF头
-    header.append("RIFF");
-    header.append(reinterpret_cast<const char*>(&fileSize), 4);
-    header.append("WAVE");
-    
-    // fmt子块
-    header.append("fmt ");
-    quint32 fmtSize = 16;
-    header.append(reinterpret_cast<const char*>(&fmtSize), 4);
+    RequestMetrics metrics;
+    metrics.requestId = requestId;
+    metrics.audioBytes = audioBytes;
+    metrics.stamps[point] = at;
     
-    quint16 audioFormat = 1; // PCM
-    header.append(reinterpret_cast<const char*>(&audioFormat), 2);
-    header.append(reinterpret_cast<const char*>(&channels), 2);
-    header.append(reinterpret_cast<const char*>(&sampleRate), 4);
-    
-    quint32 byteRate = sampleRate * channels * bitsPerSample / 8;
-    header.append(reinterpret_cast<const char*>(&byteRate), 4);
-    
-    quint16 blockAlign = channels * bitsPerSample / 8;
-    header.append(reinterpret_cast<const char*>(&blockAlign), 2);
-    header.append(reinterpret_cast<const char*>(&bitsPerSample), 2);
-    
-    // data子块
-    header.append("data");
-    header.append(reinterpret_cast<const char*>(&dataSize), 4);
+    // 同一控件的上一句已出字、仍在等待插入报告时，先不带TextInserted结束
+    RequestMetrics previous;
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        auto it = m_requestMetrics.find(requestId);
+        if (it != m_requestMetrics.end() && it->has(RequestMetrics::ResultReady)) {
+            previous = it.value();
+            m_requestStatistics.add(previous);
+        }
+        m_requestMetrics.insert(requestId, metrics);
+    }
+    if (!previous.requestId.isEmpty()) {
+        traceRequestStages(previous);
+        SessionRecorder::completed(previous);
+        emit requestCompleted(previous);
+    }
+}
+
+void VoiceRecognitionManager::discardRequestMetrics(const QString &requestId)
+{
+    QMutexLocker locker(&m_metricsMutex);
+    m_requestMetrics.remove(requestId);
+}
+
+void VoiceRecognitionManager::stampRequest(const QString &requestId, RequestMetrics::Stamp point, qint64 at)
+{
+    if (!at) {
+        at = RequestMetrics::now();
+    }
+    QMutexLocker locker(&m_metricsMutex);
+    auto it = m_requestMetrics.find(requestId);
+    if (it == m_requestMetrics.end() || it->has(point)) {
+        return;
+    }
+    it->stamps[point] = at;
+    if (point == RequestMetrics::ResponseReceived && !it->has(RequestMetrics::FirstResponseByte)) {
+        it->stamps[RequestMetrics::FirstResponseByte] = at;
+    }
+}
+
+bool VoiceRecognitionManager::isRequestTracked(const QString &requestId) const
+{
+    QMutexLocker locker(&m_metricsMutex);
+    return m_requestMetrics.contains(requestId);
+}
+
+void VoiceRecognitionManager::awaitTextInserted(const QString &requestId)
+{
+    qint64 readyAt = 0;
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        auto it = m_requestMetrics.constFind(requestId);
+        if (it == m_requestMetrics.constEnd()) {
+            return;
+        }
+        readyAt = it->stamps[RequestMetrics::ResultReady];
+    }
     
-    return header;
-} 
\ No newline at end of file
+    // 请求ID即控件ID，超时前可能已开始下一句：只结束同一次结果的记录
+    QTimer::singleShot(TEXT_INSERT_REPORT_TIMEOUT, this, [this, requestId, readyAt]() {
+        {
+            QMutexLocker locker(&m_metricsMutex);
+            auto it = m_requestMetrics.constFind(requestId);
+            if (it == m_requestMetrics.constEnd() || it->stamps[RequestMetrics::ResultReady] != readyAt) {
+                return;
+            }
+        }
+        completeRequestMetrics(requestId, QString());
+    });
+}
+
+void VoiceRecognitionManager::reportTextInserted(const QString &requestId)
+{
+    const qint64 insertedAt = RequestMetrics::now();
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        auto it = m_requestMetrics.find(requestId);
+        if (it == m_requestMetrics.end() || !it->has(RequestMetrics::ResultReady)) {
+            return;
+        }
+        it->stamps[RequestMetrics::TextInserted] = insertedAt;
+    }
+    completeRequestMetrics(requestId, QString());
+}
+
+void VoiceRecognitionManager::completeRequestMetrics(const QString &requestId, const QString &error)
+{
+    RequestMetrics metrics;
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        auto it = m_requestMetrics.find(requestId);
+        if (it == m_requestMetrics.end()) {
+            return;
+        }
+        metrics = it.value();
+        m_requestMetrics.erase(it);
+        metrics.error = error;
+        m_requestStatistics.add(metrics);
+    }
+    traceRequestStages(metrics);
+    SessionRecorder::completed(metrics);
+    emit requestCompleted(metrics);
+}
+
+RequestStatistics VoiceRecognitionManager::requestStatistics() const
+{
+    QMutexLocker locker(&m_metricsMutex);
+    return m_requestStatistics;
+}
+
+void VoiceRecognitionManager::resetRequestStatistics()
+{
+    QMutexLocker locker(&m_metricsMutex);
+    m_requestStatistics = RequestStatistics();
+}
+
+CaptureHealth VoiceRecognitionManager::captureHealth() const
+{
+    QMutexLocker locker(&m_metricsMutex);
+    return m_captureHealth;
+}
+
+void VoiceRecognitionManager::resetCaptureHealth()
+{
+    QMutexLocker locker(&m_metricsMutex);
+    m_captureHealth = CaptureHealth();
+}
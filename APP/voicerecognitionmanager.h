@@ -4,24 +4,65 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
-#include <QAudioInput>
-#include <QBuffer>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QAudioFormat>
-#include <QAudioDeviceInfo>
+#include <QScopedPointer>
+#include <QPair>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QMutex>
+#include "enginepipeline.h"
+#include "dictationpipeline.h"
+#include "handsfreepipeline.h"
+#include "prefixsegmenter.h"
+#include "capturestore.h"
+#include "audiosource.h"
+#include "capturehealth.h"
+#include "requestmetrics.h"
+
+class QHttpPart;
 
 /**
  * 函数名称：`VoiceRecognitionManager`
  * 功能描述：语音识别管理器，运行在独立线程中处理所有语音识别逻辑
  * 设计模式：单例模式，全局唯一实例
- * 线程安全：所有操作通过信号槽机制保证线程安全
+ * 设计特点：内置引擎、连续听写和免按键监听分别由EnginePipeline、DictationPipeline、HandsFreePipeline实现，
+ *           管理器负责按键录音、识别服务、投机识别、可选短语和请求计时，并在各流水线之间转发结果
+ * 线程安全：initialize()之后对象属于工作线程，三条流水线是它的子对象，随之移到同一线程；录音来源、录音数据、
+ *           引擎会话等状态只在该线程中访问。录音、识别等公开操作可在任意线程调用，不在管理器线程时排队过去，
+ *           按调用顺序执行；请求计时和采集统计由m_metricsMutex保护，结果通过信号返回
  */
 class VoiceRecognitionManager : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * 内置引擎状态
+     */
+    enum EngineState {
+        EngineOff = EnginePipeline::Off,            // 未启用内置引擎，使用识别服务
+        EngineLoading = EnginePipeline::Loading,    // 后台加载权重
+        EngineWarming = EnginePipeline::Warming,    // 后台预热推理
+        EngineReady = EnginePipeline::Ready,        // 可以识别
+        EngineFailed = EnginePipeline::Failed       // 加载失败，退回识别服务
+    };
+    Q_ENUM(EngineState)
+
+    /**
+     * 听写的中间结果
+     */
+    enum PartialMode {
+        PartialOff = DictationPipeline::PartialOff,         // 不出中间结果，每段说完才出字
+        PartialReplace = DictationPipeline::PartialReplace, // 每次重新识别后整段替换
+        PartialStable = DictationPipeline::PartialStable    // 按token时间戳提交稳定的前缀，只改写未定稿的尾部
+    };
+    Q_ENUM(PartialMode)
+
     /**
      * 函数名称：`instance`
      * 功能描述：获取单例实例
@@ -47,10 +88,264 @@ public:
      */
     void setServiceUrl(const QString &url);
 
+    /**
+     * 函数名称：`setEngineModel`
+     * 功能描述：启用内置推理引擎，设置后录音过程中即分块识别，不再请求Python服务
+     * 参数说明：
+     *     - modelFile：QString，export_native.py导出的权重文件，为空则恢复使用服务
+     *     - precision：QString，线性层精度：auto/fp32/int8
+     *     - kernels：QString，内核指令集：auto/generic/avx2/avx512/avx512vnni
+     * 返回值：bool，模型是否加载成功
+     */
+    bool setEngineModel(const QString &modelFile, const QString &precision = "auto",
+                        const QString &kernels = "auto");
+
+    /**
+     * 函数名称：`loadEngineAsync`
+     * 功能描述：在后台线程加载内置引擎并用合成音频预热，立即返回；状态通过engineStateChanged通知。
+     *           加载/预热期间可以正常录音，松键后的请求在引擎就绪时自动识别（失败则交给识别服务）
+     * 参数说明：
+     *     - modelFile：QString，export_native.py导出的权重文件
+     *     - precision：QString，线性层精度：auto/fp32/int8
+     *     - kernels：QString，内核指令集：auto/generic/avx2/avx512/avx512vnni
+     * 返回值：void
+     */
+    void loadEngineAsync(const QString &modelFile, const QString &precision = "auto",
+                         const QString &kernels = "auto");
+
+    /**
+     * 函数名称：`engineState`
+     * 功能描述：内置引擎当前状态（在管理器线程中更新，其他线程应以engineStateChanged为准）
+     */
+    EngineState engineState() const { return static_cast<EngineState>(m_engine->state()); }
+
+    /**
+     * 函数名称：`markStartupPhase`
+     * 功能描述：记录启动阶段时间点，首次调用（main开始处）为计时起点；首次出字时输出各阶段耗时
+     * 参数说明：
+     *     - phase：QString，阶段名称
+     * 返回值：void
+     * 线程安全：可在任意线程调用
+     */
+    static void markStartupPhase(const QString &phase);
+
+    /**
+     * 函数名称：`startupTimings`
+     * 功能描述：已记录的启动阶段及其距起点的毫秒数
+     */
+    static QVector<QPair<QString, qint64>> startupTimings();
+
+    /**
+     * 函数名称：`requestStatistics`
+     * 功能描述：启动（或上次重置）以来已结束请求的汇总：各阶段和total的耗时直方图（可查任意分位数）、成功与失败次数。
+     *           常驻累计，每个请求结束时记录一次，开销为十余次直方图计数
+     * 返回值：RequestStatistics，快照
+     * 线程安全：可在任意线程调用
+     */
+    RequestStatistics requestStatistics() const;
+
+    /**
+     * 函数名称：`resetRequestStatistics`
+     * 功能描述：清空requestStatistics的累计，如基准测试的热身之后
+     * 线程安全：可在任意线程调用
+     */
+    void resetRequestStatistics();
+
+    /**
+     * 函数名称：`captureHealth`
+     * 功能描述：启动（或上次重置）以来已结束的各路采集（按键录音、免按键监听、听写）的健康状况汇总：
+     *           回调周期与抖动直方图、缓冲区水位、已处理音频与墙钟的偏差、空洞次数和丢失时长。
+     *           进行中的采集在停止时计入
+     * 返回值：CaptureHealth，快照
+     * 线程安全：可在任意线程调用
+     */
+    CaptureHealth captureHealth() const;
+
+    /**
+     * 函数名称：`resetCaptureHealth`
+     * 功能描述：清空captureHealth的累计
+     * 线程安全：可在任意线程调用
+     */
+    void resetCaptureHealth();
+
+    /**
+     * 函数名称：`reportTextInserted`
+     * 功能描述：识别结果已插入输入框，记录TextInserted并结束该请求（发出requestCompleted）。
+     *           由收到recognitionFinished并插入文字的一方调用；1秒内未报告的请求不带该时间点结束
+     * 参数说明：
+     *     - requestId：QString，recognitionFinished带来的请求ID
+     * 返回值：void
+     * 线程安全：可在任意线程调用
+     */
+    void reportTextInserted(const QString &requestId);
+
+    /**
+     * 函数名称：`autotuneEngine`
+     * 功能描述：在后台实测各线程配置（每次推理的线程数 × 并发会话数），选出满足延迟目标时吞吐最高的组合并应用；
+     *           引擎尚未就绪时在就绪后执行
+     * 参数说明：
+     *     - targetLatencyMs：int，单条请求p95延迟上限
+     * 返回值：void
+     */
+    void autotuneEngine(int targetLatencyMs = 500);
+
+    /**
+     * 函数名称：`setEngineThreads`
+     * 功能描述：手动指定线程配置，跳过调优
+     * 参数说明：
+     *     - intraOpThreads：int，每次推理的最大线程数，交互会话同样使用
+     *     - sessions：int，并发推理的批量会话数
+     * 返回值：void
+     */
+    void setEngineThreads(int intraOpThreads, int sessions);
+
+    /**
+     * 函数名称：`engineThreadConfig`
+     * 功能描述：当前生效的线程配置（调优结果或手动指定），未配置时valid为false
+     */
+    EngineAutotuner::Result engineThreadConfig() const { return m_engine->threadConfig(); }
+
+    /**
+     * 函数名称：`isEngineEnabled`
+     * 功能描述：是否使用内置推理引擎
+     * 参数说明：无
+     * 返回值：bool
+     */
+    bool isEngineEnabled() const { return m_engine->isEnabled(); }
+
+    /**
+     * 函数名称：`setEngineStreaming`
+     * 功能描述：设置内置引擎是否边录边算；关闭后松键时整句提交到调度器的交互队列，
+     *           可与其他控件同时松键的请求合并为一批
+     * 参数说明：
+     *     - enabled：bool，是否分块识别，默认开启
+     * 返回值：void
+     */
+    void setEngineStreaming(bool enabled) { m_engine->setStreaming(enabled); }
+    bool isEngineStreaming() const { return m_engine->isStreaming(); }
+
+    /**
+     * 函数名称：`setCommandVocabulary`
+     * 功能描述：为某个来源（控件ID或批量任务的请求ID）声明可选短语，之后该来源的识别只在这些短语中选择：
+     *           内置引擎在词表前缀树内做受限CTC解码，识别服务的结果按编辑距离对应到最接近的短语。
+     *           可在任意线程调用，在管理器线程中生效
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - phrases：QStringList，可选短语，支持(a|b)多选一和[a]可省略，为空则恢复自由识别
+     *     - minConfidence：double，置信度低于此值时报"未匹配到可选项"，0表示总是取最接近的短语
+     * 返回值：void
+     */
+    void setCommandVocabulary(const QString &requestId, const QStringList &phrases, double minConfidence = 0.0);
+
+    /**
+     * 函数名称：`setWakeWordTemplates`
+     * 功能描述：设置唤醒词模板（操作员把唤醒词录3~5遍），替换已有模板；模板在调用线程中提取，在管理器线程中换上
+     * 参数说明：
+     *     - samples：QList<QByteArray>，每段为16kHz单声道16位PCM，首尾可带少量静音
+     *     - threshold：double，检测阈值（平均余弦距离），<=0时用KeywordSpotter的默认值
+     * 返回值：int，有效的模板数
+     */
+    int setWakeWordTemplates(const QList<QByteArray> &samples, double threshold = 0.0);
+
+    /**
+     * 函数名称：`loadWakeWordTemplates`
+     * 功能描述：从WAV文件读取唤醒词模板，其余同setWakeWordTemplates
+     * 参数说明：
+     *     - wavFiles：QStringList，16kHz单声道16位PCM的WAV文件
+     *     - threshold：double，检测阈值，<=0时用默认值
+     * 返回值：int，有效的模板数
+     */
+    int loadWakeWordTemplates(const QStringList &wavFiles, double threshold = 0.0);
+
+    /**
+     * 函数名称：`setHandsFreeEnabled`
+     * 功能描述：开启/关闭免按键模式：常驻监听麦克风做唤醒词检测，命中后由聚焦的输入框开始正常录音，
+     *           录音带上唤醒词之后已采到的音频（预录），说完后静音HandsFreePipeline::HANDS_FREE_SILENCE_MS自动结束。
+     *           监听在管理器线程中打开和检测，完成后发出handsFreeChanged
+     * 参数说明：
+     *     - enabled：bool，是否开启
+     * 返回值：void
+     */
+    void setHandsFreeEnabled(bool enabled);
+
+    /**
+     * 函数名称：`isHandsFreeEnabled`
+     * 功能描述：是否在免按键模式（在管理器线程中更新，其他线程应以handsFreeChanged为准）
+     */
+    bool isHandsFreeEnabled() const { return m_handsFree->isEnabled(); }
+
+    /**
+     * 函数名称：`wakeWordCpuLoad`
+     * 功能描述：唤醒词检测占单核CPU的比例（检测耗时 / 监听时长）
+     */
+    double wakeWordCpuLoad() const;
+
+    /**
+     * 函数名称：`setCaptureMemoryLimit`
+     * 功能描述：设置录音在内存中保留的上限，超出部分写入临时文件，上传时直接从文件流式读取；
+     *           长时间录音的内存占用不随时长增长。下次录音生效
+     * 参数说明：
+     *     - bytes：qint64，字节数（16kHz单声道每分钟约1.9MB），0表示全部保留在内存中
+     * 返回值：void
+     */
+    void setCaptureMemoryLimit(qint64 bytes) { m_captureStore->setMemoryLimit(bytes); }
+    qint64 captureMemoryLimit() const { return m_captureStore->memoryLimit(); }
+
+    /**
+     * 函数名称：`setSpeculativeInterval`
+     * 功能描述：识别服务的投机识别：按键录音期间约每intervalMs在停顿处切一段，已录部分先送去识别，
+     *           松键后只需识别最后一段，再与已返回的分段按顺序拼接。内置引擎已边录边算，不使用此机制。
+     *           任一分段失败时改为整段上传一次。默认关闭：分段之间没有上下文，切点两侧的文字和标点可能与整句识别不同
+     * 参数说明：
+     *     - intervalMs：int，分段的最短时长（建议4000），0表示关闭（松键后整段上传，默认）
+     * 返回值：void
+     */
+    void setSpeculativeInterval(int intervalMs) { m_speculativeIntervalMs = intervalMs; }
+    int speculativeInterval() const { return m_speculativeIntervalMs; }
+
+    /**
+     * 函数名称：`setCaptureBufferMs`
+     * 功能描述：设置麦克风缓冲区时长，下次开始采集生效。一路采集结束时如发现采集线程没跟上（空洞、设备错误、高水位），
+     *           管理器自动把缓冲区加倍，最多MAX_CAPTURE_BUFFER_MS
+     * 参数说明：
+     *     - ms：int，毫秒，0表示设备默认
+     * 返回值：void
+     */
+    void setCaptureBufferMs(int ms) { m_captureBufferMs = ms; }
+    int captureBufferMs() const { return m_captureBufferMs; }
+
+    /**
+     * 函数名称：`setAudioSource`
+     * 功能描述：设置录音来源（见AudioSource::create）："device"为麦克风，"file:<路径>?speed=N"回放文件，
+     *           "synthetic:speech?seed=N"合成信号；录音、免按键监听和听写都从它采集。下次开始采集时生效
+     * 参数说明：
+     *     - spec：QString，来源描述
+     * 返回值：bool，描述串无效或文件无法读取时返回false，保持原来源
+     */
+    bool setAudioSource(const QString &spec);
+    QString audioSource() const { return m_audioSourceSpec; }
+
+    /**
+     * 函数名称：`isDictating`
+     * 功能描述：是否正在连续听写（含停止后等待在途分段；在管理器线程中更新，其他线程应以dictationFinished为准）
+     */
+    bool isDictating() const { return m_dictation->isActive(); }
+
+    /**
+     * 函数名称：`setDictationPartialMode`
+     * 功能描述：设置听写的中间结果：内置引擎就绪时，说话过程中每DictationPipeline::DICTATION_PARTIAL_INTERVAL毫秒录音
+     *           重新识别一次当前分段，通过dictationPartialReady发出。识别服务下不出中间结果。下次听写生效
+     * 参数说明：
+     *     - mode：PartialMode，中间结果方式
+     * 返回值：void
+     */
+    void setDictationPartialMode(PartialMode mode) { m_dictation->setPartialMode(static_cast<DictationPipeline::PartialMode>(mode)); }
+    PartialMode dictationPartialMode() const { return static_cast<PartialMode>(m_dictation->partialMode()); }
+
 public slots:
     /**
      * 函数名称：`startRecording`
-     * 功能描述：开始录音（由UI控件调用）
+     * 功能描述：开始录音（由UI控件调用）。按下的时刻在调用线程记下，录音来源在管理器线程中创建
      * 参数说明：
      *     - requestId：QString，请求ID，用于标识来源控件
      * 返回值：void
@@ -59,7 +354,7 @@ public slots:
 
     /**
      * 函数名称：`stopRecording`
-     * 功能描述：停止录音并开始识别
+     * 功能描述：停止录音并开始识别。松键的时刻在调用线程记下，最后一块的识别在管理器线程进行，不阻塞界面
      * 参数说明：无
      * 返回值：void
      */
@@ -73,6 +368,45 @@ public slots:
      */
     void cancelRecording();
 
+    /**
+     * 函数名称：`startDictation`
+     * 功能描述：开始连续听写：持续录音，按停顿切成分段，每段说完即送去识别（录音不停），
+     *           结果按分段顺序通过dictationTextReady发出；缓存只有当前分段，时长不限。
+     *           听写的录音、分段和识别都在管理器线程中进行；正在录音/听写或无法以16kHz单声道打开麦克风时
+     *           发出statusChanged说明原因，随后发出dictationFinished
+     * 参数说明：
+     *     - requestId：QString，请求ID，用于标识目标控件
+     * 返回值：void
+     */
+    void startDictation(const QString &requestId);
+
+    /**
+     * 函数名称：`stopDictation`
+     * 功能描述：结束听写：停止录音，最后一段送去识别，全部分段的结果发出后发dictationFinished
+     * 参数说明：无
+     * 返回值：void
+     */
+    void stopDictation();
+
+    /**
+     * 函数名称：`cancelDictation`
+     * 功能描述：取消听写：停止录音，丢弃尚未返回的分段结果
+     * 参数说明：无
+     * 返回值：void
+     */
+    void cancelDictation();
+
+    /**
+     * 函数名称：`recognizeAudio`
+     * 功能描述：识别一段已录好的音频（批量任务使用），内置引擎下进入调度器的批量队列，
+     *           不会占用交互线程；结果通过recognitionFinished按requestId返回。可在任意线程调用
+     * 参数说明：
+     *     - pcmData：QByteArray，16kHz单声道16位PCM
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void recognizeAudio(const QByteArray &pcmData, const QString &requestId);
+
 signals:
     /**
      * 信号名称：`recognitionStarted`
@@ -106,13 +440,217 @@ signals:
      */
     void statusChanged(const QString &status);
 
+    /**
+     * 信号名称：`engineStateChanged`
+     * 功能描述：内置引擎状态变化（加载中/预热中/就绪/失败）
+     * 参数说明：
+     *     - state：EngineState，新状态
+     */
+    void engineStateChanged(VoiceRecognitionManager::EngineState state);
+
+    /**
+     * 信号名称：`engineThreadConfigChanged`
+     * 功能描述：线程配置已更新，新配置通过engineThreadConfig()获取
+     * 参数说明：
+     *     - summary：QString，配置的单行描述
+     */
+    void engineThreadConfigChanged(const QString &summary);
+
+    /**
+     * 信号名称：`commandRecognized`
+     * 功能描述：声明了可选短语的来源识别完成，随后同样发出recognitionFinished
+     * 参数说明：
+     *     - phrase：QString，匹配的短语
+     *     - confidence：double，置信度(0, 1]
+     *     - requestId：QString，请求ID
+     */
+    void commandRecognized(const QString &phrase, double confidence, const QString &requestId);
+
+    /**
+     * 信号名称：`wakeWordDetected`
+     * 功能描述：免按键模式下检测到唤醒词，聚焦的输入框收到后调用startRecording开始录音
+     * 参数说明：无
+     */
+    void wakeWordDetected();
+
+    /**
+     * 信号名称：`handsFreeChanged`
+     * 功能描述：setHandsFreeEnabled处理完成，开启时没有模板或无法以16kHz单声道打开麦克风则为false
+     * 参数说明：
+     *     - enabled：bool，是否在免按键模式
+     */
+    void handsFreeChanged(bool enabled);
+
+    /**
+     * 信号名称：`recordingStopped`
+     * 功能描述：录音被自动结束（免按键模式下说完后静音），控件据此进入识别中状态
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     */
+    void recordingStopped(const QString &requestId);
+
+    /**
+     * 信号名称：`dictationTextReady`
+     * 功能描述：听写的一个分段识别完成（按分段顺序发出），控件追加到末尾
+     * 参数说明：
+     *     - text：QString，分段文本
+     *     - requestId：QString，请求ID
+     */
+    void dictationTextReady(const QString &text, const QString &requestId);
+
+    /**
+     * 信号名称：`dictationPartialReady`
+     * 功能描述：当前分段的中间结果：committedText接在已有文字之后不再改动，tentativeText替换上次的未定稿文字；
+     *           分段结束时剩余文字由dictationTextReady发出，届时未定稿文字作废
+     * 参数说明：
+     *     - committedText：QString，新定稿的文字，整段替换方式下始终为空
+     *     - tentativeText：QString，未定稿的文字
+     *     - requestId：QString，请求ID
+     */
+    void dictationPartialReady(const QString &committedText, const QString &tentativeText, const QString &requestId);
+
+    /**
+     * 信号名称：`dictationFinished`
+     * 功能描述：听写结束且全部分段结果已发出（或已取消、未能开始）
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     */
+    void dictationFinished(const QString &requestId);
+
+    /**
+     * 信号名称：`requestCompleted`
+     * 功能描述：一次按键录音或recognizeAudio的请求结束（成功、失败或未识别到内容），带各时间点的时间戳；
+     *           成功时在插入文字的一方调用reportTextInserted之后（最迟recognitionFinished之后1秒）发出，
+     *           可能在调用reportTextInserted的线程中发出。听写和投机识别的分段不单独发出
+     * 参数说明：
+     *     - metrics：RequestMetrics，时间戳和错误信息
+     */
+    void requestCompleted(const RequestMetrics &metrics);
+
 private slots:
     void onRecognitionReplyFinished();
 
+    /**
+     * 函数名称：`onAudioNotify`
+     * 功能描述：录音过程中定时触发，把新录到的音频送入内置引擎的分块识别
+     * 参数说明：无
+     * 返回值：void
+     */
+    void onAudioNotify();
+
+    /**
+     * 函数名称：`onCaptureGap`
+     * 功能描述：采集出现空洞时立即告警，缓冲区调整在该路采集结束时进行
+     * 参数说明：
+     *     - lostUs：qint64，丢失的音频时长（微秒）
+     * 返回值：void
+     */
+    void onCaptureGap(qint64 lostUs);
+
+    /**
+     * 函数名称：`onSchedulerRequestFinished`
+     * 功能描述：调度器完成一条请求
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - text：QString，识别文本
+     * 返回值：void
+     */
+    void onSchedulerRequestFinished(const QString &requestId, const QString &text);
+
+    /**
+     * 函数名称：`onSchedulerCommandFinished`
+     * 功能描述：调度器完成一条受限解码的请求
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - phrase：QString，匹配的短语
+     *     - confidence：double，置信度
+     * 返回值：void
+     */
+    void onSchedulerCommandFinished(const QString &requestId, const QString &phrase, double confidence);
+
+    /**
+     * 函数名称：`onEngineStateChanged`
+     * 功能描述：引擎流水线状态变化，转发为engineStateChanged并更新状态提示
+     * 参数说明：
+     *     - state：EnginePipeline::State，新状态
+     * 返回值：void
+     */
+    void onEngineStateChanged(EnginePipeline::State state);
+
+    /**
+     * 函数名称：`onEngineLoadFinished`
+     * 功能描述：引擎加载结束：成功时按新引擎重新编译词表，再提交加载期间积压的请求（失败则交给识别服务）
+     * 参数说明：
+     *     - ok：bool，是否加载成功
+     * 返回值：void
+     */
+    void onEngineLoadFinished(bool ok);
+
+    /**
+     * 函数名称：`onMonitorAudio`
+     * 功能描述：免按键模式监听到的音频：听写取自监听流时送入听写，录音期间追加到录音数据
+     * 参数说明：
+     *     - chunk：QByteArray，16kHz单声道16位PCM
+     * 返回值：void
+     */
+    void onMonitorAudio(const QByteArray &chunk);
+
+    /**
+     * 函数名称：`onWakeWordSpotted`
+     * 功能描述：检测到唤醒词：未在听写时通知聚焦的输入框开始录音
+     */
+    void onWakeWordSpotted();
+
+    /**
+     * 函数名称：`onDictationSegmentReady`
+     * 功能描述：听写分段需要整句识别：交给内置引擎（含加载中积压），未启用时请求识别服务
+     * 参数说明：
+     *     - segmentId：QString，分段的请求ID
+     *     - pcm：QByteArray，分段音频
+     * 返回值：void
+     */
+    void onDictationSegmentReady(const QString &segmentId, const QByteArray &pcm);
+
 private:
     explicit VoiceRecognitionManager(QObject *parent = nullptr);
     ~VoiceRecognitionManager();
 
+    /**
+     * 函数名称：`postToManagerThread`
+     * 功能描述：不在管理器线程中调用时，把操作排队到管理器线程（同一线程的多次调用保持顺序）
+     * 参数说明：
+     *     - functor：可调用对象，在管理器线程中执行
+     * 返回值：bool，是否已排队；已在管理器线程中时返回false，由调用方直接执行
+     */
+    template <typename Functor>
+    bool postToManagerThread(Functor functor)
+    {
+        if (QThread::currentThread() == thread()) {
+            return false;
+        }
+        QMetaObject::invokeMethod(this, functor, Qt::QueuedConnection);
+        return true;
+    }
+
+    /**
+     * 函数名称：`startRecordingAt`
+     * 功能描述：startRecording在管理器线程中的部分
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - keyDownAt：qint64，按下的时刻（RequestMetrics::now()）
+     * 返回值：void
+     */
+    void startRecordingAt(const QString &requestId, qint64 keyDownAt);
+
+    /**
+     * 函数名称：`stopRecordingAt`
+     * 功能描述：stopRecording在管理器线程中的部分
+     * 参数说明：
+     *     - keyUpAt：qint64，松键的时刻（RequestMetrics::now()）
+     * 返回值：void
+     */
+    void stopRecordingAt(qint64 keyUpAt);
+
     /**
      * 函数名称：`setupAudioFormat`
      * 功能描述：配置音频格式
@@ -121,23 +659,219 @@ private:
      */
     QAudioFormat setupAudioFormat();
 
+    /**
+     * 函数名称：`createAudioSource`
+     * 功能描述：按当前来源设置创建录音来源并检查格式
+     * 参数说明：
+     *     - allowNearest：bool，麦克风不支持16kHz单声道时是否改用最接近的格式
+     *     - error：QString*，失败时写入错误信息
+     * 返回值：AudioSource*，调用方负责释放，失败返回nullptr
+     */
+    AudioSource *createAudioSource(bool allowNearest, QString *error);
+
+    /**
+     * 函数名称：`finishCaptureHealth`
+     * 功能描述：一路采集停止后把它的健康状况计入captureHealth；采集线程没跟上时告警，并加大下次采集的缓冲区
+     * 参数说明：
+     *     - source：AudioSource*，已停止的来源
+     * 返回值：void
+     */
+    void finishCaptureHealth(AudioSource *source);
+
     /**
      * 函数名称：`sendRecognitionRequest`
      * 功能描述：发送识别请求到服务器
      * 参数说明：
      *     - audioData：QByteArray，音频数据
+     *     - requestId：QString，请求ID，随响应返回
+     * 返回值：void
+     */
+    void sendRecognitionRequest(const QByteArray &audioData, const QString &requestId);
+
+    /**
+     * 函数名称：`sendRecognitionRequest`
+     * 功能描述：发送录音存储中的音频，请求体从存储流式读取（临时文件分段映射），不复制整段音频
+     * 参数说明：
+     *     - store：const CaptureStore*，已结束写入的录音
+     *     - requestId：QString，请求ID，随响应返回
+     * 返回值：void
+     */
+    void sendRecognitionRequest(const CaptureStore *store, const QString &requestId);
+
+    /**
+     * 函数名称：`postRecognitionRequest`
+     * 功能描述：组装表单（音频、语言、keys）并发出请求，设置超时
+     * 参数说明：
+     *     - audioPart：QHttpPart，已设置内容的音频部分
+     *     - body：QIODevice*，音频部分的请求体设备，随表单释放，可为nullptr
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void postRecognitionRequest(QHttpPart audioPart, QIODevice *body, const QString &requestId);
+
+    /**
+     * 函数名称：`adoptWakeSpotter`
+     * 功能描述：在管理器线程中换上新的唤醒词检测器，没有模板时关闭免按键模式
+     * 参数说明：
+     *     - spotter：QSharedPointer<KeywordSpotter>，已加好模板的检测器
      * 返回值：void
      */
-    void sendRecognitionRequest(const QByteArray &audioData);
+    void adoptWakeSpotter(const QSharedPointer<KeywordSpotter> &spotter);
+
+    /**
+     * 函数名称：`beginSpeculation`
+     * 功能描述：录音开始时准备投机识别（仅识别服务，且来源未声明可选短语）
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     * 返回值：bool，是否分段预识别
+     */
+    bool beginSpeculation(const QString &requestId);
+
+    /**
+     * 函数名称：`feedSpeculation`
+     * 功能描述：新录到的音频送入切分器，产生的切点之前的部分立即提交识别
+     */
+    void feedSpeculation();
 
     /**
-     * 函数名称：`createWavHeader`
-     * 功能描述：创建WAV文件头
+     * 函数名称：`submitPrefixSegment`
+     * 功能描述：把上一切点到endBytes的音频作为一个分段发往识别服务
      * 参数说明：
-     *     - pcmData：QByteArray，PCM音频数据
-     * 返回值：QByteArray，WAV文件头
+     *     - endBytes：qint64，分段在录音中的结束位置（字节）
+     * 返回值：void
      */
-    QByteArray createWavHeader(const QByteArray &pcmData);
+    void submitPrefixSegment(qint64 endBytes);
+
+    /**
+     * 函数名称：`finishSpeculation`
+     * 功能描述：松键：已提交过分段时只上传最后一段，等全部分段返回后拼接
+     * 返回值：bool，是否已按分段处理；未提交过分段（短句）时返回false，由调用方整段上传
+     */
+    bool finishSpeculation();
+
+    /**
+     * 函数名称：`deliverPrefixSegment`
+     * 功能描述：某个分段的识别结果返回，全部返回后按顺序拼接并发出
+     * 参数说明：
+     *     - segmentId：QString，分段的请求ID
+     *     - text：QString，识别文本
+     *     - error：QString，失败时的错误信息，成功为空
+     * 返回值：void
+     */
+    void deliverPrefixSegment(const QString &segmentId, const QString &text, const QString &error);
+
+    /**
+     * 函数名称：`completePrefixSession`
+     * 功能描述：录音已结束且全部分段已返回时，拼接结果发出（任一分段失败则报错）
+     * 参数说明：
+     *     - requestId：QString，录音的请求ID
+     * 返回值：void
+     */
+    void completePrefixSession(const QString &requestId);
+
+    /**
+     * 函数名称：`reportRecognitionError`
+     * 功能描述：识别失败：听写分段记为空结果、不打断听写，其余请求发recognitionError
+     * 参数说明：
+     *     - error：QString，错误信息
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void reportRecognitionError(const QString &error, const QString &requestId);
+
+    /**
+     * 函数名称：`emitRecognitionResult`
+     * 功能描述：发出识别结果及状态信号（服务与内置引擎共用）
+     * 参数说明：
+     *     - text：QString，识别文本
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void emitRecognitionResult(const QString &text, const QString &requestId);
+
+    /**
+     * 函数名称：`deliverText`
+     * 功能描述：自由识别的文本：来源声明了可选短语时对应到最接近的短语，否则直接发出
+     * 参数说明：
+     *     - text：QString，识别文本
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void deliverText(const QString &text, const QString &requestId);
+
+    /**
+     * 函数名称：`emitCommandResult`
+     * 功能描述：发出短语匹配结果，置信度低于来源的下限时报错
+     * 参数说明：
+     *     - phrase：QString，匹配的短语，为空表示无匹配
+     *     - confidence：double，置信度
+     *     - requestId：QString，请求ID
+     * 返回值：void
+     */
+    void emitCommandResult(const QString &phrase, double confidence, const QString &requestId);
+
+    /**
+     * 函数名称：`commandGrammar`
+     * 功能描述：来源的已编译词表，未声明或引擎未就绪时为空
+     */
+    QSharedPointer<const CommandGrammar> commandGrammar(const QString &requestId) const;
+
+    /**
+     * 函数名称：`flushPendingRequests`
+     * 功能描述：引擎加载结束后提交加载期间积压的请求，加载失败时改为请求识别服务
+     */
+    void flushPendingRequests();
+
+    /**
+     * 函数名称：`beginRequestMetrics`
+     * 功能描述：开始记录一次请求的时间戳（同一请求ID上次未结束的记录作废）
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - point：RequestMetrics::Stamp，起始时间点
+     *     - at：qint64，起始时间（RequestMetrics::now()）
+     *     - audioBytes：qint64，已知的音频字节数（recognizeAudio），按键录音在松键时补上
+     * 返回值：void
+     */
+    void beginRequestMetrics(const QString &requestId, RequestMetrics::Stamp point, qint64 at, qint64 audioBytes = 0);
+
+    /**
+     * 函数名称：`discardRequestMetrics`
+     * 功能描述：丢弃请求的记录，不发出requestCompleted（录音启动失败、取消）
+     */
+    void discardRequestMetrics(const QString &requestId);
+
+    /**
+     * 函数名称：`stampRequest`
+     * 功能描述：记录时间点，已记录过的时间点保留第一次的值；请求未在记录中（听写、投机识别的分段）时忽略
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - point：RequestMetrics::Stamp，时间点
+     *     - at：qint64，时间（RequestMetrics::now()），0表示现在
+     * 返回值：void
+     */
+    void stampRequest(const QString &requestId, RequestMetrics::Stamp point, qint64 at = 0);
+
+    /**
+     * 函数名称：`isRequestTracked`
+     * 功能描述：请求是否在记录中
+     */
+    bool isRequestTracked(const QString &requestId) const;
+
+    /**
+     * 函数名称：`awaitTextInserted`
+     * 功能描述：结果已发出，等待reportTextInserted结束请求；超时后不带TextInserted结束
+     */
+    void awaitTextInserted(const QString &requestId);
+
+    /**
+     * 函数名称：`completeRequestMetrics`
+     * 功能描述：请求结束：移除记录，计入requestStatistics，发出requestCompleted
+     * 参数说明：
+     *     - requestId：QString，请求ID
+     *     - error：QString，失败时的错误信息，成功为空
+     * 返回值：void
+     */
+    void completeRequestMetrics(const QString &requestId, const QString &error);
 
 private:
     static VoiceRecognitionManager* m_instance;
@@ -146,15 +880,60 @@ private:
     QString m_currentRequestId;
     
     // 音频相关
-    QAudioInput* m_audioInput;
-    QBuffer* m_audioBuffer;
-    QByteArray m_audioData;
+    QString m_audioSourceSpec;          // 录音来源描述，空表示麦克风
+    AudioSource* m_audioSource;         // 按键录音的来源
+    CaptureStore* m_captureStore;       // 录音数据，超过内存上限的部分在临时文件中
     
     // 网络相关
     QNetworkAccessManager* m_networkManager;
-    
+
+    // 识别流水线，均为本对象的子对象，随本对象在管理器线程中运行
+    EnginePipeline* m_engine;           // 内置引擎：加载、调度器、按键录音的分块识别
+    DictationPipeline* m_dictation;     // 连续听写
+    HandsFreePipeline* m_handsFree;     // 免按键监听与唤醒词检测
+    bool m_firstRecognitionDone;        // 是否已记录首次出字
+
+    // 可选短语，按请求ID索引
+    struct CommandVocabulary {
+        QStringList patterns;           // 声明的短语/语法
+        QStringList phrases;            // 展开后的短语，供识别服务的结果匹配
+        double minConfidence = 0.0;
+        QSharedPointer<const CommandGrammar> grammar;   // 引擎就绪后编译
+    };
+    QHash<QString, CommandVocabulary> m_commandVocabularies;
+
+    // 投机识别（识别服务）
+    struct PrefixSession {
+        int generation = 0;             // 分段请求ID中的编号，区分同一控件的前后两次录音
+        int submitted = 0;              // 已提交的分段数
+        int total = -1;                 // 松键后确定的分段总数，-1表示仍在录音
+        QMap<int, QString> results;     // 已返回的分段文本
+        QString error;                  // 分段失败的错误信息，有值时整段上传
+        QByteArray pcm;                 // 松键后分段未返回就开始了新录音时，保留的整段录音
+        QElapsedTimer releaseClock;     // 松键计时
+    };
+    QHash<QString, PrefixSession> m_prefixSessions;     // 按录音的请求ID索引
+    QScopedPointer<PrefixSegmenter> m_prefixSegmenter;  // 当前录音的切分器，为空表示未投机识别
+    qint64 m_prefixScannedBytes;        // 已送入切分器的字节数
+    qint64 m_prefixCutBytes;            // 已提交分段的结束位置
+    QByteArray m_prefixChunk;           // 送入切分器前的读取缓冲区，容量复用
+    int m_prefixGeneration;
+    int m_speculativeIntervalMs;
+
+    // 请求计时：按键录音和recognizeAudio的请求，结束时随requestCompleted发出并计入汇总；
+    // 控件在界面线程报告插入、工具在任意线程查询汇总，由m_metricsMutex保护
+    mutable QMutex m_metricsMutex;
+    QHash<QString, RequestMetrics> m_requestMetrics;
+    RequestStatistics m_requestStatistics;
+    CaptureHealth m_captureHealth;      // 已结束的采集，同样由m_metricsMutex保护
+    int m_captureBufferMs;              // 麦克风缓冲区，0表示设备默认
+
     // 常量
     static const int RECOGNITION_TIMEOUT = 10000; // 10秒超时
+    static const int STREAM_NOTIFY_INTERVAL = 100; // 分块识别送数间隔(毫秒)
+    static const int MAX_CAPTURE_BUFFER_MS = 1000;  // 自动加大麦克风缓冲区的上限(毫秒)
+    static const int CAPTURE_MEMORY_LIMIT_MB = 8;   // 录音默认内存上限(MB)，约4分钟
+    static const int TEXT_INSERT_REPORT_TIMEOUT = 1000; // 结果发出后等待reportTextInserted的时长(毫秒)
 };
 
 #endif // VOICERECOGNITIONMANAGER_H 
\ No newline at end of file
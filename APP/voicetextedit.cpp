@@ -1,4 +1,5 @@
 #include "voicetextedit.h"
+#include "voicelogging.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QHttpMultiPart>
@@ -311,7 +312,7 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
 {
     // 安全检查：确保reply不为空
     if (!reply) {
-        qDebug() << "Error: reply is null";
+        qCWarning(lcNetwork) << "Error: reply is null";
         emit statusChanged("网络响应错误");
         setState(State::Idle);
         return;
@@ -319,18 +320,18 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
     
     // 获取HTTP状态码
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    qDebug() << "HTTP Status Code:" << statusCode;
+    qCTrace(lcNetwork) << "HTTP Status Code:" << statusCode;
     
     // 读取响应数据（在检查错误之前）
     QByteArray responseData = reply->readAll();
-    qDebug() << "Response data:" << responseData;
+    qCTrace(lcNetwork) << "Response data:" << responseData;
     
     // 确保reply被正确删除
     reply->deleteLater();
     
     // 检查网络错误
     if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Network error:" << reply->error() << reply->errorString();
+        qCWarning(lcNetwork) << "Network error:" << reply->error() << reply->errorString();
         emit statusChanged("识别失败: " + reply->errorString());
         setState(State::Idle);
         return;
@@ -338,7 +339,7 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
     
     // 检查HTTP状态码
     if (statusCode != 200) {
-        qDebug() << "HTTP error, status code:" << statusCode;
+        qCWarning(lcNetwork) << "HTTP error, status code:" << statusCode;
         emit statusChanged("服务器错误: HTTP " + QString::number(statusCode));
         setState(State::Idle);
         return;
@@ -346,7 +347,7 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
     
     // 检查响应数据是否为空
     if (responseData.isEmpty()) {
-        qDebug() << "Empty response data";
+        qCWarning(lcNetwork) << "Empty response data";
         emit statusChanged("服务器返回空数据");
         setState(State::Idle);
         return;
@@ -357,7 +358,7 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
     QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
     
     if (parseError.error != QJsonParseError::NoError) {
-        qDebug() << "JSON parse error:" << parseError.errorString();
+        qCWarning(lcNetwork) << "JSON parse error:" << parseError.errorString();
         emit statusChanged("响应解析失败: " + parseError.errorString());
         setState(State::Idle);
         return;
@@ -366,38 +367,38 @@ void VoiceTextEdit::onRecognitionFinished(QNetworkReply *reply)
     QJsonObject obj = doc.object();
     QString recognizedText;
     
-    qDebug() << "=========== Qt客户端解析调试信息 ===========";
-    qDebug() << "JSON object keys:" << obj.keys();
+    qCTrace(lcNetwork) << "=========== Qt客户端解析调试信息 ===========";
+    qCTrace(lcNetwork) << "JSON object keys:" << obj.keys();
     
     // 根据SenseVoice API响应格式解析
     if (obj.contains("result")) {
         QJsonArray resultArray = obj["result"].toArray();
-        qDebug() << "Result array size:" << resultArray.size();
+        qCTrace(lcNetwork) << "Result array size:" << resultArray.size();
         
         if (!resultArray.isEmpty()) {
             QJsonObject firstResult = resultArray[0].toObject();
-            qDebug() << "First result keys:" << firstResult.keys();
+            qCTrace(lcNetwork) << "First result keys:" << firstResult.keys();
             
             // 打印所有可用的文本字段
             QString rawText = firstResult["raw_text"].toString();
             QString cleanText = firstResult["clean_text"].toString();
             QString finalText = firstResult["text"].toString();
             
-            qDebug() << "🔤 原始文本 (raw_text):" << rawText;
-            qDebug() << "🧹 清理文本 (clean_text):" << cleanText;
-            qDebug() << "✨ 最终文本 (text):" << finalText;
+            qCTrace(lcNetwork) << "🔤 原始文本 (raw_text):" << rawText;
+            qCTrace(lcNetwork) << "🧹 清理文本 (clean_text):" << cleanText;
+            qCTrace(lcNetwork) << "✨ 最终文本 (text):" << finalText;
             
             // 使用最终处理的text字段
             recognizedText = finalText;
-            qDebug() << "📝 将要插入的文本:" << recognizedText;
-            qDebug() << "📏 文本长度:" << recognizedText.length();
+            qCTrace(lcNetwork) << "📝 将要插入的文本:" << recognizedText;
+            qCTrace(lcNetwork) << "📏 文本长度:" << recognizedText.length();
         }
     } else if (obj.contains("text")) {
         recognizedText = obj["text"].toString();
-        qDebug() << "Direct text:" << recognizedText;
+        qCTrace(lcNetwork) << "Direct text:" << recognizedText;
     }
     
-    qDebug() << "=============================================";
+    qCTrace(lcNetwork) << "=============================================";
     
     if (recognizedText.isEmpty()) {
         emit statusChanged("未识别到有效内容");
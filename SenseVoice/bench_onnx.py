@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+# -*- encoding: utf-8 -*-
+# 用ONNX Runtime（funasr_onnx）识别enginebench的同一份语料，输出延迟和RTF，
+# 作为内置推理引擎（enginebench --variants all）的对照基线。
+#
+# 用法:
+#   python bench_onnx.py --corpus corpus.tsv --threads 4
+# corpus.tsv每行为 <wav路径>\t<参考文本>，与enginebench相同；两边的线程数应一致。
+
+import argparse
+import time
+
+import numpy as np
+import soundfile
+from funasr_onnx import SenseVoiceSmall
+
+
+def percentile(values, p):
+    return float(np.percentile(values, p)) if values else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ONNX Runtime识别延迟基准")
+    parser.add_argument("--model_dir", default="./model/iic/SenseVoiceSmall")
+    parser.add_argument("--corpus", required=True, help="语料列表：<wav路径>\\t<参考文本>")
+    parser.add_argument("--threads", type=int, default=4, help="ONNX Runtime的intra_op线程数")
+    parser.add_argument("--quantize", action="store_true", help="使用model_quant.onnx")
+    args = parser.parse_args()
+
+    model = SenseVoiceSmall(args.model_dir, batch_size=1, quantize=args.quantize,
+                            intra_op_num_threads=args.threads)
+
+    wavs = []
+    with open(args.corpus, encoding="utf-8") as f:
+        for line in f:
+            path = line.rstrip("\n").split("\t")[0]
+            if path:
+                wavs.append(path)
+
+    # 第一条预热，不计入统计
+    latencies = []
+    audio_seconds = 0.0
+    compute_seconds = 0.0
+    for i, path in enumerate(wavs):
+        samples, rate = soundfile.read(path, dtype="float32")
+        start = time.perf_counter()
+        model([samples], language="auto", textnorm="withitn")
+        elapsed = time.perf_counter() - start
+        if i == 0:
+            continue
+        latencies.append(elapsed * 1000)
+        audio_seconds += len(samples) / rate
+        compute_seconds += elapsed
+
+    print(f"语料: {len(latencies)} 条, 共 {audio_seconds:.1f} 秒  线程: {args.threads}"
+          f"  {'int8' if args.quantize else 'fp32'}")
+    print(f"onnxruntime  p50={percentile(latencies, 50):.1f}ms  p95={percentile(latencies, 95):.1f}ms"
+          f"  p99={percentile(latencies, 99):.1f}ms  RTF={compute_seconds / max(audio_seconds, 1e-9):.4f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+# -*- encoding: utf-8 -*-
+# 将SenseVoiceSmall权重导出为Qt应用内置推理引擎（APP/engine）使用的二进制格式
+#
+# 文件布局(版本3):
+#   "SVNW" | uint32 版本号 | uint32 头部长度 | 头部JSON(utf-8) | 64字节对齐填充 | float32张量数据
+# 头部JSON包含模型结构参数(config)、词表(tokens)以及每个张量的形状和数据偏移(tensors)。
+# 数据区起点和每个张量的偏移都按64字节对齐，张量已按引擎的计算布局存放（线性层[out, in]、
+# FSMN按抽头[kernel, size]），引擎以只读方式mmap后直接使用，多个进程共享同一份page cache。
+# 版本2的FSMN为[size, kernel]，引擎仍可加载，但需在加载时转置到堆上。
+#
+# 输入可以是PyTorch权重(--model_dir)或export.py导出的ONNX模型(--onnx)。
+# 指定--quantize时线性层权重按输出通道对称量化为int8（dtype为"int8"，缩放存为"<名称>_scale"），
+# 文件约为fp32的1/4，引擎按int8精度加载，量化后的权重同样只读映射、多进程共享。
+
+import os
+import json
+import struct
+import argparse
+
+import numpy as np
+
+MAGIC = b"SVNW"
+VERSION = 3
+ALIGNMENT = 64
+
+# 与model.py中SenseVoiceSmall的定义一致，ONNX模型中不包含这两个表
+LID_DICT = {"auto": 0, "zh": 3, "en": 4, "yue": 7, "ja": 11, "ko": 12, "nospeech": 13}
+TEXTNORM_DICT = {"withitn": 14, "woitn": 15}
+
+
+def load_cmvn(cmvn_file):
+    """读取am.mvn，返回(means, vars)，与utils.frontend.WavFrontend.load_cmvn一致"""
+    with open(cmvn_file, "r", encoding="utf-8") as f:
+        lines = f.readlines()
+    means_list, vars_list = [], []
+    for i in range(len(lines)):
+        line_item = lines[i].split()
+        if line_item[0] == "<AddShift>":
+            line_item = lines[i + 1].split()
+            if line_item[0] == "<LearnRateCoef>":
+                means_list = line_item[3 : (len(line_item) - 1)]
+        elif line_item[0] == "<Rescale>":
+            line_item = lines[i + 1].split()
+            if line_item[0] == "<LearnRateCoef>":
+                vars_list = line_item[3 : (len(line_item) - 1)]
+    return np.array(means_list, dtype=np.float32), np.array(vars_list, dtype=np.float32)
+
+
+def load_tokens(model_path):
+    """从sentencepiece模型读取词表"""
+    import sentencepiece as spm
+
+    sp = spm.SentencePieceProcessor()
+    sp.load(os.path.join(model_path, "chn_jpn_yue_eng_ko_spectok.bpe.model"))
+    return [sp.id_to_piece(i) for i in range(sp.get_piece_size())]
+
+
+def build_config(input_size, encoder_conf, frontend_conf, vocab_size, blank_id, lid_dict, textnorm_dict):
+    return {
+        "input_size": input_size,
+        "output_size": encoder_conf.get("output_size", 512),
+        "attention_heads": encoder_conf.get("attention_heads", 4),
+        "linear_units": encoder_conf.get("linear_units", 2048),
+        "num_blocks": encoder_conf.get("num_blocks", 50),
+        "tp_blocks": encoder_conf.get("tp_blocks", 20),
+        "kernel_size": encoder_conf.get("kernel_size", 11),
+        "sanm_shfit": encoder_conf.get("sanm_shfit", 0),
+        "vocab_size": vocab_size,
+        "blank_id": blank_id,
+        "fs": frontend_conf.get("fs", 16000),
+        "n_mels": frontend_conf.get("n_mels", 80),
+        "frame_length": frontend_conf.get("frame_length", 25),
+        "frame_shift": frontend_conf.get("frame_shift", 10),
+        "lfr_m": frontend_conf.get("lfr_m", 7),
+        "lfr_n": frontend_conf.get("lfr_n", 6),
+        "lid_dict": lid_dict,
+        "textnorm_dict": textnorm_dict,
+    }
+
+
+def onnx_module_path(node_name):
+    """由ONNX节点名还原模块路径，如 /encoder/encoders/encoders.3/self_attn/linear_out/MatMul
+    -> encoder.encoders.3.self_attn.linear_out（ModuleList子模块名带父模块名前缀，合并为一段）"""
+    parts = []
+    for segment in node_name.strip("/").split("/")[:-1]:
+        if parts and segment.startswith(parts[-1] + "."):
+            parts[-1] = segment
+        else:
+            parts.append(segment)
+    return ".".join(parts)
+
+
+def load_onnx_state(onnx_file):
+    """从ONNX模型中恢复与PyTorch state_dict同名的权重。
+    保留原名的初始化器直接使用；线性层被导出为MatMul(权重已转置)+Add，按节点名还原"""
+    import onnx
+    from onnx import numpy_helper
+
+    graph = onnx.load(onnx_file).graph
+    initializers = {init.name: numpy_helper.to_array(init) for init in graph.initializer}
+    state = {name: value for name, value in initializers.items() if "." in name and not name.startswith("onnx::")}
+
+    for node in graph.node:
+        module = onnx_module_path(node.name)
+        params = [initializers[name] for name in node.input if name in initializers]
+        if not module or not params:
+            continue
+        value = params[0]
+        if node.op_type == "MatMul" and value.ndim == 2:
+            state.setdefault(module + ".weight", value.T)
+        elif node.op_type == "Add" and value.ndim == 1 and value.size > 1:
+            state.setdefault(module + ".bias", value)
+        elif node.op_type == "Mul" and value.ndim == 1 and value.size > 1:
+            # opset<17时LayerNorm被拆成基本算子，gamma在Mul节点上
+            state.setdefault(module + ".weight", value)
+        elif node.op_type == "Conv":
+            state.setdefault(module + ".weight", value)
+        elif node.op_type == "Gather" and value.ndim == 2:
+            state.setdefault(module + ".weight", value)
+    return {name: np.asarray(value, dtype=np.float32) for name, value in state.items()}
+
+
+def check_tensors(tensors, config):
+    expected = ["embed.weight", "ctc.ctc_lo.weight", "ctc.ctc_lo.bias",
+                "encoder.after_norm.weight", "encoder.after_norm.bias",
+                "encoder.tp_norm.weight", "encoder.tp_norm.bias"]
+    layers = ["encoder.encoders0.0."]
+    layers += ["encoder.encoders.{}.".format(i) for i in range(config["num_blocks"] - 1)]
+    layers += ["encoder.tp_encoders.{}.".format(i) for i in range(config["tp_blocks"])]
+    for prefix in layers:
+        for suffix in ["norm1.weight", "norm1.bias", "norm2.weight", "norm2.bias",
+                       "self_attn.linear_q_k_v.weight", "self_attn.linear_q_k_v.bias",
+                       "self_attn.linear_out.weight", "self_attn.linear_out.bias",
+                       "self_attn.fsmn_block.weight",
+                       "feed_forward.w_1.weight", "feed_forward.w_1.bias",
+                       "feed_forward.w_2.weight", "feed_forward.w_2.bias"]:
+            expected.append(prefix + suffix)
+    missing = [name for name in expected if name not in tensors]
+    if missing:
+        raise ValueError("缺少{}个张量，例如: {}".format(len(missing), ", ".join(missing[:5])))
+
+
+def collect_tensors(state, cmvn):
+    tensors = {}
+    for name, value in state.items():
+        if name.startswith("encoder.") or name.startswith("ctc.ctc_lo.") or name == "embed.weight":
+            if name.endswith("fsmn_block.weight"):
+                # Conv1d权重 (size, 1, kernel) -> 按抽头存放 (kernel, size)，与fsmnMemory的读取顺序一致
+                value = value.reshape(value.shape[0], value.shape[-1]).T
+            tensors[name] = np.ascontiguousarray(value, dtype=np.float32)
+    tensors["frontend.cmvn_means"] = cmvn[0]
+    tensors["frontend.cmvn_vars"] = cmvn[1]
+    return tensors
+
+
+# 量化为int8的线性层权重（名称后缀），其余张量（LayerNorm、FSMN、embedding、偏置）保持float32
+QUANTIZED_SUFFIXES = ("self_attn.linear_q_k_v.weight", "self_attn.linear_out.weight",
+                      "feed_forward.w_1.weight", "feed_forward.w_2.weight", "ctc.ctc_lo.weight")
+
+
+def quantize_tensors(tensors):
+    """按输出通道对称量化，与APP/engine/enginekernels.cpp中的quantizeWeights一致"""
+    result = {}
+    for name, value in tensors.items():
+        if not name.endswith(QUANTIZED_SUFFIXES):
+            result[name] = value
+            continue
+        max_abs = np.abs(value).max(axis=1)
+        scale = np.where(max_abs > 0, max_abs / 127.0, 1.0).astype(np.float32)
+        result[name] = np.clip(np.rint(value / scale[:, None]), -127, 127).astype(np.int8)
+        result[name + "_scale"] = scale
+    return result
+
+
+def align(size):
+    return (size + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def write_model(output_file, config, tokens, tensors):
+    table = {}
+    offset = 0
+    for name, value in tensors.items():
+        table[name] = {"shape": list(value.shape), "offset": offset}
+        if value.dtype == np.int8:
+            table[name]["dtype"] = "int8"
+        offset = align(offset + value.nbytes)
+
+    header = json.dumps(
+        {"config": config, "tokens": tokens, "tensors": table, "alignment": ALIGNMENT},
+        ensure_ascii=False,
+    ).encode("utf-8")
+
+    with open(output_file, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<II", VERSION, len(header)))
+        f.write(header)
+        f.write(b"\0" * (align(f.tell()) - f.tell()))
+        data_start = f.tell()
+        for name, value in tensors.items():
+            f.write(b"\0" * (data_start + table[name]["offset"] - f.tell()))
+            f.write(value.tobytes() if value.dtype == np.int8 else value.astype("<f4").tobytes())
+
+
+def export_from_pytorch(model_dir, device):
+    from model import SenseVoiceSmall
+
+    model, kwargs = SenseVoiceSmall.from_pretrained(model=model_dir, device=device)
+    model.eval()
+    model_path = kwargs.get("output_dir", os.path.dirname(kwargs.get("init_param")))
+
+    config = build_config(kwargs.get("input_size", 560), kwargs["encoder_conf"], kwargs["frontend_conf"],
+                          model.vocab_size, model.blank_id, model.lid_dict, model.textnorm_dict)
+    state = {k: v.detach().float().cpu().numpy() for k, v in model.state_dict().items()}
+    return model_path, config, state
+
+
+def export_from_onnx(onnx_file):
+    import yaml
+
+    model_path = os.path.dirname(os.path.abspath(onnx_file))
+    with open(os.path.join(model_path, "config.yaml"), "r", encoding="utf-8") as f:
+        conf = yaml.safe_load(f)
+
+    state = load_onnx_state(onnx_file)
+    vocab_size = state["ctc.ctc_lo.weight"].shape[0]
+    config = build_config(conf.get("input_size", 560), conf.get("encoder_conf", {}), conf.get("frontend_conf", {}),
+                          vocab_size, 0, LID_DICT, TEXTNORM_DICT)
+    return model_path, config, state
+
+
+def main():
+    parser = argparse.ArgumentParser(description="导出内置推理引擎权重")
+    parser.add_argument("--model_dir", default="./model/iic/SenseVoiceSmall")
+    parser.add_argument("--onnx", default=None, help="从export.py导出的model.onnx转换（同目录需有config.yaml、am.mvn和bpe模型）")
+    parser.add_argument("--output", default=None, help="输出文件，默认写入模型目录下的model.svnw")
+    parser.add_argument("--device", default="cpu")
+    parser.add_argument("--quantize", action="store_true", help="线性层权重导出为int8（按输出通道量化）")
+    args = parser.parse_args()
+
+    if args.onnx:
+        model_path, config, state = export_from_onnx(args.onnx)
+    else:
+        model_path, config, state = export_from_pytorch(args.model_dir, args.device)
+
+    cmvn = load_cmvn(os.path.join(model_path, "am.mvn"))
+    tokens = load_tokens(model_path)
+    tensors = collect_tensors(state, cmvn)
+    check_tensors(tensors, config)
+    if args.quantize:
+        tensors = quantize_tensors(tensors)
+
+    output_file = args.output or os.path.join(model_path, "model_int8.svnw" if args.quantize else "model.svnw")
+    write_model(output_file, config, tokens, tensors)
+    print("Export native engine weights to {}".format(output_file))
+
+
+if __name__ == "__main__":
+    main()
@@ -91,25 +91,15 @@ class WavFrontend:
 
     @staticmethod
     def apply_lfr(inputs: np.ndarray, lfr_m: int, lfr_n: int) -> np.ndarray:
-        LFR_inputs = []
-
+        # 一次性按下标取帧拼接，等价于左侧用首帧、右侧用尾帧补齐后每lfr_n帧取lfr_m帧，
+        # 不再逐帧构造列表和vstack
         T = inputs.shape[0]
         T_lfr = int(np.ceil(T / lfr_n))
-        left_padding = np.tile(inputs[0], ((lfr_m - 1) // 2, 1))
-        inputs = np.vstack((left_padding, inputs))
-        T = T + (lfr_m - 1) // 2
-        for i in range(T_lfr):
-            if lfr_m <= T - i * lfr_n:
-                LFR_inputs.append((inputs[i * lfr_n : i * lfr_n + lfr_m]).reshape(1, -1))
-            else:
-                # process last LFR frame
-                num_padding = lfr_m - (T - i * lfr_n)
-                frame = inputs[i * lfr_n :].reshape(-1)
-                for _ in range(num_padding):
-                    frame = np.hstack((frame, inputs[-1]))
-
-                LFR_inputs.append(frame)
-        LFR_outputs = np.vstack(LFR_inputs).astype(np.float32)
+        left = (lfr_m - 1) // 2
+        index = np.arange(T_lfr)[:, None] * lfr_n - left + np.arange(lfr_m)[None, :]
+        np.clip(index, 0, T - 1, out=index)
+        LFR_outputs = np.empty((T_lfr, lfr_m * inputs.shape[1]), dtype=np.float32)
+        np.take(inputs, index, axis=0, out=LFR_outputs.reshape(T_lfr, lfr_m, inputs.shape[1]))
         return LFR_outputs
 
     def apply_cmvn(self, inputs: np.ndarray) -> np.ndarray:
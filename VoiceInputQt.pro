@@ -0,0 +1,6 @@
+# 顶层工程：应用程序 + 性能工具
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    APP \
+    tools
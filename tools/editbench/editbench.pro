@@ -0,0 +1,20 @@
+# 输入框未定稿文字基准：中间结果更新的耗时与文档长度的关系、撤销记录、重排和绘制次数
+QT       += core gui widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = editbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../APP ../../APP/engine
+
+SOURCES += \
+    main.cpp \
+    ../../APP/tentativetextregion.cpp \
+    ../../APP/engine/stableprefixtracker.cpp
+
+HEADERS += \
+    ../../APP/tentativetextregion.h \
+    ../../APP/engine/stableprefixtracker.h
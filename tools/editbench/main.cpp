@@ -0,0 +1,354 @@
+/**
+ * editbench：输入框未定稿文字的更新开销基准
+ *
+ * 在不同长度的文档末尾模拟听写的中间结果（每次替换灰色的未定稿文字，每隔几次定稿一小段），对比：
+ *   - cursor：未定稿文字写入文档，每次用QTextCursor删除旧的、插入新的（一次编辑块）
+ *   - region：TentativeTextRegion，未定稿文字画在插入点之后的不透明标签上，不进入排版，定稿文字才写入文档
+ * 统计每次更新的耗时（调用本身，以及加上随后的排版和绘制）的中位数、撤销记录数，
+ * 以及文档改动（每次改动所在段落重新排版）和视口绘制的次数。
+ * region方式在最长文档上的中位耗时超过最短文档的--max-ratio倍时返回码为2。
+ *
+ * 指定--partials时另外模拟连续听写的中间结果（每200ms录音一个token，离录音末尾600ms以内的token
+ * 每次识别有一半概率变成别的字），在最长的文档上对比整段替换（replace）与稳定前缀提交（stable）
+ * 每秒录音的改动、重排、绘制次数和被改写的未定稿字符数。
+ *
+ * 用法：editbench [--lines 10,1000,100000] [--updates 300] [--commit-every 5] [--max-ratio 1.1] [--partials 500]
+ * 无显示环境下可加 -platform offscreen
+ */
+
+#include "tentativetextregion.h"
+#include "stableprefixtracker.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QStringList>
+#include <QTextDocument>
+#include <QTextEdit>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+const int TOKEN_MS = 200;           // 模拟语音每个token的时长
+const int SEGMENT_MS = 8000;        // 模拟听写每个分段的时长
+const int SEGMENTS = 10;
+
+struct RunResult {
+    QVector<double> callUs;         // 更新调用本身
+    QVector<double> totalUs;        // 调用 + 处理随后的排版和绘制事件
+    int undoSteps = 0;              // 运行期间新增的撤销记录
+    int commits = 0;
+    int relayouts = 0;              // 文档内容改动次数，每次改动所在段落重新排版
+    int repaints = 0;               // 视口及其子控件的绘制事件
+};
+
+/**
+ * 一次中间结果：新定稿的文字和替换后的未定稿文字
+ */
+struct PartialUpdate {
+    QString committed;
+    QString tentative;
+};
+
+/**
+ * 统计视口及其子控件（未定稿文字的标签）收到的绘制事件
+ */
+class PaintCounter : public QObject
+{
+public:
+    int paints = 0;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            ++paints;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+double median(QVector<double> values)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+QString column(double value, int precision, int width = 10)
+{
+    return QString::number(value, 'f', precision).rightJustified(width);
+}
+
+/**
+ * 中间结果序列：未定稿文字的长度在1~20个字之间循环，每commitEvery次把其中两个字定稿
+ */
+QString tentativeAt(int update)
+{
+    QString text;
+    const int length = update % 20 + 1;
+    for (int i = 0; i < length; ++i) {
+        text.append(QChar(0x4E00 + (update * 7 + i) % 2000));
+    }
+    return text;
+}
+
+QVector<PartialUpdate> syntheticUpdates(int updates, int commitEvery)
+{
+    QVector<PartialUpdate> sequence;
+    for (int update = 0; update < updates; ++update) {
+        const bool commit = commitEvery > 0 && update % commitEvery == commitEvery - 1;
+        sequence.append({commit ? tentativeAt(update - 1).left(2) : QString(), tentativeAt(update)});
+    }
+    return sequence;
+}
+
+QString tokenText(const std::vector<int> &ids)
+{
+    QString text;
+    for (int id : ids) {
+        text.append(QChar(0x4E00 + id % 20000));
+    }
+    return text;
+}
+
+/**
+ * 模拟一个分段在录音到audioMs时的识别结果；last为分段结束后的最终结果，全部正确
+ */
+std::vector<StablePrefixTracker::Token> simulatedHypothesis(int segment, int audioMs, bool last, quint32 &seed)
+{
+    std::vector<StablePrefixTracker::Token> tokens;
+    for (int i = 0; (i + 1) * TOKEN_MS <= audioMs; ++i) {
+        StablePrefixTracker::Token token;
+        token.id = segment * 97 + i;
+        token.startMs = i * TOKEN_MS;
+        token.endMs = token.startMs + TOKEN_MS;
+        if (!last && token.endMs > audioMs - 600) {
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 16) & 1) {
+                token.id += 10000;
+            }
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/**
+ * 按管理器和控件的处理方式，把模拟的识别结果变成控件收到的更新序列：
+ * stable经StablePrefixTracker只提交稳定前缀、改写尾部；replace每次整段替换，分段结束时整段定稿
+ */
+QVector<PartialUpdate> simulatedDictation(bool stable, int intervalMs)
+{
+    QVector<PartialUpdate> sequence;
+    StablePrefixTracker tracker;
+    quint32 seed = 1;
+    for (int segment = 0; segment < SEGMENTS; ++segment) {
+        tracker.reset();
+        QString committed;
+        QString tentative;
+        for (int audioMs = qMin(intervalMs, SEGMENT_MS); ; audioMs = qMin(audioMs + intervalMs, SEGMENT_MS)) {
+            const bool last = audioMs == SEGMENT_MS;
+            const std::vector<StablePrefixTracker::Token> tokens = simulatedHypothesis(segment, audioMs, last, seed);
+            if (!stable) {
+                std::vector<int> ids;
+                for (const StablePrefixTracker::Token &token : tokens) {
+                    ids.push_back(token.id);
+                }
+                const QString text = tokenText(ids);
+                if (last) {
+                    sequence.append({text, QString()});
+                } else if (text != tentative) {
+                    sequence.append({QString(), text});
+                    tentative = text;
+                }
+            } else {
+                if (last) {
+                    tracker.finish(tokens);
+                } else {
+                    tracker.update(tokens, audioMs);
+                }
+                const QString nowCommitted = tokenText(tracker.committedIds());
+                const QString all = tokenText(tracker.allIds());
+                const QString delta = nowCommitted.startsWith(committed) ? nowCommitted.mid(committed.size()) : QString();
+                const QString nowTentative = all.startsWith(nowCommitted) ? all.mid(nowCommitted.size()) : QString();
+                if (last) {
+                    sequence.append({delta, QString()});
+                } else if (!delta.isEmpty() || nowTentative != tentative) {
+                    sequence.append({delta, nowTentative});
+                }
+                committed += delta;
+                tentative = nowTentative;
+            }
+            if (last) {
+                break;
+            }
+        }
+    }
+    return sequence;
+}
+
+RunResult run(QApplication &app, int lines, bool useRegion, const QVector<PartialUpdate> &sequence)
+{
+    QTextEdit edit;
+    edit.resize(800, 600);
+    QStringList content;
+    for (int i = 0; i < lines; ++i) {
+        content.append(QString("第%1行 已有的文字，用于排版。").arg(i));
+    }
+    edit.setPlainText(content.join('\n'));
+    edit.show();
+    edit.moveCursor(QTextCursor::End);
+    app.processEvents();
+
+    RunResult result;
+    QTextDocument *document = edit.document();
+    const int undoBefore = document->availableUndoSteps();
+
+    TentativeTextRegion region(&edit);
+    region.begin();
+    QTextCharFormat tentativeFormat;
+    tentativeFormat.setForeground(Qt::gray);
+    int tentativeStart = 0;
+    int tentativeLength = 0;
+
+    PaintCounter paints;
+    edit.viewport()->installEventFilter(&paints);
+    for (QObject *child : edit.viewport()->children()) {
+        child->installEventFilter(&paints);
+    }
+    QObject::connect(document, &QTextDocument::contentsChange, &edit, [&result]() { ++result.relayouts; });
+
+    QElapsedTimer timer;
+    for (const PartialUpdate &update : sequence) {
+        const QString &committed = update.committed;
+        const QString &tentative = update.tentative;
+        result.commits += committed.isEmpty() ? 0 : 1;
+
+        timer.start();
+        if (useRegion) {
+            region.update(committed, tentative);
+        } else {
+            QTextCursor cursor(document);
+            cursor.beginEditBlock();
+            if (tentativeLength > 0) {
+                cursor.setPosition(tentativeStart);
+                cursor.setPosition(tentativeStart + tentativeLength, QTextCursor::KeepAnchor);
+                cursor.removeSelectedText();
+            } else {
+                cursor.movePosition(QTextCursor::End);
+            }
+            cursor.insertText(committed, QTextCharFormat());
+            tentativeStart = cursor.position();
+            tentativeLength = tentative.size();
+            cursor.insertText(tentative, tentativeFormat);
+            cursor.endEditBlock();
+        }
+        result.callUs.append(timer.nsecsElapsed() / 1000.0);
+        app.processEvents();
+        result.totalUs.append(timer.nsecsElapsed() / 1000.0);
+    }
+    result.undoSteps = document->availableUndoSteps() - undoBefore;
+    result.repaints = paints.paints;
+    return result;
+}
+
+/**
+ * 在lines行的文档上对比两种中间结果的提交方式，按每秒录音输出
+ */
+void comparePartials(QTextStream &out, QApplication &app, int lines, int intervalMs)
+{
+    const double seconds = SEGMENTS * SEGMENT_MS / 1000.0;
+    out << "\n模拟听写: " << SEGMENTS << " 段 x " << SEGMENT_MS / 1000 << " 秒, 中间结果间隔 " << intervalMs
+        << " ms, 文档 " << lines << " 行, region方式\n";
+    out << QString("mode").leftJustified(8) << QString("改动/秒").rightJustified(10)
+        << QString("重排/秒").rightJustified(10) << QString("绘制/秒").rightJustified(10)
+        << QString("改写字符/秒").rightJustified(10) << "\n";
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool stable = mode == 1;
+        const QVector<PartialUpdate> sequence = simulatedDictation(stable, intervalMs);
+        qint64 rewritten = 0;
+        QString tentative;
+        for (const PartialUpdate &update : sequence) {
+            rewritten += tentative.size();      // 上次显示的未定稿文字整体被替换
+            tentative = update.tentative;
+        }
+        const RunResult result = run(app, lines, true, sequence);
+        out << QString(stable ? "stable" : "replace").leftJustified(8) << column(sequence.size() / seconds, 2)
+            << column(result.relayouts / seconds, 2) << column(result.repaints / seconds, 2)
+            << column(rewritten / seconds, 1) << "\n";
+        out.flush();
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("输入框未定稿文字的更新开销与文档长度的关系");
+    parser.addHelpOption();
+    parser.addOption({"lines", "逐一测试的文档行数", "list", "10,1000,100000"});
+    parser.addOption({"updates", "每种文档模拟的中间结果次数", "count", "300"});
+    parser.addOption({"commit-every", "每隔几次中间结果定稿一小段，0表示不定稿", "count", "5"});
+    parser.addOption({"max-ratio", "region方式最长与最短文档的中位耗时之比上限，超过则返回2", "ratio", "1.1"});
+    parser.addOption({"partials", "另外模拟连续听写，按此间隔对比整段替换与稳定前缀提交的重排和绘制次数", "ms"});
+    parser.process(app);
+
+    QVector<int> lineCounts;
+    for (const QString &value : parser.value("lines").split(',', QString::SkipEmptyParts)) {
+        lineCounts.append(qMax(1, value.toInt()));
+    }
+    std::sort(lineCounts.begin(), lineCounts.end());
+    if (lineCounts.isEmpty()) {
+        parser.showHelp(1);
+    }
+    const int updates = qMax(1, parser.value("updates").toInt());
+    const int commitEvery = parser.value("commit-every").toInt();
+
+    out << QString("mode").leftJustified(8) << QString("行数").rightJustified(10)
+        << QString("调用(us)").rightJustified(10) << QString("含排版(us)").rightJustified(10)
+        << QString("撤销记录").rightJustified(10) << QString("定稿次数").rightJustified(10)
+        << QString("重排").rightJustified(10) << QString("绘制").rightJustified(10) << "\n";
+    out.flush();
+
+    const QVector<PartialUpdate> sequence = syntheticUpdates(updates, commitEvery);
+    QVector<double> regionTotals;
+    for (int lines : lineCounts) {
+        for (int mode = 0; mode < 2; ++mode) {
+            const bool useRegion = mode == 1;
+            const RunResult result = run(app, lines, useRegion, sequence);
+            out << QString(useRegion ? "region" : "cursor").leftJustified(8) << QString::number(lines).rightJustified(10)
+                << column(median(result.callUs), 1) << column(median(result.totalUs), 1)
+                << QString::number(result.undoSteps).rightJustified(10)
+                << QString::number(result.commits).rightJustified(10)
+                << QString::number(result.relayouts).rightJustified(10)
+                << QString::number(result.repaints).rightJustified(10) << "\n";
+            out.flush();
+            if (useRegion) {
+                regionTotals.append(median(result.totalUs));
+            }
+        }
+    }
+
+    if (parser.isSet("partials")) {
+        comparePartials(out, app, lineCounts.last(), qMax(1, parser.value("partials").toInt()));
+    }
+
+    const double ratio = regionTotals.last() / qMax(regionTotals.first(), 1e-3);
+    out << "\nregion " << lineCounts.last() << "行/" << lineCounts.first() << "行 中位耗时之比: "
+        << QString::number(ratio, 'f', 2) << "\n";
+    if (ratio > parser.value("max-ratio").toDouble()) {
+        out << "FAIL: 未定稿文字的更新开销随文档长度增长\n";
+        return 2;
+    }
+    out << "PASS\n";
+    return 0;
+}
@@ -0,0 +1,19 @@
+# 内置推理引擎基准：整句识别与分块识别的松键延迟、准确率对比
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = enginebench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../APP/engine/engine.pri)
+
+SOURCES += \
+    main.cpp \
+    ../../APP/voicelogging.cpp
+
+HEADERS += \
+    ../../APP/voicelogging.h
@@ -0,0 +1,47 @@
+#!/bin/sh
+# 统计同时运行多个内置引擎实例时每个实例的内存开销（Linux）
+#
+# 依次启动N个 enginebench --memory --hold，全部就绪后读取各进程的/proc/<pid>/smaps_rollup：
+#   Rss            进程可见的常驻内存（共享的权重页面在每个进程中都会计入）
+#   Pss            按共享进程数均摊后的内存，N个实例的Pss之和即整机实际占用
+#   Private        进程独占的内存，即每增加一个实例的增量
+#
+# 用法：instance_memory.sh <enginebench路径> <model.svnw> [实例数，默认4]
+
+BENCH=${1:?用法: instance_memory.sh <enginebench> <model.svnw> [N]}
+MODEL=${2:?用法: instance_memory.sh <enginebench> <model.svnw> [N]}
+COUNT=${3:-4}
+TMPDIR=$(mktemp -d)
+PIDS=""
+
+cleanup() {
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    rm -rf "$TMPDIR"
+}
+trap cleanup EXIT INT TERM
+
+i=1
+while [ "$i" -le "$COUNT" ]; do
+    "$BENCH" --model "$MODEL" --memory --hold > "$TMPDIR/$i.log" 2>&1 &
+    PIDS="$PIDS $!"
+    # 等待预热完成再启动下一个，避免并发调页影响加载耗时
+    while ! grep -q '^ready' "$TMPDIR/$i.log" 2>/dev/null; do
+        kill -0 $! 2>/dev/null || { cat "$TMPDIR/$i.log"; exit 1; }
+        sleep 0.2
+    done
+    grep '模型加载耗时' "$TMPDIR/$i.log" | sed "s/^/实例$i /"
+    i=$((i + 1))
+done
+
+printf '\n%-8s %10s %10s %10s\n' "pid" "Rss(MB)" "Pss(MB)" "Private(MB)"
+for pid in $PIDS; do
+    awk -v pid="$pid" '
+        /^Rss:/ { rss = $2 }
+        /^Pss:/ { pss = $2 }
+        /^Private_(Clean|Dirty):/ { priv += $2 }
+        END { printf "%-8s %10.1f %10.1f %10.1f\n", pid, rss / 1024, pss / 1024, priv / 1024 }
+    ' "/proc/$pid/smaps_rollup"
+done | tee "$TMPDIR/table"
+
+awk '{ pss += $3; priv += $4; n++ }
+     END { printf "\n%d个实例 Pss合计 %.1f MB，平均每个新增实例(Private) %.1f MB\n", n, pss, priv / n }' "$TMPDIR/table"
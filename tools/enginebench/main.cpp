@@ -0,0 +1,781 @@
+/**
+ * enginebench：内置推理引擎基准工具
+ *
+ * 对固定语料分别执行整句识别和分块识别，统计：
+ *   - 松键到出字延迟：整句模式为整段音频的识别耗时；分块模式为最后100ms送入 + finish()的耗时
+ *   - 字错误率(CER)及两种模式的差值
+ *   - 指定--batch时，另测按批推理（InferenceScheduler的批量路径）相对逐条推理的吞吐
+ *   - 指定--check-allocations时，在热身后再跑一遍语料，统计稳态推理路径（特征、编码、CTC、解码为token）
+ *     的堆分配次数，非零则返回码为2
+ *   - 指定--variants时，按列出的精度/内核组合（如fp32,int8:avx2,int8:avx512vnni，all为全部）分别加载模型，
+ *     对比各组合的延迟、RTF和CER（以第一个组合为基准）
+ *   - 指定--memory时只加载模型并预热一次，输出本进程的常驻内存构成（Linux，读取smaps_rollup）；
+ *     配合--hold保持运行，供instance_memory.sh统计多实例时每个新增实例的内存开销
+ *   - 指定--grammar时语料的参考文本应为词表中的短语，对比自由识别、自由识别后按编辑距离对应短语、
+ *     受限解码三种方式的松键延迟和整句正确率（需要手工修改的比例）
+ *   - 指定--threads时每次推理使用多个intra-op线程；指定--autotune时只加载模型，实测各"线程数×并发会话数"
+ *     组合的p95延迟和吞吐，输出满足目标延迟时吞吐最高的配置（即VOICE_ENGINE_THREADS=auto的选择）
+ *   - 指定--partials时按听写中间结果的方式，每隔指定毫秒重新识别一次已录部分，对比整段替换与稳定前缀提交
+ *     两种方式每秒音频的界面改动次数、被改写的已显示字符数和需重新排版的字符数，以及最终结果的CER
+ *
+ * 语料列表为UTF-8文本，每行 "<wav路径>\t<参考文本>"，wav须为16kHz单声道16位PCM，
+ * 相对路径以列表文件所在目录为基准。
+ *
+ * 用法：enginebench --model model.svnw --corpus corpus.tsv [--chunk 10] [--lookahead 5] [--batch 8]
+ *                   [--check-allocations]
+ *       enginebench --model model.svnw --corpus corpus.tsv --variants all
+ *       enginebench --model model.svnw --memory [--hold]
+ *       enginebench --model model.svnw --autotune 500
+ *       enginebench --model model.svnw --corpus commands.tsv --grammar phrases.txt
+ *       enginebench --model model.svnw --corpus corpus.tsv --partials 500
+ */
+
+#include "sensevoiceengine.h"
+#include "enginekernels.h"
+#include "engineautotuner.h"
+#include "stableprefixtracker.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QStringList>
+#include <QThread>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 统计全部堆分配次数，用于检查稳态推理是否零分配
+static std::atomic<quint64> g_heapAllocations(0);
+
+void *operator new(std::size_t size)
+{
+    ++g_heapAllocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+const int STREAM_BLOCK_MS = 100;    // 与VoiceRecognitionManager的送数间隔一致
+const int SAMPLE_RATE = 16000;
+
+struct Utterance {
+    QString path;
+    QString reference;
+    QVector<qint16> samples;
+};
+
+struct ModeResult {
+    QVector<double> latencyMs;
+    double computeMs = 0.0;
+    int errors = 0;
+    int referenceChars = 0;
+
+    double cer() const { return referenceChars ? 100.0 * errors / referenceChars : 0.0; }
+};
+
+struct PartialResult {
+    int edits = 0;                  // 界面改动次数
+    qint64 rewrittenChars = 0;      // 被删除改写的已显示字符
+    qint64 relayoutChars = 0;       // 每次改动后段落的总长度之和（排版以段落为单位）
+    ModeResult accuracy;            // 最终文本的CER
+
+    /**
+     * 记录一次改动：删除末尾removed个字符，追加added个字符，改动后段落长度为length
+     */
+    void edit(int removed, int added, int length)
+    {
+        if (removed == 0 && added == 0) {
+            return;
+        }
+        ++edits;
+        rewrittenChars += removed;
+        relayoutChars += length;
+    }
+};
+
+struct VariantResult {
+    QString name;
+    qint64 loadMs = 0;
+    ModeResult full;
+    ModeResult streaming;
+};
+
+bool readWav(const QString &path, QVector<qint16> &samples, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开: " + path;
+        return false;
+    }
+    QByteArray data = file.readAll();
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE") {
+        *error = "不是WAV文件: " + path;
+        return false;
+    }
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.skipRawData(12);
+    quint16 format = 0, channels = 0, bits = 0;
+    quint32 rate = 0;
+    while (!stream.atEnd()) {
+        char id[4];
+        quint32 size = 0;
+        stream.readRawData(id, 4);
+        stream >> size;
+        if (qstrncmp(id, "fmt ", 4) == 0) {
+            quint32 byteRate;
+            quint16 blockAlign;
+            stream >> format >> channels >> rate >> byteRate >> blockAlign >> bits;
+            stream.skipRawData(static_cast<int>(size) - 16);
+        } else if (qstrncmp(id, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16 || rate != SAMPLE_RATE) {
+                *error = "仅支持16kHz单声道16位PCM: " + path;
+                return false;
+            }
+            size = qMin<quint32>(size, static_cast<quint32>(data.size() - stream.device()->pos()));
+            samples.resize(static_cast<int>(size / 2));
+            stream.readRawData(reinterpret_cast<char *>(samples.data()), samples.size() * 2);
+            return true;
+        } else {
+            stream.skipRawData(static_cast<int>(size + (size & 1)));
+        }
+    }
+    *error = "缺少data块: " + path;
+    return false;
+}
+
+QString normalizeText(const QString &text)
+{
+    QString result;
+    for (const QChar &c : text) {
+        if (c.isLetterOrNumber()) {
+            result.append(c.toLower());
+        }
+    }
+    return result;
+}
+
+int editDistance(const QString &a, const QString &b)
+{
+    QVector<int> prev(b.size() + 1), curr(b.size() + 1);
+    for (int j = 0; j <= b.size(); ++j) {
+        prev[j] = j;
+    }
+    for (int i = 1; i <= a.size(); ++i) {
+        curr[0] = i;
+        for (int j = 1; j <= b.size(); ++j) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            curr[j] = std::min(std::min(prev[j] + 1, curr[j - 1] + 1), prev[j - 1] + cost);
+        }
+        std::swap(prev, curr);
+    }
+    return prev[b.size()];
+}
+
+double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(p * (values.size() - 1) + 0.5), values.size() - 1);
+    return values[index];
+}
+
+void score(ModeResult &result, const QString &reference, const QString &hypothesis)
+{
+    QString ref = normalizeText(reference);
+    result.errors += editDistance(ref, normalizeText(hypothesis));
+    result.referenceChars += ref.size();
+}
+
+/**
+ * 读取本进程的内存统计（kB），键为smaps_rollup中的字段名
+ */
+QMap<QString, qint64> readMemoryStats()
+{
+    QMap<QString, qint64> stats;
+    QFile file("/proc/self/smaps_rollup");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return stats;
+    }
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        int colon = line.indexOf(':');
+        if (colon > 0 && line.endsWith(" kB")) {
+            stats.insert(QString::fromLatin1(line.left(colon)),
+                         line.mid(colon + 1, line.size() - colon - 4).trimmed().toLongLong());
+        }
+    }
+    return stats;
+}
+
+int reportMemory(QTextStream &out, const SenseVoiceEngine &engine, bool hold)
+{
+    // 预热一次，让推理实际用到的权重页面全部调入
+    QVector<qint16> silence(SAMPLE_RATE, 0);
+    engine.recognize(silence.constData(), silence.size());
+
+    QMap<QString, qint64> stats = readMemoryStats();
+    if (stats.isEmpty()) {
+        out << "无法读取/proc/self/smaps_rollup（仅支持Linux）\n";
+        return 1;
+    }
+    out << "权重" << (engine.model().isMapped() ? "只读映射" : "读入内存") << "\n";
+    for (const QString &key : {QString("Rss"), QString("Pss"), QString("Shared_Clean"),
+                               QString("Private_Clean"), QString("Private_Dirty"), QString("Anonymous")}) {
+        out << key.leftJustified(16) << QString::number(stats.value(key) / 1024.0, 'f', 1).rightJustified(10)
+            << " MB\n";
+    }
+    out << "ready\n";
+    out.flush();
+
+    if (hold) {
+        // 保持运行直到被外部结束，期间由instance_memory.sh读取/proc/<pid>/smaps_rollup
+        forever {
+            QThread::sleep(3600);
+        }
+    }
+    return 0;
+}
+
+/**
+ * 分块模式：按录音节奏送数，最后一个送数周期的音频在松键后处理
+ * 返回松键后的耗时(ms)，录音过程中的计算耗时累加到recordingMs
+ */
+double runStream(SenseVoiceStream &stream, const qint16 *samples, int count, double *recordingMs,
+                 const CommandGrammar *grammar = nullptr)
+{
+    const int blockSamples = SAMPLE_RATE * STREAM_BLOCK_MS / 1000;
+    const int tail = count % blockSamples == 0 ? qMin(count, blockSamples) : count % blockSamples;
+    QElapsedTimer timer;
+    stream.reset(grammar);
+    for (int offset = 0; offset < count - tail; offset += blockSamples) {
+        timer.start();
+        stream.acceptWaveform(samples + offset, qMin(blockSamples, count - tail - offset));
+        *recordingMs += timer.nsecsElapsed() / 1e6;
+    }
+    timer.start();
+    stream.acceptWaveform(samples + count - tail, tail);
+    stream.inputFinished();
+    return timer.nsecsElapsed() / 1e6;
+}
+
+/**
+ * 整句与分块两种模式各识别一遍语料；showDiff时输出两种模式结果不同的条目
+ */
+void runCorpus(QTextStream &out, const SenseVoiceEngine &engine, SenseVoiceEngine::Workspace &workspace,
+               SenseVoiceStream &stream, const QVector<Utterance> &corpus,
+               ModeResult &full, ModeResult &streaming, bool showDiff)
+{
+    for (const Utterance &utt : corpus) {
+        const qint16 *samples = utt.samples.constData();
+        const int count = utt.samples.size();
+
+        // 整句模式：松键后才开始计算
+        QElapsedTimer timer;
+        timer.start();
+        SenseVoiceEngine::Utterance input = {samples, count};
+        engine.recognizeTokens(&input, 1, workspace);
+        QString fullText = engine.decodeTokens(workspace.tokenIds[0]);
+        double fullMs = timer.nsecsElapsed() / 1e6;
+        full.latencyMs.append(fullMs);
+        full.computeMs += fullMs;
+        score(full, utt.reference, fullText);
+
+        double recordingMs = 0.0;
+        double releaseMs = runStream(stream, samples, count, &recordingMs);
+        QString streamText = stream.partialText();
+        streaming.latencyMs.append(releaseMs);
+        streaming.computeMs += recordingMs + releaseMs;
+        score(streaming, utt.reference, streamText);
+
+        if (showDiff && fullText != streamText) {
+            out << "差异 " << QFileInfo(utt.path).fileName() << "\n  整句: " << fullText
+                << "\n  分块: " << streamText << "\n";
+        }
+    }
+}
+
+QString column(double value, int precision)
+{
+    return QString::number(value, 'f', precision).rightJustified(10);
+}
+
+void reportHeader(QTextStream &out, const QString &first)
+{
+    out << first.leftJustified(10) << QString("p50(ms)").rightJustified(10)
+        << QString("p95(ms)").rightJustified(10) << QString("p99(ms)").rightJustified(10)
+        << QString("RTF").rightJustified(10) << QString("CER(%)").rightJustified(10);
+}
+
+void reportRow(QTextStream &out, const QString &name, const ModeResult &r, double audioSeconds)
+{
+    out << name.leftJustified(10)
+        << column(percentile(r.latencyMs, 0.5), 1)
+        << column(percentile(r.latencyMs, 0.95), 1)
+        << column(percentile(r.latencyMs, 0.99), 1)
+        << column(r.computeMs / 1000.0 / audioSeconds, 3)
+        << column(r.cer(), 2);
+}
+
+/**
+ * 受限词表对比：自由识别、自由识别后按编辑距离对应短语、受限解码，统计松键延迟和整句正确率
+ */
+int compareGrammar(QTextStream &out, const SenseVoiceEngine &engine, SenseVoiceStream &stream,
+                   const QVector<Utterance> &corpus, const QString &grammarFile)
+{
+    QFile file(grammarFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        out << "无法打开词表: " << grammarFile << "\n";
+        return 1;
+    }
+    QStringList patterns;
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (!line.isEmpty() && !line.startsWith('#')) {
+            patterns.append(line);
+        }
+    }
+
+    CommandGrammar grammar;
+    QString error;
+    QElapsedTimer compileTimer;
+    compileTimer.start();
+    if (!grammar.compile(patterns, engine.model().tokens(), engine.model().config().blankId, &error)) {
+        out << "词表编译失败: " << error << "\n";
+        return 1;
+    }
+    out << "词表: " << grammar.phrases().size() << " 条短语, " << grammar.nodeCount() << " 个节点, 编译耗时 "
+        << QString::number(compileTimer.nsecsElapsed() / 1e6, 'f', 1) << " ms\n";
+
+    QVector<double> freeMs;
+    QVector<double> constrainedMs;
+    int freeCorrect = 0;
+    int snappedCorrect = 0;
+    int constrainedCorrect = 0;
+    for (const Utterance &utt : corpus) {
+        const QString reference = normalizeText(utt.reference);
+        double recordingMs = 0.0;
+        freeMs.append(runStream(stream, utt.samples.constData(), utt.samples.size(), &recordingMs));
+        const QString text = stream.partialText();
+        freeCorrect += normalizeText(text) == reference ? 1 : 0;
+        snappedCorrect += normalizeText(CommandGrammar::matchText(grammar.phrases(), text).text) == reference ? 1 : 0;
+
+        // 受限解码在最后一块中已推进完毕，finishCommand只取结果，一并计入松键延迟
+        constrainedMs.append(runStream(stream, utt.samples.constData(), utt.samples.size(), &recordingMs,
+                                       &grammar));
+        QElapsedTimer timer;
+        timer.start();
+        const CommandGrammar::Match match = stream.finishCommand();
+        constrainedMs.last() += timer.nsecsElapsed() / 1e6;
+        constrainedCorrect += normalizeText(match.text) == reference ? 1 : 0;
+        if (normalizeText(match.text) != reference) {
+            out << "错配 " << QFileInfo(utt.path).fileName() << "  参考: " << utt.reference << "  自由: " << text
+                << "  受限: " << match.text << " (" << QString::number(match.confidence, 'f', 2) << ")\n";
+        }
+    }
+
+    auto row = [&out, &corpus](const QString &name, const QVector<double> &latency, int correct) {
+        out << name.leftJustified(12) << column(percentile(latency, 0.5), 1) << column(percentile(latency, 0.95), 1)
+            << column(100.0 * correct / corpus.size(), 1) << "\n";
+    };
+    out << "\n" << QString("mode").leftJustified(12) << QString("p50(ms)").rightJustified(10)
+        << QString("p95(ms)").rightJustified(10) << QString("正确率(%)").rightJustified(10) << "\n";
+    row("free", freeMs, freeCorrect);
+    row("free+match", freeMs, snappedCorrect);
+    row("grammar", constrainedMs, constrainedCorrect);
+    return 0;
+}
+
+/**
+ * 解析--variants：逗号分隔的"精度[:内核]"，all展开为本机支持的每种fp32和int8内核
+ */
+QStringList parseVariants(const QString &spec)
+{
+    if (spec != "all") {
+        return spec.split(',', QString::SkipEmptyParts);
+    }
+    // fp32内核只区分到AVX-512（VNNI只用于int8）
+    QStringList variants;
+    const int fp32Best = qMin<int>(EngineKernels::bestIsa(), EngineKernels::Avx512);
+    for (int isa = EngineKernels::Generic; isa <= fp32Best; ++isa) {
+        variants.append(QString("fp32:") + EngineKernels::isaName(static_cast<EngineKernels::Isa>(isa)));
+    }
+    for (int isa = EngineKernels::Generic; isa <= EngineKernels::bestIsa(); ++isa) {
+        variants.append(QString("int8:") + EngineKernels::isaName(static_cast<EngineKernels::Isa>(isa)));
+    }
+    return variants;
+}
+
+/**
+ * 按每个精度/内核组合重新加载模型并识别语料，输出对比表，CER差值以第一个组合为基准
+ */
+int compareVariants(QTextStream &out, const QString &modelFile, const SenseVoiceEngine::Options &baseOptions,
+                    const QStringList &variants, const QVector<Utterance> &corpus, double audioSeconds)
+{
+    QVector<VariantResult> results;
+    for (const QString &variant : variants) {
+        SenseVoiceEngine::Options options = baseOptions;
+        options.precision = variant.section(':', 0, 0);
+        options.kernels = variant.section(':', 1, 1).isEmpty() ? QString("auto") : variant.section(':', 1, 1);
+
+        SenseVoiceEngine engine;
+        engine.setOptions(options);
+        QString error;
+        QElapsedTimer timer;
+        timer.start();
+        if (!engine.load(modelFile, &error)) {
+            out << variant << " 加载失败: " << error << "\n";
+            return 1;
+        }
+
+        VariantResult result;
+        result.loadMs = timer.elapsed();
+        result.name = QString(engine.model().precision() == SenseVoiceModel::Int8 ? "int8" : "fp32") + "/"
+                      + EngineKernels::isaName(EngineKernels::activeIsa());
+        out << "测试 " << result.name << " ...\n";
+        out.flush();
+
+        // 预热一条，避免首个组合承担权重页面调入的开销
+        SenseVoiceEngine::Workspace workspace(engine);
+        engine.reserveWorkspace(workspace, 1);
+        SenseVoiceStream stream(&engine);
+        SenseVoiceEngine::Utterance warmup = {corpus.first().samples.constData(), corpus.first().samples.size()};
+        engine.recognizeTokens(&warmup, 1, workspace);
+
+        runCorpus(out, engine, workspace, stream, corpus, result.full, result.streaming, false);
+        results.append(result);
+    }
+
+    out << "\n语料: " << corpus.size() << " 条, 共 " << QString::number(audioSeconds, 'f', 1) << " 秒\n";
+    out << QString("variant").leftJustified(18);
+    reportHeader(out, "mode");
+    out << QString("ΔCER").rightJustified(10) << QString("加载(ms)").rightJustified(10) << "\n";
+    for (const VariantResult &result : results) {
+        const VariantResult &base = results.first();
+        out << result.name.leftJustified(18);
+        reportRow(out, "full", result.full, audioSeconds);
+        out << column(result.full.cer() - base.full.cer(), 2) << QString::number(result.loadMs).rightJustified(10)
+            << "\n" << QString().leftJustified(18);
+        reportRow(out, "streaming", result.streaming, audioSeconds);
+        out << column(result.streaming.cer() - base.streaming.cer(), 2) << "\n";
+    }
+    out.flush();
+    return 0;
+}
+
+/**
+ * 模拟听写的中间结果：每intervalMs录音重新识别一次已录部分，分别按整段替换和稳定前缀提交更新显示文本
+ */
+int comparePartials(QTextStream &out, const SenseVoiceEngine &engine, SenseVoiceEngine::Workspace &workspace,
+                    const QVector<Utterance> &corpus, double audioSeconds, int intervalMs)
+{
+    PartialResult replace;
+    PartialResult stable;
+    std::vector<StablePrefixTracker::Token> tokens;
+    StablePrefixTracker tracker;
+    const int step = qMax(intervalMs, 1) * SAMPLE_RATE / 1000;
+
+    for (const Utterance &utt : corpus) {
+        QString replaceShown;
+        QString committed;
+        QString tentative;
+        tracker.reset();
+        for (int end = qMin(step, utt.samples.size()); ; end = qMin(end + step, utt.samples.size())) {
+            const bool last = end == utt.samples.size();
+            engine.recognizeAligned(utt.samples.constData(), end, workspace, tokens);
+
+            // 整段替换：文本有变化就整体删掉重写
+            const QString text = engine.decodeTokens(workspace.tokenIds[0]);
+            if (text != replaceShown) {
+                replace.edit(replaceShown.size(), text.size(), text.size());
+                replaceShown = text;
+            }
+
+            // 稳定前缀：定稿部分只追加，只改写未定稿的尾部
+            if (last) {
+                tracker.finish(tokens);
+            } else {
+                tracker.update(tokens, end * 1000 / SAMPLE_RATE);
+            }
+            const QString nowCommitted = engine.decodeTokens(tracker.committedIds());
+            const QString all = engine.decodeTokens(tracker.allIds());
+            const QString delta = nowCommitted.startsWith(committed) ? nowCommitted.mid(committed.size()) : QString();
+            const QString nowTentative = all.startsWith(nowCommitted) ? all.mid(nowCommitted.size()) : QString();
+            if (!delta.isEmpty() || nowTentative != tentative) {
+                committed += delta;
+                stable.edit(tentative.size(), delta.size() + nowTentative.size(), committed.size() + nowTentative.size());
+                tentative = nowTentative;
+            }
+            if (last) {
+                break;
+            }
+        }
+        score(replace.accuracy, utt.reference, replaceShown);
+        score(stable.accuracy, utt.reference, committed);
+    }
+
+    auto row = [&out, audioSeconds](const QString &name, const PartialResult &result) {
+        out << name.leftJustified(10) << column(result.edits / audioSeconds, 2)
+            << column(result.rewrittenChars / audioSeconds, 1) << column(result.relayoutChars / audioSeconds, 1)
+            << column(result.accuracy.cer(), 2) << "\n";
+    };
+    out << "\n语料: " << corpus.size() << " 条, 共 " << QString::number(audioSeconds, 'f', 1)
+        << " 秒  中间结果间隔: " << intervalMs << " ms\n";
+    out << QString("mode").leftJustified(10) << QString("改动/秒").rightJustified(10)
+        << QString("改写字符/秒").rightJustified(10) << QString("重排字符/秒").rightJustified(10)
+        << QString("CER(%)").rightJustified(10) << "\n";
+    row("replace", replace);
+    row("stable", stable);
+    out.flush();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("内置推理引擎整句/分块识别基准");
+    parser.addHelpOption();
+    parser.addOption({"model", "权重文件(model.svnw)", "file"});
+    parser.addOption({"corpus", "语料列表: <wav>\\t<参考文本>", "file"});
+    parser.addOption({"chunk", "每块提交的LFR帧数", "frames", "10"});
+    parser.addOption({"lookahead", "每块前瞻帧数", "frames", "5"});
+    parser.addOption({"lookback", "注意力回看帧数，-1表示整句", "frames", "-1"});
+    parser.addOption({"language", "语种", "lang", "auto"});
+    parser.addOption({"precision", "线性层精度: auto/fp32/int8", "precision", "auto"});
+    parser.addOption({"kernels", "内核指令集: auto/generic/avx2/avx512/avx512vnni", "isa", "auto"});
+    parser.addOption({"variants", "对比多个精度/内核组合，如fp32,int8:avx2；all为全部", "list"});
+    parser.addOption({"batch", "批量推理每批条数，0表示不测", "size", "0"});
+    parser.addOption({"check-allocations", "热身后检查稳态推理路径是否零堆分配"});
+    parser.addOption({"memory", "只加载模型并输出常驻内存构成"});
+    parser.addOption({"hold", "与--memory一起使用，输出后保持运行"});
+    parser.addOption({"threads", "每次推理的intra-op线程数", "count", "1"});
+    parser.addOption({"grammar", "受限词表文件（每行一个短语或语法），对比自由识别与受限解码", "file"});
+    parser.addOption({"autotune", "只加载模型，实测线程配置并按目标延迟选择", "ms"});
+    parser.addOption({"partials", "按听写中间结果的间隔重新识别，对比整段替换与稳定前缀提交", "ms"});
+    parser.process(app);
+
+    if (!parser.isSet("model")
+        || (!parser.isSet("corpus") && !parser.isSet("memory") && !parser.isSet("autotune"))) {
+        parser.showHelp(1);
+    }
+
+    SenseVoiceEngine::Options options;
+    options.language = parser.value("language");
+    options.chunkFrames = parser.value("chunk").toInt();
+    options.lookaheadFrames = parser.value("lookahead").toInt();
+    options.lookBackFrames = parser.value("lookback").toInt();
+    options.precision = parser.value("precision");
+    options.kernels = parser.value("kernels");
+    options.intraOpThreads = qMax(1, parser.value("threads").toInt());
+
+    QString error;
+    if (parser.isSet("autotune")) {
+        SenseVoiceEngine engine;
+        engine.setOptions(options);
+        if (!engine.load(parser.value("model"), &error)) {
+            out << "模型加载失败: " << error << "\n";
+            return 1;
+        }
+        EngineAutotuner::Options tuneOptions;
+        tuneOptions.targetLatencyMs = parser.value("autotune").toInt();
+        EngineAutotuner::Result result = EngineAutotuner::run(engine, tuneOptions);
+        out << "threads  sessions  p95(ms)  吞吐(秒音频/秒)\n";
+        for (const EngineAutotuner::Measurement &m : result.measurements) {
+            out << QString("%1  %2  %3  %4\n")
+                       .arg(m.intraOpThreads, 7)
+                       .arg(m.sessions, 8)
+                       .arg(m.p95LatencyMs, 7, 'f', 1)
+                       .arg(m.throughput, 14, 'f', 2);
+        }
+        out << "\n选择: " << EngineAutotuner::summary(result) << "\n";
+        out << "VOICE_ENGINE_THREADS=" << result.intraOpThreads << "x" << result.sessions << "\n";
+        return result.valid ? 0 : 1;
+    }
+
+    if (parser.isSet("memory")) {
+        SenseVoiceEngine engine;
+        engine.setOptions(options);
+        QElapsedTimer loadTimer;
+        loadTimer.start();
+        if (!engine.load(parser.value("model"), &error)) {
+            out << "模型加载失败: " << error << "\n";
+            return 1;
+        }
+        out << "模型加载耗时: " << loadTimer.elapsed() << " ms\n";
+        return reportMemory(out, engine, parser.isSet("hold"));
+    }
+
+    // 读取语料
+    QFile corpusFile(parser.value("corpus"));
+    if (!corpusFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        out << "无法打开语料列表: " << corpusFile.fileName() << "\n";
+        return 1;
+    }
+    QDir corpusDir = QFileInfo(corpusFile).absoluteDir();
+    QVector<Utterance> corpus;
+    double audioSeconds = 0.0;
+    QTextStream corpusStream(&corpusFile);
+    corpusStream.setCodec("UTF-8");
+    while (!corpusStream.atEnd()) {
+        QString line = corpusStream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        Utterance utt;
+        utt.path = corpusDir.absoluteFilePath(line.section('\t', 0, 0));
+        utt.reference = line.section('\t', 1);
+        if (!readWav(utt.path, utt.samples, &error)) {
+            out << "跳过: " << error << "\n";
+            continue;
+        }
+        audioSeconds += static_cast<double>(utt.samples.size()) / SAMPLE_RATE;
+        corpus.append(utt);
+    }
+    if (corpus.isEmpty()) {
+        out << "语料为空\n";
+        return 1;
+    }
+
+    if (parser.isSet("variants")) {
+        return compareVariants(out, parser.value("model"), options, parseVariants(parser.value("variants")),
+                               corpus, audioSeconds);
+    }
+
+    SenseVoiceEngine engine;
+    engine.setOptions(options);
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    if (!engine.load(parser.value("model"), &error)) {
+        out << "模型加载失败: " << error << "\n";
+        return 1;
+    }
+    out << "模型加载耗时: " << loadTimer.elapsed() << " ms  精度: "
+        << (engine.model().precision() == SenseVoiceModel::Int8 ? "int8" : "fp32")
+        << "  内核: " << EngineKernels::isaName(EngineKernels::activeIsa())
+        << "  线程: " << options.intraOpThreads << "\n";
+
+    // 与应用中一样复用工作区和识别会话
+    SenseVoiceEngine::Workspace workspace(engine);
+    engine.reserveWorkspace(workspace, qMax(1, parser.value("batch").toInt()));
+    SenseVoiceStream stream(&engine);
+
+    if (parser.isSet("grammar")) {
+        return compareGrammar(out, engine, stream, corpus, parser.value("grammar"));
+    }
+    if (parser.isSet("partials")) {
+        return comparePartials(out, engine, workspace, corpus, audioSeconds, parser.value("partials").toInt());
+    }
+
+    ModeResult full;
+    ModeResult streaming;
+    runCorpus(out, engine, workspace, stream, corpus, full, streaming, true);
+
+    out << "\n语料: " << corpus.size() << " 条, 共 " << QString::number(audioSeconds, 'f', 1) << " 秒"
+        << "  chunk=" << options.chunkFrames << " lookahead=" << options.lookaheadFrames
+        << " lookback=" << options.lookBackFrames << "\n";
+    reportHeader(out, "mode");
+    out << "\n";
+    reportRow(out, "full", full, audioSeconds);
+    out << "\n";
+    reportRow(out, "streaming", streaming, audioSeconds);
+    out << "\nCER差值(分块-整句): " << QString::number(streaming.cer() - full.cer(), 'f', 2) << "%\n";
+
+    // 批量推理：语料按batch条一组送入recognizeBatch，与逐条整句识别的总耗时对比
+    const int batchSize = parser.value("batch").toInt();
+    if (batchSize > 0) {
+        ModeResult batched;
+        QElapsedTimer timer;
+        for (int start = 0; start < corpus.size(); start += batchSize) {
+            QVector<QByteArray> utterances;
+            for (int i = start; i < qMin(start + batchSize, corpus.size()); ++i) {
+                const QVector<qint16> &samples = corpus[i].samples;
+                utterances.append(QByteArray(reinterpret_cast<const char *>(samples.constData()),
+                                             samples.size() * 2));
+            }
+            timer.restart();
+            QStringList texts = engine.recognizeBatch(utterances, workspace);
+            double ms = timer.nsecsElapsed() / 1e6;
+            batched.computeMs += ms;
+            for (int i = 0; i < texts.size(); ++i) {
+                batched.latencyMs.append(ms);
+                score(batched, corpus[start + i].reference, texts[i]);
+            }
+        }
+        out << "\n批量推理 batch=" << batchSize << "\n";
+        reportRow(out, "batched", batched, audioSeconds);
+        out << "\n";
+        out << "吞吐(秒音频/秒): 逐条 " << QString::number(audioSeconds * 1000.0 / full.computeMs, 'f', 2)
+            << "  批量 " << QString::number(audioSeconds * 1000.0 / batched.computeMs, 'f', 2) << "\n";
+    }
+
+    // 稳态零分配检查：上面已用同样的语料热身，这里只统计推理路径本身（不含生成文本）；
+    // recognize()生成文本，只检查它的工作区没有重建或扩容（计入arena扩容）
+    if (parser.isSet("check-allocations")) {
+        quint64 fullAllocations = 0;
+        quint64 streamAllocations = 0;
+        if (!corpus.isEmpty()) {
+            engine.recognize(corpus[0].samples.constData(), corpus[0].samples.size());
+        }
+        quint64 arenaBefore = InferenceArena::totalHeapAllocations();
+        for (const Utterance &utt : corpus) {
+            SenseVoiceEngine::Utterance input = {utt.samples.constData(), utt.samples.size()};
+            quint64 before = g_heapAllocations.load();
+            engine.recognizeTokens(&input, 1, workspace);
+            fullAllocations += g_heapAllocations.load() - before;
+            engine.recognize(utt.samples.constData(), utt.samples.size());
+
+            double recordingMs = 0.0;
+            before = g_heapAllocations.load();
+            runStream(stream, utt.samples.constData(), utt.samples.size(), &recordingMs);
+            streamAllocations += g_heapAllocations.load() - before;
+        }
+        quint64 arenaGrowth = InferenceArena::totalHeapAllocations() - arenaBefore;
+        out << "\n稳态堆分配: 整句 " << fullAllocations << "  分块 " << streamAllocations
+            << "  arena扩容 " << arenaGrowth << "  arena容量 "
+            << QString::number(workspace.arena.capacity() / 1048576.0, 'f', 1) << " MB\n";
+        if (fullAllocations + streamAllocations + arenaGrowth > 0) {
+            out << "FAIL: 稳态推理路径存在堆分配\n";
+            out.flush();
+            return 2;
+        }
+        out << "PASS\n";
+    }
+    out.flush();
+
+    return 0;
+}
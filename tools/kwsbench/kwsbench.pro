@@ -0,0 +1,19 @@
+# 唤醒词检测基准：常驻检测的CPU占用、误唤醒率和检出率
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = kwsbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../APP/engine/engine.pri)
+
+SOURCES += \
+    main.cpp \
+    ../../APP/voicelogging.cpp
+
+HEADERS += \
+    ../../APP/voicelogging.h
@@ -0,0 +1,247 @@
+/**
+ * kwsbench：唤醒词检测基准工具
+ *
+ * 用唤醒词模板（KeywordSpotter）按VoiceRecognitionManager免按键模式的方式逐块处理录音，统计：
+ *   - 检出率：每条正样本（含一次唤醒词的录音）至少命中一次的比例
+ *   - 误唤醒率：负样本（不含唤醒词的长录音：对话、键盘声、环境噪声等）上每小时的命中次数
+ *   - CPU占用：在负样本上按默认阈值处理的耗时 / 音频时长，即常驻检测占单核的比例，
+ *     以及通过能量门控、实际做DTW匹配的帧比例；超过--max-cpu时返回码为2
+ * 多个阈值逐一测试，用于选取VOICE_WAKE_THRESHOLD。
+ *
+ * 正样本列表为UTF-8文本，每行一个wav路径，相对路径以列表文件所在目录为基准；
+ * wav须为16kHz单声道16位PCM。
+ *
+ * 用法：kwsbench --templates kw1.wav,kw2.wav,kw3.wav --positives positives.txt --negatives office.wav,street.wav
+ *                [--thresholds 0.1,0.15,0.2,0.25,0.3] [--block 100] [--max-cpu 2]
+ */
+
+#include "keywordspotter.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+
+struct Recording {
+    QString path;
+    QVector<qint16> samples;
+};
+
+struct RunResult {
+    int detections = 0;
+    qint64 elapsedNs = 0;
+    qint64 frames = 0;
+    qint64 matchedFrames = 0;
+};
+
+bool readWav(const QString &path, QVector<qint16> &samples, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开: " + path;
+        return false;
+    }
+    QByteArray data = file.readAll();
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE") {
+        *error = "不是WAV文件: " + path;
+        return false;
+    }
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.skipRawData(12);
+    quint16 format = 0, channels = 0, bits = 0;
+    quint32 rate = 0;
+    while (!stream.atEnd()) {
+        char id[4];
+        quint32 size = 0;
+        stream.readRawData(id, 4);
+        stream >> size;
+        if (qstrncmp(id, "fmt ", 4) == 0) {
+            quint32 byteRate;
+            quint16 blockAlign;
+            stream >> format >> channels >> rate >> byteRate >> blockAlign >> bits;
+            stream.skipRawData(static_cast<int>(size) - 16);
+        } else if (qstrncmp(id, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16 || rate != SAMPLE_RATE) {
+                *error = "仅支持16kHz单声道16位PCM: " + path;
+                return false;
+            }
+            size = qMin<quint32>(size, static_cast<quint32>(data.size() - stream.device()->pos()));
+            samples.resize(static_cast<int>(size / 2));
+            stream.readRawData(reinterpret_cast<char *>(samples.data()), samples.size() * 2);
+            return true;
+        } else {
+            stream.skipRawData(static_cast<int>(size + (size & 1)));
+        }
+    }
+    *error = "缺少data块: " + path;
+    return false;
+}
+
+bool readRecordings(const QStringList &paths, QVector<Recording> &recordings, QString *error)
+{
+    for (const QString &path : paths) {
+        Recording recording;
+        recording.path = path;
+        if (!readWav(path, recording.samples, error)) {
+            return false;
+        }
+        recordings.append(recording);
+    }
+    return true;
+}
+
+QStringList readList(const QString &listFile, QString *error)
+{
+    QFile file(listFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "无法打开: " + listFile;
+        return QStringList();
+    }
+    const QDir base = QFileInfo(listFile).absoluteDir();
+    QStringList paths;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        const QString path = QString::fromUtf8(line).trimmed();
+        if (!path.isEmpty() && !path.startsWith('#')) {
+            paths.append(QDir::isAbsolutePath(path) ? path : base.filePath(path));
+        }
+    }
+    return paths;
+}
+
+/**
+ * 按块送入一段录音，统计命中次数和检测耗时；块大小与管理器收到的监听数据相当
+ */
+void runRecording(KeywordSpotter &spotter, const Recording &recording, int blockSamples, RunResult &result)
+{
+    spotter.reset();
+    QElapsedTimer timer;
+    for (int offset = 0; offset < recording.samples.size(); offset += blockSamples) {
+        const int count = qMin(blockSamples, recording.samples.size() - offset);
+        timer.start();
+        const bool detected = spotter.acceptWaveform(recording.samples.constData() + offset, count);
+        result.elapsedNs += timer.nsecsElapsed();
+        if (detected) {
+            ++result.detections;
+        }
+    }
+    result.frames += spotter.frames();
+    result.matchedFrames += spotter.matchedFrames();
+}
+
+QString column(double value, int precision, int width = 14)
+{
+    return QString::number(value, 'f', precision).rightJustified(width);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("唤醒词检测的CPU占用、误唤醒率和检出率基准");
+    parser.addHelpOption();
+    parser.addOption({"templates", "唤醒词模板wav，逗号分隔", "files"});
+    parser.addOption({"positives", "正样本列表，每行一个含唤醒词的wav", "file"});
+    parser.addOption({"negatives", "不含唤醒词的长录音wav，逗号分隔", "files"});
+    parser.addOption({"thresholds", "逐一测试的检测阈值", "list", "0.1,0.15,0.2,0.25,0.3"});
+    parser.addOption({"block", "每次送入的音频时长", "ms", "100"});
+    parser.addOption({"max-cpu", "默认阈值下单核CPU占用上限(%)，超过则返回2", "percent", "2"});
+    parser.process(app);
+
+    if (!parser.isSet("templates") || (!parser.isSet("positives") && !parser.isSet("negatives"))) {
+        parser.showHelp(1);
+    }
+
+    QString error;
+    QVector<Recording> templates;
+    QVector<Recording> positives;
+    QVector<Recording> negatives;
+    if (!readRecordings(parser.value("templates").split(',', QString::SkipEmptyParts), templates, &error)
+        || (parser.isSet("positives") && !readRecordings(readList(parser.value("positives"), &error), positives, &error))
+        || !readRecordings(parser.value("negatives").split(',', QString::SkipEmptyParts), negatives, &error)) {
+        out << error << "\n";
+        return 1;
+    }
+
+    double negativeSeconds = 0.0;
+    for (const Recording &recording : negatives) {
+        negativeSeconds += recording.samples.size() / static_cast<double>(SAMPLE_RATE);
+    }
+    const int blockSamples = qMax(1, parser.value("block").toInt() * SAMPLE_RATE / 1000);
+
+    auto createSpotter = [&templates, &out](float threshold) {
+        KeywordSpotter::Options options;
+        if (threshold > 0.0f) {
+            options.threshold = threshold;
+        }
+        KeywordSpotter *spotter = new KeywordSpotter(options);
+        for (const Recording &recording : templates) {
+            if (!spotter->addTemplate(recording.samples.constData(), recording.samples.size()) && threshold <= 0.0f) {
+                out << "模板无效（裁掉首尾静音后须为0.24~2秒）: " << recording.path << "\n";
+            }
+        }
+        return spotter;
+    };
+
+    QScopedPointer<KeywordSpotter> defaultSpotter(createSpotter(0.0f));
+    if (defaultSpotter->templateCount() == 0) {
+        out << "没有有效的唤醒词模板\n";
+        return 1;
+    }
+    out << "模板: " << defaultSpotter->templateCount() << " 个, 正样本: " << positives.size()
+        << " 条, 负样本: " << QString::number(negativeSeconds / 3600.0, 'f', 2) << " 小时\n\n";
+
+    out << QString("阈值").leftJustified(8) << QString("检出率(%)").rightJustified(14)
+        << QString("误唤醒/小时").rightJustified(14) << "\n";
+    for (const QString &value : parser.value("thresholds").split(',', QString::SkipEmptyParts)) {
+        QScopedPointer<KeywordSpotter> spotter(createSpotter(value.toFloat()));
+        int hits = 0;
+        for (const Recording &recording : positives) {
+            RunResult result;
+            runRecording(*spotter, recording, blockSamples, result);
+            hits += result.detections > 0 ? 1 : 0;
+        }
+        RunResult negative;
+        for (const Recording &recording : negatives) {
+            runRecording(*spotter, recording, blockSamples, negative);
+        }
+        out << value.leftJustified(8)
+            << (positives.isEmpty() ? QString("-").rightJustified(14) : column(100.0 * hits / positives.size(), 1))
+            << (negatives.isEmpty() ? QString("-").rightJustified(14)
+                                    : column(negative.detections / (negativeSeconds / 3600.0), 2))
+            << "\n";
+        out.flush();
+    }
+
+    // 常驻检测的开销以负样本为准：绝大部分时间没有人说唤醒词
+    const QVector<Recording> &cpuSet = negatives.isEmpty() ? positives : negatives;
+    RunResult cpu;
+    double cpuSeconds = 0.0;
+    for (const Recording &recording : cpuSet) {
+        runRecording(*defaultSpotter, recording, blockSamples, cpu);
+        cpuSeconds += recording.samples.size() / static_cast<double>(SAMPLE_RATE);
+    }
+    const double cpuPercent = cpuSeconds > 0.0 ? 100.0 * (cpu.elapsedNs / 1e9) / cpuSeconds : 0.0;
+    out << "\nCPU（默认阈值" << defaultSpotter->options().threshold << "）: 处理 "
+        << QString::number(cpuSeconds, 'f', 1) << " 秒音频耗时 " << QString::number(cpu.elapsedNs / 1e6, 'f', 1)
+        << " ms, 单核占用 " << QString::number(cpuPercent, 'f', 3) << "%, 做DTW匹配的帧 "
+        << QString::number(100.0 * cpu.matchedFrames / qMax<qint64>(cpu.frames, 1), 'f', 1) << "%\n";
+    out.flush();
+
+    return cpuPercent > parser.value("max-cpu").toDouble() ? 2 : 0;
+}
@@ -0,0 +1,43 @@
+# 端到端延迟基准：按键录音脚本驱动VoiceRecognitionManager，统计各阶段分位数和并发吞吐
+QT       += core gui widgets network multimedia
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = latencybench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../APP
+
+SOURCES += \
+    main.cpp \
+    ../../APP/recognitionprotocol.cpp \
+    ../../APP/voicerecognitionmanager.cpp \
+    ../../APP/enginepipeline.cpp \
+    ../../APP/dictationpipeline.cpp \
+    ../../APP/handsfreepipeline.cpp \
+    ../../APP/capturestore.cpp \
+    ../../APP/latencyhistogram.cpp \
+    ../../APP/pipelinetrace.cpp \
+    ../../APP/sessionrecorder.cpp \
+    ../../APP/voicelogging.cpp \
+    ../../APP/audiosource.cpp \
+    ../../APP/capturehealth.cpp
+
+HEADERS += \
+    ../../APP/recognitionprotocol.h \
+    ../../APP/voicerecognitionmanager.h \
+    ../../APP/enginepipeline.h \
+    ../../APP/dictationpipeline.h \
+    ../../APP/handsfreepipeline.h \
+    ../../APP/capturestore.h \
+    ../../APP/audiosource.h \
+    ../../APP/capturehealth.h \
+    ../../APP/requestmetrics.h \
+    ../../APP/latencyhistogram.h \
+    ../../APP/pipelinetrace.h \
+    ../../APP/sessionrecorder.h \
+    ../../APP/voicelogging.h
+
+include(../../APP/engine/engine.pri)
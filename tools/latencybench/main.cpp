@@ -0,0 +1,540 @@
+/**
+ * latencybench：识别链路端到端延迟基准
+ *
+ * 在进程内驱动VoiceRecognitionManager，按VoiceRecognitionManager::requestCompleted带回的时间戳统计各阶段耗时：
+ *   - startup：按键到录音设备启动；first-audio：设备启动到第一块录音数据
+ *   - capture：松键到录音封口；encode：WAV头和表单组装；upload：请求体上传；server：上传完成到响应首字节
+ *     （内置引擎为识别耗时）；download：响应首字节到全部收到；parse：解析响应；
+ *     insert：结果插入输入框（QTextEdit::insertPlainText后调用reportTextInserted）
+ *   - total：松键（批量请求为提交）到文字插入，即用户等待的时间
+ * 两种负载：
+ *   - 按键录音：录音来源为回放语料的文件（AudioSource），每条语料按脚本"按下 → 放完音频 → 再按住tail毫秒 → 松键"，
+ *     一条出字后间隔--gap毫秒再按下一条
+ *   - --concurrency列出的每个并发数：用recognizeAudio保持N条请求在途，统计吞吐（条/秒、秒音频/秒）和各阶段分位数。
+ *     QNetworkAccessManager对同一主机最多6个HTTP/1.1连接，超过6的并发在客户端排队，排队时间计入upload
+ * 识别后端为--url的服务（真实服务或本地替身），或--model的内置引擎。
+ * 每个阶段输出p50/p95/p99（毫秒）；--json把全部结果写成JSON，--label标记本次构建，便于不同构建之间对比。
+ * 按键录音的total p95超过--max-p95毫秒时返回码为2。
+ * --speculative按给定间隔开启投机识别（VoiceRecognitionManager::setSpeculativeInterval），
+ * --baseline读入之前一次的--json结果，逐项输出两次的total p50/p95及变化，用于记录某项改动前后的实测数字。
+ * --trace把整个运行的时间线（管理器、网络、各请求的阶段，服务端返回Server-Timing时含服务端各段）写成Chrome trace JSON，
+ * 用ui.perfetto.dev打开，查看某条慢请求的时间花在哪里。
+ *
+ * 语料列表为UTF-8文本，每行 "<wav路径>[\t<松键前多按住的毫秒>]"，wav须为16kHz单声道16位PCM，
+ * 相对路径以列表文件所在目录为基准；未写按住时长的行用--tail。
+ * 管理器与本工具在同一线程（不调用initialize），与应用中控件直接调用管理器的方式一致。
+ *
+ * 用法：latencybench --corpus corpus.txt [--url http://127.0.0.1:8000 | --model model.svnw] [--repeat 3]
+ *                    [--speed 1] [--tail 300] [--gap 200] [--concurrency 1,4,8] [--requests 100]
+ *                    [--speculative 4000] [--json result.json] [--label build-id] [--baseline before.json]
+ *                    [--max-p95 ms] [--trace trace.json] [--verbose]
+ * 无显示环境下可加 -platform offscreen
+ */
+
+#include "voicerecognitionmanager.h"
+#include "requestmetrics.h"
+#include "audiosource.h"
+#include "pipelinetrace.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextEdit>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+const int COMPLETION_TIMEOUT_MS = 30000;    // 单条请求等待上限，管理器自身的请求超时为10秒
+
+struct Utterance {
+    QString path;
+    int tailMs = -1;                        // 放完音频后再按住的时长，-1表示用--tail
+    QByteArray pcm;
+
+    double seconds() const { return pcm.size() / 32000.0; }
+};
+
+struct RunResult {
+    QString name;
+    int concurrency = 1;
+    int requests = 0;
+    int errors = 0;
+    double seconds = 0.0;                   // 墙钟时间
+    double audioSeconds = 0.0;              // 成功识别的音频时长
+    QVector<double> stageMs[RequestMetrics::StageCount];
+    QVector<double> totalMs;
+    QHash<QString, int> errorCounts;
+
+    void add(const RequestMetrics &metrics)
+    {
+        ++requests;
+        if (!metrics.error.isEmpty()) {
+            ++errors;
+            ++errorCounts[metrics.error];
+            return;
+        }
+        audioSeconds += metrics.audioBytes / 32000.0;
+        for (int stage = 0; stage < RequestMetrics::StageCount; ++stage) {
+            const qint64 ns = metrics.stageNs(static_cast<RequestMetrics::Stage>(stage));
+            if (ns >= 0) {
+                stageMs[stage].append(ns / 1e6);
+            }
+        }
+        const qint64 total = metrics.totalNs();
+        if (total >= 0) {
+            totalMs.append(total / 1e6);
+        }
+    }
+};
+
+void discardDebugMessages(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context);
+    if (type != QtDebugMsg) {
+        QTextStream(stderr) << message << "\n";
+    }
+}
+
+double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(p * (values.size() - 1) + 0.5), values.size() - 1);
+    return values[index];
+}
+
+bool readCorpus(const QString &listPath, QVector<Utterance> &corpus, QString *error)
+{
+    QFile file(listPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "无法打开语料列表: " + listPath;
+        return false;
+    }
+    const QDir base = QFileInfo(listPath).absoluteDir();
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split('\t');
+        Utterance utterance;
+        utterance.path = base.absoluteFilePath(fields[0].trimmed());
+        if (fields.size() > 1) {
+            utterance.tailMs = fields[1].trimmed().toInt();
+        }
+        if (!AudioSource::readWavFile(utterance.path, &utterance.pcm, error)) {
+            return false;
+        }
+        corpus.append(utterance);
+    }
+    if (corpus.isEmpty()) {
+        *error = "语料列表为空: " + listPath;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 运行事件循环直到done()成立或超时；每条请求结束（requestCompleted）时检查一次
+ */
+bool waitUntil(VoiceRecognitionManager *manager, const std::function<bool()> &done, int timeoutMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+    while (!done()) {
+        const qint64 remaining = timeoutMs - clock.elapsed();
+        if (remaining <= 0) {
+            return false;
+        }
+        QEventLoop loop;
+        QTimer::singleShot(static_cast<int>(remaining), &loop, &QEventLoop::quit);
+        QObject::connect(manager, &VoiceRecognitionManager::requestCompleted, &loop, &QEventLoop::quit,
+                         Qt::QueuedConnection);
+        loop.exec();
+    }
+    return true;
+}
+
+void sleepMs(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+QString column(double value, int precision, int width = 10)
+{
+    return QString::number(value, 'f', precision).rightJustified(width);
+}
+
+void report(QTextStream &out, const RunResult &run)
+{
+    out << "\n== " << run.name << "  请求: " << run.requests << "  失败: " << run.errors;
+    if (run.seconds > 0.0) {
+        out << "  吞吐: " << QString::number(run.requests / run.seconds, 'f', 2) << " 条/秒, "
+            << QString::number(run.audioSeconds / run.seconds, 'f', 2) << " 秒音频/秒";
+    }
+    out << "\n";
+    out << QString("阶段").leftJustified(10) << QString("次数").rightJustified(8) << QString("p50(ms)").rightJustified(10)
+        << QString("p95(ms)").rightJustified(10) << QString("p99(ms)").rightJustified(10) << "\n";
+    auto row = [&out](const QString &name, const QVector<double> &values) {
+        if (values.isEmpty()) {
+            return;
+        }
+        out << name.leftJustified(10) << QString::number(values.size()).rightJustified(8)
+            << column(percentile(values, 0.5), 1) << column(percentile(values, 0.95), 1)
+            << column(percentile(values, 0.99), 1) << "\n";
+    };
+    for (int stage = 0; stage < RequestMetrics::StageCount; ++stage) {
+        row(RequestMetrics::stageName(static_cast<RequestMetrics::Stage>(stage)), run.stageMs[stage]);
+    }
+    row("total", run.totalMs);
+    for (auto it = run.errorCounts.constBegin(); it != run.errorCounts.constEnd(); ++it) {
+        out << "  失败 " << it.value() << " 次: " << it.key() << "\n";
+    }
+    out.flush();
+}
+
+void report(QTextStream &out, const CaptureHealth &health)
+{
+    out << "采集回调: " << health.callbacks << "  周期p50/p99(ms): "
+        << QString::number(health.period.percentileNs(50) / 1e6, 'f', 1) << "/"
+        << QString::number(health.period.percentileNs(99) / 1e6, 'f', 1) << "  抖动p99(ms): "
+        << QString::number(health.jitter.percentileNs(99) / 1e6, 'f', 1) << "  最大偏差(ms): "
+        << QString::number(health.maxDriftUs / 1000.0, 'f', 1) << "  空洞: " << health.gaps << "\n";
+    out.flush();
+}
+
+QJsonObject toJson(const CaptureHealth &health)
+{
+    QJsonObject object;
+    object["callbacks"] = health.callbacks;
+    object["periodP50"] = health.period.percentileNs(50) / 1e6;
+    object["periodP99"] = health.period.percentileNs(99) / 1e6;
+    object["jitterP99"] = health.jitter.percentileNs(99) / 1e6;
+    object["maxDriftMs"] = health.maxDriftUs / 1000.0;
+    object["gaps"] = health.gaps;
+    object["lostMs"] = health.lostUs / 1000.0;
+    return object;
+}
+
+/**
+ * 与之前一次--json结果中同名的各项对比total的p50/p95，失败返回false并设置error
+ */
+bool compareWithBaseline(QTextStream &out, const QJsonArray &runs, const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开: " + path;
+        return false;
+    }
+    const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+    if (!baseline.contains("runs")) {
+        *error = "不是latencybench的JSON结果: " + path;
+        return false;
+    }
+    QHash<QString, QJsonObject> before;
+    for (const QJsonValue &value : baseline["runs"].toArray()) {
+        before.insert(value.toObject()["name"].toString(), value.toObject());
+    }
+
+    out << "
+对比 " << path << "（" << baseline["label"].toString() << "）total(ms)
+";
+    out << QString("项目").leftJustified(18) << QString("p50前").rightJustified(10) << QString("p50后").rightJustified(10)
+        << QString("变化").rightJustified(10) << QString("p95前").rightJustified(10)
+        << QString("p95后").rightJustified(10) << QString("变化").rightJustified(10) << "
+";
+    auto change = [](double from, double to) {
+        return from > 0.0 ? QString::number((to - from) / from * 100.0, 'f', 1).append('%').rightJustified(10)
+                          : QString("-").rightJustified(10);
+    };
+    for (const QJsonValue &value : runs) {
+        const QJsonObject after = value.toObject();
+        const QString name = after["name"].toString();
+        if (!before.contains(name)) {
+            continue;
+        }
+        const QJsonObject totalBefore = before[name]["stagesMs"].toObject()["total"].toObject();
+        const QJsonObject totalAfter = after["stagesMs"].toObject()["total"].toObject();
+        const double p50Before = totalBefore["p50"].toDouble();
+        const double p50After = totalAfter["p50"].toDouble();
+        const double p95Before = totalBefore["p95"].toDouble();
+        const double p95After = totalAfter["p95"].toDouble();
+        out << name.leftJustified(18) << column(p50Before, 1) << column(p50After, 1) << change(p50Before, p50After)
+            << column(p95Before, 1) << column(p95After, 1) << change(p95Before, p95After) << "
+";
+    }
+    out.flush();
+    return true;
+}
+
+QJsonObject toJson(const RunResult &run)
+{
+    auto distribution = [](const QVector<double> &values) {
+        QJsonObject object;
+        object["count"] = values.size();
+        object["p50"] = percentile(values, 0.5);
+        object["p95"] = percentile(values, 0.95);
+        object["p99"] = percentile(values, 0.99);
+        return object;
+    };
+    QJsonObject stages;
+    for (int stage = 0; stage < RequestMetrics::StageCount; ++stage) {
+        if (!run.stageMs[stage].isEmpty()) {
+            stages[RequestMetrics::stageName(static_cast<RequestMetrics::Stage>(stage))] =
+                distribution(run.stageMs[stage]);
+        }
+    }
+    stages["total"] = distribution(run.totalMs);
+
+    QJsonObject errors;
+    for (auto it = run.errorCounts.constBegin(); it != run.errorCounts.constEnd(); ++it) {
+        errors[it.key()] = it.value();
+    }
+
+    QJsonObject object;
+    object["name"] = run.name;
+    object["concurrency"] = run.concurrency;
+    object["requests"] = run.requests;
+    object["errors"] = run.errors;
+    object["errorCounts"] = errors;
+    object["seconds"] = run.seconds;
+    object["requestsPerSecond"] = run.seconds > 0.0 ? run.requests / run.seconds : 0.0;
+    object["audioSecondsPerSecond"] = run.seconds > 0.0 ? run.audioSeconds / run.seconds : 0.0;
+    object["stagesMs"] = stages;
+    return object;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("识别链路端到端延迟基准（按键录音脚本 + 并发吞吐）");
+    parser.addHelpOption();
+    parser.addOption({"corpus", "语料列表: <wav>[\\t<松键前多按住的毫秒>]", "file"});
+    parser.addOption({"url", "识别服务地址（真实服务或本地替身）", "url", "http://127.0.0.1:8000"});
+    parser.addOption({"model", "使用内置引擎的权重文件，不请求识别服务", "file"});
+    parser.addOption({"repeat", "按键录音把语料重复几遍", "count", "1"});
+    parser.addOption({"speed", "录音回放倍速（>0），只缩短按住的时间", "factor", "1"});
+    parser.addOption({"tail", "放完音频后再按住多久松键", "ms", "300"});
+    parser.addOption({"gap", "一条出字后隔多久按下一条", "ms", "200"});
+    parser.addOption({"concurrency", "逐一测试的并发数（recognizeAudio），0表示不测", "list", "0"});
+    parser.addOption({"requests", "每个并发数提交的请求数，默认语料条数×repeat", "count"});
+    parser.addOption({"json", "把结果写成JSON文件", "file"});
+    parser.addOption({"label", "写入JSON的构建标记（如git提交）", "text"});
+    parser.addOption({"speculative", "开启投机识别，录音期间每隔多久切一段（仅识别服务）", "ms"});
+    parser.addOption({"baseline", "与之前一次--json的结果对比total", "file"});
+    parser.addOption({"max-p95", "按键录音total的p95上限，超过则返回2", "ms"});
+    parser.addOption({"trace", "把时间线写成Chrome trace JSON", "file"});
+    parser.addOption({"verbose", "输出管理器的调试日志"});
+    parser.process(app);
+
+    if (!parser.isSet("corpus")) {
+        parser.showHelp(1);
+    }
+    if (!parser.isSet("verbose")) {
+        qInstallMessageHandler(discardDebugMessages);
+    }
+
+    QString error;
+    QVector<Utterance> corpus;
+    if (!readCorpus(parser.value("corpus"), corpus, &error)) {
+        out << error << "\n";
+        return 1;
+    }
+    const int repeat = qMax(1, parser.value("repeat").toInt());
+    const double speed = parser.value("speed").toDouble();
+    if (speed <= 0.0) {
+        out << "--speed须大于0\n";
+        return 1;
+    }
+
+    PipelineTrace::setEnabled(parser.isSet("trace"));
+    VoiceRecognitionManager *manager = VoiceRecognitionManager::instance();
+    manager->setServiceUrl(parser.value("url"));
+    QString backend = parser.value("url");
+    if (parser.isSet("model")) {
+        if (!manager->setEngineModel(parser.value("model"))) {
+            out << "模型加载失败: " << parser.value("model") << "\n";
+            return 1;
+        }
+        backend = "engine:" + parser.value("model");
+    }
+    const int speculativeMs = qMax(0, parser.value("speculative").toInt());
+    manager->setSpeculativeInterval(speculativeMs);
+
+    // 结果插入与输入框相同的QTextEdit，与输入框一样插入后报告给管理器，requestCompleted随后带回全部时间戳
+    QTextEdit edit;
+    edit.resize(800, 600);
+    edit.show();
+    QHash<QString, RequestMetrics> completed;
+    QObject::connect(manager, &VoiceRecognitionManager::recognitionFinished, &edit,
+                     [&edit, manager](const QString &text, const QString &requestId) {
+        edit.insertPlainText(text);
+        manager->reportTextInserted(requestId);
+    });
+    std::function<void(const RequestMetrics &)> onCompleted;
+    QObject::connect(manager, &VoiceRecognitionManager::requestCompleted, &edit,
+                     [&completed, &onCompleted](const RequestMetrics &metrics) {
+        completed.insert(metrics.requestId, metrics);
+        if (onCompleted) {
+            onCompleted(metrics);
+        }
+    });
+
+    QJsonArray runs;
+    out << "后端: " << backend << "  语料: " << corpus.size() << " 条\n";
+    out.flush();
+
+    // 按键录音：按下 → 回放一条语料 → 按住tail → 松键，出字后再按下一条
+    RunResult pushToTalk;
+    pushToTalk.name = "push-to-talk";
+    const int defaultTailMs = parser.value("tail").toInt();
+    const int gapMs = parser.value("gap").toInt();
+    QElapsedTimer wall;
+    wall.start();
+    for (int round = 0; round < repeat; ++round) {
+        for (int i = 0; i < corpus.size(); ++i) {
+            const Utterance &utterance = corpus[i];
+            const QString requestId = QString("ptt-%1-%2").arg(round).arg(i);
+            if (!manager->setAudioSource(QString("file:%1?speed=%2").arg(utterance.path).arg(speed))) {
+                out << "无法回放: " << utterance.path << "\n";
+                return 1;
+            }
+            manager->startRecording(requestId);
+            const int tailMs = utterance.tailMs >= 0 ? utterance.tailMs : defaultTailMs;
+            sleepMs(static_cast<int>(utterance.seconds() * 1000.0 / speed) + tailMs);
+            manager->stopRecording();
+
+            if (!waitUntil(manager, [&completed, &requestId]() { return completed.contains(requestId); },
+                           COMPLETION_TIMEOUT_MS)) {
+                RequestMetrics timedOut;
+                timedOut.requestId = requestId;
+                timedOut.error = "基准等待超时";
+                completed.insert(requestId, timedOut);
+            }
+            pushToTalk.add(completed.take(requestId));
+            sleepMs(gapMs);
+        }
+    }
+    pushToTalk.seconds = wall.elapsed() / 1000.0;
+    report(out, pushToTalk);
+    runs.append(toJson(pushToTalk));
+    // 回放来源按时钟补齐送出量，不会丢数据；回调周期和抖动反映管理器线程事件循环的延迟
+    const CaptureHealth captureHealth = manager->captureHealth();
+    report(out, captureHealth);
+
+    // 并发：保持N条recognizeAudio请求在途，一条结束立即补一条
+    const int requestCount = parser.isSet("requests") ? qMax(1, parser.value("requests").toInt())
+                                                      : corpus.size() * repeat;
+    for (const QString &value : parser.value("concurrency").split(',', QString::SkipEmptyParts)) {
+        const int concurrency = value.toInt();
+        if (concurrency <= 0) {
+            continue;
+        }
+        RunResult run;
+        run.name = QString("concurrency-%1").arg(concurrency);
+        run.concurrency = concurrency;
+        int submitted = 0;
+        int finished = 0;
+        auto submitNext = [&]() {
+            const Utterance &utterance = corpus[submitted % corpus.size()];
+            manager->recognizeAudio(utterance.pcm, QString("load-%1-%2").arg(concurrency).arg(submitted));
+            ++submitted;
+        };
+        onCompleted = [&](const RequestMetrics &metrics) {
+            if (!metrics.requestId.startsWith(QString("load-%1-").arg(concurrency))) {
+                return;
+            }
+            ++finished;
+            run.add(completed.take(metrics.requestId));
+            if (submitted < requestCount) {
+                submitNext();
+            }
+        };
+
+        wall.restart();
+        while (submitted < qMin(concurrency, requestCount)) {
+            submitNext();
+        }
+        const bool done = waitUntil(manager, [&finished, requestCount]() { return finished >= requestCount; },
+                                    COMPLETION_TIMEOUT_MS + requestCount * 1000);
+        run.seconds = wall.elapsed() / 1000.0;
+        onCompleted = nullptr;
+        if (!done) {
+            run.errors += requestCount - finished;
+            run.requests += requestCount - finished;
+            run.errorCounts["基准等待超时"] += requestCount - finished;
+        }
+        report(out, run);
+        runs.append(toJson(run));
+    }
+
+    if (parser.isSet("json")) {
+        QJsonObject root;
+        root["label"] = parser.value("label");
+        root["backend"] = backend;
+        root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        root["host"] = QSysInfo::machineHostName();
+        root["cpu"] = QSysInfo::currentCpuArchitecture();
+        root["qt"] = QString(qVersion());
+        root["corpus"] = parser.value("corpus");
+        root["utterances"] = corpus.size();
+        root["speed"] = speed;
+        root["speculativeIntervalMs"] = speculativeMs;
+        root["runs"] = runs;
+        root["capture"] = toJson(captureHealth);
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "无法写入: " << parser.value("json") << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+        out << "\n结果已写入 " << parser.value("json") << "\n";
+    }
+
+    if (parser.isSet("baseline") && !compareWithBaseline(out, runs, parser.value("baseline"), &error)) {
+        out << error << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("trace")) {
+        if (!PipelineTrace::writeJson(parser.value("trace"), &error)) {
+            out << "无法写入: " << parser.value("trace") << " " << error << "\n";
+            return 1;
+        }
+        out << "时间线已写入 " << parser.value("trace") << "\n";
+    }
+
+    if (parser.isSet("max-p95")) {
+        const double p95 = percentile(pushToTalk.totalMs, 0.95);
+        if (pushToTalk.totalMs.isEmpty() || p95 > parser.value("max-p95").toDouble()) {
+            out << "FAIL: 按键录音松键到出字p95 " << QString::number(p95, 'f', 1) << " ms\n";
+            return 2;
+        }
+        out << "PASS\n";
+    }
+    return 0;
+}
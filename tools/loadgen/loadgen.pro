@@ -0,0 +1,26 @@
+# 识别服务多用户压测：模拟按键录音的用户逐级加压，统计吞吐、延迟分位数、错误率和饱和点
+QT       += core network multimedia
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = loadgen
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../APP
+
+SOURCES += \
+    main.cpp \
+    ../../APP/recognitionprotocol.cpp \
+    ../../APP/audiosource.cpp \
+    ../../APP/capturehealth.cpp \
+    ../../APP/latencyhistogram.cpp
+
+HEADERS += \
+    ../../APP/recognitionprotocol.h \
+    ../../APP/audiosource.h \
+    ../../APP/capturehealth.h \
+    ../../APP/latencyhistogram.h \
+    ../../APP/requestmetrics.h
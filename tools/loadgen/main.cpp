@@ -0,0 +1,531 @@
+/**
+ * loadgen：识别服务的多用户压测
+ *
+ * 模拟N个按键录音的用户同时使用同一个识别服务，逐级增加用户数，找出服务的饱和点：
+ *   - 每个用户循环"停顿 → 按住说一句 → 松键上传 → 等到出字"：停顿时长服从均值为--think的指数分布，
+ *     句长服从中位数--length-median、--length-sigma的对数正态分布（截断到--length-min ~ --length-max），
+ *     按住的时长等于句长（--speed可加速）；出字或失败后才开始下一次停顿，与真实用户一致
+ *   - 每个用户有独立的QNetworkAccessManager（独立的连接），请求由RecognitionProtocol组装，与客户端完全相同
+ *   - 音频为合成的类语音信号；指定--corpus时从语料中随机取句，句长即语料时长
+ *   - --users列出各级用户数，每级持续--step秒，用户逐级累加
+ * 每级输出：发出请求速率（实际施加的负载）、成功吞吐（条/秒、秒音频/秒）、延迟p50/p95/p99（松键上传到收到响应）、
+ * 错误率（HTTP错误、连接错误、超时、响应无效）。延迟p95超过--slo或错误率超过--max-error-rate的第一级即饱和，
+ * 其前一级为服务能稳定承受的负载；另标出吞吐不再随用户数增长的一级。请求按发出时所在的级别统计。
+ *
+ * 语料列表为UTF-8文本，每行一个wav路径（16kHz单声道16位PCM），相对路径以列表文件所在目录为基准。
+ *
+ * 用法：loadgen [--url http://127.0.0.1:8000] [--users 1,2,4,8,16,32] [--step 30] [--think 5]
+ *               [--length-median 3] [--length-sigma 0.6] [--corpus list.txt] [--speed 1] [--timeout 10000]
+ *               [--slo 1500] [--max-error-rate 0.01] [--seed 1] [--json result.json] [--label text]
+ */
+
+#include "recognitionprotocol.h"
+#include "audiosource.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QHttpMultiPart>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const int BYTES_PER_SECOND = SAMPLE_RATE * 2;
+
+/**
+ * 所有用户共用的负载参数和音频
+ */
+struct Workload
+{
+    QString serviceUrl;
+    double thinkSeconds = 5.0;
+    double lengthMedian = 3.0;
+    double lengthSigma = 0.6;
+    double lengthMin = 0.5;
+    double lengthMax = 20.0;
+    double speed = 1.0;
+    int timeoutMs = 10000;
+    quint32 seed = 1;
+    QByteArray syntheticPcm;            // 合成音频，按句长从头截取
+    QVector<QByteArray> corpus;         // 指定--corpus时从中随机取句
+    int currentStep = 0;                // 请求按发出时的级别统计
+};
+
+/**
+ * 一次请求的结果
+ */
+struct RequestResult
+{
+    int step = 0;
+    double latencyMs = 0.0;             // 发出请求到收到完整响应
+    double audioSeconds = 0.0;
+    QString error;                      // 成功为空
+};
+
+/**
+ * 函数名称：`syntheticSpeech`
+ * 功能描述：类语音的合成信号：1~3秒的浊音（谐波、4Hz音节包络）与0.3~1秒的底噪交替
+ */
+QByteArray syntheticSpeech(double seconds, quint32 seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    QVector<qint16> samples(static_cast<int>(seconds * SAMPLE_RATE));
+    int index = 0;
+    bool voiced = false;
+    while (index < samples.size()) {
+        const double partSeconds = voiced ? 1.0 + 2.0 * unit(rng) : 0.3 + 0.7 * unit(rng);
+        const int partEnd = qMin(samples.size(), index + static_cast<int>(partSeconds * SAMPLE_RATE));
+        const double pitch = 100.0 + 120.0 * unit(rng);
+        for (int i = index; i < partEnd; ++i) {
+            double value = 30.0 * (unit(rng) - 0.5);
+            if (voiced) {
+                const double t = static_cast<double>(i - index) / SAMPLE_RATE;
+                const double envelope = 0.5 * (1.0 - std::cos(2.0 * M_PI * 4.0 * t));
+                for (int k = 1; k * pitch < 4000.0; ++k) {
+                    value += 2500.0 * envelope * std::sin(2.0 * M_PI * k * pitch * t) / k;
+                }
+            }
+            samples[i] = static_cast<qint16>(qBound(-32768.0, value, 32767.0));
+        }
+        index = partEnd;
+        voiced = !voiced;
+    }
+    return QByteArray(reinterpret_cast<const char*>(samples.constData()), samples.size() * 2);
+}
+
+double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(p * (values.size() - 1) + 0.5), values.size() - 1);
+    return values[index];
+}
+
+bool readCorpus(const QString &listPath, QVector<QByteArray> &corpus, QString *error)
+{
+    QFile file(listPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "无法打开语料列表: " + listPath;
+        return false;
+    }
+    const QDir base = QFileInfo(listPath).absoluteDir();
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QByteArray pcm;
+        if (!AudioSource::readWavFile(base.absoluteFilePath(line.section('\t', 0, 0)), &pcm, error)) {
+            return false;
+        }
+        corpus.append(pcm);
+    }
+    if (corpus.isEmpty()) {
+        *error = "语料列表为空: " + listPath;
+        return false;
+    }
+    return true;
+}
+
+QString column(double value, int precision, int width = 10)
+{
+    return QString::number(value, 'f', precision).rightJustified(width);
+}
+
+} // namespace
+
+/**
+ * 一个模拟用户：停顿 → 按住说一句 → 上传 → 等到响应，循环直到stop()
+ */
+class SimulatedUser : public QObject
+{
+    Q_OBJECT
+
+public:
+    SimulatedUser(int id, Workload *workload, QObject *parent = nullptr)
+        : QObject(parent)
+        , m_workload(workload)
+        , m_rng(workload->seed * 7919u + static_cast<quint32>(id))
+        , m_network(new QNetworkAccessManager(this))
+    {
+        m_timer.setSingleShot(true);
+        m_timeout.setSingleShot(true);
+        m_timeout.setInterval(workload->timeoutMs);
+        connect(&m_timeout, &QTimer::timeout, this, &SimulatedUser::onTimeout);
+    }
+
+    void start()
+    {
+        m_stopped = false;
+        think();
+    }
+
+    /**
+     * 不再按键；已发出的请求照常等待结果
+     */
+    void stop()
+    {
+        m_stopped = true;
+        m_timer.stop();
+        m_timer.disconnect();
+    }
+
+    bool waiting() const { return !m_reply.isNull(); }
+
+signals:
+    void requestFinished(const RequestResult &result);
+
+private slots:
+    void onReplyFinished()
+    {
+        QNetworkReply *reply = m_reply;
+        m_reply = nullptr;
+        m_timeout.stop();
+
+        m_result.latencyMs = m_clock.nsecsElapsed() / 1e6;
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (m_timedOut) {
+            m_result.error = "超时";
+        } else if (status >= 400) {
+            m_result.error = QString("HTTP %1").arg(status);
+        } else if (reply->error() != QNetworkReply::NoError) {
+            m_result.error = reply->errorString();
+        } else {
+            RecognitionProtocol::Result parsed;
+            QString parseError;
+            if (!RecognitionProtocol::parseResponse(reply->readAll(), &parsed, &parseError)) {
+                m_result.error = parseError;
+            }
+        }
+        reply->deleteLater();
+        emit requestFinished(m_result);
+
+        if (!m_stopped) {
+            think();
+        }
+    }
+
+    void onTimeout()
+    {
+        if (m_reply) {
+            m_timedOut = true;
+            m_reply->abort();
+        }
+    }
+
+private:
+    void think()
+    {
+        const double seconds = std::exponential_distribution<double>(1.0 / m_workload->thinkSeconds)(m_rng);
+        m_timer.disconnect();
+        connect(&m_timer, &QTimer::timeout, this, &SimulatedUser::press);
+        m_timer.start(qRound(seconds * 1000.0));
+    }
+
+    void press()
+    {
+        // 选一句话，按住与句长相同的时间再松键
+        if (!m_workload->corpus.isEmpty()) {
+            const int index = std::uniform_int_distribution<int>(0, m_workload->corpus.size() - 1)(m_rng);
+            m_pcm = m_workload->corpus.at(index);
+        } else {
+            double seconds = m_workload->lengthMedian
+                    * std::exp(m_workload->lengthSigma * std::normal_distribution<double>(0.0, 1.0)(m_rng));
+            seconds = qBound(m_workload->lengthMin, seconds, m_workload->lengthMax);
+            const int bytes = qMin(m_workload->syntheticPcm.size(), static_cast<int>(seconds * SAMPLE_RATE) * 2);
+            m_pcm = QByteArray::fromRawData(m_workload->syntheticPcm.constData(), bytes);
+        }
+        m_timer.disconnect();
+        connect(&m_timer, &QTimer::timeout, this, &SimulatedUser::release);
+        m_timer.start(qRound(m_pcm.size() * 1000.0 / BYTES_PER_SECOND / m_workload->speed));
+    }
+
+    void release()
+    {
+        m_result = RequestResult();
+        m_result.step = m_workload->currentStep;
+        m_result.audioSeconds = static_cast<double>(m_pcm.size()) / BYTES_PER_SECOND;
+        m_timedOut = false;
+
+        QHttpPart audioPart;
+        audioPart.setBody(RecognitionProtocol::createWavHeader(m_pcm.size()) + m_pcm);
+        QHttpMultiPart *multiPart = RecognitionProtocol::createMultiPart(audioPart, nullptr);
+        m_clock.start();
+        m_reply = m_network->post(RecognitionProtocol::createRequest(m_workload->serviceUrl), multiPart);
+        multiPart->setParent(m_reply);
+        connect(m_reply, &QNetworkReply::finished, this, &SimulatedUser::onReplyFinished);
+        m_timeout.start();
+    }
+
+    Workload *m_workload;
+    std::mt19937 m_rng;
+    QNetworkAccessManager *m_network;
+    QTimer m_timer;                     // 停顿、按住
+    QTimer m_timeout;
+    QPointer<QNetworkReply> m_reply;
+    QElapsedTimer m_clock;
+    QByteArray m_pcm;
+    RequestResult m_result;
+    bool m_stopped = true;
+    bool m_timedOut = false;
+};
+
+namespace {
+
+struct StepResult
+{
+    int users = 0;
+    double seconds = 0.0;
+    int sent = 0;
+    int succeeded = 0;
+    double audioSeconds = 0.0;
+    QVector<double> latencyMs;
+    QHash<QString, int> errorCounts;
+
+    int errors() const { return sent - succeeded; }
+    double errorRate() const { return sent ? static_cast<double>(errors()) / sent : 0.0; }
+    double throughput() const { return seconds > 0.0 ? succeeded / seconds : 0.0; }
+
+    QJsonObject toJson() const
+    {
+        QJsonObject errors;
+        for (auto it = errorCounts.constBegin(); it != errorCounts.constEnd(); ++it) {
+            errors[it.key()] = it.value();
+        }
+        QJsonObject object;
+        object["users"] = users;
+        object["seconds"] = seconds;
+        object["sent"] = sent;
+        object["succeeded"] = succeeded;
+        object["errorRate"] = errorRate();
+        object["errorCounts"] = errors;
+        object["offeredPerSecond"] = seconds > 0.0 ? sent / seconds : 0.0;
+        object["requestsPerSecond"] = throughput();
+        object["audioSecondsPerSecond"] = seconds > 0.0 ? audioSeconds / seconds : 0.0;
+        object["p50Ms"] = percentile(latencyMs, 0.5);
+        object["p95Ms"] = percentile(latencyMs, 0.95);
+        object["p99Ms"] = percentile(latencyMs, 0.99);
+        return object;
+    }
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("识别服务多用户压测：逐级增加用户数，统计吞吐、延迟分位数和错误率，找出饱和点");
+    parser.addHelpOption();
+    parser.addOption({"url", "识别服务地址（真实服务或本地替身）", "url", "http://127.0.0.1:8000"});
+    parser.addOption({"users", "各级用户数，逐级累加", "list", "1,2,4,8,16,32"});
+    parser.addOption({"step", "每级持续时间", "seconds", "30"});
+    parser.addOption({"think", "两次按键之间的平均停顿（指数分布）", "seconds", "5"});
+    parser.addOption({"length-median", "句长中位数（对数正态分布）", "seconds", "3"});
+    parser.addOption({"length-sigma", "句长对数正态分布的sigma", "sigma", "0.6"});
+    parser.addOption({"length-min", "最短句长", "seconds", "0.5"});
+    parser.addOption({"length-max", "最长句长", "seconds", "20"});
+    parser.addOption({"corpus", "语料列表（每行一个wav），从中随机取句代替合成音频", "file"});
+    parser.addOption({"speed", "按住时长的加速倍数（>0），只缩短说话时间", "factor", "1"});
+    parser.addOption({"timeout", "单条请求超时", "ms", "10000"});
+    parser.addOption({"slo", "延迟p95上限，超过即视为饱和", "ms", "1500"});
+    parser.addOption({"max-error-rate", "错误率上限，超过即视为饱和", "ratio", "0.01"});
+    parser.addOption({"seed", "随机数种子", "seed", "1"});
+    parser.addOption({"json", "把结果写成JSON文件", "file"});
+    parser.addOption({"label", "写入JSON的标记（如服务版本、机型）", "text"});
+    parser.process(app);
+
+    Workload workload;
+    workload.serviceUrl = parser.value("url");
+    workload.thinkSeconds = qMax(0.001, parser.value("think").toDouble());
+    workload.lengthMedian = parser.value("length-median").toDouble();
+    workload.lengthSigma = parser.value("length-sigma").toDouble();
+    workload.lengthMin = parser.value("length-min").toDouble();
+    workload.lengthMax = qMax(workload.lengthMin, parser.value("length-max").toDouble());
+    workload.speed = parser.value("speed").toDouble();
+    workload.timeoutMs = parser.value("timeout").toInt();
+    workload.seed = parser.value("seed").toUInt();
+    if (workload.speed <= 0.0 || workload.lengthMedian <= 0.0) {
+        out << "--speed和--length-median须大于0\n";
+        return 1;
+    }
+    QString error;
+    if (parser.isSet("corpus")) {
+        if (!readCorpus(parser.value("corpus"), workload.corpus, &error)) {
+            out << error << "\n";
+            return 1;
+        }
+    } else {
+        workload.syntheticPcm = syntheticSpeech(workload.lengthMax, workload.seed);
+    }
+
+    QVector<int> levels;
+    for (const QString &value : parser.value("users").split(',', QString::SkipEmptyParts)) {
+        const int users = value.trimmed().toInt();
+        if (users > 0 && (levels.isEmpty() || users > levels.last())) {
+            levels.append(users);
+        }
+    }
+    const int stepSeconds = qMax(1, parser.value("step").toInt());
+    if (levels.isEmpty()) {
+        out << "--users须为递增的正整数列表\n";
+        return 1;
+    }
+
+    out << "服务: " << workload.serviceUrl << "  音频: "
+        << (workload.corpus.isEmpty() ? QString("合成，句长中位数%1秒").arg(workload.lengthMedian)
+                                      : QString("语料%1句").arg(workload.corpus.size()))
+        << "  停顿均值: " << workload.thinkSeconds << "秒  每级: " << stepSeconds << "秒\n";
+    out.flush();
+
+    QVector<StepResult> steps(levels.size());
+    QVector<SimulatedUser*> users;
+    auto record = [&steps](const RequestResult &result) {
+        StepResult &step = steps[result.step];
+        ++step.sent;
+        if (result.error.isEmpty()) {
+            ++step.succeeded;
+            step.audioSeconds += result.audioSeconds;
+            step.latencyMs.append(result.latencyMs);
+        } else {
+            ++step.errorCounts[result.error];
+        }
+    };
+
+    for (int level = 0; level < levels.size(); ++level) {
+        workload.currentStep = level;
+        while (users.size() < levels[level]) {
+            SimulatedUser *user = new SimulatedUser(users.size(), &workload, &app);
+            QObject::connect(user, &SimulatedUser::requestFinished, &app, record);
+            users.append(user);
+            user->start();
+        }
+        steps[level].users = levels[level];
+        steps[level].seconds = stepSeconds;
+
+        QEventLoop loop;
+        QTimer::singleShot(stepSeconds * 1000, &loop, &QEventLoop::quit);
+        loop.exec();
+        out << "  " << levels[level] << " 用户: 已发出 " << steps[level].sent << " 条\n";
+        out.flush();
+    }
+
+    // 停止按键，等在途请求结束（超时会中止请求）
+    for (SimulatedUser *user : users) {
+        user->stop();
+    }
+    QElapsedTimer drain;
+    drain.start();
+    auto inFlight = [&users]() {
+        return std::any_of(users.begin(), users.end(), [](SimulatedUser *user) { return user->waiting(); });
+    };
+    while (inFlight() && drain.elapsed() < workload.timeoutMs + 2000) {
+        QEventLoop loop;
+        QTimer::singleShot(50, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    // 报告
+    out << "\n" << QString("用户").rightJustified(6) << QString("发出/秒").rightJustified(10)
+        << QString("成功/秒").rightJustified(10) << QString("音频秒/秒").rightJustified(10)
+        << QString("错误率").rightJustified(10) << QString("p50(ms)").rightJustified(10)
+        << QString("p95(ms)").rightJustified(10) << QString("p99(ms)").rightJustified(10) << "\n";
+    QJsonArray stepArray;
+    for (const StepResult &step : steps) {
+        out << QString::number(step.users).rightJustified(6) << column(step.sent / step.seconds, 2)
+            << column(step.throughput(), 2) << column(step.audioSeconds / step.seconds, 2)
+            << column(step.errorRate() * 100.0, 1, 9) << "%" << column(percentile(step.latencyMs, 0.5), 1)
+            << column(percentile(step.latencyMs, 0.95), 1) << column(percentile(step.latencyMs, 0.99), 1) << "\n";
+        for (auto it = step.errorCounts.constBegin(); it != step.errorCounts.constEnd(); ++it) {
+            out << "        失败 " << it.value() << " 次: " << it.key() << "\n";
+        }
+        stepArray.append(step.toJson());
+    }
+
+    // 饱和点：p95或错误率超限的第一级；拐点：用户数增加而吞吐增长不到5%的第一级
+    const double slo = parser.value("slo").toDouble();
+    const double maxErrorRate = parser.value("max-error-rate").toDouble();
+    int saturated = -1;
+    for (int i = 0; i < steps.size() && saturated < 0; ++i) {
+        if (percentile(steps[i].latencyMs, 0.95) > slo || steps[i].errorRate() > maxErrorRate) {
+            saturated = i;
+        }
+    }
+    int knee = -1;
+    for (int i = 1; i < steps.size() && knee < 0; ++i) {
+        if (steps[i].throughput() < steps[i - 1].throughput() * 1.05) {
+            knee = i;
+        }
+    }
+
+    out << "\n";
+    if (saturated < 0) {
+        out << "未饱和：" << levels.last() << " 用户时p95与错误率仍在上限内（p95 ≤ " << slo << "ms，错误率 ≤ "
+            << maxErrorRate * 100.0 << "%）\n";
+    } else {
+        out << "饱和点：" << levels[saturated] << " 用户（成功 " << QString::number(steps[saturated].throughput(), 'f', 2)
+            << " 条/秒，p95 " << QString::number(percentile(steps[saturated].latencyMs, 0.95), 'f', 0)
+            << "ms，错误率 " << QString::number(steps[saturated].errorRate() * 100.0, 'f', 1) << "%）\n";
+        if (saturated > 0) {
+            out << "可稳定承受：" << levels[saturated - 1] << " 用户，"
+                << QString::number(steps[saturated - 1].throughput(), 'f', 2) << " 条/秒\n";
+        } else {
+            out << "第一级即超限，请减少用户数或放宽--slo\n";
+        }
+    }
+    if (knee >= 0) {
+        out << "吞吐拐点：" << levels[knee] << " 用户起吞吐不再随用户数增长（"
+            << QString::number(steps[knee - 1].throughput(), 'f', 2) << " → "
+            << QString::number(steps[knee].throughput(), 'f', 2) << " 条/秒）\n";
+    }
+
+    if (parser.isSet("json")) {
+        QJsonObject root;
+        root["label"] = parser.value("label");
+        root["url"] = workload.serviceUrl;
+        root["thinkSeconds"] = workload.thinkSeconds;
+        root["lengthMedianSeconds"] = workload.lengthMedian;
+        root["lengthSigma"] = workload.lengthSigma;
+        root["corpus"] = parser.value("corpus");
+        root["sloMs"] = slo;
+        root["maxErrorRate"] = maxErrorRate;
+        root["steps"] = stepArray;
+        root["saturatedUsers"] = saturated < 0 ? QJsonValue() : QJsonValue(levels[saturated]);
+        root["sustainableUsers"] = saturated < 0 ? QJsonValue(levels.last())
+                                                 : saturated > 0 ? QJsonValue(levels[saturated - 1]) : QJsonValue();
+        root["kneeUsers"] = knee < 0 ? QJsonValue() : QJsonValue(levels[knee]);
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly)) {
+            out << "无法写入: " << parser.value("json") << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+        out << "\n结果已写入 " << parser.value("json") << "\n";
+    }
+    return 0;
+}
+
+#include "main.moc"
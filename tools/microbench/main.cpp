@@ -0,0 +1,545 @@
+/**
+ * microbench：客户端每句话路径上的热点函数微基准（QTest/QBENCHMARK）
+ *
+ * 逐个测量松键到出字路径上的函数，每项输出每次调用的耗时（QBENCHMARK）和堆分配次数、字节数（QINFO行）：
+ *   - createWavHeader：WAV头
+ *   - multipartInMemory：sendRecognitionRequest(QByteArray)的WAV拼接 + 表单组装（1/5/30秒音频）
+ *   - multipartFromStore：sendRecognitionRequest(CaptureStore*)的流式请求体，按64KB读完（含落盘的录音）
+ *   - parseResponse：onRecognitionReplyFinished的JSON解析
+ *   - setState：输入框一次按键录音的状态切换（录音中 → 识别中 → 空闲），含样式表重新应用
+ *   - endpointer / prefixSegmenter / wavFrontend：听写端点检测、投机识别切分、Fbank特征，每次1秒音频按100ms送入
+ *   - requestStatistics：请求结束时计入管理器常驻的各阶段耗时直方图
+ *   - logging：一句按键录音途中控件和管理器输出的全部日志（22条，含完整响应体），对比三种方式：
+ *     qDebug-sync为改造前（无条件qDebug，同步格式化写出），categories-default为release默认级别
+ *     （debug关闭、trace编译掉），categories-async为打开debug、经AsyncLogSink异步写出；输出写到空设备
+ * 端点检测之外的引擎前端和耗时统计在稳态下不应分配内存，出现分配时该项失败。
+ *
+ * 堆分配在glibc上按malloc/calloc/realloc统计（Qt容器和operator new都经过malloc），其他平台只统计operator new。
+ *
+ * 用法：microbench [-platform offscreen] [函数名...] [-iterations N] [-o result.xml,xml | -o result.csv,csv]
+ * QTest的其他参数（-median、-minimumvalue、-tickcounter等）同样可用
+ */
+
+#include "recognitionprotocol.h"
+#include "requestmetrics.h"
+#include "capturestore.h"
+#include "simplevoicetextedit.h"
+#include "endpointer.h"
+#include "prefixsegmenter.h"
+#include "wavfrontend.h"
+#include "voicelogging.h"
+#include <QtTest>
+#include <QHttpMultiPart>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QScopedPointer>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// 统计堆分配：次数和申请的字节数
+static std::atomic<quint64> g_heapAllocations(0);
+static std::atomic<quint64> g_heapBytes(0);
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    ++g_heapAllocations;
+    g_heapBytes += size;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    ++g_heapAllocations;
+    g_heapBytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    ++g_heapAllocations;
+    g_heapBytes += size;
+    return __libc_realloc(p, size);
+}
+#else
+void *operator new(std::size_t size)
+{
+    ++g_heapAllocations;
+    g_heapBytes += size;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+#endif
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const int BLOCK_SAMPLES = SAMPLE_RATE / 10;     // 与管理器的送数间隔一致（100ms）
+
+/**
+ * 合成语音：2秒浊音（150Hz，包络起伏）与1秒底噪交替，可驱动端点检测和切分
+ */
+std::vector<int16_t> syntheticSpeech(int seconds)
+{
+    std::vector<int16_t> samples(static_cast<size_t>(seconds) * SAMPLE_RATE);
+    quint32 seed = 1;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const double t = static_cast<double>(i) / SAMPLE_RATE;
+        const double phase = std::fmod(t, 3.0);
+        if (phase < 2.0) {
+            samples[i] = static_cast<int16_t>(2500.0 * std::sin(2.0 * M_PI * 150.0 * t) * std::sin(M_PI * phase / 2.0));
+        } else {
+            samples[i] = static_cast<int16_t>(static_cast<int>((seed >> 16) % 31) - 15);
+        }
+    }
+    return samples;
+}
+
+QByteArray toPcm(const std::vector<int16_t> &samples)
+{
+    return QByteArray(reinterpret_cast<const char*>(samples.data()),
+                      static_cast<int>(samples.size() * sizeof(int16_t)));
+}
+
+/**
+ * 执行一次op，返回期间的堆分配次数，并输出次数和字节数
+ */
+template <typename Op>
+quint64 reportAllocations(Op op)
+{
+    const quint64 count = g_heapAllocations.load();
+    const quint64 bytes = g_heapBytes.load();
+    op();
+    const quint64 allocations = g_heapAllocations.load() - count;
+    qInfo("每次堆分配: %llu 次, %llu 字节", static_cast<unsigned long long>(allocations),
+          static_cast<unsigned long long>(g_heapBytes.load() - bytes));
+    return allocations;
+}
+
+/**
+ * 一句按键录音的日志内容
+ */
+struct UtteranceLog {
+    QString controlId = QStringLiteral("voicetextEdit_1");
+    QString text = QStringLiteral("今天下午三点在二号会议室讨论第三季度的预算安排。");
+    QString rawText = QStringLiteral("<|zh|><|NEUTRAL|><|Speech|><|withitn|>今天下午三点在二号会议室讨论第三季度的预算安排。");
+    QByteArray response =
+        "{\"result\": [{\"key\": \"audio_input\", "
+        "\"text\": \"今天下午三点在二号会议室讨论第三季度的预算安排。\", "
+        "\"raw_text\": \"<|zh|><|NEUTRAL|><|Speech|><|withitn|>今天下午三点在二号会议室讨论第三季度的预算安排。\", "
+        "\"clean_text\": \"今天下午三点在二号会议室讨论第三季度的预算安排。\"}]}";
+    qint64 audioBytes = 5 * SAMPLE_RATE * 2;
+};
+
+/**
+ * 改造前：控件和管理器的每条日志都是无条件的qDebug
+ */
+void logUtteranceUnconditional(const UtteranceLog &u)
+{
+    qDebug() << "📝 V键按下，开始等待长按确认，ID:" << u.controlId;
+    qDebug() << "📝 状态变化，ID:" << u.controlId << "，从" << 0 << "到" << 1;
+    qDebug() << "📝 长按确认，开始录音，ID:" << u.controlId;
+    qDebug() << "📝 状态变化，ID:" << u.controlId << "，从" << 1 << "到" << 2;
+    qDebug() << "🎤 开始录音，请求ID:" << u.controlId;
+    qDebug() << "🎤 录音已开始，来源:" << "麦克风" << "采样率:" << SAMPLE_RATE;
+    qDebug() << "📝 收到录音开始信号，ID:" << u.controlId;
+    qDebug() << "📝 V键释放，结束录音，ID:" << u.controlId;
+    qDebug() << "🎤 停止录音";
+    qDebug() << "📝 状态变化，ID:" << u.controlId << "，从" << 2 << "到" << 3;
+    qDebug() << "🎤 发送识别请求，音频数据大小:" << u.audioBytes << "其中临时文件:" << 0;
+    qDebug() << "🎤 HTTP状态码:" << 200;
+    qDebug() << "🎤 响应数据:" << u.response;
+    qDebug() << "🎤 =========== 识别管理器解析结果 ===========";
+    qDebug() << "🎤 🔤 原始文本:" << u.rawText;
+    qDebug() << "🎤 🧹 清理文本:" << u.text;
+    qDebug() << "🎤 ✨ 最终文本:" << u.text;
+    qDebug() << "🎤 =============================================";
+    qDebug() << "🎤 ✅ 识别成功，发送结果:" << u.text;
+    qDebug() << "📝 收到识别完成信号，文本:" << u.text << "，请求ID:" << u.controlId << "，当前ID:" << u.controlId;
+    qDebug() << "📝 插入识别结果到当前控件，ID:" << u.controlId;
+    qDebug() << "📝 状态变化，ID:" << u.controlId << "，从" << 3 << "到" << 0;
+}
+
+/**
+ * 改造后：同样的日志，按各自在控件和管理器中的类别和级别输出
+ */
+void logUtteranceCategorized(const UtteranceLog &u)
+{
+    qCTrace(lcWidget) << "📝 V键按下，开始等待长按确认，ID:" << u.controlId;
+    qCTrace(lcWidget) << "📝 状态变化，ID:" << u.controlId << "，从" << 0 << "到" << 1;
+    qCTrace(lcWidget) << "📝 长按确认，开始录音，ID:" << u.controlId;
+    qCTrace(lcWidget) << "📝 状态变化，ID:" << u.controlId << "，从" << 1 << "到" << 2;
+    qCDebug(lcManager) << "🎤 开始录音，请求ID:" << u.controlId;
+    qCDebug(lcCapture) << "🎤 录音已开始，来源:" << "麦克风" << "采样率:" << SAMPLE_RATE;
+    qCTrace(lcWidget) << "📝 收到录音开始信号，ID:" << u.controlId;
+    qCTrace(lcWidget) << "📝 V键释放，结束录音，ID:" << u.controlId;
+    qCDebug(lcManager) << "🎤 停止录音";
+    qCTrace(lcWidget) << "📝 状态变化，ID:" << u.controlId << "，从" << 2 << "到" << 3;
+    qCDebug(lcNetwork) << "🎤 发送识别请求，音频数据大小:" << u.audioBytes << "其中临时文件:" << 0;
+    qCTrace(lcNetwork) << "🎤 HTTP状态码:" << 200;
+    qCTrace(lcNetwork) << "🎤 响应数据:" << u.response;
+    qCTrace(lcNetwork) << "🎤 =========== 识别管理器解析结果 ===========";
+    qCTrace(lcNetwork) << "🎤 🔤 原始文本:" << u.rawText;
+    qCTrace(lcNetwork) << "🎤 🧹 清理文本:" << u.text;
+    qCTrace(lcNetwork) << "🎤 ✨ 最终文本:" << u.text;
+    qCTrace(lcNetwork) << "🎤 =============================================";
+    qCDebug(lcManager) << "🎤 ✅ 识别成功，发送结果:" << u.text;
+    qCTrace(lcWidget) << "📝 收到识别完成信号，文本:" << u.text << "，请求ID:" << u.controlId << "，当前ID:" << u.controlId;
+    qCTrace(lcWidget) << "📝 插入识别结果到当前控件，ID:" << u.controlId;
+    qCTrace(lcWidget) << "📝 状态变化，ID:" << u.controlId << "，从" << 3 << "到" << 0;
+}
+
+enum LogMode { LogUnconditional, LogCategoriesDefault, LogCategoriesAsync };
+
+FILE *g_nullOutput = nullptr;
+
+/**
+ * 改造前的输出方式：与Qt默认的消息处理相同，在调用线程上格式化并写出，这里写到空设备
+ */
+void synchronousNullHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    const QByteArray line = qFormatLogMessage(type, context, message).toLocal8Bit() + '\n';
+    std::fwrite(line.constData(), 1, line.size(), g_nullOutput);
+    std::fflush(g_nullOutput);
+}
+
+// 其余基准不输出管理器和控件的日志
+const char *QUIET_RULES = "default.debug=false\nvoiceinput.*.debug=false";
+
+/**
+ * 暴露setState的输入框
+ */
+class StateBenchTextEdit : public SimpleVoiceTextEdit
+{
+public:
+    using SimpleVoiceTextEdit::setState;
+};
+
+} // namespace
+
+class ClientBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void createWavHeader();
+    void multipartInMemory_data();
+    void multipartInMemory();
+    void multipartFromStore_data();
+    void multipartFromStore();
+    void parseResponse();
+    void setState();
+    void endpointer();
+    void prefixSegmenter();
+    void wavFrontend();
+    void requestStatistics();
+    void logging_data();
+    void logging();
+};
+
+void ClientBenchmarks::initTestCase()
+{
+    // 管理器和控件的调试日志不计入测量，日志本身的开销由logging单独测量
+    QLoggingCategory::setFilterRules(QUIET_RULES);
+}
+
+void ClientBenchmarks::createWavHeader()
+{
+    QByteArray header;
+    QBENCHMARK {
+        header = RecognitionProtocol::createWavHeader(5 * SAMPLE_RATE * 2);
+    }
+    QCOMPARE(header.size(), 44);
+    reportAllocations([]() { RecognitionProtocol::createWavHeader(5 * SAMPLE_RATE * 2); });
+}
+
+void ClientBenchmarks::multipartInMemory_data()
+{
+    QTest::addColumn<int>("seconds");
+    QTest::newRow("1s") << 1;
+    QTest::newRow("5s") << 5;
+    QTest::newRow("30s") << 30;
+}
+
+void ClientBenchmarks::multipartInMemory()
+{
+    QFETCH(int, seconds);
+    const QByteArray pcm = toPcm(syntheticSpeech(seconds));
+
+    // 与sendRecognitionRequest(QByteArray)相同：拼出WAV，组装表单
+    auto build = [&pcm]() {
+        QHttpPart audioPart;
+        audioPart.setBody(RecognitionProtocol::createWavHeader(pcm.size()) + pcm);
+        delete RecognitionProtocol::createMultiPart(audioPart, nullptr);
+    };
+    QBENCHMARK {
+        build();
+    }
+    reportAllocations(build);
+}
+
+void ClientBenchmarks::multipartFromStore_data()
+{
+    QTest::addColumn<int>("seconds");
+    QTest::addColumn<int>("memoryLimitKb");
+    QTest::newRow("5s-memory") << 5 << 0;
+    QTest::newRow("30s-memory") << 30 << 0;
+    QTest::newRow("30s-spilled") << 30 << 256;
+}
+
+void ClientBenchmarks::multipartFromStore()
+{
+    QFETCH(int, seconds);
+    QFETCH(int, memoryLimitKb);
+
+    CaptureStore store;
+    store.setMemoryLimit(memoryLimitKb * 1024LL);
+    store.open(QIODevice::WriteOnly);
+    const QByteArray pcm = toPcm(syntheticSpeech(seconds));
+    for (int offset = 0; offset < pcm.size(); offset += BLOCK_SAMPLES * 2) {
+        store.write(pcm.constData() + offset, qMin(BLOCK_SAMPLES * 2, pcm.size() - offset));
+    }
+    store.close();
+
+    // 与sendRecognitionRequest(CaptureStore*)相同，再按QNetworkAccessManager的方式分块读完请求体
+    QByteArray buffer(64 * 1024, Qt::Uninitialized);
+    auto build = [&store, &buffer]() {
+        QIODevice *body = store.createReader(RecognitionProtocol::createWavHeader(store.bytesCaptured()));
+        QHttpPart audioPart;
+        audioPart.setBodyDevice(body);
+        QScopedPointer<QHttpMultiPart> multiPart(RecognitionProtocol::createMultiPart(audioPart, body));
+        while (body->read(buffer.data(), buffer.size()) > 0) {
+        }
+    };
+    QBENCHMARK {
+        build();
+    }
+    reportAllocations(build);
+}
+
+void ClientBenchmarks::parseResponse()
+{
+    // api.py的实际响应格式
+    const QByteArray body =
+        "{\"result\": [{\"key\": \"audio_input\", "
+        "\"text\": \"今天下午三点在二号会议室讨论第三季度的预算安排。\", "
+        "\"raw_text\": \"<|zh|><|NEUTRAL|><|Speech|><|withitn|>今天下午三点在二号会议室讨论第三季度的预算安排。\", "
+        "\"clean_text\": \"今天下午三点在二号会议室讨论第三季度的预算安排。\"}]}";
+    RecognitionProtocol::Result result;
+    QString error;
+    QBENCHMARK {
+        RecognitionProtocol::parseResponse(body, &result, &error);
+    }
+    QVERIFY(result.text.startsWith("今天"));
+    reportAllocations([&]() { RecognitionProtocol::parseResponse(body, &result, &error); });
+}
+
+void ClientBenchmarks::setState()
+{
+    StateBenchTextEdit edit;
+    edit.resize(400, 120);
+    edit.show();
+    QCoreApplication::processEvents();
+
+    // 一次按键录音的状态切换，样式表变化后的重新polish在setStyleSheet中同步完成
+    auto cycle = [&edit]() {
+        edit.setState(SimpleVoiceTextEdit::State::Recording);
+        edit.setState(SimpleVoiceTextEdit::State::Recognizing);
+        edit.setState(SimpleVoiceTextEdit::State::Idle);
+    };
+    cycle();
+    QBENCHMARK {
+        cycle();
+    }
+    reportAllocations(cycle);
+}
+
+void ClientBenchmarks::endpointer()
+{
+    const std::vector<int16_t> samples = syntheticSpeech(30);
+    Endpointer endpointer;
+    Endpointer::Segment segment;
+    size_t offset = 0;
+
+    // 每次1秒音频（10块），循环使用30秒的合成语音，分段在切出时立即取走
+    auto feedSecond = [&]() {
+        for (int block = 0; block < 10; ++block) {
+            if (offset + BLOCK_SAMPLES > samples.size()) {
+                offset = 0;
+            }
+            endpointer.acceptWaveform(samples.data() + offset, BLOCK_SAMPLES);
+            offset += BLOCK_SAMPLES;
+            while (endpointer.popSegment(segment)) {
+            }
+        }
+    };
+    for (int i = 0; i < 30; ++i) {
+        feedSecond();
+    }
+    QBENCHMARK {
+        feedSecond();
+    }
+    // 每个切出的分段带一份音频副本，属于设计内的分配
+    reportAllocations(feedSecond);
+}
+
+void ClientBenchmarks::prefixSegmenter()
+{
+    const std::vector<int16_t> samples = syntheticSpeech(30);
+    PrefixSegmenter segmenter;
+    size_t offset = 0;
+    int64_t cut = 0;
+
+    auto feedSecond = [&]() {
+        for (int block = 0; block < 10; ++block) {
+            if (offset + BLOCK_SAMPLES > samples.size()) {
+                offset = 0;
+            }
+            segmenter.acceptWaveform(samples.data() + offset, BLOCK_SAMPLES);
+            offset += BLOCK_SAMPLES;
+            while (segmenter.takeCut(cut)) {
+            }
+        }
+    };
+    for (int i = 0; i < 30; ++i) {
+        feedSecond();
+    }
+    QBENCHMARK {
+        feedSecond();
+    }
+    QCOMPARE(reportAllocations(feedSecond), quint64(0));
+}
+
+void ClientBenchmarks::wavFrontend()
+{
+    const std::vector<int16_t> samples = syntheticSpeech(1);
+    WavFrontend frontend(WavFrontend::Options(), nullptr, nullptr);
+    std::vector<float> features(static_cast<size_t>(frontend.featureDim()) * 200);
+
+    // 与分块识别相同：每100ms送入一块，取出已就绪的LFR特征
+    auto feedSecond = [&]() {
+        frontend.reset();
+        for (size_t offset = 0; offset + BLOCK_SAMPLES <= samples.size(); offset += BLOCK_SAMPLES) {
+            frontend.acceptWaveform(samples.data() + offset, BLOCK_SAMPLES);
+            frontend.popFeatures(features.data(), false);
+        }
+        frontend.popFeatures(features.data(), true);
+    };
+    feedSecond();
+    QBENCHMARK {
+        feedSecond();
+    }
+    QCOMPARE(reportAllocations(feedSecond), quint64(0));
+}
+
+void ClientBenchmarks::requestStatistics()
+{
+    // 管理器在每个请求结束时的汇总记录：各阶段和total各计入一次直方图
+    RequestMetrics metrics;
+    metrics.requestId = "bench";
+    qint64 at = RequestMetrics::now();
+    for (int point = 0; point < RequestMetrics::StampCount; ++point) {
+        if (point != RequestMetrics::Submitted) {
+            metrics.stamps[point] = at;
+        }
+        at += 3000000 + point * 1000000;
+    }
+    QScopedPointer<RequestStatistics> statistics(new RequestStatistics);
+    QBENCHMARK {
+        statistics->add(metrics);
+    }
+    QVERIFY(statistics->total.count() > 0);
+    QCOMPARE(reportAllocations([&]() { statistics->add(metrics); }), quint64(0));
+}
+
+void ClientBenchmarks::logging_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("qDebug-sync") << int(LogUnconditional);
+    QTest::newRow("categories-default") << int(LogCategoriesDefault);
+    QTest::newRow("categories-async") << int(LogCategoriesAsync);
+}
+
+void ClientBenchmarks::logging()
+{
+    QFETCH(int, mode);
+    const UtteranceLog utterance;
+    g_nullOutput = std::fopen(QProcess::nullDevice().toLocal8Bit().constData(), "w");
+    QVERIFY(g_nullOutput);
+
+    // QTest自己的消息处理在测量期间换下，结束后恢复
+    QtMessageHandler testHandler = nullptr;
+    if (mode == LogUnconditional) {
+        QLoggingCategory::setFilterRules("voiceinput.*.debug=false");
+        testHandler = qInstallMessageHandler(synchronousNullHandler);
+    } else if (mode == LogCategoriesDefault) {
+        QLoggingCategory::setFilterRules(QUIET_RULES);
+        testHandler = qInstallMessageHandler(synchronousNullHandler);
+    } else {
+        QLoggingCategory::setFilterRules("default.debug=false\nvoiceinput.*.debug=true");
+        testHandler = qInstallMessageHandler(nullptr);
+        AsyncLogSink::install(QProcess::nullDevice(), false);
+    }
+
+    auto utteranceLogs = [&]() {
+        if (mode == LogUnconditional) {
+            logUtteranceUnconditional(utterance);
+        } else {
+            logUtteranceCategorized(utterance);
+        }
+    };
+    QBENCHMARK {
+        utteranceLogs();
+    }
+    const quint64 count = g_heapAllocations.load();
+    const quint64 bytes = g_heapBytes.load();
+    utteranceLogs();
+    const quint64 allocations = g_heapAllocations.load() - count;
+    const quint64 allocatedBytes = g_heapBytes.load() - bytes;
+
+    const qint64 dropped = AsyncLogSink::droppedMessages();
+    AsyncLogSink::uninstall();
+    qInstallMessageHandler(testHandler);
+    QLoggingCategory::setFilterRules(QUIET_RULES);
+    std::fclose(g_nullOutput);
+    g_nullOutput = nullptr;
+
+    // 统计放在恢复QTest的消息处理之后输出
+    qInfo("每句日志堆分配: %llu 次, %llu 字节", static_cast<unsigned long long>(allocations),
+          static_cast<unsigned long long>(allocatedBytes));
+    if (mode == LogCategoriesAsync) {
+        qInfo("异步队列丢弃: %lld 条", static_cast<long long>(dropped));
+    }
+}
+
+QTEST_MAIN(ClientBenchmarks)
+
+#include "main.moc"
@@ -0,0 +1,47 @@
+# 客户端热点函数微基准：WAV头、表单组装、响应解析、输入框状态切换、引擎前端（QTest/QBENCHMARK）
+QT       += core gui widgets network multimedia testlib
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = microbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../APP
+
+SOURCES += \
+    main.cpp \
+    ../../APP/recognitionprotocol.cpp \
+    ../../APP/voicerecognitionmanager.cpp \
+    ../../APP/enginepipeline.cpp \
+    ../../APP/dictationpipeline.cpp \
+    ../../APP/handsfreepipeline.cpp \
+    ../../APP/capturestore.cpp \
+    ../../APP/latencyhistogram.cpp \
+    ../../APP/pipelinetrace.cpp \
+    ../../APP/sessionrecorder.cpp \
+    ../../APP/voicelogging.cpp \
+    ../../APP/audiosource.cpp \
+    ../../APP/capturehealth.cpp \
+    ../../APP/simplevoicetextedit.cpp \
+    ../../APP/tentativetextregion.cpp
+
+HEADERS += \
+    ../../APP/recognitionprotocol.h \
+    ../../APP/voicerecognitionmanager.h \
+    ../../APP/enginepipeline.h \
+    ../../APP/dictationpipeline.h \
+    ../../APP/handsfreepipeline.h \
+    ../../APP/capturestore.h \
+    ../../APP/audiosource.h \
+    ../../APP/capturehealth.h \
+    ../../APP/requestmetrics.h \
+    ../../APP/latencyhistogram.h \
+    ../../APP/pipelinetrace.h \
+    ../../APP/sessionrecorder.h \
+    ../../APP/voicelogging.h \
+    ../../APP/simplevoicetextedit.h \
+    ../../APP/tentativetextregion.h
+
+include(../../APP/engine/engine.pri)
@@ -0,0 +1,809 @@
+/**
+ * mockasrserver：识别服务（SenseVoice/api.py）的本地替身
+ *
+ * 实现客户端用到的接口契约，不需要torch和模型，延迟和故障可控、可复现：
+ *   - GET /health：{"status": "ok", "service": "MockASR", "version": "1.0", "warmup_ms": 0}
+ *   - POST /api/v1/asr：multipart表单（files可多个、keys逗号分隔、lang），返回
+ *     {"result": [{"key", "text", "raw_text", "clean_text"}, ...]}，每个音频一条；缺少files时与FastAPI一样返回422
+ * 识别文本：默认固定一句，--transcripts按行轮流返回，--echo返回收到的音频字节数和时长。
+ * 处理耗时 = --latency分布抽样 + --jitter均匀抖动 + --rtf×音频秒数；--workers限制同时处理的请求数，
+ * 多出的请求排队（模拟单卡推理串行），排队时间不计入处理耗时。
+ * 故障注入（每个请求开始处理时抽样一次，处理耗时到点后生效）：
+ *   - --error-rate：返回--error-status（默认500）和{"detail": ...}
+ *   - --drop-rate：不返回，直接重置连接
+ *   - --stall-rate：在处理耗时之外再卡住--stall-ms（默认15秒，超过客户端10秒的请求超时）才返回
+ * --bandwidth限制带宽（kbit/s，所有连接共享，上下行分别计算）：上传受限时服务端放慢读取，由TCP反压到客户端。
+ * 识别接口的响应带Server-Timing头（parse、queue、process、total，毫秒），与api.py相同，客户端时间线据此画出服务端各段。
+ * 随机数种子固定（--seed），同样的参数和请求顺序得到同样的延迟和故障序列。
+ *
+ * 用法：mockasrserver [--host 127.0.0.1] [--port 8000] [--latency lognormal:300,0.4] [--rtf 30] [--jitter 20]
+ *                     [--workers 1] [--error-rate 0.02] [--error-status 503] [--drop-rate 0.01]
+ *                     [--stall-rate 0.01] [--stall-ms 15000] [--bandwidth 2000]
+ *                     [--transcripts lines.txt | --transcript 文本 | --echo] [--seed 1] [--stats 5] [--verbose]
+ * 延迟分布：fixed:毫秒、uniform:下限,上限、normal:均值,标准差、lognormal:中位数,sigma（长尾）
+ * --port 0 时由系统分配端口；启动后第一行输出实际地址。
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QQueue>
+#include <QRegularExpression>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+const int MAX_HEADER_BYTES = 64 * 1024;
+const qint64 MAX_BODY_BYTES = 256LL * 1024 * 1024;
+const qint64 THROTTLED_CHUNK_BYTES = 16 * 1024;     // 限速时每次读写的上限，同时是套接字读缓冲区大小
+const int PACE_INTERVAL_MS = 5;
+const char *RAW_TEXT_TAGS = "<|zh|><|NEUTRAL|><|Speech|><|withitn|>";
+
+void printLine(const QString &line)
+{
+    QTextStream out(stdout);
+    out << line << "\n";
+    out.flush();
+}
+
+/**
+ * 处理耗时的分布
+ */
+struct LatencyDistribution
+{
+    enum Kind { Fixed, Uniform, Normal, LogNormal };
+
+    Kind kind = Fixed;
+    double first = 0.0;                 // fixed：毫秒；uniform：下限；normal：均值；lognormal：中位数
+    double second = 0.0;                // uniform：上限；normal：标准差；lognormal：sigma
+
+    static bool parse(const QString &spec, LatencyDistribution *out)
+    {
+        const QString name = spec.section(':', 0, 0).trimmed();
+        const QStringList values = spec.section(':', 1).split(',', QString::SkipEmptyParts);
+        QVector<double> numbers;
+        for (const QString &value : values) {
+            bool ok = false;
+            numbers.append(value.trimmed().toDouble(&ok));
+            if (!ok || numbers.last() < 0.0) {
+                return false;
+            }
+        }
+
+        LatencyDistribution distribution;
+        if (name == "fixed" && numbers.size() == 1) {
+            distribution.kind = Fixed;
+        } else if (name == "uniform" && numbers.size() == 2 && numbers[0] <= numbers[1]) {
+            distribution.kind = Uniform;
+        } else if (name == "normal" && numbers.size() == 2) {
+            distribution.kind = Normal;
+        } else if (name == "lognormal" && numbers.size() == 2) {
+            distribution.kind = LogNormal;
+        } else {
+            return false;
+        }
+        distribution.first = numbers[0];
+        distribution.second = numbers.value(1);
+        *out = distribution;
+        return true;
+    }
+
+    double sample(std::mt19937 &rng) const
+    {
+        switch (kind) {
+        case Fixed:
+            return first;
+        case Uniform:
+            return std::uniform_real_distribution<double>(first, second)(rng);
+        case Normal:
+            return std::max(0.0, std::normal_distribution<double>(first, second)(rng));
+        case LogNormal:
+            return first * std::exp(second * std::normal_distribution<double>(0.0, 1.0)(rng));
+        }
+        return first;
+    }
+};
+
+struct ServerOptions
+{
+    LatencyDistribution latency;
+    double rtfMs = 0.0;                 // 每秒音频增加的处理耗时（毫秒）
+    int jitterMs = 0;
+    int workers = 0;                    // 同时处理的请求数，0为不限
+    double errorRate = 0.0;
+    int errorStatus = 500;
+    double dropRate = 0.0;
+    double stallRate = 0.0;
+    int stallMs = 15000;
+    qint64 bandwidthBytesPerSecond = 0; // 0为不限
+    QStringList transcripts;
+    bool echo = false;
+    quint32 seed = 1;
+    bool verbose = false;
+};
+
+struct HttpRequest
+{
+    QByteArray method;
+    QByteArray path;
+    QHash<QByteArray, QByteArray> headers;      // 名称为小写
+    QByteArray body;
+};
+
+struct FormPart
+{
+    QByteArray name;
+    QByteArray body;
+};
+
+/**
+ * 函数名称：`parseMultipart`
+ * 功能描述：解析multipart/form-data请求体
+ * 参数说明：
+ *     - contentType：QByteArray，Content-Type头（含boundary）
+ *     - body：QByteArray，请求体
+ *     - parts：QVector<FormPart>*，输出各部分
+ * 返回值：bool，格式是否有效
+ */
+bool parseMultipart(const QByteArray &contentType, const QByteArray &body, QVector<FormPart> *parts)
+{
+    const int boundaryAt = contentType.indexOf("boundary=");
+    if (!contentType.startsWith("multipart/form-data") || boundaryAt < 0) {
+        return false;
+    }
+    QByteArray boundary = contentType.mid(boundaryAt + 9);
+    if (boundary.contains(';')) {
+        boundary.truncate(boundary.indexOf(';'));
+    }
+    boundary = boundary.trimmed();
+    if (boundary.size() >= 2 && boundary.startsWith('"') && boundary.endsWith('"')) {
+        boundary = boundary.mid(1, boundary.size() - 2);
+    }
+
+    static const QRegularExpression nameExpression("(?:^|[;\\s])name=\"([^\"]*)\"",
+                                                   QRegularExpression::CaseInsensitiveOption);
+    const QByteArray delimiter = "--" + boundary;
+    const QByteArray separator = "\r\n" + delimiter;
+    int pos = body.indexOf(delimiter);
+    while (pos >= 0) {
+        pos += delimiter.size();
+        if (body.mid(pos, 2) == "--") {
+            return true;
+        }
+        const int headerEnd = body.indexOf("\r\n\r\n", pos);
+        const int next = headerEnd < 0 ? -1 : body.indexOf(separator, headerEnd + 4);
+        if (next < 0) {
+            return false;
+        }
+        FormPart part;
+        const QString headers = QString::fromUtf8(body.mid(pos, headerEnd - pos));
+        part.name = nameExpression.match(headers).captured(1).toUtf8();
+        part.body = body.mid(headerEnd + 4, next - headerEnd - 4);
+        parts->append(part);
+        pos = next + 2;
+    }
+    return false;
+}
+
+/**
+ * 函数名称：`wavSeconds`
+ * 功能描述：音频时长；不是WAV时按16kHz单声道16位PCM计算
+ */
+double wavSeconds(const QByteArray &audio)
+{
+    if (audio.size() < 44 || !audio.startsWith("RIFF")) {
+        return audio.size() / 32000.0;
+    }
+    const uchar *data = reinterpret_cast<const uchar*>(audio.constData());
+    const quint32 byteRate = qFromLittleEndian<quint32>(data + 28);
+    int offset = 12;
+    while (offset + 8 <= audio.size()) {
+        const quint32 chunkSize = qFromLittleEndian<quint32>(data + offset + 4);
+        if (audio.mid(offset, 4) == "data") {
+            const qint64 available = audio.size() - offset - 8;
+            return byteRate ? qMin<qint64>(chunkSize, available) / static_cast<double>(byteRate) : 0.0;
+        }
+        offset += 8 + static_cast<int>(qMin<quint32>(chunkSize, audio.size()));
+    }
+    return 0.0;
+}
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 422: return "Unprocessable Entity";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Unknown";
+    }
+}
+
+QByteArray detailBody(const QString &detail)
+{
+    QJsonObject object;
+    object["detail"] = detail;
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * 令牌桶限速，所有连接共享；速率为0时不限
+ */
+class TokenBucket
+{
+public:
+    void setRate(qint64 bytesPerSecond)
+    {
+        m_rate = bytesPerSecond;
+        m_tokens = burst();
+        m_clock.start();
+    }
+
+    bool limited() const { return m_rate > 0; }
+
+    qint64 take(qint64 wanted)
+    {
+        if (m_rate <= 0) {
+            return wanted;
+        }
+        m_tokens = qMin(burst(), m_tokens + m_rate * (m_clock.nsecsElapsed() / 1e9));
+        m_clock.restart();
+        const qint64 granted = qMin<qint64>(wanted, static_cast<qint64>(m_tokens));
+        m_tokens -= granted;
+        return granted;
+    }
+
+private:
+    double burst() const { return qMax(1460.0, m_rate / 50.0); }    // 约20ms的量
+
+    qint64 m_rate = 0;
+    double m_tokens = 0.0;
+    QElapsedTimer m_clock;
+};
+
+} // namespace
+
+class MockAsrServer;
+
+/**
+ * 一个客户端连接：解析HTTP/1.1请求（Content-Length请求体，保持连接），逐个交给服务器处理，按限速写回响应
+ */
+class Connection : public QObject
+{
+    Q_OBJECT
+
+public:
+    Connection(QTcpSocket *socket, MockAsrServer *server);
+
+    void respond(int status, const QByteArray &json, const QByteArray &extraHeaders = QByteArray());
+    void reset();
+
+private slots:
+    void pump();
+
+private:
+    bool parseRequest();
+    void fail(int status, const QString &detail);
+
+    QTcpSocket *m_socket;
+    MockAsrServer *m_server;
+    QTimer m_paceTimer;
+    QByteArray m_input;
+    int m_headerEnd = -1;               // 当前请求头的结束位置，-1为还未收全
+    qint64 m_contentLength = 0;
+    HttpRequest m_request;
+    bool m_busy = false;                // 已收完一个请求，回应写完前不解析下一个
+    bool m_keepAlive = true;
+    QByteArray m_output;
+    int m_outputOffset = 0;
+};
+
+class MockAsrServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    MockAsrServer(const ServerOptions &options, QObject *parent = nullptr)
+        : QTcpServer(parent)
+        , m_options(options)
+        , m_rng(options.seed)
+    {
+        m_upload.setRate(options.bandwidthBytesPerSecond);
+        m_download.setRate(options.bandwidthBytesPerSecond);
+    }
+
+    TokenBucket &upload() { return m_upload; }
+    TokenBucket &download() { return m_download; }
+
+    void handle(Connection *connection, const HttpRequest &request);
+    QString statsLine() const;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        QTcpSocket *socket = new QTcpSocket;
+        if (!socket->setSocketDescriptor(socketDescriptor)) {
+            delete socket;
+            return;
+        }
+        new Connection(socket, this);
+    }
+
+private:
+    enum class Fault { None, Error, Drop, Stall };
+
+    struct Job {
+        int id = 0;
+        QPointer<Connection> connection;
+        QStringList keys;
+        QVector<qint64> audioBytes;
+        QVector<double> audioSeconds;
+        QElapsedTimer queued;
+        double parseMs = 0.0;
+    };
+
+    void handleRecognition(Connection *connection, const HttpRequest &request);
+    void startJobs();
+    void finishJob(const Job &job, Fault fault, double queuedMs, double processMs);
+    QByteArray recognitionResponse(const Job &job);
+    Fault drawFault();
+
+    ServerOptions m_options;
+    std::mt19937 m_rng;
+    TokenBucket m_upload;
+    TokenBucket m_download;
+    QQueue<Job> m_queue;
+    int m_active = 0;
+    int m_transcriptIndex = 0;
+
+    // 统计
+    int m_nextJobId = 1;
+    int m_peakQueue = 0;
+    qint64 m_requests = 0;
+    qint64 m_succeeded = 0;
+    qint64 m_errors = 0;
+    qint64 m_drops = 0;
+    qint64 m_stalls = 0;
+    qint64 m_abandoned = 0;             // 回应前客户端已断开（超时、取消）
+};
+
+Connection::Connection(QTcpSocket *socket, MockAsrServer *server)
+    : QObject(server)
+    , m_socket(socket)
+    , m_server(server)
+{
+    m_socket->setParent(this);
+    if (server->upload().limited()) {
+        // 读缓冲区有上限，服务端读得慢时数据留在内核缓冲区，TCP窗口收缩，客户端上传随之变慢
+        m_socket->setReadBufferSize(THROTTLED_CHUNK_BYTES);
+    }
+    m_paceTimer.setInterval(PACE_INTERVAL_MS);
+    connect(&m_paceTimer, &QTimer::timeout, this, &Connection::pump);
+    connect(m_socket, &QTcpSocket::readyRead, this, &Connection::pump);
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &Connection::pump);
+    connect(m_socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+    QTimer::singleShot(0, this, &Connection::pump);
+}
+
+void Connection::respond(int status, const QByteArray &json, const QByteArray &extraHeaders)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + reasonPhrase(status) + "\r\n";
+    response += "Server: mockasrserver\r\n";
+    response += extraHeaders;
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(json.size()) + "\r\n";
+    response += m_keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    response += json;
+    m_output = response;
+    m_outputOffset = 0;
+    QTimer::singleShot(0, this, &Connection::pump);
+}
+
+void Connection::reset()
+{
+    m_paceTimer.stop();
+    m_socket->abort();
+    deleteLater();
+}
+
+void Connection::fail(int status, const QString &detail)
+{
+    m_busy = true;
+    m_keepAlive = false;
+    m_input.clear();
+    respond(status, detailBody(detail));
+}
+
+void Connection::pump()
+{
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        m_paceTimer.stop();
+        return;
+    }
+
+    // 上传：受限时按令牌读取，其余留在套接字中
+    const qint64 available = m_socket->bytesAvailable();
+    if (available > 0) {
+        const qint64 wanted = m_server->upload().limited() ? qMin(available, THROTTLED_CHUNK_BYTES) : available;
+        const qint64 granted = m_server->upload().take(wanted);
+        if (granted > 0) {
+            m_input.append(m_socket->read(granted));
+        }
+    }
+
+    // 下载：受限时按令牌分块写出
+    if (!m_output.isEmpty()) {
+        const qint64 remaining = m_output.size() - m_outputOffset;
+        const bool limited = m_server->download().limited();
+        if (!limited || m_socket->bytesToWrite() < THROTTLED_CHUNK_BYTES) {
+            const qint64 granted = m_server->download().take(limited ? qMin(remaining, THROTTLED_CHUNK_BYTES)
+                                                                      : remaining);
+            if (granted > 0) {
+                m_socket->write(m_output.constData() + m_outputOffset, granted);
+                m_outputOffset += static_cast<int>(granted);
+            }
+        }
+        if (m_outputOffset == m_output.size()) {
+            m_output.clear();
+            m_outputOffset = 0;
+            m_busy = false;
+            if (!m_keepAlive) {
+                m_paceTimer.stop();
+                m_socket->disconnectFromHost();
+                return;
+            }
+        }
+    }
+
+    while (!m_busy && parseRequest()) {
+    }
+
+    const bool pending = m_socket->bytesAvailable() > 0 || !m_output.isEmpty();
+    if (pending && !m_paceTimer.isActive()) {
+        m_paceTimer.start();
+    } else if (!pending) {
+        m_paceTimer.stop();
+    }
+}
+
+bool Connection::parseRequest()
+{
+    if (m_headerEnd < 0) {
+        const int end = m_input.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (m_input.size() > MAX_HEADER_BYTES) {
+                fail(431, "Request header too large");
+            }
+            return false;
+        }
+
+        const QList<QByteArray> lines = m_input.left(end).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 3) {
+            fail(400, "Bad request line");
+            return false;
+        }
+        m_request = HttpRequest();
+        m_request.method = requestLine[0];
+        m_request.path = requestLine[1];
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon > 0) {
+                m_request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+            }
+        }
+        if (m_request.headers.value("transfer-encoding").toLower().contains("chunked")) {
+            fail(411, "Chunked request bodies are not supported");
+            return false;
+        }
+        m_contentLength = m_request.headers.value("content-length", "0").toLongLong();
+        if (m_contentLength < 0 || m_contentLength > MAX_BODY_BYTES) {
+            fail(413, "Request body too large");
+            return false;
+        }
+        m_keepAlive = requestLine[2].trimmed() == "HTTP/1.1"
+                && m_request.headers.value("connection").toLower() != "close";
+        m_headerEnd = end + 4;
+    }
+
+    if (m_input.size() - m_headerEnd < m_contentLength) {
+        return false;
+    }
+    m_request.body = m_input.mid(m_headerEnd, static_cast<int>(m_contentLength));
+    m_input.remove(0, m_headerEnd + static_cast<int>(m_contentLength));
+    m_headerEnd = -1;
+    m_busy = true;
+    m_server->handle(this, m_request);
+    return true;
+}
+
+void MockAsrServer::handle(Connection *connection, const HttpRequest &request)
+{
+    const QByteArray path = request.path.left(request.path.indexOf('?') < 0 ? request.path.size()
+                                                                           : request.path.indexOf('?'));
+    if (path == "/health" && request.method == "GET") {
+        QJsonObject object;
+        object["status"] = "ok";
+        object["service"] = "MockASR";
+        object["version"] = "1.0";
+        object["warmup_ms"] = 0;
+        connection->respond(200, QJsonDocument(object).toJson(QJsonDocument::Compact));
+    } else if (path == "/" && request.method == "GET") {
+        connection->respond(200, "{\"message\":\"Mock ASR server is running\"}");
+    } else if (path == "/api/v1/asr") {
+        if (request.method != "POST") {
+            connection->respond(405, detailBody("Method Not Allowed"));
+            return;
+        }
+        handleRecognition(connection, request);
+    } else {
+        connection->respond(404, detailBody("Not Found"));
+    }
+}
+
+void MockAsrServer::handleRecognition(Connection *connection, const HttpRequest &request)
+{
+    ++m_requests;
+    QElapsedTimer parseClock;
+    parseClock.start();
+    QVector<FormPart> parts;
+    if (!parseMultipart(request.headers.value("content-type"), request.body, &parts)) {
+        connection->respond(400, detailBody("There was an error parsing the body"));
+        return;
+    }
+
+    Job job;
+    job.id = m_nextJobId++;
+    job.connection = connection;
+    for (const FormPart &part : parts) {
+        if (part.name == "files") {
+            job.audioBytes.append(part.body.size());
+            job.audioSeconds.append(wavSeconds(part.body));
+        } else if (part.name == "keys") {
+            job.keys = QString::fromUtf8(part.body).split(',');
+        }
+    }
+    if (job.audioBytes.isEmpty()) {
+        // 与FastAPI的参数校验错误相同
+        connection->respond(422, "{\"detail\":[{\"type\":\"missing\",\"loc\":[\"body\",\"files\"],"
+                                 "\"msg\":\"Field required\"}]}");
+        return;
+    }
+
+    job.parseMs = parseClock.nsecsElapsed() / 1e6;
+    job.queued.start();
+    m_queue.enqueue(job);
+    m_peakQueue = qMax(m_peakQueue, m_queue.size());
+    startJobs();
+}
+
+MockAsrServer::Fault MockAsrServer::drawFault()
+{
+    const double draw = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+    if (draw < m_options.dropRate) {
+        return Fault::Drop;
+    }
+    if (draw < m_options.dropRate + m_options.stallRate) {
+        return Fault::Stall;
+    }
+    if (draw < m_options.dropRate + m_options.stallRate + m_options.errorRate) {
+        return Fault::Error;
+    }
+    return Fault::None;
+}
+
+void MockAsrServer::startJobs()
+{
+    while (!m_queue.isEmpty() && (m_options.workers <= 0 || m_active < m_options.workers)) {
+        const Job job = m_queue.dequeue();
+        ++m_active;
+
+        // 耗时和故障按开始处理的顺序抽样，同样的请求顺序得到同样的序列
+        double audioSeconds = 0.0;
+        for (double seconds : job.audioSeconds) {
+            audioSeconds += seconds;
+        }
+        const double queuedMs = job.queued.nsecsElapsed() / 1e6;
+        double processMs = m_options.latency.sample(m_rng) + m_options.rtfMs * audioSeconds;
+        if (m_options.jitterMs > 0) {
+            processMs += std::uniform_real_distribution<double>(-m_options.jitterMs, m_options.jitterMs)(m_rng);
+        }
+        processMs = qMax(0.0, processMs);
+        const Fault fault = drawFault();
+        const double delayMs = fault == Fault::Stall ? processMs + m_options.stallMs : processMs;
+
+        QTimer::singleShot(qRound(delayMs), this, [this, job, fault, queuedMs, delayMs]() {
+            --m_active;
+            finishJob(job, fault, queuedMs, delayMs);
+            startJobs();
+        });
+    }
+}
+
+void MockAsrServer::finishJob(const Job &job, Fault fault, double queuedMs, double processMs)
+{
+    double audioSeconds = 0.0;
+    for (double seconds : job.audioSeconds) {
+        audioSeconds += seconds;
+    }
+    const QByteArray timing = QString("Server-Timing: parse;dur=%1, queue;dur=%2, process;dur=%3, total;dur=%4\r\n")
+        .arg(job.parseMs, 0, 'f', 2)
+        .arg(queuedMs, 0, 'f', 2)
+        .arg(processMs, 0, 'f', 2)
+        .arg(job.parseMs + queuedMs + processMs, 0, 'f', 2)
+        .toLatin1();
+    QString outcome;
+    if (!job.connection) {
+        ++m_abandoned;
+        outcome = "客户端已断开";
+    } else if (fault == Fault::Drop) {
+        ++m_drops;
+        outcome = "重置连接";
+        job.connection->reset();
+    } else if (fault == Fault::Error) {
+        ++m_errors;
+        outcome = QString::number(m_options.errorStatus);
+        job.connection->respond(m_options.errorStatus, detailBody("Injected failure"), timing);
+    } else {
+        if (fault == Fault::Stall) {
+            ++m_stalls;
+        }
+        ++m_succeeded;
+        outcome = fault == Fault::Stall ? "200（卡住后）" : "200";
+        job.connection->respond(200, recognitionResponse(job), timing);
+    }
+
+    if (m_options.verbose) {
+        printLine(QString("#%1 %2秒音频 排队%3ms 处理%4ms → %5")
+            .arg(job.id)
+            .arg(audioSeconds, 0, 'f', 2)
+            .arg(queuedMs, 0, 'f', 0)
+            .arg(processMs, 0, 'f', 0)
+            .arg(outcome));
+    }
+}
+
+QByteArray MockAsrServer::recognitionResponse(const Job &job)
+{
+    QJsonArray results;
+    for (int i = 0; i < job.audioBytes.size(); ++i) {
+        QString text;
+        if (m_options.echo) {
+            text = QString("收到%1字节音频，时长%2秒。").arg(job.audioBytes[i]).arg(job.audioSeconds[i], 0, 'f', 2);
+        } else if (!m_options.transcripts.isEmpty()) {
+            text = m_options.transcripts.at(m_transcriptIndex++ % m_options.transcripts.size());
+        } else {
+            text = "这是一段测试识别结果。";
+        }
+
+        // 与api.py相同：key取自keys，raw_text带模型的语种/情感标记
+        QJsonObject item;
+        item["key"] = job.keys.value(i, "wav_file_tmp_name");
+        item["text"] = text;
+        item["raw_text"] = RAW_TEXT_TAGS + text;
+        item["clean_text"] = text;
+        results.append(item);
+    }
+    QJsonObject object;
+    object["result"] = results;
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+QString MockAsrServer::statsLine() const
+{
+    return QString("请求 %1：成功 %2、错误 %3、重置 %4、卡住 %5、客户端放弃 %6；处理中 %7，排队 %8（峰值 %9）")
+        .arg(m_requests).arg(m_succeeded).arg(m_errors).arg(m_drops).arg(m_stalls).arg(m_abandoned)
+        .arg(m_active).arg(m_queue.size()).arg(m_peakQueue);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("识别服务的本地替身（/api/v1/asr、/health），延迟和故障可注入");
+    parser.addHelpOption();
+    parser.addOption({"host", "监听地址", "address", "127.0.0.1"});
+    parser.addOption({"port", "监听端口，0为系统分配", "port", "8000"});
+    parser.addOption({"latency", "处理耗时分布: fixed:ms | uniform:min,max | normal:mean,sd | lognormal:median,sigma",
+                      "spec", "fixed:0"});
+    parser.addOption({"rtf", "每秒音频增加的处理耗时", "ms", "0"});
+    parser.addOption({"jitter", "处理耗时的均匀抖动（±）", "ms", "0"});
+    parser.addOption({"workers", "同时处理的请求数，其余排队；0为不限", "count", "0"});
+    parser.addOption({"error-rate", "返回错误状态码的比例", "ratio", "0"});
+    parser.addOption({"error-status", "注入错误时的状态码", "status", "500"});
+    parser.addOption({"drop-rate", "不返回、直接重置连接的比例", "ratio", "0"});
+    parser.addOption({"stall-rate", "卡住--stall-ms后才返回的比例", "ratio", "0"});
+    parser.addOption({"stall-ms", "卡住的时长", "ms", "15000"});
+    parser.addOption({"bandwidth", "上下行带宽上限（所有连接共享），0为不限", "kbit/s", "0"});
+    parser.addOption({"transcript", "返回的识别文本", "text"});
+    parser.addOption({"transcripts", "识别文本列表（UTF-8，每行一条，按请求轮流返回）", "file"});
+    parser.addOption({"echo", "返回收到的音频字节数和时长"});
+    parser.addOption({"seed", "随机数种子", "seed", "1"});
+    parser.addOption({"stats", "每隔多少秒输出一次统计，0为不输出", "seconds", "0"});
+    parser.addOption({"verbose", "逐条输出请求的排队、处理耗时和结果"});
+    parser.process(app);
+
+    ServerOptions options;
+    if (!LatencyDistribution::parse(parser.value("latency"), &options.latency)) {
+        out << "无效的延迟分布: " << parser.value("latency") << "\n";
+        return 1;
+    }
+    options.rtfMs = parser.value("rtf").toDouble();
+    options.jitterMs = parser.value("jitter").toInt();
+    options.workers = parser.value("workers").toInt();
+    options.errorRate = parser.value("error-rate").toDouble();
+    options.errorStatus = parser.value("error-status").toInt();
+    options.dropRate = parser.value("drop-rate").toDouble();
+    options.stallRate = parser.value("stall-rate").toDouble();
+    options.stallMs = parser.value("stall-ms").toInt();
+    options.bandwidthBytesPerSecond = parser.value("bandwidth").toLongLong() * 1000 / 8;
+    options.echo = parser.isSet("echo");
+    options.seed = parser.value("seed").toUInt();
+    options.verbose = parser.isSet("verbose");
+    if (options.errorRate + options.dropRate + options.stallRate > 1.0 || options.errorStatus < 100) {
+        out << "故障比例之和须不超过1，状态码须为有效的HTTP状态码\n";
+        return 1;
+    }
+    if (parser.isSet("transcript")) {
+        options.transcripts.append(parser.value("transcript"));
+    }
+    if (parser.isSet("transcripts")) {
+        QFile file(parser.value("transcripts"));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            out << "无法读取: " << parser.value("transcripts") << "\n";
+            return 1;
+        }
+        for (const QString &line : QString::fromUtf8(file.readAll()).split('\n')) {
+            if (!line.trimmed().isEmpty()) {
+                options.transcripts.append(line.trimmed());
+            }
+        }
+    }
+
+    MockAsrServer server(options);
+    if (!server.listen(QHostAddress(parser.value("host")), static_cast<quint16>(parser.value("port").toUInt()))) {
+        out << "监听失败: " << server.errorString() << "\n";
+        return 1;
+    }
+    out << "mockasrserver 监听 http://" << parser.value("host") << ":" << server.serverPort() << "\n";
+    out.flush();
+
+    QTimer statsTimer;
+    const int statsSeconds = parser.value("stats").toInt();
+    if (statsSeconds > 0) {
+        QObject::connect(&statsTimer, &QTimer::timeout, &server, [&server]() {
+            printLine(server.statsLine());
+        });
+        statsTimer.start(statsSeconds * 1000);
+    }
+
+    return app.exec();
+}
+
+#include "main.moc"
@@ -0,0 +1,13 @@
+# 识别服务的本地替身：/api/v1/asr、/health，可注入延迟分布、抖动、错误、卡住和带宽上限
+QT       += core network
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = mockasrserver
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp
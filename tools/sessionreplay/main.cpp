@@ -0,0 +1,509 @@
+/**
+ * sessionreplay：按会话录制文件重放
+ *
+ * 读取应用在设置VOICE_SESSION_FILE时录下的文件（SessionRecorder），按原来的时间把操作重新送入VoiceRecognitionManager：
+ *   - 按键录音：按下时录音来源换成这句录下的音频（AudioSource的文件回放），在原来松键的时刻松键；取消同样重放
+ *   - recognizeAudio：在原来的时刻提交录下的整段音频
+ *   - 听写：与按键录音相同，开始、停止或取消听写
+ * --speed为倍速，按键时刻和音频回放同时加快；会话之间超过--max-idle毫秒的空闲压缩为--max-idle。
+ * 识别后端为--url的服务（真实服务或mockasrserver），或--model的内置引擎。
+ * 逐句输出原来与重放的松键到出字耗时、文本是否一致，最后输出两者的分位数；--json写出逐句结果。
+ * --dump只列出文件中的记录（时间、类型、请求ID和摘要），不重放。
+ *
+ * 录音数据块的到达时刻记录在文件中（--dump可见），重放时音频按AudioSource的10ms时钟送出，不复现块与块之间的抖动。
+ * 管理器与本工具在同一线程（不调用initialize），与latencybench相同。
+ *
+ * 用法：sessionreplay --session session.bin [--url http://127.0.0.1:8000 | --model model.svnw] [--speed 1]
+ *                     [--max-idle 2000] [--json result.json] [--dump] [--verbose]
+ * 无显示环境下可加 -platform offscreen
+ */
+
+#include "voicerecognitionmanager.h"
+#include "requestmetrics.h"
+#include "sessionrecorder.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+const int COMPLETION_TIMEOUT_MS = 30000;    // 最后一个操作之后等待结果的上限
+
+/**
+ * 一次重放的操作
+ */
+struct Action {
+    enum Kind {
+        Press,
+        Release,
+        Cancel,
+        Submit,
+        DictationStart,
+        DictationStop,
+        DictationCancel
+    };
+
+    Kind kind;
+    qint64 timeNs;                          // 录制时的时刻
+    QString requestId;
+    int sentence;                           // 对应的句子，Release等为-1
+};
+
+/**
+ * 一句话（按键录音、提交或听写）的原始结果与重放结果
+ */
+struct Sentence {
+    QString requestId;
+    QString kind;                           // "push-to-talk" / "submit" / "dictation"
+    QByteArray pcm;                         // 录下的音频；按键录音和听写写入临时文件回放
+    QString audioFile;
+    QString originalText;
+    QString originalError;
+    double originalMs = -1.0;               // 松键（提交）到最后一个时间点
+    QString replayText;
+    QString replayError;
+    double replayMs = -1.0;
+    bool replayDone = false;
+    bool cancelled = false;                 // 录制时取消，原来和重放都不应有结果
+};
+
+void discardDebugMessages(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context);
+    if (type != QtDebugMsg) {
+        QTextStream(stderr) << message << "\n";
+    }
+}
+
+double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(p * (values.size() - 1) + 0.5), values.size() - 1);
+    return values[index];
+}
+
+const char *typeName(SessionRecorder::RecordType type)
+{
+    static const char *names[] = {"?", "audio", "key-down", "key-up", "cancel", "submit", "dictation-start",
+                                  "dictation-stop", "dictation-cancel", "request", "response", "result", "completed"};
+    return type >= SessionRecorder::Audio && type <= SessionRecorder::Completed ? names[type] : names[0];
+}
+
+/**
+ * 函数名称：`completedMetrics`
+ * 功能描述：从Completed记录还原RequestMetrics
+ */
+RequestMetrics completedMetrics(const SessionReader::Record &record)
+{
+    RequestMetrics metrics;
+    metrics.requestId = record.requestId();
+    metrics.error = QString::fromUtf8(record.field(1));
+    const QByteArray stamps = record.field(2);
+    for (int point = 0; point < RequestMetrics::StampCount && (point + 1) * 8 <= stamps.size(); ++point) {
+        metrics.stamps[point] = qFromLittleEndian<qint64>(stamps.constData() + point * 8);
+    }
+    return metrics;
+}
+
+void dump(QTextStream &out, const SessionReader &reader)
+{
+    for (const SessionReader::Record &record : reader.records()) {
+        out << QString::number((record.timeNs - reader.startNs()) / 1e6, 'f', 1).rightJustified(12) << "  "
+            << QString(typeName(record.type)).leftJustified(17) << record.requestId();
+        switch (record.type) {
+        case SessionRecorder::Audio:
+            out << "  " << record.field(1).size() << " 字节";
+            break;
+        case SessionRecorder::Submit:
+            out << "  " << record.field(1).size() << " 字节";
+            break;
+        case SessionRecorder::Request:
+        case SessionRecorder::Result:
+            out << "  " << QString::fromUtf8(record.field(1));
+            break;
+        case SessionRecorder::Response:
+            out << "  HTTP " << record.field(1) << "  " << record.field(3).size() << " 字节";
+            if (!record.field(2).isEmpty()) {
+                out << "  Server-Timing: " << record.field(2);
+            }
+            break;
+        case SessionRecorder::Completed: {
+            const RequestMetrics metrics = completedMetrics(record);
+            out << "  " << QString::number(metrics.totalNs() / 1e6, 'f', 1) << " ms";
+            if (!metrics.error.isEmpty()) {
+                out << "  " << metrics.error;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        out << "\n";
+    }
+    if (reader.truncated()) {
+        out << "（文件末尾有不完整的记录）\n";
+    }
+}
+
+/**
+ * 函数名称：`buildPlan`
+ * 功能描述：把记录整理成操作序列和句子：按下或开始听写之后的录音数据块归入这句，原始结果按请求ID归入最近一句
+ */
+void buildPlan(const SessionReader &reader, QVector<Action> *actions, QVector<Sentence> *sentences)
+{
+    QHash<QString, int> latest;             // 请求ID → 最近一句
+    int capturing = -1;                     // 正在采集音频的句子
+    for (const SessionReader::Record &record : reader.records()) {
+        const QString requestId = record.requestId();
+        auto startSentence = [&](const QString &kind) {
+            Sentence sentence;
+            sentence.requestId = requestId;
+            sentence.kind = kind;
+            sentences->append(sentence);
+            latest.insert(requestId, sentences->size() - 1);
+            return sentences->size() - 1;
+        };
+        switch (record.type) {
+        case SessionRecorder::Audio:
+            if (capturing >= 0) {
+                (*sentences)[capturing].pcm.append(record.field(1));
+            }
+            break;
+        case SessionRecorder::KeyDown:
+            capturing = startSentence("push-to-talk");
+            actions->append({Action::Press, record.timeNs, requestId, capturing});
+            break;
+        case SessionRecorder::DictationStart:
+            capturing = startSentence("dictation");
+            actions->append({Action::DictationStart, record.timeNs, requestId, capturing});
+            break;
+        case SessionRecorder::Submit: {
+            const int index = startSentence("submit");
+            (*sentences)[index].pcm = record.field(1);
+            (*sentences)[index].pcm.detach();
+            actions->append({Action::Submit, record.timeNs, requestId, index});
+            break;
+        }
+        // 停止录音时设备可能再送出最后一块数据，松键之后的数据块仍归入这句，直到下一句开始
+        case SessionRecorder::KeyUp:
+            actions->append({Action::Release, record.timeNs, requestId, -1});
+            break;
+        case SessionRecorder::Cancel:
+            if (latest.contains(requestId)) {
+                (*sentences)[latest.value(requestId)].cancelled = true;
+            }
+            actions->append({Action::Cancel, record.timeNs, requestId, -1});
+            break;
+        case SessionRecorder::DictationStop:
+            actions->append({Action::DictationStop, record.timeNs, requestId, -1});
+            break;
+        case SessionRecorder::DictationCancel:
+            actions->append({Action::DictationCancel, record.timeNs, requestId, -1});
+            break;
+        case SessionRecorder::Result:
+            if (latest.contains(requestId)) {
+                (*sentences)[latest.value(requestId)].originalText += QString::fromUtf8(record.field(1));
+            }
+            break;
+        case SessionRecorder::Completed:
+            if (latest.contains(requestId)) {
+                const RequestMetrics metrics = completedMetrics(record);
+                Sentence &sentence = (*sentences)[latest.value(requestId)];
+                sentence.originalError = metrics.error;
+                sentence.originalMs = metrics.totalNs() / 1e6;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * 函数名称：`scheduleMs`
+ * 功能描述：各操作在重放中的时刻（毫秒）：没有进行中的录音或听写时，相邻操作间超过maxIdleMs的空闲压缩，再按倍速缩短
+ */
+QVector<double> scheduleMs(const QVector<Action> &actions, double speed, int maxIdleMs)
+{
+    QVector<double> times;
+    qint64 skippedNs = 0;
+    bool active = false;
+    for (int i = 0; i < actions.size(); ++i) {
+        if (i > 0 && !active) {
+            const qint64 idleNs = actions[i].timeNs - actions[i - 1].timeNs;
+            skippedNs += qMax<qint64>(0, idleNs - maxIdleMs * 1000000LL);
+        }
+        const Action::Kind kind = actions[i].kind;
+        if (kind == Action::Press || kind == Action::DictationStart) {
+            active = true;
+        } else if (kind != Action::Submit) {
+            active = false;
+        }
+        const qint64 offsetNs = actions[i].timeNs - actions[0].timeNs - skippedNs;
+        times.append(offsetNs / 1e6 / speed);
+    }
+    return times;
+}
+
+void waitUntilMs(const QElapsedTimer &clock, double targetMs)
+{
+    const qint64 remaining = static_cast<qint64>(targetMs) - clock.elapsed();
+    if (remaining > 0) {
+        QEventLoop loop;
+        QTimer::singleShot(static_cast<int>(remaining), Qt::PreciseTimer, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("按会话录制文件重放按键、音频和请求");
+    parser.addHelpOption();
+    parser.addOption({"session", "会话录制文件（VOICE_SESSION_FILE）", "file"});
+    parser.addOption({"url", "识别服务地址（真实服务或本地替身）", "url", "http://127.0.0.1:8000"});
+    parser.addOption({"model", "使用内置引擎的权重文件，不请求识别服务", "file"});
+    parser.addOption({"speed", "重放倍速（>0），按键时刻和音频回放同时加快", "factor", "1"});
+    parser.addOption({"max-idle", "会话之间的空闲最多保留多久", "ms", "2000"});
+    parser.addOption({"json", "把逐句结果写成JSON文件", "file"});
+    parser.addOption({"dump", "只列出文件中的记录，不重放"});
+    parser.addOption({"verbose", "输出管理器的调试日志"});
+    parser.process(app);
+
+    if (!parser.isSet("session")) {
+        parser.showHelp(1);
+    }
+    if (!parser.isSet("verbose")) {
+        qInstallMessageHandler(discardDebugMessages);
+    }
+
+    QString error;
+    SessionReader reader;
+    if (!reader.open(parser.value("session"), &error)) {
+        out << error << "\n";
+        return 1;
+    }
+    if (parser.isSet("dump")) {
+        dump(out, reader);
+        return 0;
+    }
+    const double speed = parser.value("speed").toDouble();
+    if (speed <= 0.0) {
+        out << "--speed须大于0\n";
+        return 1;
+    }
+
+    QVector<Action> actions;
+    QVector<Sentence> sentences;
+    buildPlan(reader, &actions, &sentences);
+    if (actions.isEmpty()) {
+        out << "文件中没有可重放的操作\n";
+        return 1;
+    }
+    QTemporaryDir audioDir;
+    for (int i = 0; i < sentences.size(); ++i) {
+        Sentence &sentence = sentences[i];
+        if (sentence.kind == "submit") {
+            continue;
+        }
+        // 扩展名不是.wav的文件，AudioSource按裸PCM读取
+        sentence.audioFile = audioDir.filePath(QString("%1.pcm").arg(i));
+        QFile file(sentence.audioFile);
+        if (!file.open(QIODevice::WriteOnly) || file.write(sentence.pcm) != sentence.pcm.size()) {
+            out << "无法写入临时音频: " << sentence.audioFile << "\n";
+            return 1;
+        }
+    }
+    const QVector<double> times = scheduleMs(actions, speed, qMax(0, parser.value("max-idle").toInt()));
+
+    VoiceRecognitionManager *manager = VoiceRecognitionManager::instance();
+    manager->setServiceUrl(parser.value("url"));
+    QString backend = parser.value("url");
+    if (parser.isSet("model")) {
+        if (!manager->setEngineModel(parser.value("model"))) {
+            out << "模型加载失败: " << parser.value("model") << "\n";
+            return 1;
+        }
+        backend = "engine:" + parser.value("model");
+    }
+
+    // 同一请求ID可能先后对应多句：结果归入该ID最早一句还没结束的
+    QHash<QString, QVector<int>> inFlight;
+    int finished = 0;
+    auto current = [&sentences, &inFlight](const QString &requestId) -> Sentence * {
+        const QVector<int> &queue = inFlight[requestId];
+        return queue.isEmpty() ? nullptr : &sentences[queue.first()];
+    };
+    auto finish = [&inFlight, &finished](const QString &requestId) {
+        if (!inFlight[requestId].isEmpty()) {
+            inFlight[requestId].removeFirst();
+            ++finished;
+        }
+    };
+    QObject::connect(manager, &VoiceRecognitionManager::recognitionFinished, &app,
+                     [manager, &current](const QString &text, const QString &requestId) {
+        if (Sentence *sentence = current(requestId)) {
+            sentence->replayText = text;
+        }
+        manager->reportTextInserted(requestId);
+    });
+    QObject::connect(manager, &VoiceRecognitionManager::requestCompleted, &app,
+                     [&current, &finish](const RequestMetrics &metrics) {
+        if (Sentence *sentence = current(metrics.requestId)) {
+            sentence->replayError = metrics.error;
+            sentence->replayMs = metrics.totalNs() / 1e6;
+            sentence->replayDone = true;
+            finish(metrics.requestId);
+        }
+    });
+    QObject::connect(manager, &VoiceRecognitionManager::dictationTextReady, &app,
+                     [&current](const QString &text, const QString &requestId) {
+        if (Sentence *sentence = current(requestId)) {
+            sentence->replayText += text;
+        }
+    });
+    QObject::connect(manager, &VoiceRecognitionManager::dictationFinished, &app,
+                     [&current, &finish](const QString &requestId) {
+        if (Sentence *sentence = current(requestId)) {
+            sentence->replayDone = true;
+            finish(requestId);
+        }
+    });
+
+    out << "后端: " << backend << "  会话: " << parser.value("session") << "  句数: " << sentences.size()
+        << "  重放时长: " << QString::number(times.last() / 1000.0, 'f', 1) << " 秒\n";
+    out.flush();
+
+    int started = 0;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < actions.size(); ++i) {
+        const Action &action = actions[i];
+        waitUntilMs(clock, times[i]);
+        if (action.sentence >= 0) {
+            inFlight[action.requestId].append(action.sentence);
+            ++started;
+        }
+        const Sentence *sentence = action.sentence >= 0 ? &sentences[action.sentence] : nullptr;
+        switch (action.kind) {
+        case Action::Press:
+            manager->setAudioSource(QString("file:%1?speed=%2").arg(sentence->audioFile).arg(speed));
+            manager->startRecording(action.requestId);
+            break;
+        case Action::Release:
+            manager->stopRecording();
+            break;
+        case Action::Cancel:
+            // 取消的一句不会有结果
+            manager->cancelRecording();
+            finish(action.requestId);
+            break;
+        case Action::Submit:
+            manager->recognizeAudio(sentence->pcm, action.requestId);
+            break;
+        case Action::DictationStart:
+            manager->setAudioSource(QString("file:%1?speed=%2").arg(sentence->audioFile).arg(speed));
+            manager->startDictation(action.requestId);       // 未能开始时同样发出dictationFinished
+            break;
+        case Action::DictationStop:
+            manager->stopDictation();
+            break;
+        case Action::DictationCancel:
+            manager->cancelDictation();
+            break;
+        }
+    }
+
+    QElapsedTimer wait;
+    wait.start();
+    while (finished < started && wait.elapsed() < COMPLETION_TIMEOUT_MS) {
+        waitUntilMs(wait, wait.elapsed() + 50);
+    }
+
+    // 逐句对比
+    QVector<double> originalMs;
+    QVector<double> replayMs;
+    int mismatches = 0;
+    QJsonArray rows;
+    out << "\n" << QString("请求ID").leftJustified(24) << QString("类型").leftJustified(14)
+        << QString("原始(ms)").rightJustified(10) << QString("重放(ms)").rightJustified(10) << "  文本\n";
+    for (const Sentence &sentence : sentences) {
+        const bool same = sentence.cancelled
+                              ? sentence.replayText.isEmpty()
+                              : sentence.replayDone && sentence.replayText == sentence.originalText
+                                    && sentence.replayError.isEmpty() == sentence.originalError.isEmpty();
+        if (!same) {
+            ++mismatches;
+        }
+        if (sentence.originalMs >= 0.0 && sentence.originalError.isEmpty()) {
+            originalMs.append(sentence.originalMs);
+        }
+        if (sentence.replayMs >= 0.0 && sentence.replayError.isEmpty()) {
+            replayMs.append(sentence.replayMs);
+        }
+        out << sentence.requestId.leftJustified(24) << sentence.kind.leftJustified(14)
+            << QString::number(sentence.originalMs, 'f', 1).rightJustified(10)
+            << QString::number(sentence.replayMs, 'f', 1).rightJustified(10) << "  "
+            << (sentence.cancelled ? "已取消" : !sentence.replayDone ? "未完成" : same ? "一致" : "不同") << "\n";
+        if (!same) {
+            out << "    原始: " << (sentence.originalError.isEmpty() ? sentence.originalText : sentence.originalError)
+                << "\n    重放: " << (sentence.replayError.isEmpty() ? sentence.replayText : sentence.replayError)
+                << "\n";
+        }
+
+        QJsonObject row;
+        row["requestId"] = sentence.requestId;
+        row["kind"] = sentence.kind;
+        row["audioSeconds"] = sentence.pcm.size() / 32000.0;
+        row["originalMs"] = sentence.originalMs;
+        row["originalText"] = sentence.originalText;
+        row["originalError"] = sentence.originalError;
+        row["replayMs"] = sentence.replayMs;
+        row["replayText"] = sentence.replayText;
+        row["replayError"] = sentence.replayError;
+        row["cancelled"] = sentence.cancelled;
+        row["same"] = same;
+        rows.append(row);
+    }
+    out << "\n松键到出字 p50/p95(ms)  原始: " << QString::number(percentile(originalMs, 0.5), 'f', 1) << "/"
+        << QString::number(percentile(originalMs, 0.95), 'f', 1)
+        << "  重放: " << QString::number(percentile(replayMs, 0.5), 'f', 1) << "/"
+        << QString::number(percentile(replayMs, 0.95), 'f', 1) << "\n";
+    out << "结果不同或未完成: " << mismatches << " / " << sentences.size() << "\n";
+
+    if (parser.isSet("json")) {
+        QJsonObject root;
+        root["session"] = parser.value("session");
+        root["backend"] = backend;
+        root["speed"] = speed;
+        root["sentences"] = rows;
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "无法写入: " << parser.value("json") << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+        out << "结果已写入 " << parser.value("json") << "\n";
+    }
+    return 0;
+}
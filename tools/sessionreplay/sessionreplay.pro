@@ -0,0 +1,43 @@
+# 会话重放：按会话录制文件的原始节奏（或加速）把按键、音频和提交重新送入VoiceRecognitionManager
+QT       += core gui widgets network multimedia
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = sessionreplay
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../APP
+
+SOURCES += \
+    main.cpp \
+    ../../APP/recognitionprotocol.cpp \
+    ../../APP/voicerecognitionmanager.cpp \
+    ../../APP/enginepipeline.cpp \
+    ../../APP/dictationpipeline.cpp \
+    ../../APP/handsfreepipeline.cpp \
+    ../../APP/capturestore.cpp \
+    ../../APP/latencyhistogram.cpp \
+    ../../APP/pipelinetrace.cpp \
+    ../../APP/sessionrecorder.cpp \
+    ../../APP/voicelogging.cpp \
+    ../../APP/audiosource.cpp \
+    ../../APP/capturehealth.cpp
+
+HEADERS += \
+    ../../APP/recognitionprotocol.h \
+    ../../APP/voicerecognitionmanager.h \
+    ../../APP/enginepipeline.h \
+    ../../APP/dictationpipeline.h \
+    ../../APP/handsfreepipeline.h \
+    ../../APP/capturestore.h \
+    ../../APP/audiosource.h \
+    ../../APP/capturehealth.h \
+    ../../APP/requestmetrics.h \
+    ../../APP/latencyhistogram.h \
+    ../../APP/pipelinetrace.h \
+    ../../APP/sessionrecorder.h \
+    ../../APP/voicelogging.h
+
+include(../../APP/engine/engine.pri)
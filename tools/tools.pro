@@ -0,0 +1,12 @@
+# 性能测试与调试工具
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    enginebench \
+    kwsbench \
+    editbench \
+    latencybench \
+    microbench \
+    mockasrserver \
+    loadgen \
+    sessionreplay